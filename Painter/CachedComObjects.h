@@ -35,6 +35,8 @@ private:
 
 	D3D11_VIEWPORT					viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
 	UINT							numberOfViewport = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+	D3D11_RECT						scissorRects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
+	UINT							numberOfScissorRect = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
 
 	CachedComObjects(ID3D11DeviceContext* immediateContext)
 	{
@@ -52,6 +54,7 @@ private:
 		immediateContext->OMGetDepthStencilState(&depthStencilState, &RasterizerState);
 		immediateContext->IAGetPrimitiveTopology(&primitiveTopology);
 		immediateContext->RSGetViewports(&numberOfViewport, viewports);
+		immediateContext->RSGetScissorRects(&numberOfScissorRect, scissorRects);
 	}
 
 	void pop(ID3D11DeviceContext* immediateContext)const
@@ -70,6 +73,7 @@ private:
 		immediateContext->OMSetDepthStencilState(depthStencilState, RasterizerState);
 		immediateContext->IASetPrimitiveTopology(primitiveTopology);
 		immediateContext->RSSetViewports(numberOfViewport, viewports);
+		immediateContext->RSSetScissorRects(numberOfScissorRect, scissorRects);
 	}
 
 
@@ -0,0 +1,130 @@
+﻿#include "ConstantArena.h"
+#include <assert.h>
+#include <string.h>
+
+#define hrInspection(hr) assert(hr == S_OK)
+
+HRESULT ConstantArena::create(ID3D11Device* newDevice, ID3D11DeviceContext* immediateContext, UINT capacity)
+{
+	assert(newDevice && "The device is invalid.");
+	assert(immediateContext && "The context is invalid.");
+	device = newDevice;
+	enabled = false;
+	mapped = false;
+	fences.clear();
+	idleQueries.clear();
+	frameIndex = 0;
+
+	//オフセット指定のバインドとNO_OVERWRITEでの定数バッファのMapが使えるか
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+	if (FAILED(immediateContext->QueryInterface(IID_PPV_ARGS(context1.ReleaseAndGetAddressOf()))) ||
+		FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+		!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+	{
+		context1.Reset();
+		return S_FALSE;
+	}
+
+	capacity = (capacity + alignment - 1) & ~(alignment - 1);
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = capacity;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	HRESULT hr = device->CreateBuffer(&desc, nullptr, buffer.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	if (FAILED(hr)) { return hr; }
+	allocator.create(capacity, alignment);
+	//フェンス用のクエリは毎フレーム作らずに使い回す
+	const D3D11_QUERY_DESC queryDesc{ D3D11_QUERY_EVENT, 0 };
+	for (size_t i = 0; i < maxFencedFrames; i++)
+	{
+		ComPtr<ID3D11Query> query;
+		hr = device->CreateQuery(&queryDesc, query.GetAddressOf());
+		hrInspection(hr);
+		if (FAILED(hr)) { return hr; }
+		idleQueries.push_back(std::move(query));
+	}
+	enabled = true;
+	return hr;
+}
+
+void ConstantArena::beginFrame(ID3D11DeviceContext* immediateContext)
+{
+	if (!enabled) { return; }
+	//GPUが通過したフレームの領域を解放する
+	UINT64 completed = 0;
+	while (!fences.empty())
+	{
+		BOOL done = FALSE;
+		if (immediateContext->GetData(fences.front().first.Get(), &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || !done) { break; }
+		completed = fences.front().second;
+		idleQueries.push_back(std::move(fences.front().first));
+		fences.pop_front();
+	}
+	if (completed) { allocator.retire(completed); }
+}
+
+void ConstantArena::endFrame(ID3D11DeviceContext* immediateContext)
+{
+	if (!enabled) { return; }
+	frameIndex++;
+	allocator.endFrame(frameIndex);
+	//全部のクエリが使用中なら, このフレームは次にフェンスしたフレームと一緒に解放される
+	if (idleQueries.empty()) { return; }
+	immediateContext->End(idleQueries.back().Get());
+	fences.emplace_back(std::move(idleQueries.back()), frameIndex);
+	idleQueries.pop_back();
+}
+
+void ConstantArena::releaseFences()
+{
+	for (auto& fence : fences) { idleQueries.push_back(std::move(fence.first)); }
+	fences.clear();
+}
+
+HRESULT ConstantArena::write(ID3D11DeviceContext* immediateContext, const void* data, UINT size, UINT* outFirstConstant, UINT* outConstantCount)
+{
+	//定数の個数は16 (256バイト) の倍数で指定する
+	const UINT reserved = (size + alignment - 1) & ~(alignment - 1);
+	size_t offset = allocator.allocate(reserved);
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (offset == RingAllocator::invalidOffset || !mapped)
+	{
+		//リングが一周してGPUに追いついたら待たずにバッファごと破棄する
+		if (mapped) { statistics.discardCount++; }
+		allocator.reset();
+		releaseFences();
+		offset = allocator.allocate(reserved);
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		mapped = true;
+	}
+	assert(offset != RingAllocator::invalidOffset && "The constants do not fit in the arena.");
+	D3D11_MAPPED_SUBRESOURCE subresource{};
+	HRESULT hr = immediateContext->Map(buffer.Get(), 0, mapType, 0, &subresource);
+	hrInspection(hr);
+	if (FAILED(hr)) { return hr; }
+	memcpy(static_cast<unsigned char*>(subresource.pData) + offset, data, size);
+	immediateContext->Unmap(buffer.Get(), 0);
+	*outFirstConstant = static_cast<UINT>(offset / 16);
+	*outConstantCount = reserved / 16;
+	statistics.bytesWritten += size;
+	return hr;
+}
+
+bool ConstantArena::bind(ID3D11DeviceContext* immediateContext, UINT slot, const void* data, UINT size, bool useVs, bool usePs, bool useDs, bool useHs, bool useGs)
+{
+	assert(immediateContext && "The context is invalid.");
+	if (!enabled) { return false; }
+	assert(size % 16 == 0 && "constant buffer's need to be 16 byte aligned");
+	UINT firstConstant = 0, constantCount = 0;
+	if (FAILED(write(immediateContext, data, size, &firstConstant, &constantCount))) { return false; }
+	ID3D11Buffer* buffers[] = { buffer.Get() };
+	if (useVs)context1->VSSetConstantBuffers1(slot, 1, buffers, &firstConstant, &constantCount);
+	if (usePs)context1->PSSetConstantBuffers1(slot, 1, buffers, &firstConstant, &constantCount);
+	if (useDs)context1->DSSetConstantBuffers1(slot, 1, buffers, &firstConstant, &constantCount);
+	if (useHs)context1->HSSetConstantBuffers1(slot, 1, buffers, &firstConstant, &constantCount);
+	if (useGs)context1->GSSetConstantBuffers1(slot, 1, buffers, &firstConstant, &constantCount);
+	statistics.bindCount++;
+	return true;
+}
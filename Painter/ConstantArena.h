@@ -0,0 +1,89 @@
+﻿#pragma once
+#include <d3d11_1.h>
+#include <wrl.h>
+#include <deque>
+#include <vector>
+#include "../func/ConstantShadow.h"
+#include "../func/RingAllocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+/****************************************************************
+	Frame-wide constant buffer.
+	Per-draw constants are written linearly into one large dynamic
+	buffer at 256 byte offsets (MAP_WRITE_NO_OVERWRITE) and bound
+	with *SetConstantBuffers1 ranges, so drawing many objects does
+	not rename a small buffer on every draw. Frames are fenced with
+	a fixed pool of event queries created once; when every query is
+	still in flight the frame goes unfenced and is freed with the
+	next fenced one. If the ring catches up with the GPU the buffer
+	is discarded instead of waiting.
+	Needs D3D11.1 constant buffer offsetting. Without it isEnabled
+	is false and bind returns false, so callers keep their own
+	ConstantBuffer path.
+
+	Usage per frame:
+		beginFrame -> painters bind -> endFrame (before Present)
+****************************************************************/
+class ConstantArena
+{
+public:
+	struct Statistics
+	{
+		size_t bindCount = 0;
+		size_t bytesWritten = 0;
+		size_t discardCount = 0;
+	};
+private:
+	ComPtr<ID3D11Buffer> buffer;
+	ComPtr<ID3D11DeviceContext1> context1;
+	ComPtr<ID3D11Device> device;
+	RingAllocator allocator;
+	std::vector<ComPtr<ID3D11Query>> idleQueries;
+	std::deque<std::pair<ComPtr<ID3D11Query>, UINT64>> fences;
+	UINT64 frameIndex = 0;
+	bool enabled = false;
+	bool mapped = false;			// the buffer has been discarded at least once
+	Statistics statistics;
+
+	HRESULT write(ID3D11DeviceContext* immediateContext, const void* data, UINT size, UINT* outFirstConstant, UINT* outConstantCount);
+	// Returns every fence query to the pool.
+	void releaseFences();
+public:
+	static constexpr UINT alignment = 256;
+	static constexpr size_t maxFencedFrames = 8;
+
+	// capacity in bytes, enough for a few frames of draws.
+	HRESULT create(ID3D11Device* device, ID3D11DeviceContext* immediateContext, UINT capacity = 4 * 1024 * 1024);
+	bool isEnabled()const { return enabled; }
+
+	void beginFrame(ID3D11DeviceContext* immediateContext);
+	void endFrame(ID3D11DeviceContext* immediateContext);
+
+	/****************************************************************
+		Copy size bytes of constants into the arena and bind them to
+		slot of the selected stages.
+		Returns false when offsetting is unavailable; nothing is bound
+		and the caller falls back to its own buffer.
+	****************************************************************/
+	bool bind(ID3D11DeviceContext* immediateContext,
+		UINT slot,
+		const void* data,
+		UINT size,
+		bool useVs = true,
+		bool usePs = true,
+		bool useDs = true,
+		bool useHs = true,
+		bool useGs = true);
+	template<class T>
+	bool bind(ID3D11DeviceContext* immediateContext, UINT slot, const T& data,
+		bool useVs = true, bool usePs = true, bool useDs = true, bool useHs = true, bool useGs = true)
+	{
+		static_assert(IsConstantData<T>::value, "Constant data must be trivially copyable and 16 byte aligned in size");
+		return bind(immediateContext, slot, &data, sizeof(T), useVs, usePs, useDs, useHs, useGs);
+	}
+
+	const Statistics& getStatistics()const { return statistics; }
+	void resetStatistics() { statistics = Statistics(); }
+	const RingAllocator& getAllocator()const { return allocator; }
+};
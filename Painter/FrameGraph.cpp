@@ -0,0 +1,331 @@
+﻿#include "FrameGraph.h"
+#include <assert.h>
+#include <algorithm>
+#include <queue>
+
+namespace detail
+{
+	// Imported layers and transient layers share one key space for hazard tracking.
+	inline unsigned int physicalKey(const FrameGraph::ResourceNode& node, FrameGraph::Resource resource)
+	{
+		return node.imported ? (0x80000000u | resource) : node.physical;
+	}
+}
+
+FrameGraph::Resource FrameGraph::Builder::create(const char* name, const LayerDesc& desc)
+{
+	assert(graph && "The graph is invalid.");
+	ResourceNode& node = graph->resources.emplace_back();
+	node.name = name;
+	node.desc = desc;
+	graph->compiled = false;
+	return static_cast<Resource>(graph->resources.size() - 1);
+}
+
+FrameGraph::Resource FrameGraph::Builder::read(Resource resource)
+{
+	assert(resource < graph->resources.size() && "The resource is invalid.");
+	graph->passes[pass].reads.push_back(resource);
+	graph->resources[resource].readers.push_back(pass);
+	graph->compiled = false;
+	return resource;
+}
+
+FrameGraph::Resource FrameGraph::Builder::write(Resource resource)
+{
+	assert(resource < graph->resources.size() && "The resource is invalid.");
+	graph->passes[pass].writes.push_back(resource);
+	graph->resources[resource].writers.push_back(pass);
+	graph->compiled = false;
+	return resource;
+}
+
+FrameGraph::Resource FrameGraph::Builder::writeDepth(Resource resource)
+{
+	assert(graph->passes[pass].depth == invalidResource && "The pass already has a depth target.");
+	graph->passes[pass].depth = resource;
+	return write(resource);
+}
+
+void FrameGraph::Builder::sideEffect()
+{
+	graph->passes[pass].sideEffect = true;
+}
+
+unsigned int FrameGraph::addPass(const char* name)
+{
+	passes.emplace_back().name = name;
+	compiled = false;
+	return static_cast<unsigned int>(passes.size() - 1);
+}
+
+FrameGraph::Resource FrameGraph::importLayer(const char* name, const LayerDesc& desc)
+{
+	ResourceNode& node = resources.emplace_back();
+	node.name = name;
+	node.desc = desc;
+	node.imported = true;
+	compiled = false;
+	return static_cast<Resource>(resources.size() - 1);
+}
+
+FrameGraph::Resource FrameGraph::getDepthTarget(unsigned int pass)const
+{
+	const PassNode& node = passes[pass];
+	if (node.depth != invalidResource) { return node.depth; }
+	return node.writes.size() == 1 ? node.writes.front() : invalidResource;
+}
+
+void FrameGraph::clear()
+{
+	passes.clear();
+	resources.clear();
+	order.clear();
+	physicalLayers.clear();
+	compiled = false;
+}
+
+FrameGraph::Result FrameGraph::compile()
+{
+	const unsigned int passCount = static_cast<unsigned int>(passes.size());
+	order.clear();
+	physicalLayers.clear();
+	compiled = false;
+
+	for (PassNode& pass : passes)
+	{
+		pass.culled = false;
+		pass.refCount = static_cast<unsigned int>(pass.writes.size());
+		pass.unbindShaderResources.clear();
+		pass.unbindRenderTargets = false;
+		for (Resource r : pass.reads)
+		{
+			// Sampling a layer while rendering into it.
+			if (std::find(pass.writes.begin(), pass.writes.end(), r) != pass.writes.end())
+			{
+				return Result::selfDependency;
+			}
+		}
+	}
+	for (ResourceNode& node : resources)
+	{
+		// Builders may declare passes in any order; the walk below needs pass order.
+		std::sort(node.writers.begin(), node.writers.end());
+		std::sort(node.readers.begin(), node.readers.end());
+		node.refCount = static_cast<unsigned int>(node.readers.size());
+		node.firstPass = ~0u;
+		node.lastPass = 0;
+		node.physical = ~0u;
+	}
+
+	//未使用パスの除去
+	std::vector<Resource> unused{};
+	auto cullPass = [&](PassNode& pass)
+	{
+		pass.culled = true;
+		for (Resource r : pass.reads)
+		{
+			ResourceNode& node = resources[r];
+			if (node.refCount > 0 && --node.refCount == 0 && !node.imported)
+			{
+				unused.push_back(r);
+			}
+		}
+	};
+	for (PassNode& pass : passes)
+	{
+		bool writesImported = false;
+		for (Resource r : pass.writes) { writesImported |= resources[r].imported; }
+		if (writesImported) { pass.sideEffect = true; }
+		if (pass.refCount == 0 && !pass.sideEffect) { cullPass(pass); }
+	}
+	for (Resource r = 0; r < resources.size(); r++)
+	{
+		if (resources[r].refCount == 0 && !resources[r].imported) { unused.push_back(r); }
+	}
+	while (!unused.empty())
+	{
+		const Resource r = unused.back();
+		unused.pop_back();
+		for (unsigned int writer : resources[r].writers)
+		{
+			PassNode& pass = passes[writer];
+			if (pass.culled) { continue; }
+			if (pass.refCount > 0 && --pass.refCount == 0 && !pass.sideEffect)
+			{
+				cullPass(pass);
+			}
+		}
+	}
+
+	//依存関係の構築
+	std::vector<std::vector<unsigned int>> edges(passCount);
+	std::vector<unsigned int> inDegree(passCount, 0);
+	auto addEdge = [&](unsigned int from, unsigned int to)
+	{
+		if (from == to) { return; }
+		edges[from].push_back(to);
+		inDegree[to]++;
+	};
+	for (Resource r = 0; r < resources.size(); r++)
+	{
+		const ResourceNode& node = resources[r];
+		unsigned int lastWriter = ~0u;
+		std::vector<unsigned int> pendingReaders{};
+		size_t w = 0, rd = 0;
+		// Walk writers and readers together in pass order.
+		while (w < node.writers.size() || rd < node.readers.size())
+		{
+			const bool takeWriter = rd >= node.readers.size() ||
+				(w < node.writers.size() && node.writers[w] < node.readers[rd]);
+			if (takeWriter)
+			{
+				const unsigned int writer = node.writers[w++];
+				if (passes[writer].culled) { continue; }
+				if (lastWriter != ~0u) { addEdge(lastWriter, writer); }
+				for (unsigned int reader : pendingReaders) { addEdge(reader, writer); }
+				pendingReaders.clear();
+				lastWriter = writer;
+			}
+			else
+			{
+				const unsigned int reader = node.readers[rd++];
+				if (passes[reader].culled) { continue; }
+				if (lastWriter != ~0u)
+				{
+					addEdge(lastWriter, reader);
+				}
+				else if (!node.imported)
+				{
+					// A transient layer is read before anything writes it.
+					return Result::uninitializedRead;
+				}
+				pendingReaders.push_back(reader);
+			}
+		}
+	}
+
+	//実行順の決定
+	// Among ready passes, prefer the one whose inputs were produced most recently,
+	// so producers and consumers stay adjacent and transient lifetimes stay short.
+	std::vector<unsigned int> readyTime(passCount, 0);
+	using Entry = std::pair<unsigned int, unsigned int>;
+	auto later = [](const Entry& a, const Entry& b)
+	{
+		if (a.first != b.first) { return a.first < b.first; }
+		return a.second > b.second;
+	};
+	std::priority_queue<Entry, std::vector<Entry>, decltype(later)> ready(later);
+	unsigned int aliveCount = 0;
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		if (passes[p].culled) { continue; }
+		aliveCount++;
+		if (inDegree[p] == 0) { ready.push({ 0, p }); }
+	}
+	order.reserve(aliveCount);
+	while (!ready.empty())
+	{
+		const unsigned int p = ready.top().second;
+		ready.pop();
+		const unsigned int position = static_cast<unsigned int>(order.size());
+		order.push_back(p);
+		for (unsigned int next : edges[p])
+		{
+			readyTime[next] = std::max(readyTime[next], position + 1);
+			if (--inDegree[next] == 0) { ready.push({ readyTime[next], next }); }
+		}
+	}
+	// Every edge points forward in pass order, so this only guards against a broken graph.
+	if (order.size() != aliveCount)
+	{
+		order.clear();
+		return Result::cycle;
+	}
+
+	//寿命の算出
+	for (unsigned int position = 0; position < order.size(); position++)
+	{
+		const PassNode& pass = passes[order[position]];
+		auto touch = [&](Resource r)
+		{
+			ResourceNode& node = resources[r];
+			node.firstPass = std::min(node.firstPass, position);
+			node.lastPass = std::max(node.lastPass, position);
+		};
+		for (Resource r : pass.reads) { touch(r); }
+		for (Resource r : pass.writes) { touch(r); }
+	}
+
+	//物理レイヤーの割り当て
+	std::vector<Resource> transients{};
+	for (Resource r = 0; r < resources.size(); r++)
+	{
+		if (!resources[r].imported && resources[r].firstPass != ~0u) { transients.push_back(r); }
+	}
+	std::sort(transients.begin(), transients.end(), [&](Resource a, Resource b)
+		{
+			return resources[a].firstPass < resources[b].firstPass;
+		});
+	std::vector<unsigned int> physicalLastPass{};
+	for (Resource r : transients)
+	{
+		ResourceNode& node = resources[r];
+		for (unsigned int i = 0; i < physicalLayers.size(); i++)
+		{
+			if (physicalLayers[i] == node.desc && physicalLastPass[i] < node.firstPass)
+			{
+				node.physical = i;
+				break;
+			}
+		}
+		if (node.physical == ~0u)
+		{
+			node.physical = static_cast<unsigned int>(physicalLayers.size());
+			physicalLayers.push_back(node.desc);
+			physicalLastPass.push_back(0);
+		}
+		physicalLastPass[node.physical] = node.lastPass;
+	}
+
+	//ハザードの検出
+	std::vector<unsigned int> boundShaderResources{};
+	std::vector<unsigned int> boundRenderTargets{};
+	for (unsigned int p : order)
+	{
+		PassNode& pass = passes[p];
+		for (Resource r : pass.reads)
+		{
+			const unsigned int key = detail::physicalKey(resources[r], r);
+			if (std::find(boundRenderTargets.begin(), boundRenderTargets.end(), key) != boundRenderTargets.end())
+			{
+				pass.unbindRenderTargets = true;
+			}
+		}
+		for (Resource r : pass.writes)
+		{
+			const unsigned int key = detail::physicalKey(resources[r], r);
+			auto it = std::find(boundShaderResources.begin(), boundShaderResources.end(), key);
+			if (it != boundShaderResources.end())
+			{
+				pass.unbindShaderResources.push_back(r);
+				boundShaderResources.erase(it);
+			}
+		}
+		if (pass.unbindRenderTargets || !pass.writes.empty())
+		{
+			boundRenderTargets.clear();
+		}
+		for (Resource r : pass.writes)
+		{
+			boundRenderTargets.push_back(detail::physicalKey(resources[r], r));
+		}
+		for (Resource r : pass.reads)
+		{
+			boundShaderResources.push_back(detail::physicalKey(resources[r], r));
+		}
+	}
+
+	compiled = true;
+	return Result::ok;
+}
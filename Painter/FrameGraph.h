@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+/****************************************************************
+	Render pass scheduler.
+	Passes declare the layers they read and write, and compile()
+	culls unused passes, orders the rest, assigns physical layers
+	(reusing them between passes whose lifetimes do not overlap)
+	and records where SRV/RTV hazards must be unbound.
+	This part is pure CPU and has no dependency on Direct3D.
+****************************************************************/
+class FrameGraph
+{
+public:
+	using Resource = unsigned int;
+	static constexpr Resource invalidResource = ~0u;
+
+	struct LayerDesc
+	{
+		unsigned int width = 0;
+		unsigned int height = 0;
+		unsigned int format = 28;	// DXGI_FORMAT_R8G8B8A8_UNORM
+
+		bool operator==(const LayerDesc& d)const { return width == d.width && height == d.height && format == d.format; }
+		bool operator!=(const LayerDesc& d)const { return !(*this == d); }
+	};
+
+	struct ResourceNode
+	{
+		std::string name;
+		LayerDesc desc;
+		bool imported = false;
+		unsigned int firstPass = ~0u;	// Position in the compiled order.
+		unsigned int lastPass = 0;
+		unsigned int physical = ~0u;	// Index into physicalLayers, transient resources only.
+		unsigned int refCount = 0;
+		std::vector<unsigned int> writers;
+		std::vector<unsigned int> readers;
+	};
+
+	struct PassNode
+	{
+		std::string name;
+		std::vector<Resource> reads;
+		std::vector<Resource> writes;
+		Resource depth = invalidResource;	// Layer whose depth map is bound, see Builder::writeDepth.
+		bool sideEffect = false;
+		bool culled = false;
+		unsigned int refCount = 0;
+
+		// Filled in by compile().
+		std::vector<Resource> unbindShaderResources;	// Written here while still bound as an SRV.
+		bool unbindRenderTargets = false;				// Reads a layer that the previous pass rendered to.
+	};
+
+	class Builder
+	{
+	private:
+		FrameGraph* graph;
+		unsigned int pass;
+	public:
+		Builder(FrameGraph* graph, unsigned int pass) :graph(graph), pass(pass) {}
+		Resource create(const char* name, const LayerDesc& desc);
+		Resource read(Resource resource);
+		Resource write(Resource resource);
+		// Writes resource and renders with its depth map. At most one per pass;
+		// a pass with a single write and no writeDepth uses that layer's depth.
+		Resource writeDepth(Resource resource);
+		void sideEffect();
+	};
+
+	enum class Result { ok, selfDependency, uninitializedRead, cycle };
+private:
+	std::vector<PassNode> passes;
+	std::vector<ResourceNode> resources;
+	std::vector<unsigned int> order;
+	std::vector<LayerDesc> physicalLayers;
+	bool compiled = false;
+public:
+	FrameGraph() = default;
+	virtual ~FrameGraph() = default;
+
+	unsigned int addPass(const char* name);
+	Builder getBuilder(unsigned int pass) { return Builder(this, pass); }
+	Resource importLayer(const char* name, const LayerDesc& desc);
+
+	Result compile();
+	void clear();
+
+	const std::vector<unsigned int>& getOrder()const { return order; }
+	const std::vector<LayerDesc>& getPhysicalLayers()const { return physicalLayers; }
+	const PassNode& getPass(unsigned int pass)const { return passes[pass]; }
+	const ResourceNode& getResource(Resource resource)const { return resources[resource]; }
+	// Layer whose depth map the pass renders with, invalidResource for none.
+	Resource getDepthTarget(unsigned int pass)const;
+	size_t getPassCount()const { return passes.size(); }
+	size_t getResourceCount()const { return resources.size(); }
+	bool isCompiled()const { return compiled; }
+};
@@ -0,0 +1,161 @@
+﻿#include "FrameGraphExecutor.h"
+#include <algorithm>
+
+namespace detail
+{
+	using GetShaderResources = void (STDMETHODCALLTYPE ID3D11DeviceContext::*)(UINT, UINT, ID3D11ShaderResourceView**);
+	using SetShaderResources = void (STDMETHODCALLTYPE ID3D11DeviceContext::*)(UINT, UINT, ID3D11ShaderResourceView* const*);
+
+	// Clears only the slots of one stage that hold one of views.
+	inline void unbindShaderResources(ID3D11DeviceContext* immediateContext, GetShaderResources get, SetShaderResources set,
+		const std::vector<ID3D11ShaderResourceView*>& views)
+	{
+		ID3D11ShaderResourceView* bound[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+		ID3D11ShaderResourceView* const nullView = nullptr;
+		(immediateContext->*get)(0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, bound);
+		for (UINT slot = 0; slot < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; slot++)
+		{
+			if (!bound[slot]) { continue; }
+			if (std::find(views.begin(), views.end(), bound[slot]) != views.end())
+			{
+				(immediateContext->*set)(slot, 1, &nullView);
+			}
+			bound[slot]->Release();
+		}
+	}
+}
+
+FrameGraphExecutor::Resource FrameGraphExecutor::importLayer(const char* name, Layer* layer)
+{
+	assert(layer && "The layer is invalid.");
+	FrameGraph::LayerDesc desc{};
+	desc.width = static_cast<unsigned int>(layer->viewport.Width);
+	desc.height = static_cast<unsigned int>(layer->viewport.Height);
+	if (layer->colorMap.resource)
+	{
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvd{};
+		layer->colorMap.resource->GetDesc(&srvd);
+		desc.format = static_cast<unsigned int>(srvd.Format);
+	}
+	Resource resource = graph.importLayer(name, desc);
+	if (importedLayers.size() <= resource)
+	{
+		importedLayers.resize(static_cast<size_t>(resource) + 1, nullptr);
+	}
+	importedLayers[resource] = layer;
+	return resource;
+}
+
+void FrameGraphExecutor::addPass(const char* name, const Setup& setup, const Execute& execute)
+{
+	unsigned int pass = graph.addPass(name);
+	FrameGraph::Builder builder = graph.getBuilder(pass);
+	if (setup) { setup(builder); }
+	executes.resize(static_cast<size_t>(pass) + 1);
+	executes[pass] = execute;
+}
+
+FrameGraph::Result FrameGraphExecutor::compile(ID3D11Device* device)
+{
+	assert(device && "The device is invalid.");
+	FrameGraph::Result result = graph.compile();
+	if (result != FrameGraph::Result::ok) { return result; }
+
+	const std::vector<FrameGraph::LayerDesc>& descs = graph.getPhysicalLayers();
+	if (physicalLayers.size() < descs.size())
+	{
+		physicalLayers.resize(descs.size());
+		physicalDescs.resize(descs.size());
+	}
+	for (size_t i = 0; i < descs.size(); i++)
+	{
+		if (physicalLayers[i].colorMap.view && physicalDescs[i] == descs[i]) { continue; }
+		HRESULT hr = createLayer(device, &physicalLayers[i], descs[i].width, descs[i].height, static_cast<DXGI_FORMAT>(descs[i].format));
+		assert(hr == S_OK);
+		physicalDescs[i] = descs[i];
+	}
+	return result;
+}
+
+void FrameGraphExecutor::execute(ID3D11DeviceContext* immediateContext)
+{
+	assert(immediateContext && "The context is invalid.");
+	assert(graph.isCompiled() && "The frame graph has not been compiled.");
+	std::vector<ID3D11ShaderResourceView*> hazardViews{};
+
+	CachedHandle handle = pushCachedComObjects(immediateContext);
+	const std::vector<unsigned int>& order = graph.getOrder();
+	for (unsigned int position = 0; position < order.size(); position++)
+	{
+		const FrameGraph::PassNode& pass = graph.getPass(order[position]);
+
+		if (!pass.unbindShaderResources.empty())
+		{
+			hazardViews.clear();
+			for (Resource r : pass.unbindShaderResources)
+			{
+				Layer* layer = getLayer(r);
+				if (layer->colorMap.resource) { hazardViews.push_back(layer->colorMap.resource.Get()); }
+				if (layer->depthMap.resource) { hazardViews.push_back(layer->depthMap.resource.Get()); }
+			}
+			detail::unbindShaderResources(immediateContext, &ID3D11DeviceContext::VSGetShaderResources, &ID3D11DeviceContext::VSSetShaderResources, hazardViews);
+			detail::unbindShaderResources(immediateContext, &ID3D11DeviceContext::PSGetShaderResources, &ID3D11DeviceContext::PSSetShaderResources, hazardViews);
+			detail::unbindShaderResources(immediateContext, &ID3D11DeviceContext::DSGetShaderResources, &ID3D11DeviceContext::DSSetShaderResources, hazardViews);
+			detail::unbindShaderResources(immediateContext, &ID3D11DeviceContext::HSGetShaderResources, &ID3D11DeviceContext::HSSetShaderResources, hazardViews);
+			detail::unbindShaderResources(immediateContext, &ID3D11DeviceContext::GSGetShaderResources, &ID3D11DeviceContext::GSSetShaderResources, hazardViews);
+		}
+
+		if (!pass.writes.empty())
+		{
+			assert(pass.writes.size() <= D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT && "The pass writes more layers than can be bound at once.");
+			ID3D11RenderTargetView* views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+			UINT viewCount = 0;
+			for (Resource r : pass.writes)
+			{
+				Layer* layer = getLayer(r);
+				const FrameGraph::ResourceNode& node = graph.getResource(r);
+				// Aliased layers hold the previous owner's pixels until first written.
+				if (!node.imported && node.firstPass == position)
+				{
+					layer->clear(immediateContext);
+				}
+				if (viewCount < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT)
+				{
+					views[viewCount++] = layer->colorMap.view.Get();
+				}
+			}
+			const Resource depth = graph.getDepthTarget(order[position]);
+			Layer* target = getLayer(depth != FrameGraph::invalidResource ? depth : pass.writes.front());
+			immediateContext->OMSetRenderTargets(viewCount, views, depth != FrameGraph::invalidResource ? target->depthMap.view.Get() : nullptr);
+			immediateContext->RSSetViewports(1, &target->viewport);
+		}
+		else if (pass.unbindRenderTargets)
+		{
+			immediateContext->OMSetRenderTargets(0, nullptr, nullptr);
+		}
+
+		if (executes[order[position]])
+		{
+			executes[order[position]](immediateContext, *this);
+		}
+	}
+	popCachedComObjects(immediateContext, handle);
+}
+
+void FrameGraphExecutor::reset()
+{
+	graph.clear();
+	executes.clear();
+	importedLayers.clear();
+}
+
+Layer* FrameGraphExecutor::getLayer(Resource resource)
+{
+	const FrameGraph::ResourceNode& node = graph.getResource(resource);
+	if (node.imported)
+	{
+		return importedLayers[resource];
+	}
+	assert(node.physical < physicalLayers.size() && "The resource was culled or not compiled.");
+	return &physicalLayers[node.physical];
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+#include "Painter.h"
+#include "FrameGraph.h"
+#include <functional>
+#include <vector>
+
+/****************************************************************
+	Runs a FrameGraph on a device context.
+	Transient layers are created from the compiled physical layer
+	list and kept between frames while their descriptions match.
+****************************************************************/
+class FrameGraphExecutor
+{
+public:
+	using Resource = FrameGraph::Resource;
+	using Setup = std::function<void(FrameGraph::Builder&)>;
+	using Execute = std::function<void(ID3D11DeviceContext*, FrameGraphExecutor&)>;
+private:
+	FrameGraph graph;
+	std::vector<Execute> executes;
+	std::vector<Layer*> importedLayers;
+	std::vector<Layer> physicalLayers;
+	std::vector<FrameGraph::LayerDesc> physicalDescs;
+public:
+	FrameGraphExecutor() = default;
+	virtual ~FrameGraphExecutor() = default;
+
+	Resource importLayer(const char* name, Layer* layer);
+	void addPass(const char* name, const Setup& setup, const Execute& execute);
+
+	FrameGraph::Result compile(ID3D11Device* device);
+	void execute(ID3D11DeviceContext* immediateContext);
+	void reset();
+
+	Layer* getLayer(Resource resource);
+	const FrameGraph& getGraph()const { return graph; }
+};
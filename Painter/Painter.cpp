@@ -5,7 +5,13 @@
 #include <wrl.h>
 #include <assert.h>
 #include <vector>
+#include <algorithm>
 #include <WICTextureLoader.h>
+#include <unordered_map>
+#include "../func/Frustum.h"
+#include "../func/InputLayoutKey.h"
+#include "../func/MeshLoader.h"
+#include "../func/ParallelFor.h"
 
 #define hrInspection(hr) assert(hr == S_OK)
 
@@ -50,11 +56,82 @@ namespace detail
 		}
 	}
 
+	//リフレクションできなければ全スロットを使うものとして扱う
+	inline void reflectCso(const CsoData& data, ShaderStage stage, ShaderBindings& outBindings)
+	{
+		ShaderReflection reflection;
+		if (reflectShader(data.code, data.length, &reflection) == ShaderReflectResult::ok)
+		{
+			outBindings = reflection.slots;
+			outBindings.stage = stage;
+			return;
+		}
+		outBindings.stage = stage;
+		outBindings.constantBuffers = ~0u;
+		outBindings.shaderResources = ~0ull;
+		outBindings.samplers = ~0u;
+		outBindings.unorderedAccess = ~0u;
+	}
+
+	inline void bindStages(unsigned int stages, bool& useVs, bool& usePs, bool& useDs, bool& useHs, bool& useGs)
+	{
+		useVs = StageBindingTable::hasStage(stages, ShaderStage::vertex);
+		usePs = StageBindingTable::hasStage(stages, ShaderStage::pixel);
+		useDs = StageBindingTable::hasStage(stages, ShaderStage::domain);
+		useHs = StageBindingTable::hasStage(stages, ShaderStage::hull);
+		useGs = StageBindingTable::hasStage(stages, ShaderStage::geometry);
+	}
+
 	using PsCache = map<string, PixelShader>;
-	using VsCache = map<string, VertexShader>;
+	//入力レイアウトを後から作れるようにバイトコードを残す
+	struct VsCacheEntry
+	{
+		VertexShader shader;
+		vector<char> bytecode;
+		vector<InputSignatureElement> signature;
+		bool reflected = false;
+	};
+	using VsCache = map<string, VsCacheEntry>;
+	using InputLayoutCache = unordered_map<InputLayoutKey, ComPtr<ID3D11InputLayout>, InputLayoutKey::Hasher>;
+
+	inline InputLayoutCache& getInputLayoutCache()
+	{
+		static InputLayoutCache inputLayoutCache;
+		return inputLayoutCache;
+	}
+
+	HRESULT getInputLayout(ID3D11Device* device, const VsCacheEntry& entry,
+		const D3D11_INPUT_ELEMENT_DESC* descs, UINT descsArrSize, ID3D11InputLayout** outLayout)
+	{
+		InputLayoutKey key;
+		for (UINT i = 0; i < descsArrSize; i++)
+		{
+			const D3D11_INPUT_ELEMENT_DESC& desc = descs[i];
+			key.addElement(desc.SemanticName, desc.SemanticIndex, desc.Format, desc.InputSlot,
+				desc.AlignedByteOffset, desc.InputSlotClass, desc.InstanceDataStepRate);
+		}
+		if (entry.reflected) { key.addSignature(entry.signature); }
+		else { key.addBytecode(entry.bytecode.data(), entry.bytecode.size()); }
+
+		InputLayoutCache& cache = getInputLayoutCache();
+		auto found = cache.find(key);
+		if (found != cache.end())
+		{
+			*outLayout = found->second.Get();
+			(*outLayout)->AddRef();
+			return S_OK;
+		}
+		ComPtr<ID3D11InputLayout> layout;
+		HRESULT hr = device->CreateInputLayout(descs, descsArrSize, entry.bytecode.data(), entry.bytecode.size(), layout.GetAddressOf());
+		if (FAILED(hr)) { return hr; }
+		cache.emplace(std::move(key), layout);
+		*outLayout = layout.Detach();
+		return hr;
+	}
 	using DsCache = map<string, DomainShader>;
 	using HsCache = map<string, HullShader>;
 	using GsCache = map<string, GeometryShader>;
+	using CsCache = map<string, ComputeShader>;
 
 	HRESULT createTexture2D(ID3D11Device* device,
 		ID3D11Texture2D** texture2D,
@@ -72,7 +149,7 @@ namespace detail
 		desc.Format = format;
 		desc.SampleDesc.Count = 1;
 		desc.Usage = D3D11_USAGE_DEFAULT;
-		if (bindFlag & D3D11_BIND_DEPTH_STENCIL)
+		if (bindFlag & (D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_UNORDERED_ACCESS))
 		{
 			desc.CPUAccessFlags = 0;
 		}
@@ -140,6 +217,120 @@ namespace detail
 		dsvd.Texture2D.MipSlice = 0;
 		return device->CreateDepthStencilView(texture2D, &dsvd, depthStencil);
 	}
+
+	HRESULT createOptimizedIndexBuffer(ID3D11Device* device,
+		IndexBuffer* outIndexBuffer,
+		const UINT* indices,
+		size_t indexCount,
+		bool use16BitIndices)
+	{
+		if (use16BitIndices)
+		{
+			vector<USHORT> shortIndices(indexCount);
+			convertTo16BitIndices(shortIndices.data(), indices, indexCount);
+			return createIndexBuffer(device, outIndexBuffer, (UINT)shortIndices.size(), shortIndices.data());
+		}
+		return createIndexBuffer(device, outIndexBuffer, (UINT)indexCount, indices);
+	}
+
+	//バッファを作り直すたびに新しい値を振る (デバイスのスレッドからのみ呼ばれる)
+	UINT64 makeGeometryId()
+	{
+		static UINT64 lastId = 0;
+		return ++lastId;
+	}
+
+	//LOD列をインデックスの後ろに連結する
+	void buildGeometryLods(Geometry* outGeometry, const vector<Geometry::Vertex>& vertices, vector<UINT>& indices)
+	{
+		const float* positions = vertices.empty() ? nullptr : &vertices[0].position.x;
+		buildLodChain(indices, outGeometry->lods, positions, vertices.size(), sizeof(Geometry::Vertex));
+		computeBoundingSphere(&outGeometry->bounds.x, positions, vertices.size(), sizeof(Geometry::Vertex));
+		vector<Meshlet> meshlets;
+		buildMeshlets(meshlets, indices.data(), outGeometry->getLod(0).indexCount, positions, vertices.size(), sizeof(Geometry::Vertex));
+		outGeometry->meshlets.build(meshlets.data(), meshlets.size());
+	}
+
+	struct PreparedMesh
+	{
+		MeshCache cache;
+		MeshData mesh;
+		vector<MeshLod> lods;
+		vector<Meshlet> meshlets;
+		MeshOptimizeReport report{};
+		HRESULT hr = S_OK;
+	};
+
+	//デバイスを使わない部分(読み込み、最適化、LOD生成)
+	void prepareMesh(const char* path, PreparedMesh* outMesh, bool analyze)
+	{
+		static_assert(sizeof(MeshVertex) == sizeof(Geometry::Vertex), "MeshVertex must match Geometry::Vertex");
+		const string cachePath = string(path) + ".meshcache";
+		if (outMesh->cache.open(cachePath.c_str(), path) && outMesh->cache.getLodCount() > 0)
+		{
+			//キャッシュは最適化済みなのでそのまま転送する
+			const size_t vertexCount = outMesh->cache.getVertexCount();
+			const size_t indexCount = outMesh->cache.getLods()[0].indexCount;
+			outMesh->report.use16BitIndices = fitsIn16BitIndices(vertexCount);
+			if (analyze)
+			{
+				outMesh->report.after = analyzeMesh(outMesh->cache.getIndices(), indexCount, vertexCount, sizeof(Geometry::Vertex));
+				outMesh->report.after.indexBytes = indexCount * (outMesh->report.use16BitIndices ? sizeof(USHORT) : sizeof(UINT));
+				outMesh->report.before = outMesh->report.after;
+			}
+			return;
+		}
+		outMesh->cache.close();
+		MeshLoadResult result = importMesh(path, &outMesh->mesh);
+		if (result == MeshLoadResult::fileNotFound)
+		{
+			outMesh->hr = HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+			return;
+		}
+		if (result != MeshLoadResult::ok || outMesh->mesh.indices.empty())
+		{
+			outMesh->hr = E_FAIL;
+			return;
+		}
+		vector<MeshVertex>& vertices = outMesh->mesh.vertices;
+		vector<UINT>& indices = outMesh->mesh.indices;
+		outMesh->report = optimizeMesh(vertices, indices);
+		buildLodChain(indices, outMesh->lods, vertices[0].position, vertices.size(), sizeof(MeshVertex));
+		buildMeshlets(outMesh->meshlets, indices.data(), outMesh->lods[0].indexCount, vertices[0].position, vertices.size(), sizeof(MeshVertex));
+		saveMeshCache(cachePath.c_str(), path, vertices.data(), vertices.size(), indices.data(), indices.size(),
+			outMesh->lods.data(), outMesh->lods.size(), outMesh->meshlets.data(), outMesh->meshlets.size());
+	}
+
+	HRESULT uploadPreparedMesh(ID3D11Device* device, Geometry* outGeometry, PreparedMesh& mesh)
+	{
+		if (FAILED(mesh.hr)) { return mesh.hr; }
+		const bool cached = mesh.cache.isOpen();
+		const MeshVertex* vertices = cached ? mesh.cache.getVertices() : mesh.mesh.vertices.data();
+		const UINT* indices = cached ? mesh.cache.getIndices() : mesh.mesh.indices.data();
+		const size_t vertexCount = cached ? mesh.cache.getVertexCount() : mesh.mesh.vertices.size();
+		const size_t indexCount = cached ? mesh.cache.getIndexCount() : mesh.mesh.indices.size();
+		if (vertexCount == 0 || indexCount == 0) { return E_FAIL; }
+		if (cached)
+		{
+			outGeometry->lods.assign(mesh.cache.getLods(), mesh.cache.getLods() + mesh.cache.getLodCount());
+			outGeometry->meshlets.build(mesh.cache.getMeshlets(), mesh.cache.getMeshletCount());
+		}
+		else
+		{
+			outGeometry->lods = mesh.lods;
+			outGeometry->meshlets.build(mesh.meshlets.data(), mesh.meshlets.size());
+		}
+		computeBoundingSphere(&outGeometry->bounds.x, vertices[0].position, vertexCount, sizeof(MeshVertex));
+
+		HRESULT hr = createVertexBuffer(device, &outGeometry->vertexBuffer, sizeof(Geometry::Vertex), (UINT)vertexCount, vertices);
+		hrInspection(hr);
+		hr = createOptimizedIndexBuffer(device, &outGeometry->indexBuffer, indices, indexCount, mesh.report.use16BitIndices);
+		hrInspection(hr);
+		outGeometry->quantized = false;
+		XMStoreFloat4x4(&outGeometry->dequantization, XMMatrixIdentity());
+		outGeometry->id = makeGeometryId();
+		return hr;
+	}
 }
 
 void PixelShader::set(ID3D11DeviceContext* immediateContext)
@@ -173,6 +364,12 @@ void GeometryShader::set(ID3D11DeviceContext* immediateContext)
 	immediateContext->GSSetShader(shader.Get(), nullptr, 0);
 }
 
+void ComputeShader::set(ID3D11DeviceContext* immediateContext)
+{
+	assert(immediateContext && "The context is invalid.");
+	immediateContext->CSSetShader(shader.Get(), nullptr, 0);
+}
+
 void ShaderResource::set(ID3D11DeviceContext* immediateContext, UINT slot, bool useVs, bool usePs, bool useDs, bool useHs, bool useGs)
 {
 	assert(immediateContext && "The context is invalid.");
@@ -183,19 +380,69 @@ void ShaderResource::set(ID3D11DeviceContext* immediateContext, UINT slot, bool
 	if (useGs)immediateContext->GSSetShaderResources(slot, 1, resource.GetAddressOf());
 }
 
+void ShaderResource::set(ID3D11DeviceContext* immediateContext, UINT slot, const StageBindingTable& table)
+{
+	bool useVs, usePs, useDs, useHs, useGs;
+	detail::bindStages(table.getShaderResourceStages(slot), useVs, usePs, useDs, useHs, useGs);
+	set(immediateContext, slot, useVs, usePs, useDs, useHs, useGs);
+}
+
+void ShaderResource::setCompute(ID3D11DeviceContext* immediateContext, UINT slot)
+{
+	assert(immediateContext && "The context is invalid.");
+	immediateContext->CSSetShaderResources(slot, 1, resource.GetAddressOf());
+}
+
+void UnorderedAccessResource::setUnorderedAccess(ID3D11DeviceContext* immediateContext, UINT slot, UINT initialCount)
+{
+	assert(immediateContext && "The context is invalid.");
+	immediateContext->CSSetUnorderedAccessViews(slot, 1, unorderedAccess.GetAddressOf(), &initialCount);
+}
+
 void StructuredBuffer::updateSubresource(ID3D11DeviceContext* immediateContext, const void* data)
 {
 	assert(immediateContext && "The context is invalid.");
 	immediateContext->UpdateSubresource(buffer.Get(), 0, 0, data, 0, 0);
 }
 
-void ConstantBuffer::updateSubresource(ID3D11DeviceContext* immediateContext, const void* data)
+void StructuredBuffer::updateSubresource(ID3D11DeviceContext* immediateContext, const void* data, UINT byteOffset, UINT byteSize)
+{
+	assert(immediateContext && "The context is invalid.");
+	const D3D11_BOX box{ byteOffset, 0, 0, byteOffset + byteSize, 1, 1 };
+	immediateContext->UpdateSubresource(buffer.Get(), 0, &box, data, 0, 0);
+}
+
+void RawBuffer::updateSubresource(ID3D11DeviceContext* immediateContext, const void* data)
+{
+	assert(immediateContext && "The context is invalid.");
+	immediateContext->UpdateSubresource(buffer.Get(), 0, 0, data, 0, 0);
+}
+
+void IndirectArgsBuffer::updateSubresource(ID3D11DeviceContext* immediateContext, const void* data)
+{
+	assert(immediateContext && "The context is invalid.");
+	immediateContext->UpdateSubresource(buffer.Get(), 0, 0, data, 0, 0);
+}
+
+void RawConstantBuffer::updateSubresource(ID3D11DeviceContext* immediateContext, const void* data)
 {
 	assert(immediateContext && "The context is invalid.");
+	if (usage == ConstantBufferUsage::dynamic)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped{};
+		HRESULT hr = immediateContext->Map(buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		hrInspection(hr);
+		if (SUCCEEDED(hr))
+		{
+			memcpy(mapped.pData, data, byteWidth);
+			immediateContext->Unmap(buffer.Get(), 0);
+		}
+		return;
+	}
 	immediateContext->UpdateSubresource(buffer.Get(), 0, 0, data, 0, 0);
 }
 
-void ConstantBuffer::set(ID3D11DeviceContext* immediateContext, UINT slot, bool useVs, bool usePs, bool useDs, bool useHs, bool useGs)
+void RawConstantBuffer::set(ID3D11DeviceContext* immediateContext, UINT slot, bool useVs, bool usePs, bool useDs, bool useHs, bool useGs)
 {
 	assert(immediateContext && "The context is invalid.");
 	if (useVs)immediateContext->VSSetConstantBuffers(slot, 1, buffer.GetAddressOf());
@@ -205,6 +452,40 @@ void ConstantBuffer::set(ID3D11DeviceContext* immediateContext, UINT slot, bool
 	if (useGs)immediateContext->GSSetConstantBuffers(slot, 1, buffer.GetAddressOf());
 }
 
+void RawConstantBuffer::set(ID3D11DeviceContext* immediateContext, UINT slot, const StageBindingTable& table)
+{
+	bool useVs, usePs, useDs, useHs, useGs;
+	detail::bindStages(table.getConstantBufferStages(slot), useVs, usePs, useDs, useHs, useGs);
+	set(immediateContext, slot, useVs, usePs, useDs, useHs, useGs);
+}
+
+void RawConstantBuffer::setCompute(ID3D11DeviceContext* immediateContext, UINT slot)
+{
+	assert(immediateContext && "The context is invalid.");
+	immediateContext->CSSetConstantBuffers(slot, 1, buffer.GetAddressOf());
+}
+
+HRESULT FrameConstantBuffer::create(ID3D11Device* device)
+{
+	return createConstantBuffer(device, &buffer, &data);
+}
+
+void FrameConstantBuffer::update(ID3D11DeviceContext* immediateContext)
+{
+	buffer.update(immediateContext, data);
+	set(immediateContext);
+}
+
+void FrameConstantBuffer::set(ID3D11DeviceContext* immediateContext)
+{
+	buffer.set(immediateContext, ConstantSlot::frame, true, true, true, true, true);
+}
+
+void FrameConstantBuffer::set(ID3D11DeviceContext* immediateContext, const StageBindingTable& table)
+{
+	buffer.set(immediateContext, ConstantSlot::frame, table);
+}
+
 void RenderTexture::clear(ID3D11DeviceContext* immediateContext, float r, float g, float b, float a)
 {
 	assert(immediateContext && "The context is invalid.");
@@ -218,6 +499,13 @@ void DepthTexture::clear(ID3D11DeviceContext* immediateContext)
 	immediateContext->ClearDepthStencilView(view.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 }
 
+void Texture::updateSubresource(ID3D11DeviceContext* immediateContext, const void* data, UINT x, UINT y, UINT width, UINT height, UINT rowPitch)
+{
+	assert(immediateContext && "The context is invalid.");
+	const D3D11_BOX box{ x, y, 0, x + width, y + height, 1 };
+	immediateContext->UpdateSubresource(texture.Get(), 0, &box, data, rowPitch, 0);
+}
+
 void Layer::clear(ID3D11DeviceContext* immediateContext, float r, float g, float b, float a)
 {
 	assert(immediateContext && "The context is invalid.");
@@ -237,9 +525,15 @@ void VertexBuffer::set(ID3D11DeviceContext* immediateContext, UINT slot, UINT of
 	immediateContext->IASetVertexBuffers(slot, 1, buffer.GetAddressOf(), &stride, &offset);
 }
 
+void StreamOutputBuffer::setTarget(ID3D11DeviceContext* immediateContext)
+{
+	const UINT offset = 0;
+	immediateContext->SOSetTargets(1, buffer.GetAddressOf(), &offset);
+}
+
 void IndexBuffer::set(ID3D11DeviceContext* immediateContext)
 {
-	immediateContext->IASetIndexBuffer(buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	immediateContext->IASetIndexBuffer(buffer.Get(), format, 0);
 }
 
 void Mesh::set(ID3D11DeviceContext* immediateContext, UINT slot, UINT offset)
@@ -260,6 +554,79 @@ void Geometry::set(ID3D11DeviceContext* immediateContext)
 	indexBuffer.set(immediateContext);
 }
 
+MeshLod Geometry::getLod(UINT lod)const
+{
+	if (lods.empty())
+	{
+		MeshLod full{};
+		full.indexCount = indexBuffer.count;
+		return full;
+	}
+	return lods[lod < lods.size() ? lod : lods.size() - 1];
+}
+
+ObjectConstants makeObjectConstants(const Geometry& geometry, const Float4x4& world, UINT materialIndex)
+{
+	ObjectConstants object;
+	object.world = world;
+	object.materialIndex = materialIndex;
+	if (!geometry.quantized) { return object; }
+	//逆量子化は軸ごとの拡大と平行移動だけなので, 法線はその拡大の逆数を掛ければworldだけを通したのと同じになる
+	XMStoreFloat4x4(&object.world, XMMatrixMultiply(XMLoadFloat4x4(&geometry.dequantization), XMLoadFloat4x4(&world)));
+	object.normalScale = Float3(1.0f / geometry.dequantization._11, 1.0f / geometry.dequantization._22, 1.0f / geometry.dequantization._33);
+	return object;
+}
+
+UINT LodSelector::select(const Geometry& geometry, const Float4x4& world, const Float4x4& view, const Float4x4& projection, float viewportHeight)
+{
+	if (geometry.lods.size() <= 1)
+	{
+		current = 0;
+		return current;
+	}
+	Matrix worldMatrix = XMLoadFloat4x4(&world);
+	XMVECTOR center = XMVector3TransformCoord(XMVectorSet(geometry.bounds.x, geometry.bounds.y, geometry.bounds.z, 1.0f), worldMatrix);
+	center = XMVector3TransformCoord(center, XMLoadFloat4x4(&view));
+	//ワールド行列の最大の拡大率
+	const float worldScale = sqrtf((std::max)(XMVectorGetX(XMVector3LengthSq(worldMatrix.r[0])),
+		(std::max)(XMVectorGetX(XMVector3LengthSq(worldMatrix.r[1])), XMVectorGetX(XMVector3LengthSq(worldMatrix.r[2])))));
+	const float nearest = XMVectorGetZ(center) - geometry.bounds.w * worldScale;
+	if (nearest <= 0.0f)
+	{
+		//カメラが境界球の内側にある
+		current = 0;
+		return current;
+	}
+	const float errorToPixels = worldScale * projection._22 * viewportHeight * 0.5f / nearest;
+	current = selectLod(geometry.lods.data(), geometry.lods.size(), errorToPixels, current, pixelThreshold, hysteresis);
+	return current;
+}
+
+MeshletCullParams getMeshletCullParams(const Float4x4& world, const Float4x4& viewProjection, const Float3* eyePosition)
+{
+	MeshletCullParams params{};
+	Matrix worldMatrix = XMLoadFloat4x4(&world);
+	Float4x4 worldViewProjection = matrixToFloat4x4(worldMatrix * XMLoadFloat4x4(&viewProjection));
+	extractFrustumPlanes(params.planes, &worldViewProjection._11);
+	if (!eyePosition) { return params; }
+	//拡大率が軸ごとに異なると法線コーンが保存されない
+	const float scaleX = XMVectorGetX(XMVector3LengthSq(worldMatrix.r[0]));
+	const float scaleY = XMVectorGetX(XMVector3LengthSq(worldMatrix.r[1]));
+	const float scaleZ = XMVectorGetX(XMVector3LengthSq(worldMatrix.r[2]));
+	const float largest = (std::max)(scaleX, (std::max)(scaleY, scaleZ));
+	const float smallest = (std::min)(scaleX, (std::min)(scaleY, scaleZ));
+	if (smallest <= 0.0f || largest - smallest > largest * 1e-3f) { return params; }
+	XMVECTOR determinant;
+	Matrix inverseWorld = XMMatrixInverse(&determinant, worldMatrix);
+	XMFLOAT3 eye;
+	XMStoreFloat3(&eye, XMVector3TransformCoord(XMLoadFloat3(eyePosition), inverseWorld));
+	params.cameraPosition[0] = eye.x;
+	params.cameraPosition[1] = eye.y;
+	params.cameraPosition[2] = eye.z;
+	params.coneCulling = true;
+	return params;
+}
+
 PipelineState::PipelineState(ID3D11Device* device)
 {
 	HRESULT hr;
@@ -362,6 +729,11 @@ PipelineState::PipelineState(ID3D11Device* device)
 	hr = device->CreateRasterizerState(&rasterizerDesc, rasterizerStates[RasterizerState::solid].GetAddressOf());
 	hrInspection(hr);
 
+	rasterizerDesc.ScissorEnable = TRUE;
+	hr = device->CreateRasterizerState(&rasterizerDesc, rasterizerStates[RasterizerState::scissor].GetAddressOf());
+	hrInspection(hr);
+	rasterizerDesc.ScissorEnable = FALSE;
+
 	rasterizerDesc.FillMode = D3D11_FILL_WIREFRAME;
 	rasterizerDesc.CullMode = D3D11_CULL_NONE;
 	rasterizerDesc.AntialiasedLineEnable = TRUE;
@@ -431,6 +803,18 @@ void Painter::popStates(ID3D11DeviceContext* immediateContext)
 	cachedHandles.pop();
 }
 
+StageBindingTable makeStageBindingTable(const VertexShader* vs, const PixelShader* ps,
+	const DomainShader* ds, const HullShader* hs, const GeometryShader* gs)
+{
+	StageBindingTable table;
+	const BasicShader* shaders[] = { vs,ps,ds,hs,gs };
+	for (const BasicShader* shader : shaders)
+	{
+		if (shader) { table.setStage(shader->bindings); }
+	}
+	return table;
+}
+
 void makeCube(ID3D11Device* device, Geometry* cube)
 {
 	using Vertex = Geometry::Vertex;
@@ -529,8 +913,7 @@ void makeCube(ID3D11Device* device, Geometry* cube)
 	indices[face * 6 + 4] = face * 4 + 2;
 	indices[face * 6 + 5] = face * 4 + 3;
 
-	createVertexBuffer(device, &cube->vertexBuffer, sizeof(Vertex), 24, vertices);
-	createIndexBuffer(device, &cube->indexBuffer, 24, indices);
+	createGeometry(device, cube, vertices, 24, indices, 36);
 }
 
 void makeSphere(ID3D11Device* device, Geometry* sphere, UINT slices, UINT stacks)
@@ -579,8 +962,7 @@ void makeSphere(ID3D11Device* device, Geometry* sphere, UINT slices, UINT stacks
 		}
 	}
 
-	createVertexBuffer(device, &sphere->vertexBuffer, sizeof(Vertex), verticesSize, vertices.data());
-	createIndexBuffer(device, &sphere->indexBuffer, indicesSize, indices.data());
+	createGeometry(device, sphere, vertices.data(), verticesSize, indices.data(), indicesSize);
 }
 
 HRESULT loadPixelShader(ID3D11Device* device, PixelShader* outPs, const char* path)
@@ -599,6 +981,7 @@ HRESULT loadPixelShader(ID3D11Device* device, PixelShader* outPs, const char* pa
 		detail::loadCsoFile(path, csoData);
 		hr = device->CreatePixelShader(csoData.code, csoData.length, nullptr, outPs->shader.ReleaseAndGetAddressOf());
 		hrInspection(hr);
+		detail::reflectCso(csoData, ShaderStage::pixel, outPs->bindings);
 		psCache[path] = (*outPs);
 	}
 	return hr;
@@ -607,33 +990,44 @@ HRESULT loadPixelShader(ID3D11Device* device, PixelShader* outPs, const char* pa
 HRESULT loadVertexShader(ID3D11Device* device,
 	VertexShader* outVs,
 	const char* path,
-	D3D11_INPUT_ELEMENT_DESC* descs,
+	const D3D11_INPUT_ELEMENT_DESC* descs,
 	UINT descsArrSize)
 {
 	assert(device && "The device is invalid.");
 	static detail::VsCache vsCache;
 	HRESULT hr = S_FALSE;
-	if (vsCache.count(path))
+	auto found = vsCache.find(path);
+	if (found != vsCache.end())
 	{
-		(*outVs) = vsCache[path];
 		hr = S_OK;
 	}
 	else
 	{
 		detail::CsoData csoData;
 		detail::loadCsoFile(path, csoData);
-		hr = device->CreateVertexShader(csoData.code, csoData.length, nullptr, outVs->shader.ReleaseAndGetAddressOf());
+		detail::VsCacheEntry entry;
+		hr = device->CreateVertexShader(csoData.code, csoData.length, nullptr, entry.shader.shader.ReleaseAndGetAddressOf());
+		hrInspection(hr);
+		detail::reflectCso(csoData, ShaderStage::vertex, entry.shader.bindings);
+		entry.bytecode.assign(csoData.code, csoData.code + csoData.length);
+		entry.reflected = reflectInputSignature(csoData.code, csoData.length, &entry.signature) == ShaderReflectResult::ok;
+		found = vsCache.emplace(path, std::move(entry)).first;
+	}
+	//シェーダーはパスで, レイアウトは要素記述と入力シグネチャで共有する
+	(*outVs) = found->second.shader;
+	if (descs)
+	{
+		hr = detail::getInputLayout(device, found->second, descs, descsArrSize, outVs->layout.ReleaseAndGetAddressOf());
 		hrInspection(hr);
-		if (descs)
-		{
-			hr = device->CreateInputLayout(descs, descsArrSize, csoData.code, csoData.length, outVs->layout.ReleaseAndGetAddressOf());
-			hrInspection(hr);
-		}
-		vsCache[path] = (*outVs);
 	}
 	return hr;
 }
 
+size_t getInputLayoutCount()
+{
+	return detail::getInputLayoutCache().size();
+}
+
 HRESULT loadDomainShader(ID3D11Device* device, DomainShader* outDs, const char* path)
 {
 	assert(device && "The device is invalid.");
@@ -650,6 +1044,7 @@ HRESULT loadDomainShader(ID3D11Device* device, DomainShader* outDs, const char*
 		detail::loadCsoFile(path, csoData);
 		hr = device->CreateDomainShader(csoData.code, csoData.length, nullptr, outDs->shader.ReleaseAndGetAddressOf());
 		hrInspection(hr);
+		detail::reflectCso(csoData, ShaderStage::domain, outDs->bindings);
 		dsCache[path] = (*outDs);
 	}
 	return hr;
@@ -671,6 +1066,7 @@ HRESULT loadHullShader(ID3D11Device* device, HullShader* outHs, const char* path
 		detail::loadCsoFile(path, csoData);
 		hr = device->CreateHullShader(csoData.code, csoData.length, nullptr, outHs->shader.ReleaseAndGetAddressOf());
 		hrInspection(hr);
+		detail::reflectCso(csoData, ShaderStage::hull, outHs->bindings);
 		hsCache[path] = (*outHs);
 	}
 	return hr;
@@ -692,11 +1088,52 @@ HRESULT loadGeometryShader(ID3D11Device* device, GeometryShader* outGs, const ch
 		detail::loadCsoFile(path, csoData);
 		hr = device->CreateGeometryShader(csoData.code, csoData.length, nullptr, outGs->shader.ReleaseAndGetAddressOf());
 		hrInspection(hr);
+		detail::reflectCso(csoData, ShaderStage::geometry, outGs->bindings);
 		gsCache[path] = (*outGs);
 	}
 	return hr;
 }
 
+HRESULT loadComputeShader(ID3D11Device* device, ComputeShader* outCs, const char* path)
+{
+	assert(device && "The device is invalid.");
+	static detail::CsCache csCache;
+	HRESULT hr = S_FALSE;
+	if (csCache.count(path))
+	{
+		(*outCs) = csCache[path];
+		hr = S_OK;
+	}
+	else
+	{
+		detail::CsoData csoData;
+		detail::loadCsoFile(path, csoData);
+		hr = device->CreateComputeShader(csoData.code, csoData.length, nullptr, outCs->shader.ReleaseAndGetAddressOf());
+		hrInspection(hr);
+		detail::reflectCso(csoData, ShaderStage::compute, outCs->bindings);
+		uint32_t groupSize[3];
+		if (reflectThreadGroupSize(csoData.code, csoData.length, groupSize) == ShaderReflectResult::ok)
+		{
+			for (int i = 0; i < 3; i++) { outCs->threadGroupSize[i] = groupSize[i]; }
+		}
+		csCache[path] = (*outCs);
+	}
+	return hr;
+}
+
+HRESULT createStreamOutputShader(ID3D11Device* device, GeometryShader* outGs, const char* path, const D3D11_SO_DECLARATION_ENTRY* entries, UINT entryCount, UINT stride)
+{
+	assert(device && "The device is invalid.");
+	//宣言ごとに別のシェーダーになるのでキャッシュしない
+	detail::CsoData csoData;
+	detail::loadCsoFile(path, csoData);
+	HRESULT hr = device->CreateGeometryShaderWithStreamOutput(csoData.code, csoData.length,
+		entries, entryCount, &stride, 1, D3D11_SO_NO_RASTERIZED_STREAM, nullptr, outGs->shader.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	detail::reflectCso(csoData, ShaderStage::geometry, outGs->bindings);
+	return hr;
+}
+
 HRESULT loadShaderResource(ID3D11Device* device, ShaderResource* outSr, const wchar_t* path)
 {
 	assert(device && "The device is invalid.");
@@ -760,15 +1197,111 @@ HRESULT createStructuredBuffer(ID3D11Device* device,
 	return hr;
 }
 
-HRESULT createConstantBuffer(ID3D11Device* device, ConstantBuffer* outCb, UINT elementSize, void* initData)
+HRESULT createRWStructuredBuffer(ID3D11Device* device,
+	RWStructuredBuffer* outSb,
+	UINT elementSize,
+	UINT count,
+	const void* initData,
+	bool append)
+{
+	assert(device && "The device is invalid.");
+	D3D11_BUFFER_DESC desc{};
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	desc.ByteWidth = elementSize * count;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = elementSize;
+	D3D11_SUBRESOURCE_DATA subresourceData{};
+	subresourceData.pSysMem = initData;
+	HRESULT hr = device->CreateBuffer(&desc, initData ? &subresourceData : nullptr, outSb->buffer.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.BufferEx.FirstElement = 0;
+	srvDesc.BufferEx.NumElements = count;
+	hr = device->CreateShaderResourceView(outSb->buffer.Get(), &srvDesc, outSb->resource.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+	uavDesc.Buffer.FirstElement = 0;
+	uavDesc.Buffer.NumElements = count;
+	uavDesc.Buffer.Flags = append ? D3D11_BUFFER_UAV_FLAG_APPEND : 0;
+	hr = device->CreateUnorderedAccessView(outSb->buffer.Get(), &uavDesc, outSb->unorderedAccess.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	return hr;
+}
+
+HRESULT createRawBuffer(ID3D11Device* device, RawBuffer* outBuffer, UINT byteWidth, const void* initData)
+{
+	assert(device && "The device is invalid.");
+	assert(byteWidth % 4 == 0 && "The byte width is not a multiple of 4 bytes.");
+	outBuffer->byteWidth = byteWidth;
+	D3D11_BUFFER_DESC desc{};
+	desc.ByteWidth = byteWidth;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+	D3D11_SUBRESOURCE_DATA subresourceData{};
+	subresourceData.pSysMem = initData;
+	HRESULT hr = device->CreateBuffer(&desc, initData ? &subresourceData : nullptr, outBuffer->buffer.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+	srvDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+	srvDesc.BufferEx.FirstElement = 0;
+	srvDesc.BufferEx.NumElements = byteWidth / 4;
+	srvDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+	hr = device->CreateShaderResourceView(outBuffer->buffer.Get(), &srvDesc, outBuffer->resource.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+	uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	uavDesc.Buffer.FirstElement = 0;
+	uavDesc.Buffer.NumElements = byteWidth / 4;
+	uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+	hr = device->CreateUnorderedAccessView(outBuffer->buffer.Get(), &uavDesc, outBuffer->unorderedAccess.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	return hr;
+}
+
+HRESULT createIndirectArgsBuffer(ID3D11Device* device, IndirectArgsBuffer* outBuffer, UINT byteWidth, const void* initData)
+{
+	assert(device && "The device is invalid.");
+	assert(byteWidth % 4 == 0 && "The byte width is not a multiple of 4 bytes.");
+	outBuffer->byteWidth = byteWidth;
+	D3D11_BUFFER_DESC desc{};
+	desc.ByteWidth = byteWidth;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+	D3D11_SUBRESOURCE_DATA subresourceData{};
+	subresourceData.pSysMem = initData;
+	HRESULT hr = device->CreateBuffer(&desc, initData ? &subresourceData : nullptr, outBuffer->buffer.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	//computeからはRWByteAddressBufferとして書き込む
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+	uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	uavDesc.Buffer.FirstElement = 0;
+	uavDesc.Buffer.NumElements = byteWidth / 4;
+	uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+	hr = device->CreateUnorderedAccessView(outBuffer->buffer.Get(), &uavDesc, outBuffer->unorderedAccess.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	return hr;
+}
+
+HRESULT createConstantBuffer(ID3D11Device* device, RawConstantBuffer* outCb, UINT elementSize, const void* initData, ConstantBufferUsage usage)
 {
 	assert(device && "The device is invalid.");
 	assert(elementSize % 16 == 0 && "constant buffer's need to be 16 byte aligned");
 	D3D11_BUFFER_DESC desc = {};
 	desc.ByteWidth = elementSize;
-	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.Usage = usage == ConstantBufferUsage::dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
 	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	desc.CPUAccessFlags = 0;
+	desc.CPUAccessFlags = usage == ConstantBufferUsage::dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
+	outCb->byteWidth = elementSize;
+	outCb->usage = usage;
 	HRESULT hr = S_OK;
 	if (initData)
 	{
@@ -784,15 +1317,57 @@ HRESULT createConstantBuffer(ID3D11Device* device, ConstantBuffer* outCb, UINT e
 	return hr;
 }
 
+HRESULT createTexture(ID3D11Device* device,
+	Texture* outTexture,
+	UINT width, UINT height,
+	DXGI_FORMAT format,
+	const void* initData,
+	UINT rowPitch)
+{
+	assert(device && "The device is invalid.");
+	HRESULT hr;
+	D3D11_SUBRESOURCE_DATA subresourceData{};
+	subresourceData.pSysMem = initData;
+	subresourceData.SysMemPitch = rowPitch;
+	hr = detail::createTexture2D(device, outTexture->texture.ReleaseAndGetAddressOf(), width, height, format, D3D11_BIND_SHADER_RESOURCE, initData ? &subresourceData : nullptr);
+	hrInspection(hr);
+
+	hr = detail::createResource(device, outTexture->texture.Get(), outTexture->resource.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+
+	return hr;
+}
+
+HRESULT createRWTexture(ID3D11Device* device,
+	RWTexture* outTexture,
+	UINT width, UINT height,
+	DXGI_FORMAT format)
+{
+	assert(device && "The device is invalid.");
+	HRESULT hr;
+	hr = detail::createTexture2D(device, outTexture->texture.ReleaseAndGetAddressOf(), width, height, format, D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS, nullptr);
+	hrInspection(hr);
+
+	hr = detail::createResource(device, outTexture->texture.Get(), outTexture->resource.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+
+	hr = device->CreateUnorderedAccessView(outTexture->texture.Get(), nullptr, outTexture->unorderedAccess.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+
+	return hr;
+}
+
 HRESULT createRenderTextrue(ID3D11Device* device,
 	RenderTexture* outRt,
 	UINT width, UINT height,
-	DXGI_FORMAT format)
+	DXGI_FORMAT format,
+	bool unorderedAccess)
 {
 	assert(device && "The device is invalid.");
 	HRESULT hr;
 	ID3D11Texture2D* texture2D;
-	hr = detail::createTexture2D(device, &texture2D, width, height, format, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, nullptr);
+	const UINT bindFlag = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE | (unorderedAccess ? D3D11_BIND_UNORDERED_ACCESS : 0);
+	hr = detail::createTexture2D(device, &texture2D, width, height, format, bindFlag, nullptr);
 	hrInspection(hr);
 
 	hr = detail::createResource(device, texture2D, outRt->resource.ReleaseAndGetAddressOf());
@@ -801,6 +1376,13 @@ HRESULT createRenderTextrue(ID3D11Device* device,
 	hr = detail::createRenderTarget(device, texture2D, outRt->view.ReleaseAndGetAddressOf());
 	hrInspection(hr);
 
+	outRt->unorderedAccess.Reset();
+	if (unorderedAccess)
+	{
+		hr = device->CreateUnorderedAccessView(texture2D, nullptr, outRt->unorderedAccess.ReleaseAndGetAddressOf());
+		hrInspection(hr);
+	}
+
 	texture2D->Release();
 
 	return hr;
@@ -868,9 +1450,38 @@ HRESULT createVertexBuffer(ID3D11Device* device, VertexBuffer* outVertexBuffer,
 	return hr;
 }
 
+HRESULT createStreamOutputBuffer(ID3D11Device* device, StreamOutputBuffer* outBuffer, UINT stride, UINT count, bool shaderResource)
+{
+	assert(stride % 4 == 0 && "The stride is not a multiple of 4 bytes.");
+	outBuffer->stride = stride;
+	outBuffer->count = count;
+	D3D11_BUFFER_DESC bufferDesc{};
+	bufferDesc.ByteWidth = stride * count;
+	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_STREAM_OUTPUT | (shaderResource ? D3D11_BIND_SHADER_RESOURCE : 0);
+	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.MiscFlags = shaderResource ? D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS : 0;
+	bufferDesc.StructureByteStride = 0;
+	HRESULT hr = device->CreateBuffer(&bufferDesc, nullptr, outBuffer->buffer.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	outBuffer->view.resource.Reset();
+	if (FAILED(hr) || !shaderResource) { return hr; }
+	//シェーダーから頂点を直接読むためのByteAddressBuffer
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+	srvDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+	srvDesc.BufferEx.FirstElement = 0;
+	srvDesc.BufferEx.NumElements = bufferDesc.ByteWidth / 4;
+	srvDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+	hr = device->CreateShaderResourceView(outBuffer->buffer.Get(), &srvDesc, outBuffer->view.resource.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	return hr;
+}
+
 HRESULT createIndexBuffer(ID3D11Device* device, IndexBuffer* outIndexBuffer, UINT count, const UINT* initialValue)
 {
 	outIndexBuffer->count = count;
+	outIndexBuffer->format = DXGI_FORMAT_R32_UINT;
 	D3D11_BUFFER_DESC bufferDesc{};
 	bufferDesc.ByteWidth = sizeof(UINT) * count;
 	bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
@@ -886,3 +1497,147 @@ HRESULT createIndexBuffer(ID3D11Device* device, IndexBuffer* outIndexBuffer, UIN
 	hrInspection(hr);
 	return hr;
 }
+
+HRESULT createIndexBuffer(ID3D11Device* device, IndexBuffer* outIndexBuffer, UINT count, const USHORT* initialValue)
+{
+	outIndexBuffer->count = count;
+	outIndexBuffer->format = DXGI_FORMAT_R16_UINT;
+	D3D11_BUFFER_DESC bufferDesc{};
+	bufferDesc.ByteWidth = sizeof(USHORT) * count;
+	bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+	D3D11_SUBRESOURCE_DATA subresourceData{};
+	subresourceData.pSysMem = initialValue;
+	subresourceData.SysMemPitch = 0;
+	subresourceData.SysMemSlicePitch = 0;
+	HRESULT hr = device->CreateBuffer(&bufferDesc, &subresourceData, outIndexBuffer->buffer.ReleaseAndGetAddressOf());
+	hrInspection(hr);
+	return hr;
+}
+
+HRESULT createGeometry(ID3D11Device* device,
+	Geometry* outGeometry,
+	const Geometry::Vertex* vertices, UINT vertexCount,
+	const UINT* indices, UINT indexCount,
+	MeshOptimizeReport* outReport)
+{
+	assert(device && "The device is invalid.");
+	std::vector<Geometry::Vertex> optimizedVertices(vertices, vertices + vertexCount);
+	std::vector<UINT> optimizedIndices(indices, indices + indexCount);
+	MeshOptimizeReport report = optimizeMesh(optimizedVertices, optimizedIndices);
+	if (outReport) { (*outReport) = report; }
+	detail::buildGeometryLods(outGeometry, optimizedVertices, optimizedIndices);
+
+	HRESULT hr = createVertexBuffer(device, &outGeometry->vertexBuffer, sizeof(Geometry::Vertex), (UINT)optimizedVertices.size(), optimizedVertices.data());
+	hrInspection(hr);
+	hr = detail::createOptimizedIndexBuffer(device, &outGeometry->indexBuffer, optimizedIndices.data(), optimizedIndices.size(), report.use16BitIndices);
+	hrInspection(hr);
+	outGeometry->quantized = false;
+	XMStoreFloat4x4(&outGeometry->dequantization, XMMatrixIdentity());
+	outGeometry->id = detail::makeGeometryId();
+	return hr;
+}
+
+HRESULT createQuantizedGeometry(ID3D11Device* device,
+	Geometry* outGeometry,
+	const Geometry::Vertex* vertices, UINT vertexCount,
+	const UINT* indices, UINT indexCount,
+	MeshOptimizeReport* outReport)
+{
+	assert(device && "The device is invalid.");
+	assert(vertexCount > 0 && "The geometry is empty.");
+	std::vector<Geometry::Vertex> optimizedVertices(vertices, vertices + vertexCount);
+	std::vector<UINT> optimizedIndices(indices, indices + indexCount);
+	MeshOptimizeReport report = optimizeMesh(optimizedVertices, optimizedIndices);
+	detail::buildGeometryLods(outGeometry, optimizedVertices, optimizedIndices);
+
+	const size_t count = optimizedVertices.size();
+	QuantizationBounds bounds = computeQuantizationBounds(&optimizedVertices[0].position.x, count, sizeof(Geometry::Vertex));
+	std::vector<Geometry::QuantizedVertex> quantizedVertices(count);
+	quantizeVertices(quantizedVertices.data(), optimizedVertices.data(), count, sizeof(Geometry::Vertex), offsetof(Geometry::Vertex, normal), bounds);
+	report.after.vertexBytes = count * sizeof(Geometry::QuantizedVertex);
+	if (outReport) { (*outReport) = report; }
+
+	HRESULT hr = createVertexBuffer(device, &outGeometry->vertexBuffer, sizeof(Geometry::QuantizedVertex), (UINT)count, quantizedVertices.data());
+	hrInspection(hr);
+	hr = detail::createOptimizedIndexBuffer(device, &outGeometry->indexBuffer, optimizedIndices.data(), optimizedIndices.size(), report.use16BitIndices);
+	hrInspection(hr);
+	outGeometry->quantized = true;
+	getDequantizationMatrix(&outGeometry->dequantization._11, bounds);
+	outGeometry->id = detail::makeGeometryId();
+	return hr;
+}
+
+HRESULT loadGeometry(ID3D11Device* device,
+	Geometry* outGeometry,
+	const char* path,
+	MeshOptimizeReport* outReport)
+{
+	assert(device && "The device is invalid.");
+	detail::PreparedMesh mesh;
+	detail::prepareMesh(path, &mesh, outReport != nullptr);
+	if (outReport) { (*outReport) = mesh.report; }
+	return detail::uploadPreparedMesh(device, outGeometry, mesh);
+}
+
+HRESULT loadGeometries(ID3D11Device* device,
+	Geometry* outGeometries,
+	const char* const* paths,
+	UINT count)
+{
+	assert(device && "The device is invalid.");
+	std::vector<detail::PreparedMesh> meshes(count);
+	parallelFor(count, 1, [&](size_t i) { detail::prepareMesh(paths[i], &meshes[i], false); });
+	HRESULT result = S_OK;
+	for (UINT i = 0; i < count; i++)
+	{
+		HRESULT hr = detail::uploadPreparedMesh(device, &outGeometries[i], meshes[i]);
+		if (FAILED(hr) && SUCCEEDED(result)) { result = hr; }
+	}
+	return result;
+}
+
+void dispatchThreads(ID3D11DeviceContext* immediateContext, const ComputeShader& shader, UINT x, UINT y, UINT z)
+{
+	assert(immediateContext && "The context is invalid.");
+	const DispatchIndirectArgs groups = getDispatchArgs(x, y, z, shader.threadGroupSize);
+	assert(groups.threadGroupCountX <= maxThreadGroupsPerDimension && groups.threadGroupCountY <= maxThreadGroupsPerDimension &&
+		groups.threadGroupCountZ <= maxThreadGroupsPerDimension && "Too many thread groups in one dimension.");
+	if (groups.threadGroupCountX == 0 || groups.threadGroupCountY == 0 || groups.threadGroupCountZ == 0) { return; }
+	immediateContext->Dispatch(groups.threadGroupCountX, groups.threadGroupCountY, groups.threadGroupCountZ);
+}
+
+void dispatchIndirect(ID3D11DeviceContext* immediateContext, const IndirectArgsBuffer& args, UINT byteOffset)
+{
+	assert(immediateContext && "The context is invalid.");
+	assert(byteOffset % 4 == 0 && byteOffset + sizeof(DispatchIndirectArgs) <= args.byteWidth && "The indirect argument offset is invalid.");
+	immediateContext->DispatchIndirect(args.buffer.Get(), byteOffset);
+}
+
+void drawInstancedIndirect(ID3D11DeviceContext* immediateContext, const IndirectArgsBuffer& args, UINT byteOffset)
+{
+	assert(immediateContext && "The context is invalid.");
+	assert(byteOffset % 4 == 0 && byteOffset + sizeof(DrawInstancedIndirectArgs) <= args.byteWidth && "The indirect argument offset is invalid.");
+	immediateContext->DrawInstancedIndirect(args.buffer.Get(), byteOffset);
+}
+
+void drawIndexedInstancedIndirect(ID3D11DeviceContext* immediateContext, const IndirectArgsBuffer& args, UINT byteOffset)
+{
+	assert(immediateContext && "The context is invalid.");
+	assert(byteOffset % 4 == 0 && byteOffset + sizeof(DrawIndexedInstancedIndirectArgs) <= args.byteWidth && "The indirect argument offset is invalid.");
+	immediateContext->DrawIndexedInstancedIndirect(args.buffer.Get(), byteOffset);
+}
+
+void clearComputeBindings(ID3D11DeviceContext* immediateContext, UINT unorderedAccessCount, UINT shaderResourceCount)
+{
+	assert(immediateContext && "The context is invalid.");
+	assert(unorderedAccessCount <= D3D11_PS_CS_UAV_REGISTER_COUNT && shaderResourceCount <= D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT && "Too many slots.");
+	//書き込み中のリソースは他のステージにバインドできないので外す
+	ID3D11UnorderedAccessView* const nullUavs[D3D11_PS_CS_UAV_REGISTER_COUNT] = {};
+	ID3D11ShaderResourceView* const nullSrvs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+	if (unorderedAccessCount > 0) { immediateContext->CSSetUnorderedAccessViews(0, unorderedAccessCount, nullUavs, nullptr); }
+	if (shaderResourceCount > 0) { immediateContext->CSSetShaderResources(0, shaderResourceCount, nullSrvs); }
+}
@@ -4,13 +4,25 @@
 #include <assert.h>
 #include <map>
 #include <stack>
+#include <vector>
 #include "../func/Arithmetic.h"
+#include "../func/ComputeReference.h"
+#include "../func/ConstantShadow.h"
+#include "../func/MeshOptimizer.h"
+#include "../func/MeshSimplifier.h"
+#include "../func/Meshlet.h"
+#include "../func/SceneTree.h"
+#include "../func/ShaderReflection.h"
+#include "../func/VertexQuantization.h"
 #include "CachedComObjects.h"
+#include "ConstantArena.h"
 
 using Microsoft::WRL::ComPtr;
 
 struct BasicShader
 {
+	//Slots the shader reads, reflected from its bytecode at load time
+	ShaderBindings bindings;
 	virtual ~BasicShader() = default;
 	virtual void set(ID3D11DeviceContext*) = 0;
 };
@@ -47,6 +59,14 @@ struct GeometryShader :public BasicShader
 	void set(ID3D11DeviceContext* immediateContext)override;
 };
 
+struct ComputeShader :public BasicShader
+{
+	ComPtr<ID3D11ComputeShader> shader;
+	//[numthreads], reflected from the bytecode at load time
+	UINT threadGroupSize[3] = { 1, 1, 1 };
+	void set(ID3D11DeviceContext* immediateContext)override;
+};
+
 struct ShaderResource
 {
 	ComPtr<ID3D11ShaderResourceView> resource;
@@ -57,17 +77,59 @@ struct ShaderResource
 		bool useDs = true,
 		bool useHs = true,
 		bool useGs = true);
+	//Binds only to the stages of table that read slot
+	void set(ID3D11DeviceContext* immediateContext, UINT slot, const StageBindingTable& table);
+	void setCompute(ID3D11DeviceContext* immediateContext, UINT slot);
+};
+
+//Writable view for compute shaders (RWStructuredBuffer, RWByteAddressBuffer, RWTexture2D)
+struct UnorderedAccessResource
+{
+	ComPtr<ID3D11UnorderedAccessView> unorderedAccess;
+	//initialCount resets the hidden counter of an append buffer (-1 keeps it)
+	void setUnorderedAccess(ID3D11DeviceContext* immediateContext, UINT slot, UINT initialCount = UINT(-1));
 };
 
 struct StructuredBuffer :public ShaderResource
 {
 	ComPtr<ID3D11Buffer> buffer;
 	void updateSubresource(ID3D11DeviceContext* immediateContext, const void* data);
+	//Updates byteSize bytes starting at byteOffset
+	void updateSubresource(ID3D11DeviceContext* immediateContext, const void* data, UINT byteOffset, UINT byteSize);
+};
+
+//StructuredBuffer that compute shaders can also write
+struct RWStructuredBuffer :public StructuredBuffer, public UnorderedAccessResource {};
+
+//ByteAddressBuffer / RWByteAddressBuffer
+struct RawBuffer :public ShaderResource, public UnorderedAccessResource
+{
+	ComPtr<ID3D11Buffer> buffer;
+	UINT byteWidth = 0;
+	void updateSubresource(ID3D11DeviceContext* immediateContext, const void* data);
 };
 
-struct ConstantBuffer
+//Arguments of DispatchIndirect / DrawInstancedIndirect (ComputeReference.h), writable by compute as RWByteAddressBuffer
+struct IndirectArgsBuffer :public UnorderedAccessResource
 {
 	ComPtr<ID3D11Buffer> buffer;
+	UINT byteWidth = 0;
+	void updateSubresource(ID3D11DeviceContext* immediateContext, const void* data);
+};
+
+enum class ConstantBufferUsage
+{
+	//UpdateSubresource
+	common,
+	//Map / WRITE_DISCARD
+	dynamic,
+};
+
+struct RawConstantBuffer
+{
+	ComPtr<ID3D11Buffer> buffer;
+	UINT byteWidth = 0;
+	ConstantBufferUsage usage = ConstantBufferUsage::common;
 	void updateSubresource(ID3D11DeviceContext* immediateContext, const void* data);
 
 	void set(ID3D11DeviceContext* immediateContext,
@@ -77,10 +139,64 @@ struct ConstantBuffer
 		bool useDs = true,
 		bool useHs = true,
 		bool useGs = true);
+	//Binds only to the stages of table that read slot
+	void set(ID3D11DeviceContext* immediateContext, UINT slot, const StageBindingTable& table);
+	void setCompute(ID3D11DeviceContext* immediateContext, UINT slot);
 };
 
+/****************************************************************
+	Typed constant buffer with a shadow copy of its contents.
+	update uploads only when the data differs from the last upload
+	and counts the skipped ones. T is checked against the HLSL size
+	rule at compile time; use HLSL_PACKING_CHECK for its members.
+****************************************************************/
+template<class T>
+class ConstantBuffer;
+template<class T>
+HRESULT createConstantBuffer(ID3D11Device* device, ConstantBuffer<T>* outCb, const T* initData = nullptr, ConstantBufferUsage usage = ConstantBufferUsage::common);
 
-struct RenderTexture :public ShaderResource
+template<class T>
+class ConstantBuffer
+{
+private:
+	RawConstantBuffer raw;
+	ConstantShadow<T> shadow;
+	template<class U>
+	friend HRESULT createConstantBuffer(ID3D11Device*, ConstantBuffer<U>*, const U*, ConstantBufferUsage);
+public:
+	//Returns true if the data was uploaded
+	bool update(ID3D11DeviceContext* immediateContext, const T& data)
+	{
+		if (!shadow.update(data)) { return false; }
+		raw.updateSubresource(immediateContext, &data);
+		return true;
+	}
+	void set(ID3D11DeviceContext* immediateContext,
+		UINT slot,
+		bool useVs = true,
+		bool usePs = true,
+		bool useDs = true,
+		bool useHs = true,
+		bool useGs = true)
+	{
+		raw.set(immediateContext, slot, useVs, usePs, useDs, useHs, useGs);
+	}
+	void set(ID3D11DeviceContext* immediateContext, UINT slot, const StageBindingTable& table)
+	{
+		raw.set(immediateContext, slot, table);
+	}
+	void setCompute(ID3D11DeviceContext* immediateContext, UINT slot) { raw.setCompute(immediateContext, slot); }
+	//Forces the next update to upload (e.g. after the buffer was written elsewhere)
+	void invalidate() { shadow.invalidate(); }
+	ID3D11Buffer* getBuffer()const { return raw.buffer.Get(); }
+	const ConstantShadow<T>& getShadow()const { return shadow; }
+	size_t getUploadCount()const { return shadow.getUploadCount(); }
+	size_t getSkipCount()const { return shadow.getSkipCount(); }
+};
+
+
+//unorderedAccess is created only on request (createRenderTextrue)
+struct RenderTexture :public ShaderResource, public UnorderedAccessResource
 {
 	ComPtr<ID3D11RenderTargetView> view;
 	void clear(ID3D11DeviceContext* immediateContext, float r = 0, float g = 0, float b = 0, float a = 0);
@@ -92,6 +208,17 @@ struct DepthTexture :public ShaderResource
 	void clear(ID3D11DeviceContext* immediateContext);
 };
 
+//Texture the CPU rewrites in parts
+struct Texture :public ShaderResource
+{
+	ComPtr<ID3D11Texture2D> texture;
+	//Updates the rectangle [x, x + width) * [y, y + height); rowPitch is in bytes
+	void updateSubresource(ID3D11DeviceContext* immediateContext, const void* data, UINT x, UINT y, UINT width, UINT height, UINT rowPitch);
+};
+
+//Texture compute shaders write through RWTexture2D
+struct RWTexture :public Texture, public UnorderedAccessResource {};
+
 struct Layer
 {
 	RenderTexture colorMap;
@@ -101,6 +228,61 @@ struct Layer
 	void switching(ID3D11DeviceContext* immediateContext);
 };
 
+/****************************************************************
+	Element descriptions derived from a vertex struct.
+	The format comes from the member type, the offset from the
+	member pointer:
+		InputElements<Geometry::Vertex>()
+			.add("POSITION", &Geometry::Vertex::position)
+			.add("NORMAL", &Geometry::Vertex::normal)
+	Packed members (UNORM, SNORM) pass the format explicitly.
+****************************************************************/
+template<class T>
+struct InputFormat;
+template<> struct InputFormat<float> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32_FLOAT; };
+template<> struct InputFormat<Float2> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32G32_FLOAT; };
+template<> struct InputFormat<Float3> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32G32B32_FLOAT; };
+template<> struct InputFormat<Float4> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32G32B32A32_FLOAT; };
+template<> struct InputFormat<UINT> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32_UINT; };
+template<> struct InputFormat<INT> { static constexpr DXGI_FORMAT value = DXGI_FORMAT_R32_SINT; };
+
+template<class Vertex>
+class InputElements
+{
+private:
+	std::vector<D3D11_INPUT_ELEMENT_DESC> descs;
+	UINT slot;
+	D3D11_INPUT_CLASSIFICATION classification;
+	UINT stepRate;
+
+	template<class M>
+	static UINT offsetOf(M Vertex::* member)
+	{
+		alignas(Vertex) static const unsigned char storage[sizeof(Vertex)] = {};
+		const Vertex* vertex = reinterpret_cast<const Vertex*>(storage);
+		return static_cast<UINT>(reinterpret_cast<const unsigned char*>(&(vertex->*member)) - storage);
+	}
+public:
+	//Per-instance elements: InputElements<Instance>(1, D3D11_INPUT_PER_INSTANCE_DATA, 1)
+	explicit InputElements(UINT inputSlot = 0, D3D11_INPUT_CLASSIFICATION inputClass = D3D11_INPUT_PER_VERTEX_DATA, UINT instanceStepRate = 0)
+		:slot(inputSlot), classification(inputClass), stepRate(instanceStepRate) {}
+
+	template<class M>
+	InputElements& add(const char* semanticName, M Vertex::* member, UINT semanticIndex = 0)
+	{
+		return add(semanticName, member, InputFormat<M>::value, semanticIndex);
+	}
+	template<class M>
+	InputElements& add(const char* semanticName, M Vertex::* member, DXGI_FORMAT format, UINT semanticIndex = 0)
+	{
+		descs.push_back({ semanticName, semanticIndex, format, slot, offsetOf(member), classification, stepRate });
+		return *this;
+	}
+
+	const D3D11_INPUT_ELEMENT_DESC* data()const { return descs.data(); }
+	UINT size()const { return static_cast<UINT>(descs.size()); }
+};
+
 struct VertexBuffer
 {
 	ComPtr<ID3D11Buffer> buffer;
@@ -109,10 +291,20 @@ struct VertexBuffer
 	void set(ID3D11DeviceContext* immediateContext, UINT slot, UINT offset = 0);
 };
 
+//Vertex buffer that the stream output stage writes; count is the capacity in vertices
+struct StreamOutputBuffer :public VertexBuffer
+{
+	//ByteAddressBuffer view, created only when requested
+	ShaderResource view;
+	//Binds the buffer as stream output target 0, appending from the start
+	void setTarget(ID3D11DeviceContext* immediateContext);
+};
+
 struct IndexBuffer
 {
 	ComPtr<ID3D11Buffer> buffer;
 	UINT count = 0;
+	DXGI_FORMAT format = DXGI_FORMAT_R32_UINT;
 	void set(ID3D11DeviceContext* immediateContext);
 };
 
@@ -130,15 +322,53 @@ struct Geometry
 		Float3 position;
 		Float3 normal;
 	};
+	using QuantizedVertex = ::QuantizedVertex;
 	VertexBuffer vertexBuffer{};
 	IndexBuffer indexBuffer{};
+	bool quantized = false;
+	Float4x4 dequantization = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+	//lods[0] is the full detail level
+	std::vector<MeshLod> lods{};
+	//xyz = center, w = radius (object space)
+	Float4 bounds = { 0,0,0,0 };
+	//clusters of lods[0], empty when the geometry has none
+	MeshletCullData meshlets{};
+	//new value each time the buffers are created, so caches keyed on it notice a rebuild or a reused address
+	UINT64 id = 0;
 	void set(ID3D11DeviceContext* immediateContext);
+	MeshLod getLod(UINT lod)const;
+	UINT getLodCount()const { return lods.empty() ? 1 : (UINT)lods.size(); }
+	//world-space box of bounds, for SceneTree
+	SceneAabb getWorldBounds(const Float4x4& world)const { return transformBoundingSphere(&bounds.x, &world._11); }
+};
+
+/****************************************************************
+	Screen-size LOD selection with hysteresis, one per drawn object.
+	view / projection come from CameraControl::getView / getProjection.
+****************************************************************/
+class LodSelector
+{
+private:
+	UINT current = 0;
+public:
+	float pixelThreshold = 1.0f;
+	float hysteresis = 0.25f;
+	UINT select(const Geometry& geometry, const Float4x4& world, const Float4x4& view, const Float4x4& projection, float viewportHeight);
+	UINT getCurrent()const { return current; }
 };
 
+/****************************************************************
+	Object-space meshlet culling input for one drawn object.
+	Cone culling needs eyePosition and is skipped for non-uniform
+	world scales, where object-space normals are not preserved.
+****************************************************************/
+MeshletCullParams getMeshletCullParams(const Float4x4& world, const Float4x4& viewProjection, const Float3* eyePosition = nullptr);
+
 enum class SamplerState { point, linear, anisotropic };
 enum class DepthStencilState { none, common };
 enum class BlendState { none, alpha, add };
-enum class RasterizerState { solid, wireframe };
+//scissor = solid with the scissor test (RSSetScissorRects)
+enum class RasterizerState { solid, wireframe, scissor };
 
 class PipelineState
 {
@@ -172,34 +402,175 @@ public:
 	virtual ~PipelineState() = default;
 };
 
+/****************************************************************
+	Constant blocks by update frequency, shared by the painters and
+	example/shader/Constants.hlsli. Each block has a fixed slot:
+		frame			once per frame (FrameConstantBuffer)
+		pass			painter settings, rarely changed
+		material		colors indexed by ObjectConstants
+		object			world matrix and material index per draw
+	Quantized geometry has no block of its own: its dequantization
+	is folded into world on the CPU (makeObjectConstants).
+****************************************************************/
+namespace ConstantSlot
+{
+	constexpr UINT frame = 0;
+	constexpr UINT pass = 1;
+	constexpr UINT material = 2;
+	constexpr UINT object = 3;
+}
+
+struct FrameConstants
+{
+	Float4x4 viewProjection = {};
+	Float3 eyePos = { 0,0,0 };
+	float padding0 = 0;
+	Float3 lightDir = { 0,-1,0 };
+	float padding1 = 0;
+};
+HLSL_PACKING_CHECK(FrameConstants, eyePos);
+HLSL_PACKING_CHECK(FrameConstants, lightDir);
+
+constexpr UINT maxMaterials = 64;
+struct MaterialConstants
+{
+	Float4 colors[maxMaterials];
+	MaterialConstants() { for (Float4& color : colors) { color = Float4(1, 1, 1, 1); } }
+};
+
+struct ObjectConstants
+{
+	Float4x4 world = {};
+	UINT materialIndex = 0;
+	//normals are multiplied by this before world, undoing the dequantization scale folded into it
+	Float3 normalScale = { 1,1,1 };
+};
+HLSL_PACKING_CHECK(ObjectConstants, normalScale);
+//world of geometry with its dequantization folded in (world itself for float vertices)
+ObjectConstants makeObjectConstants(const Geometry& geometry, const Float4x4& world, UINT materialIndex = 0);
+
+/****************************************************************
+	Owner of the frame block. Set data and call update once per
+	frame; painters given it with setFrame bind it without uploading.
+****************************************************************/
+class FrameConstantBuffer
+{
+private:
+	ConstantBuffer<FrameConstants> buffer;
+public:
+	FrameConstants data;
+
+	HRESULT create(ID3D11Device* device);
+	//Uploads data if it changed and binds it to every stage
+	void update(ID3D11DeviceContext* immediateContext);
+	void set(ID3D11DeviceContext* immediateContext);
+	void set(ID3D11DeviceContext* immediateContext, const StageBindingTable& table);
+	size_t getUploadCount()const { return buffer.getUploadCount(); }
+};
+
 class Painter : public PipelineState
 {
 private:
 	std::stack<CachedHandle> cachedHandles;
+	ConstantArena* constantArena = nullptr;
+protected:
+	FrameConstantBuffer* frame = nullptr;
+	//Binds data from the frame arena when there is one, otherwise through buffer
+	template<class T>
+	void bindConstants(ID3D11DeviceContext* immediateContext, ConstantBuffer<T>* buffer, const T& data,
+		UINT slot, bool useVs, bool usePs, bool useDs, bool useHs, bool useGs)
+	{
+		if (constantArena && constantArena->bind(immediateContext, slot, data, useVs, usePs, useDs, useHs, useGs)) { return; }
+		buffer->update(immediateContext, data);
+		buffer->set(immediateContext, slot, useVs, usePs, useDs, useHs, useGs);
+	}
+	template<class T>
+	void bindConstants(ID3D11DeviceContext* immediateContext, ConstantBuffer<T>* buffer, const T& data,
+		UINT slot, const StageBindingTable& table)
+	{
+		const unsigned int stages = table.getConstantBufferStages(slot);
+		if (!stages) { return; }
+		bindConstants(immediateContext, buffer, data, slot,
+			StageBindingTable::hasStage(stages, ShaderStage::vertex),
+			StageBindingTable::hasStage(stages, ShaderStage::pixel),
+			StageBindingTable::hasStage(stages, ShaderStage::domain),
+			StageBindingTable::hasStage(stages, ShaderStage::hull),
+			StageBindingTable::hasStage(stages, ShaderStage::geometry));
+	}
 public:
 	Painter(ID3D11Device* device) :PipelineState(device) {}
 	virtual ~Painter() = default;
+	//Shared per-frame constants (null = each painter uploads its own buffers)
+	void setConstantArena(ConstantArena* arena) { constantArena = arena; }
+	//Frame block (viewProjection, eyePos, lightDir) used by the 3D painters
+	void setFrame(FrameConstantBuffer* frameConstants) { frame = frameConstants; }
 	virtual void drawBegin(ID3D11DeviceContext* immediateContext);
 	virtual void drawEnd(ID3D11DeviceContext* immediateContext);
 	virtual void pushStates(ID3D11DeviceContext* immediateContext)final;
 	virtual void popStates(ID3D11DeviceContext* immediateContext)final;
 };
 
+//Stages of a pipeline that read each slot (null = stage not used)
+StageBindingTable makeStageBindingTable(const VertexShader* vs, const PixelShader* ps,
+	const DomainShader* ds = nullptr, const HullShader* hs = nullptr, const GeometryShader* gs = nullptr);
+
 void makeCube(ID3D11Device* device, Geometry* cube);
 void makeSphere(ID3D11Device* device, Geometry* sphere, UINT slices = 32, UINT stacks = 32);
 
 HRESULT loadPixelShader(ID3D11Device* device, PixelShader* outPs, const char* path);
-HRESULT loadVertexShader(ID3D11Device* device, VertexShader* outVs, const char* path, D3D11_INPUT_ELEMENT_DESC* descs = 0, UINT descsArrSize = 0);
+//Layouts are cached by element descriptions + input signature and shared between shaders
+HRESULT loadVertexShader(ID3D11Device* device, VertexShader* outVs, const char* path, const D3D11_INPUT_ELEMENT_DESC* descs = 0, UINT descsArrSize = 0);
+template<class Vertex>
+HRESULT loadVertexShader(ID3D11Device* device, VertexShader* outVs, const char* path, const InputElements<Vertex>& elements)
+{
+	return loadVertexShader(device, outVs, path, elements.data(), elements.size());
+}
+//Number of distinct ID3D11InputLayouts created so far
+size_t getInputLayoutCount();
 HRESULT loadDomainShader(ID3D11Device* device, DomainShader* outDs, const char* path);
 HRESULT loadHullShader(ID3D11Device* device, HullShader* outHs, const char* path);
 HRESULT loadGeometryShader(ID3D11Device* device, GeometryShader* outGs, const char* path);
+HRESULT loadComputeShader(ID3D11Device* device, ComputeShader* outCs, const char* path);
+//Streams the outputs of the shader at path to buffer 0 without rasterizing.
+//A vertex or domain shader streams its own outputs through an empty geometry stage.
+HRESULT createStreamOutputShader(ID3D11Device* device, GeometryShader* outGs, const char* path, const D3D11_SO_DECLARATION_ENTRY* entries, UINT entryCount, UINT stride);
 HRESULT loadShaderResource(ID3D11Device* device, ShaderResource* outSr, const wchar_t* path);
 HRESULT createShaderResource(ID3D11Device* device, ShaderResource* outSr);
 HRESULT createStructuredBuffer(ID3D11Device* device, StructuredBuffer* outSb, UINT elementSize, UINT count, void* initData = 0);
-HRESULT createConstantBuffer(ID3D11Device* device, ConstantBuffer* outCb, UINT elementSize, void* initData = 0);
-HRESULT createRenderTextrue(ID3D11Device* device, RenderTexture* outRt, UINT width, UINT height, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
+//append = AppendStructuredBuffer / ConsumeStructuredBuffer with a hidden counter
+HRESULT createRWStructuredBuffer(ID3D11Device* device, RWStructuredBuffer* outSb, UINT elementSize, UINT count, const void* initData = 0, bool append = false);
+HRESULT createRawBuffer(ID3D11Device* device, RawBuffer* outBuffer, UINT byteWidth, const void* initData = 0);
+HRESULT createIndirectArgsBuffer(ID3D11Device* device, IndirectArgsBuffer* outBuffer, UINT byteWidth, const void* initData = 0);
+HRESULT createConstantBuffer(ID3D11Device* device, RawConstantBuffer* outCb, UINT elementSize, const void* initData = 0, ConstantBufferUsage usage = ConstantBufferUsage::common);
+template<class T>
+HRESULT createConstantBuffer(ID3D11Device* device, ConstantBuffer<T>* outCb, const T* initData, ConstantBufferUsage usage)
+{
+	HRESULT hr = createConstantBuffer(device, &outCb->raw, sizeof(T), initData, usage);
+	outCb->shadow.invalidate();
+	if (SUCCEEDED(hr) && initData) { outCb->shadow.reset(*initData); }
+	return hr;
+}
+HRESULT createTexture(ID3D11Device* device, Texture* outTexture, UINT width, UINT height, DXGI_FORMAT format, const void* initData = 0, UINT rowPitch = 0);
+HRESULT createRWTexture(ID3D11Device* device, RWTexture* outTexture, UINT width, UINT height, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
+HRESULT createRenderTextrue(ID3D11Device* device, RenderTexture* outRt, UINT width, UINT height, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, bool unorderedAccess = false);
 HRESULT createDepthTextrue(ID3D11Device* device, DepthTexture* outDt, UINT width, UINT height);
 HRESULT createLayer(ID3D11Device* device, Layer* outLayer, UINT width, UINT height, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
 HRESULT createVertexBuffer(ID3D11Device* device, VertexBuffer* outVertexBuffer, UINT stride, UINT count, const void* initialValue);
+HRESULT createStreamOutputBuffer(ID3D11Device* device, StreamOutputBuffer* outBuffer, UINT stride, UINT count, bool shaderResource = false);
 HRESULT createIndexBuffer(ID3D11Device* device, IndexBuffer* outIndexBuffer, UINT count, const UINT* initialValue);
+HRESULT createIndexBuffer(ID3D11Device* device, IndexBuffer* outIndexBuffer, UINT count, const USHORT* initialValue);
+HRESULT createGeometry(ID3D11Device* device, Geometry* outGeometry, const Geometry::Vertex* vertices, UINT vertexCount, const UINT* indices, UINT indexCount, MeshOptimizeReport* outReport = nullptr);
+HRESULT createQuantizedGeometry(ID3D11Device* device, Geometry* outGeometry, const Geometry::Vertex* vertices, UINT vertexCount, const UINT* indices, UINT indexCount, MeshOptimizeReport* outReport = nullptr);
+//.obj / .glb (path + ".meshcache" is created next to the source)
+HRESULT loadGeometry(ID3D11Device* device, Geometry* outGeometry, const char* path, MeshOptimizeReport* outReport = nullptr);
+//Imports, optimizes and builds LOD chains on one thread per mesh
+HRESULT loadGeometries(ID3D11Device* device, Geometry* outGeometries, const char* const* paths, UINT count);
+
+//Enough groups of shader's [numthreads] to cover x * y * z threads; the shader must be set
+void dispatchThreads(ID3D11DeviceContext* immediateContext, const ComputeShader& shader, UINT x, UINT y = 1, UINT z = 1);
+void dispatchIndirect(ID3D11DeviceContext* immediateContext, const IndirectArgsBuffer& args, UINT byteOffset = 0);
+void drawInstancedIndirect(ID3D11DeviceContext* immediateContext, const IndirectArgsBuffer& args, UINT byteOffset = 0);
+void drawIndexedInstancedIndirect(ID3D11DeviceContext* immediateContext, const IndirectArgsBuffer& args, UINT byteOffset = 0);
+//Unbinds compute UAV slots [0, unorderedAccessCount) and SRV slots [0, shaderResourceCount) so other stages can bind the resources
+void clearComputeBindings(ID3D11DeviceContext* immediateContext, UINT unorderedAccessCount, UINT shaderResourceCount = 0);
 
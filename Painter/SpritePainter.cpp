@@ -4,13 +4,12 @@ SpritePainter::SpritePainter(ID3D11Device* device)
 	:Painter(device)
 {
 	loadPixelShader(device, &pixelShader, "asset\\Sprite_ps.cso");
-	D3D11_INPUT_ELEMENT_DESC inputElementDesc[] =
-	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	};
-	loadVertexShader(device, &vertexShader, "asset\\Sprite_vs.cso", inputElementDesc, 3);
+	const auto inputElements = InputElements<Vertex>()
+		.add("POSITION", &Vertex::mPos)
+		.add("TEXCOORD", &Vertex::mUV)
+		.add("COLOR", &Vertex::mColor);
+	loadVertexShader(device, &vertexShader, "asset\\Sprite_vs.cso", inputElements);
+	createConstantBuffer(device, &constantBuffer, &data);
 }
 
 void SpritePainter::drawBegin(ID3D11DeviceContext* immediateContext)
@@ -45,6 +44,7 @@ void SpritePainter::draw(
 	}
 	shaderResource->set(immediateContext, 0, false, true, false, false, false);
 	vertexShader.set(immediateContext);
+	bindConstants(immediateContext, &constantBuffer, data, ConstantSlot::pass, true, false, false, false, false);
 	vertexBuffer->set(immediateContext, 0);
 	immediateContext->Draw(vertexBuffer->count, 0);
 }
@@ -69,6 +69,7 @@ void SpritePainter::drawIndexed(
 	}
 	shaderResource->set(immediateContext, 0, false, true, false, false, false);
 	vertexShader.set(immediateContext);
+	bindConstants(immediateContext, &constantBuffer, data, ConstantSlot::pass, true, false, false, false, false);
 	vertexBuffer->set(immediateContext, 0);
 	indexBuffer->set(immediateContext);
 	immediateContext->DrawIndexed(indexBuffer->count, 0, 0);
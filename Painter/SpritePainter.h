@@ -10,9 +10,16 @@ public:
 		Float2 mUV{};
 		Float4 mColor{ 1.0f,1.0f,1.0f,1.0f };
 	};
+	struct Data
+	{
+		//Added to every texcoord, e.g. ScrollingBake::getTexcoordOffset() of a scrolling layer
+		Float2 texcoordOffset{};
+		Float2 padding{};
+	}data;
 private:
 	PixelShader pixelShader;
 	VertexShader vertexShader;
+	ConstantBuffer<Data> constantBuffer;
 public:
 	SpritePainter(ID3D11Device* device);
 	virtual ~SpritePainter() = default;
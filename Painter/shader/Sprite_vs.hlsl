@@ -11,11 +11,17 @@ struct VertexOutput
 	float4 color : COLOR;
 };
 
+cbuffer SpriteData : register(b1)
+{
+	float2 texcoordOffset;
+	float2 spritePadding;
+};
+
 VertexOutput main(VertexInput vin)
 {
 	VertexOutput vout;
 	vout.pos = float4(vin.pos, 0, 1);
-	vout.texcoord = vin.texcoord;
+	vout.texcoord = vin.texcoord + texcoordOffset;
 	vout.color = vin.color;
 	return vout;
 }
@@ -0,0 +1,58 @@
+﻿#include "Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace detail
+{
+	struct BenchCase
+	{
+		const char* name;
+		bench::Function function;
+	};
+
+	inline std::vector<BenchCase>& getCases()
+	{
+		static std::vector<BenchCase> cases;
+		return cases;
+	}
+
+	const char* currentName = "";
+	volatile uint64_t sink = 0;
+}
+
+bench::Registrar::Registrar(const char* name, Function function)
+{
+	detail::getCases().push_back({ name, function });
+}
+
+void bench::report(const char* label, double value, const char* unit)
+{
+	printf("%s: %s %.3f %s\n", detail::currentName, label, value, unit);
+}
+
+void bench::consume(uint64_t value)
+{
+	detail::sink = detail::sink + value;
+}
+
+const char* bench::getRepoPath(const char* relative)
+{
+	//呼び出しごとに上書きされる
+	static std::string path;
+	path = std::string(REPO_DIR) + "/" + relative;
+	return path.c_str();
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	for (const detail::BenchCase& benchCase : detail::getCases())
+	{
+		if (filter && !strstr(benchCase.name, filter)) { continue; }
+		detail::currentName = benchCase.name;
+		benchCase.function();
+	}
+	return 0;
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+#include <chrono>
+#include <stdint.h>
+
+/****************************************************************
+	Minimal benchmark harness for the portable modules.
+	BENCH(name) registers a case; the executable runs every case
+	(or those whose name contains argv[1]) once. Cases time their
+	own loops with Timer and print results with report().
+****************************************************************/
+namespace bench
+{
+	using Function = void(*)();
+
+	struct Registrar
+	{
+		Registrar(const char* name, Function function);
+	};
+
+	class Timer
+	{
+	private:
+		std::chrono::steady_clock::time_point start;
+	public:
+		Timer() :start(std::chrono::steady_clock::now()) {}
+		double getSeconds()const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+	};
+
+	// Prints "case: label value unit".
+	void report(const char* label, double value, const char* unit);
+	// Keeps a result alive so the measured work is not optimized away.
+	void consume(uint64_t value);
+	// Absolute path of a file under the repository root.
+	const char* getRepoPath(const char* relative);
+}
+
+#define BENCH(name) \
+	static void name(); \
+	static bench::Registrar name##Registrar(#name, name); \
+	static void name()
@@ -0,0 +1,108 @@
+﻿#include "Bench.h"
+#include "ConstantShadow.h"
+#include <stdio.h>
+
+namespace
+{
+	/****************************************************************
+		Stand-ins with the layouts of the Direct3D side, so the
+		upload volume can be measured without a device:
+			OldToonData		ToonPainter::Data before the split
+			FrameBlock		FrameConstants (b0)
+			PassBlock		ToonPainter::Data (b1)
+			MaterialBlock	MaterialConstants (b2)
+			ObjectBlock		ObjectConstants (b3)
+		ConstantShadow plays ConstantBuffer::update: it reports the
+		bytes that would reach the GPU.
+	****************************************************************/
+	struct Float3 { float x, y, z; };
+	struct Float4 { float x, y, z, w; };
+	struct Float4x4 { float m[16]; };
+
+	struct OldToonData
+	{
+		Float4x4 world;
+		Float4x4 viewProjection;
+		Float4 matColor;
+		Float4 rimColor;
+		Float3 lightDir;
+		int toonLevels;
+		Float3 eyePos;
+		float outlineThreshold;
+	};
+	struct FrameBlock
+	{
+		Float4x4 viewProjection;
+		Float3 eyePos;
+		float padding0;
+		Float3 lightDir;
+		float padding1;
+	};
+	struct PassBlock
+	{
+		Float4 rimColor;
+		int toonLevels;
+		float outlineThreshold;
+		float padding[2];
+	};
+	struct MaterialBlock
+	{
+		Float4 colors[64];
+	};
+	struct ObjectBlock
+	{
+		Float4x4 world;
+		unsigned int materialIndex;
+		unsigned int padding[3];
+	};
+	static_assert(sizeof(OldToonData) == 192 && sizeof(FrameBlock) == 96 && sizeof(PassBlock) == 32 &&
+		sizeof(MaterialBlock) == 1024 && sizeof(ObjectBlock) == 80, "Layouts must match the cbuffers");
+
+	template<class T>
+	size_t upload(ConstantShadow<T>& shadow, const T& data) { return shadow.update(data) ? sizeof(T) : 0; }
+}
+
+BENCH(constantUploadBytes)
+{
+	// 1000 Toon objects with 8 materials per frame; the camera moves every frame.
+	const size_t objects = 1000, materials = 8;
+	const int frames = 60;
+	ConstantShadow<OldToonData> oldBuffer;
+	ConstantShadow<FrameBlock> frameBuffer;
+	ConstantShadow<PassBlock> passBuffer;
+	ConstantShadow<MaterialBlock> materialBuffer;
+	ConstantShadow<ObjectBlock> objectBuffer;
+	size_t before = 0, after = 0;
+	bench::Timer timer;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		OldToonData old{};
+		old.viewProjection.m[0] = static_cast<float>(frame);
+		FrameBlock frameData{};
+		frameData.viewProjection.m[0] = static_cast<float>(frame);
+		const PassBlock pass{};
+		MaterialBlock materialData{};
+		for (size_t m = 0; m < materials; m++) { materialData.colors[m] = Float4{ m / 8.0f, 0.5f, 0.5f, 1.0f }; }
+		after += upload(frameBuffer, frameData);
+		for (size_t i = 0; i < objects; i++)
+		{
+			// Before: the whole block per draw.
+			old.world.m[12] = static_cast<float>(i);
+			old.matColor = materialData.colors[i % materials];
+			before += upload(oldBuffer, old);
+			// After: pass and material are deduplicated, only the object block changes.
+			after += upload(passBuffer, pass);
+			after += upload(materialBuffer, materialData);
+			ObjectBlock object{};
+			object.world.m[12] = static_cast<float>(i);
+			object.materialIndex = static_cast<unsigned int>(i % materials);
+			after += upload(objectBuffer, object);
+		}
+	}
+	const double seconds = timer.getSeconds();
+	printf("constantUploadBytes: %zu objects, %zu materials, %d frames\n", objects, materials, frames);
+	bench::report("before (one block per draw)", static_cast<double>(before) / frames, "bytes/frame");
+	bench::report("after (frame/pass/material/object)", static_cast<double>(after) / frames, "bytes/frame");
+	bench::report("ratio", 100.0 * after / before, "%");
+	bench::report("shadow compare", seconds * 1e9 / (static_cast<double>(frames) * objects * 4), "ns/update");
+}
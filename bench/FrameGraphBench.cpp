@@ -0,0 +1,74 @@
+﻿#include "Bench.h"
+#include "FrameGraph.h"
+#include <random>
+
+namespace
+{
+	// Each pass renders one transient layer from the previous pass and a few older ones;
+	// every fourth layer is never read so culling has work to do.
+	void buildGraph(FrameGraph* graph, unsigned int passCount, std::mt19937* random)
+	{
+		const FrameGraph::LayerDesc descs[3] = { { 1920, 1080, 28 }, { 960, 540, 28 }, { 1920, 1080, 10 } };
+		graph->clear();
+		const FrameGraph::Resource backBuffer = graph->importLayer("backBuffer", descs[0]);
+		std::vector<FrameGraph::Resource> outputs{};
+		for (unsigned int p = 0; p < passCount; p++)
+		{
+			const unsigned int pass = graph->addPass("pass");
+			FrameGraph::Builder builder = graph->getBuilder(pass);
+			if (!outputs.empty())
+			{
+				builder.read(outputs.back());
+				const unsigned int extra = (*random)() % 3;
+				for (unsigned int i = 0; i < extra && outputs.size() > 1; i++)
+				{
+					const FrameGraph::Resource r = outputs[(*random)() % (outputs.size() - 1)];
+					if (r != outputs.back()) { builder.read(r); }
+				}
+			}
+			if (p + 1 == passCount)
+			{
+				builder.write(backBuffer);
+				continue;
+			}
+			const FrameGraph::Resource output = builder.create("layer", descs[(*random)() % 3]);
+			builder.write(output);
+			if (p % 4 != 3) { outputs.push_back(output); }
+		}
+	}
+}
+
+BENCH(compile500Passes)
+{
+	const unsigned int passCount = 500;
+	const int iterations = 200;
+	std::mt19937 random(1);
+	FrameGraph graph;
+	buildGraph(&graph, passCount, &random);
+
+	bench::Timer timer;
+	for (int i = 0; i < iterations; i++)
+	{
+		graph.compile();
+		bench::consume(graph.getOrder().size());
+	}
+	const double seconds = timer.getSeconds();
+	bench::report("alive passes", static_cast<double>(graph.getOrder().size()), "");
+	bench::report("physical layers", static_cast<double>(graph.getPhysicalLayers().size()), "");
+	bench::report("compile", seconds / iterations * 1e6, "us");
+}
+
+BENCH(buildAndCompile500Passes)
+{
+	const int iterations = 200;
+	std::mt19937 random(1);
+	FrameGraph graph;
+	bench::Timer timer;
+	for (int i = 0; i < iterations; i++)
+	{
+		buildGraph(&graph, 500, &random);
+		graph.compile();
+		bench::consume(graph.getOrder().size());
+	}
+	bench::report("build + compile", timer.getSeconds() / iterations * 1e6, "us");
+}
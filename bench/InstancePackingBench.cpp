@@ -0,0 +1,52 @@
+﻿#include "Bench.h"
+#include "InstancePacking.h"
+#include <stdio.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct InstanceInput
+	{
+		std::vector<float> worlds;
+		std::vector<float> colors;
+	};
+
+	InstanceInput makeInstances(size_t count)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+		InstanceInput input{ std::vector<float>(count * 16), std::vector<float>(count * 4) };
+		for (float& v : input.worlds) { v = value(random); }
+		for (float& v : input.colors) { v = value(random); }
+		return input;
+	}
+}
+
+BENCH(packInstances)
+{
+	const size_t count = 1 << 20;
+	const InstanceInput input = makeInstances(count);
+	std::vector<PackedInstance> packed(count);
+	// ToonPainter packs every instance of a drawInstanced in one call.
+	// 1024 and 16384 stay in cache, 65536 is the streaming store size (4 MB), 1M goes to memory.
+	for (size_t batch : { size_t(1024), size_t(16384), size_t(65536), count })
+	{
+		const int iterations = static_cast<int>((size_t(1) << 24) / batch);
+		bench::Timer simd;
+		for (int i = 0; i < iterations; i++) { packInstances(packed.data(), input.worlds.data(), input.colors.data(), batch); }
+		const double simdSeconds = simd.getSeconds() / iterations;
+		bench::consume(static_cast<uint64_t>(packed[0].world[0][0]));
+		bench::Timer scalar;
+		for (int i = 0; i < iterations; i++) { packInstancesReference(packed.data(), input.worlds.data(), input.colors.data(), batch); }
+		const double scalarSeconds = scalar.getSeconds() / iterations;
+		bench::consume(static_cast<uint64_t>(packed[0].world[0][0]));
+		printf("packInstances: %zu instances per call\n", batch);
+		bench::report("simd", batch / simdSeconds * 1e-6, "Minstances/s");
+		bench::report("simd written", batch * sizeof(PackedInstance) / simdSeconds * 1e-9, "GB/s");
+		bench::report("scalar reference", batch / scalarSeconds * 1e-6, "Minstances/s");
+		bench::report("speedup", scalarSeconds / simdSeconds, "x");
+	}
+	// Upload size against a full float4x4 + float4 record.
+	bench::report("bytes per instance", sizeof(PackedInstance), "bytes (80 unpacked)");
+}
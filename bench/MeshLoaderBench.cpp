@@ -0,0 +1,68 @@
+﻿#include "Bench.h"
+#include "TestMeshes.h"
+#include "MeshLoader.h"
+#include <stdio.h>
+#include <fstream>
+
+namespace
+{
+	bool writeFile(const char* path, const void* data, size_t size)
+	{
+		std::ofstream ofs{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+		ofs.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		return static_cast<bool>(ofs);
+	}
+
+	void importAndCache(const char* sourcePath, const char* cachePath, size_t fileSize)
+	{
+		MeshData mesh{};
+		bench::Timer import;
+		const MeshLoadResult result = importMesh(sourcePath, &mesh);
+		const double importSeconds = import.getSeconds();
+		if (result != MeshLoadResult::ok)
+		{
+			printf("%s: import failed (%d)\n", sourcePath, static_cast<int>(result));
+			return;
+		}
+		const double triangles = static_cast<double>(mesh.indices.size() / 3);
+		printf("%s: %.0f triangles, %.1f MB: import %.1f ms, %.1f MB/s, %.2f Mtri/s\n", sourcePath, triangles, fileSize / 1e6,
+			importSeconds * 1e3, fileSize / importSeconds * 1e-6, triangles / importSeconds * 1e-6);
+
+		bench::Timer save;
+		saveMeshCache(cachePath, sourcePath, mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+		const double saveSeconds = save.getSeconds();
+
+		MeshCache cache{};
+		bench::Timer open;
+		const bool opened = cache.open(cachePath, sourcePath);
+		const double openSeconds = open.getSeconds();
+		// Touch every page so the mapping cost is counted, not just the header read.
+		bench::Timer touch;
+		uint64_t sum = 0;
+		for (size_t i = 0; opened && i < cache.getIndexCount(); i += 1024) { sum += cache.getIndices()[i]; }
+		for (size_t i = 0; opened && i < cache.getVertexCount(); i += 128) { sum += static_cast<uint64_t>(cache.getVertices()[i].position[0]); }
+		const double touchSeconds = touch.getSeconds();
+		bench::consume(sum);
+		printf("%s: cache save %.1f ms, open %.3f ms, open + touch %.2f ms\n", sourcePath, saveSeconds * 1e3, openSeconds * 1e3, (openSeconds + touchSeconds) * 1e3);
+		cache.close();
+		remove(cachePath);
+	}
+}
+
+BENCH(importMultiMillionTriangles)
+{
+	// 1400 x 1400 quads: 3.9M triangles.
+	const TestMesh sphere = makeSphereMesh(1400, 1400);
+	const std::string text = makeObjText(sphere);
+	const float zero[3] = {};
+	const std::vector<unsigned char> glb = makeGlb(sphere, zero);
+	if (!writeFile("MeshLoaderBench.obj", text.data(), text.size()) || !writeFile("MeshLoaderBench.glb", glb.data(), glb.size()))
+	{
+		printf("could not write the source files\n");
+		return;
+	}
+	importAndCache("MeshLoaderBench.obj", "MeshLoaderBench.obj.mesh", text.size());
+	importAndCache("MeshLoaderBench.glb", "MeshLoaderBench.glb.mesh", glb.size());
+	remove("MeshLoaderBench.obj");
+	remove("MeshLoaderBench.glb");
+}
@@ -0,0 +1,20 @@
+﻿#include "Bench.h"
+#include "TestMeshes.h"
+#include "MeshOptimizer.h"
+#include <stdio.h>
+
+BENCH(optimizeSphere)
+{
+	for (unsigned int slices : { 64u, 256u, 512u })
+	{
+		const TestMesh source = makeSphereMesh(slices, slices);
+		TestMesh mesh = source;
+		bench::Timer timer;
+		const MeshOptimizeReport report = optimizeMesh(mesh.vertices, mesh.indices);
+		const double seconds = timer.getSeconds();
+		const double triangles = static_cast<double>(source.indices.size() / 3);
+		printf("optimizeSphere: %u slices, %.0f triangles: acmr %.3f -> %.3f, atvr %.3f -> %.3f, %lld bytes saved, %.2f ms, %.2f Mtri/s\n",
+			slices, triangles, report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr,
+			report.getBytesSaved(), seconds * 1e3, triangles / seconds * 1e-6);
+	}
+}
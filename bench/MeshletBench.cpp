@@ -0,0 +1,91 @@
+﻿#include "Bench.h"
+#include "TestMeshes.h"
+#include "Meshlet.h"
+#include <stdio.h>
+
+namespace
+{
+	// 90 degree frustum from an orbiting camera looking at the origin.
+	// At 0.6 from the center of the test sphere its silhouette crosses the side planes.
+	MeshletCullParams makeOrbitParams(float angle, float distance, bool coneCulling)
+	{
+		MeshletCullParams params{};
+		const float camera[3] = { sinf(angle) * distance, 0.3f * distance, -cosf(angle) * distance };
+		const float length = sqrtf(camera[0] * camera[0] + camera[1] * camera[1] + camera[2] * camera[2]);
+		const float forward[3] = { -camera[0] / length, -camera[1] / length, -camera[2] / length };
+		const float flat = sqrtf(forward[0] * forward[0] + forward[2] * forward[2]);
+		const float right[3] = { forward[2] / flat, 0.0f, -forward[0] / flat };
+		const float up[3] = { forward[1] * right[2] - forward[2] * right[1], forward[2] * right[0] - forward[0] * right[2], forward[0] * right[1] - forward[1] * right[0] };
+		const float c = sqrtf(0.5f);
+		for (int k = 0; k < 3; k++)
+		{
+			params.planes[0][k] = (right[k] + forward[k]) * c;
+			params.planes[1][k] = (-right[k] + forward[k]) * c;
+			params.planes[2][k] = (up[k] + forward[k]) * c;
+			params.planes[3][k] = (-up[k] + forward[k]) * c;
+			params.planes[4][k] = forward[k];
+			params.planes[5][k] = -forward[k];
+		}
+		for (int p = 0; p < 6; p++)
+		{
+			params.planes[p][3] = -(params.planes[p][0] * camera[0] + params.planes[p][1] * camera[1] + params.planes[p][2] * camera[2]);
+		}
+		params.planes[4][3] -= 0.1f;
+		params.planes[5][3] += 100.0f;
+		for (int k = 0; k < 3; k++) { params.cameraPosition[k] = camera[k]; }
+		params.coneCulling = coneCulling;
+		return params;
+	}
+}
+
+BENCH(buildMeshlets)
+{
+	for (unsigned int slices : { 256u, 1024u })
+	{
+		TestMesh sphere = makeSphereMesh(slices, slices / 2);
+		for (size_t i = 0; i < sphere.indices.size(); i += 3) { std::swap(sphere.indices[i + 1], sphere.indices[i + 2]); }
+		std::vector<Meshlet> meshlets{};
+		bench::Timer timer;
+		buildMeshlets(meshlets, sphere.indices.data(), sphere.indices.size(), sphere.vertices[0].position, sphere.vertices.size(), sizeof(TestVertex));
+		const double seconds = timer.getSeconds();
+		const MeshletStatistics statistics = analyzeMeshlets(meshlets.data(), meshlets.size(), sphere.vertices.size());
+		const double triangles = static_cast<double>(sphere.indices.size() / 3);
+		printf("buildMeshlets: %.0f triangles -> %zu meshlets, %.1f vertices / %.1f triangles (fill %.2f / %.2f), redundancy %.2f, cone cullable %.2f\n",
+			triangles, statistics.meshletCount, statistics.averageVertices, statistics.averageTriangles,
+			statistics.vertexFill, statistics.triangleFill, statistics.vertexRedundancy, statistics.coneCullable);
+		bench::report("build", triangles / seconds * 1e-6, "Mtriangles/s");
+	}
+}
+
+BENCH(cullMeshlets)
+{
+	TestMesh sphere = makeSphereMesh(1024, 512);
+	for (size_t i = 0; i < sphere.indices.size(); i += 3) { std::swap(sphere.indices[i + 1], sphere.indices[i + 2]); }
+	std::vector<Meshlet> meshlets{};
+	buildMeshlets(meshlets, sphere.indices.data(), sphere.indices.size(), sphere.vertices[0].position, sphere.vertices.size(), sizeof(TestVertex));
+	MeshletCullData data{};
+	data.build(meshlets.data(), meshlets.size());
+	const int frames = 500;
+	std::vector<MeshletDrawRange> ranges{};
+	for (bool coneCulling : { false, true })
+	{
+		size_t visible = 0, drawCalls = 0;
+		bench::Timer simd;
+		for (int f = 0; f < frames; f++)
+		{
+			visible += cullMeshlets(ranges, data, makeOrbitParams(f * 0.05f, 0.6f, coneCulling));
+			drawCalls += ranges.size();
+		}
+		const double simdSeconds = simd.getSeconds();
+		bench::Timer scalar;
+		for (int f = 0; f < frames; f++)
+		{
+			bench::consume(cullMeshletsReference(ranges, data, makeOrbitParams(f * 0.05f, 0.6f, coneCulling)));
+		}
+		const double scalarSeconds = scalar.getSeconds();
+		printf("cullMeshlets: %zu meshlets, cone %s: %.1f%% visible, %.0f draw ranges per frame\n", meshlets.size(), coneCulling ? "on" : "off",
+			100.0 * visible / (static_cast<double>(meshlets.size()) * frames), static_cast<double>(drawCalls) / frames);
+		bench::report(coneCulling ? "simd frustum + cone" : "simd frustum", meshlets.size() * frames / simdSeconds * 1e-6, "Mmeshlets/s");
+		bench::report(coneCulling ? "scalar frustum + cone" : "scalar frustum", meshlets.size() * frames / scalarSeconds * 1e-6, "Mmeshlets/s");
+	}
+}
@@ -0,0 +1,84 @@
+﻿#include "Bench.h"
+#include "TestMeshes.h"
+#include "OcclusionCulling.h"
+#include "ParallelFor.h"
+#include <stdio.h>
+#include <random>
+
+namespace
+{
+	constexpr unsigned int screenWidth = 640;
+	constexpr unsigned int screenHeight = 360;
+
+	void makeViewProjection(float out[16])
+	{
+		const float nearZ = 0.5f, farZ = 200.0f;
+		const float yScale = 1.0f / tanf(0.5f), xScale = yScale * screenHeight / screenWidth;
+		const float projection[16] = { xScale,0,0,0, 0,yScale,0,0, 0,0,farZ / (farZ - nearZ),1, 0,0,-nearZ * farZ / (farZ - nearZ),0 };
+		memcpy(out, projection, sizeof(projection));
+	}
+}
+
+BENCH(occlusionCulling)
+{
+	float viewProjection[16];
+	makeViewProjection(viewProjection);
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	// Building-sized boxes, one occluder mesh each.
+	const size_t occluderCount = 256;
+	std::vector<TestMesh> occluders(occluderCount);
+	for (TestMesh& occluder : occluders)
+	{
+		const float center[3] = { unit(random) * 40.0f, unit(random) * 15.0f, 20.0f + fabsf(unit(random)) * 60.0f };
+		const float half[3] = { 1.0f + fabsf(unit(random)) * 5.0f, 1.0f + fabsf(unit(random)) * 5.0f, 1.0f + fabsf(unit(random)) * 3.0f };
+		appendBoxMesh(occluder, center, half);
+	}
+
+	MaskedOcclusionBuffer buffer(screenWidth, screenHeight);
+	const int frames = 200;
+	size_t queued = 0;
+	double addSeconds = 0.0, rasterizeSeconds = 0.0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		bench::Timer add;
+		buffer.clear();
+		for (const TestMesh& occluder : occluders)
+		{
+			buffer.addOccluder(occluder.vertices[0].position, sizeof(TestVertex), occluder.indices.data(), occluder.indices.size() / 3, viewProjection);
+		}
+		addSeconds += add.getSeconds();
+		queued = buffer.getQueuedTriangleCount();
+		bench::Timer rasterize;
+		buffer.rasterize();
+		rasterizeSeconds += rasterize.getSeconds();
+	}
+	printf("occlusionCulling: %ux%u, %zu box occluders, %zu front triangles queued, %zu workers\n",
+		screenWidth, screenHeight, occluderCount, queued, getWorkerCount());
+	bench::report("occluders", occluderCount * frames / ((addSeconds + rasterizeSeconds) * 1e3), "occluders/ms");
+	bench::report("setup (addOccluder)", addSeconds / frames * 1e3, "ms/frame");
+	bench::report("rasterize", rasterizeSeconds / frames * 1e3, "ms/frame");
+	bench::report("rasterize", queued * frames / (rasterizeSeconds * 1e3), "triangles/ms");
+
+	const size_t testCount = 1 << 20;
+	std::vector<float> boxes(testCount * 6);
+	for (size_t i = 0; i < testCount; i++)
+	{
+		const float center[3] = { unit(random) * 50.0f, unit(random) * 25.0f, 25.0f + fabsf(unit(random)) * 100.0f };
+		const float size = 0.3f + fabsf(unit(random)) * 2.0f;
+		for (int k = 0; k < 3; k++)
+		{
+			boxes[i * 6 + k] = center[k] - size;
+			boxes[i * 6 + 3 + k] = center[k] + size;
+		}
+	}
+	size_t counts[3] = {};
+	bench::Timer test;
+	for (size_t i = 0; i < testCount; i++)
+	{
+		counts[static_cast<int>(buffer.testAabb(&boxes[i * 6], &boxes[i * 6 + 3], viewProjection))]++;
+	}
+	const double testSeconds = test.getSeconds();
+	printf("occlusionCulling: %zu AABB tests: %zu visible, %zu occluded, %zu outside the view\n", testCount, counts[0], counts[1], counts[2]);
+	bench::report("testAabb", testCount / testSeconds * 1e-6, "Mtests/s");
+}
@@ -0,0 +1,40 @@
+﻿#include "Bench.h"
+#include "ParallelFor.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+BENCH(dispatchOverhead)
+{
+	// Empty ranges, so only the cost of handing them out is measured.
+	const size_t rangeCount = getWorkerCount() > 1 ? getWorkerCount() : 2;
+	const size_t previous = getWorkerCount();
+	setWorkerCount(rangeCount);
+	std::atomic<uint64_t> sum{ 0 };
+	const int iterations = 20000;
+
+	bench::Timer pool;
+	for (int i = 0; i < iterations; i++)
+	{
+		parallelForRanges(rangeCount, 1, [&](size_t begin, size_t, size_t) { sum += begin; });
+	}
+	const double poolSeconds = pool.getSeconds() / iterations;
+
+	// What parallelForRanges did before the pool: start and join threads per call.
+	bench::Timer spawn;
+	for (int i = 0; i < iterations; i++)
+	{
+		std::vector<std::thread> threads;
+		for (size_t r = 1; r < rangeCount; r++) { threads.emplace_back([&, r]() { sum += r; }); }
+		sum += 0;
+		for (std::thread& thread : threads) { thread.join(); }
+	}
+	const double spawnSeconds = spawn.getSeconds() / iterations;
+	bench::consume(sum);
+	setWorkerCount(previous);
+
+	bench::report("ranges per call", static_cast<double>(rangeCount), "");
+	bench::report("pool", poolSeconds * 1e6, "us/call");
+	bench::report("thread per range", spawnSeconds * 1e6, "us/call");
+	bench::report("speedup", spawnSeconds / poolSeconds, "x");
+}
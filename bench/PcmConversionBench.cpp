@@ -0,0 +1,97 @@
+﻿#include "Bench.h"
+#include "PcmConversion.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	const char* const formatNames[] = { "u8", "s16", "s24", "s32", "f32" };
+	const char* const kernelNames[] = { "scalar", "sse2", "avx2" };
+
+	// Ten minutes of 48 kHz stereo per format.
+	constexpr size_t frames = 48000 * 600;
+	constexpr uint32_t channels = 2;
+
+	std::vector<unsigned char> makeSource(PcmFormat format)
+	{
+		std::vector<unsigned char> source(getPcmSampleSize(format) * channels * frames);
+		if (format == PcmFormat::float32)
+		{
+			float* samples = reinterpret_cast<float*>(source.data());
+			for (size_t i = 0; i < channels * frames; i++) { samples[i] = static_cast<float>(static_cast<int>(i % 65536) - 32768) / 32768.0f; }
+		}
+		else
+		{
+			for (size_t i = 0; i < source.size(); i++) { source[i] = static_cast<unsigned char>(i * 2654435761u >> 24); }
+		}
+		return source;
+	}
+
+	template<class Convert>
+	double getBestSeconds(int repeats, Convert convert)
+	{
+		double best = 1e30;
+		for (int i = 0; i < repeats; i++)
+		{
+			bench::Timer timer;
+			convert();
+			const double seconds = timer.getSeconds();
+			best = seconds < best ? seconds : best;
+		}
+		return best;
+	}
+
+	template<class T>
+	void measure(const char* output)
+	{
+		std::vector<T> left(frames), right(frames);
+		T* planes[] = { left.data(), right.data() };
+		char label[64];
+		for (PcmFormat format : { PcmFormat::unsigned8, PcmFormat::signed16, PcmFormat::signed24, PcmFormat::signed32, PcmFormat::float32 })
+		{
+			const std::vector<unsigned char> source = makeSource(format);
+			const double bytes = static_cast<double>(source.size());
+			const double reference = getBestSeconds(2, [&] { convertPcmReference(source.data(), format, channels, frames, planes); });
+			snprintf(label, sizeof(label), "%s -> %s reference", formatNames[static_cast<int>(format)], output);
+			bench::report(label, bytes / reference * 1e-9, "GB/s");
+			for (PcmKernel kernel : { PcmKernel::scalar, PcmKernel::sse2, PcmKernel::avx2 })
+			{
+				if (kernel == PcmKernel::avx2 && getPcmKernel() != PcmKernel::avx2) { continue; }
+				const double seconds = getBestSeconds(3, [&] { convertPcm(source.data(), format, channels, frames, planes, kernel); });
+				snprintf(label, sizeof(label), "%s -> %s %s", formatNames[static_cast<int>(format)], output, kernelNames[static_cast<int>(kernel)]);
+				bench::report(label, bytes / seconds * 1e-9, "GB/s");
+			}
+			bench::consume(static_cast<uint64_t>(left[frames / 2]) + static_cast<uint64_t>(right[frames - 1]));
+		}
+	}
+}
+
+// Input bytes per second into planar stereo. convertPcm splits the input across cores, the reference runs on one.
+BENCH(convertToFloat)
+{
+	measure<float>("float");
+}
+
+BENCH(convertToShort)
+{
+	measure<int16_t>("int16");
+}
+
+BENCH(convertToMono)
+{
+	std::vector<float> mono(frames);
+	char label[64];
+	for (PcmFormat format : { PcmFormat::signed16, PcmFormat::signed24, PcmFormat::float32 })
+	{
+		const std::vector<unsigned char> source = makeSource(format);
+		const double bytes = static_cast<double>(source.size());
+		const double reference = getBestSeconds(2, [&] { convertPcmMonoReference(source.data(), format, channels, frames, mono.data()); });
+		const double seconds = getBestSeconds(3, [&] { convertPcmMono(source.data(), format, channels, frames, mono.data()); });
+		snprintf(label, sizeof(label), "%s reference", formatNames[static_cast<int>(format)]);
+		bench::report(label, bytes / reference * 1e-9, "GB/s");
+		snprintf(label, sizeof(label), "%s %s", formatNames[static_cast<int>(format)], kernelNames[static_cast<int>(getPcmKernel())]);
+		bench::report(label, bytes / seconds * 1e-9, "GB/s");
+		bench::consume(static_cast<uint64_t>(mono[frames / 3] * 1e6f));
+	}
+}
@@ -0,0 +1,55 @@
+﻿#include "Bench.h"
+#include "RealFft.h"
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+BENCH(forwardThroughput)
+{
+	for (size_t size = 256; size <= 16384; size *= 4)
+	{
+		RealFft fft;
+		fft.init(size);
+		std::vector<float> input(size), re(fft.getBinCount()), im(fft.getBinCount());
+		for (size_t t = 0; t < size; t++) { input[t] = static_cast<float>(sin(0.37 * t) + 0.25 * cos(0.011 * t)); }
+		// About 2^26 samples per size.
+		const size_t repeats = (size_t(1) << 26) / size;
+		bench::Timer timer;
+		for (size_t i = 0; i < repeats; i++)
+		{
+			input[0] = static_cast<float>(i & 7);
+			fft.forward(input.data(), re.data(), im.data());
+		}
+		const double seconds = timer.getSeconds();
+		char label[64];
+		snprintf(label, sizeof(label), "n=%zu", size);
+		bench::report(label, seconds / repeats * 1e6, "us/fft");
+		snprintf(label, sizeof(label), "n=%zu throughput", size);
+		bench::report(label, size * repeats / seconds * 1e-6, "Msamples/s");
+		// 5 n log2 n is the usual flop estimate of a complex FFT; a real one does half.
+		snprintf(label, sizeof(label), "n=%zu speed", size);
+		bench::report(label, 2.5 * size * log2(static_cast<double>(size)) * repeats / seconds * 1e-9, "GFlops");
+		bench::consume(static_cast<uint64_t>(fabsf(re[size / 8]) * 1e3f));
+	}
+}
+
+BENCH(againstNaiveDft)
+{
+	const size_t size = 1024;
+	RealFft fft;
+	fft.init(size);
+	std::vector<float> input(size), re(fft.getBinCount()), im(fft.getBinCount());
+	std::vector<double> referenceRe(fft.getBinCount()), referenceIm(fft.getBinCount());
+	for (size_t t = 0; t < size; t++) { input[t] = static_cast<float>(sin(0.37 * t)); }
+	bench::Timer reference;
+	dftReference(input.data(), size, referenceRe.data(), referenceIm.data());
+	const double referenceSeconds = reference.getSeconds();
+	const int repeats = 10000;
+	bench::Timer timer;
+	for (int i = 0; i < repeats; i++) { fft.forward(input.data(), re.data(), im.data()); }
+	const double seconds = timer.getSeconds() / repeats;
+	bench::report("dftReference n=1024", referenceSeconds * 1e6, "us");
+	bench::report("RealFft n=1024", seconds * 1e6, "us");
+	bench::report("speedup", referenceSeconds / seconds, "x");
+	bench::consume(static_cast<uint64_t>(fabs(referenceRe[3]) + fabsf(re[3])));
+}
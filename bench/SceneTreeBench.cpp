@@ -0,0 +1,90 @@
+﻿#include "Bench.h"
+#include "SceneTree.h"
+#include "Frustum.h"
+#include "ParallelFor.h"
+#include <math.h>
+#include <stdio.h>
+#include <random>
+
+namespace
+{
+	SceneAabb makeBox(const float* center, float extent)
+	{
+		return SceneAabb{ { center[0] - extent, center[1] - extent, center[2] - extent }, { center[0] + extent, center[1] + extent, center[2] + extent } };
+	}
+
+	// Camera at the origin looking down +z, 1 radian vertical fov, far plane 300.
+	void makeCameraPlanes(float outPlanes[6][4])
+	{
+		const float nearZ = 0.1f, farZ = 300.0f;
+		const float scale = 1.0f / tanf(0.5f);
+		const float projection[16] =
+		{
+			scale, 0, 0, 0,
+			0, scale, 0, 0,
+			0, 0, farZ / (farZ - nearZ), 1,
+			0, 0, -nearZ * farZ / (farZ - nearZ), 0,
+		};
+		extractFrustumPlanes(outPlanes, projection);
+	}
+}
+
+BENCH(sceneTree1M)
+{
+	const size_t count = 1000000;
+	const int frames = 10;
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f), step(-0.3f, 0.3f);
+	std::vector<float> centers(count * 3);
+	for (float& c : centers) { c = position(random); }
+
+	SceneTree tree(0.5f);
+	std::vector<int> proxies(count);
+	bench::Timer insertTimer;
+	for (size_t i = 0; i < count; i++) { proxies[i] = tree.insert(makeBox(&centers[i * 3], 1.0f), static_cast<unsigned int>(i)); }
+	bench::report("insert", insertTimer.getSeconds() * 1e3, "ms");
+	bench::report("height", tree.getHeight(), "levels");
+
+	float planes[6][4];
+	makeCameraPlanes(planes);
+	std::vector<unsigned int> visible{};
+	double updateSeconds = 0.0, querySeconds = 0.0, serialSeconds = 0.0, linearSeconds = 0.0;
+	size_t reinserted = 0, visibleCount = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		// Every object moves a little each frame; most stay inside their fat box.
+		for (float& c : centers) { c += step(random); }
+		bench::Timer update;
+		for (size_t i = 0; i < count; i++) { reinserted += tree.update(proxies[i], makeBox(&centers[i * 3], 1.0f)); }
+		updateSeconds += update.getSeconds();
+
+		visible.clear();
+		bench::Timer query;
+		visibleCount += tree.query(planes, visible);
+		querySeconds += query.getSeconds();
+
+		visible.clear();
+		bench::Timer serial;
+		bench::consume(tree.querySerial(planes, visible));
+		serialSeconds += serial.getSeconds();
+
+		// Baseline: test every object's box against the frustum.
+		bench::Timer linear;
+		size_t inside = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const SceneAabb& box = tree.getFatBox(proxies[i]);
+			const float center[3] = { (box.min[0] + box.max[0]) * 0.5f, (box.min[1] + box.max[1]) * 0.5f, (box.min[2] + box.max[2]) * 0.5f };
+			inside += isSphereInFrustum(planes, center, (box.max[0] - box.min[0]) * 0.8660254f);
+		}
+		bench::consume(inside);
+		linearSeconds += linear.getSeconds();
+	}
+	printf("sceneTree1M: %zu objects, %.1f%% reinserted per frame, %.0f visible per frame, height %d, %zu workers\n", count,
+		100.0 * reinserted / (static_cast<double>(count) * frames), static_cast<double>(visibleCount) / frames, tree.getHeight(), getWorkerCount());
+	bench::report("update", updateSeconds / frames * 1e3, "ms/frame");
+	bench::report("update", count * frames / updateSeconds * 1e-6, "Mobjects/s");
+	bench::report("query (parallel)", querySeconds / frames * 1e3, "ms/frame");
+	bench::report("query (serial)", serialSeconds / frames * 1e3, "ms/frame");
+	bench::report("linear sphere test", linearSeconds / frames * 1e3, "ms/frame");
+}
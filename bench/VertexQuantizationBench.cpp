@@ -0,0 +1,51 @@
+﻿#include "Bench.h"
+#include "TestMeshes.h"
+#include "VertexQuantization.h"
+#include <random>
+
+namespace
+{
+	std::vector<TestVertex> makeVertices(size_t count)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+		std::vector<TestVertex> vertices(count);
+		for (TestVertex& v : vertices)
+		{
+			for (int c = 0; c < 3; c++) { v.position[c] = value(random) * 10.0f; v.normal[c] = value(random); }
+			const float length = sqrtf(v.normal[0] * v.normal[0] + v.normal[1] * v.normal[1] + v.normal[2] * v.normal[2]) + 1e-6f;
+			for (int c = 0; c < 3; c++) { v.normal[c] /= length; }
+		}
+		return vertices;
+	}
+}
+
+BENCH(quantizeVertices4M)
+{
+	const size_t count = 4 * 1024 * 1024;
+	const int iterations = 5;
+	const std::vector<TestVertex> vertices = makeVertices(count);
+	const QuantizationBounds bounds = computeQuantizationBounds(vertices[0].position, count, sizeof(TestVertex));
+	std::vector<QuantizedVertex> quantized(count);
+
+	bench::Timer simd;
+	for (int i = 0; i < iterations; i++)
+	{
+		quantizeVertices(quantized.data(), vertices.data(), count, sizeof(TestVertex), offsetof(TestVertex, normal), bounds);
+		bench::consume(quantized[i].position[0]);
+	}
+	const double simdSeconds = simd.getSeconds() / iterations;
+
+	bench::Timer scalar;
+	for (int i = 0; i < iterations; i++)
+	{
+		quantizePositionsReference(quantized.data(), vertices[0].position, count, sizeof(TestVertex), bounds);
+		encodeOctahedralNormalsReference(quantized.data(), vertices[0].normal, count, sizeof(TestVertex));
+		bench::consume(quantized[i].position[0]);
+	}
+	const double scalarSeconds = scalar.getSeconds() / iterations;
+
+	bench::report("simd", count / simdSeconds * 1e-6, "Mvertices/s");
+	bench::report("scalar reference", count / scalarSeconds * 1e-6, "Mvertices/s");
+	bench::report("speedup", scalarSeconds / simdSeconds, "x");
+}
@@ -0,0 +1,94 @@
+﻿#include "Bench.h"
+#include "WaveformPyramid.h"
+#include "ParallelFor.h"
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+	constexpr size_t sampleRate = 48000;
+	constexpr size_t hourSamples = sampleRate * 3600;
+
+	// Noise under a slow envelope, so min / max / rms differ between blocks.
+	float makeSample(size_t i)
+	{
+		const uint32_t noise = static_cast<uint32_t>(i * 2654435761u) >> 8;
+		const float envelope = static_cast<float>((i / sampleRate) % 7 + 1) / 8.0f;
+		return (static_cast<float>(noise & 0xFFFF) / 32768.0f - 1.0f) * envelope;
+	}
+
+	const std::vector<float>& getHourOfSamples()
+	{
+		static std::vector<float> samples;
+		if (samples.empty())
+		{
+			samples.resize(hourSamples);
+			for (size_t i = 0; i < hourSamples; i++) { samples[i] = makeSample(i); }
+		}
+		return samples;
+	}
+
+	void reportBuild(double milliseconds, size_t count)
+	{
+		bench::report("build", milliseconds, "ms");
+		bench::report("throughput", count / milliseconds * 1e-6, "Gsamples/s");
+		bench::report("faster than real time", count / static_cast<double>(sampleRate) / (milliseconds * 1e-3), "x");
+	}
+}
+
+BENCH(hourLongBuild)
+{
+	// One hour of mono 48 kHz float samples already in memory (691 MB).
+	const std::vector<float>& samples = getHourOfSamples();
+	WaveformPyramid pyramid;
+	double best = 1e30;
+	for (int i = 0; i < 3; i++)
+	{
+		const double milliseconds = pyramid.build(samples.data(), samples.size());
+		best = milliseconds < best ? milliseconds : best;
+	}
+	printf("hourLongBuild: %zu samples, block %u, %u levels, %zu workers\n", samples.size(), pyramid.getBlock(), pyramid.getLevelCount(), getWorkerCount());
+	reportBuild(best, samples.size());
+	bench::report("pyramid", pyramid.getEntryCount() * sizeof(WaveformEnvelope) / 1e6, "MB");
+	bench::consume(static_cast<uint64_t>(pyramid.getEnvelope(pyramid.getLevelCount() - 1, 0).rms * 1e6f));
+}
+
+BENCH(hourLongStreamedBuild)
+{
+	// The same hour decoded from 16-bit PCM chunk by chunk, as StreamingWindow feeds it.
+	std::vector<int16_t> pcm(hourSamples);
+	for (size_t i = 0; i < hourSamples; i++) { pcm[i] = static_cast<int16_t>(makeSample(i) * 32767.0f); }
+	const WaveformPyramid::SampleSource source = [&pcm](size_t first, size_t count, float* out)
+		{
+			for (size_t i = 0; i < count; i++) { out[i] = pcm[first + i] * (1.0f / 32768.0f); }
+		};
+	WaveformPyramid pyramid;
+	double best = 1e30;
+	for (int i = 0; i < 3; i++)
+	{
+		const double milliseconds = pyramid.build(source, pcm.size());
+		best = milliseconds < best ? milliseconds : best;
+	}
+	reportBuild(best, pcm.size());
+	bench::consume(static_cast<uint64_t>(pyramid.getEnvelope(0, 0).maximum * 1e6f));
+}
+
+BENCH(minuteAgainstReference)
+{
+	// buildReference sums every level from the samples, so only a minute of it is timed.
+	const size_t count = sampleRate * 60;
+	const std::vector<float>& samples = getHourOfSamples();
+	WaveformPyramid pyramid;
+	bench::Timer reference;
+	pyramid.buildReference(samples.data(), count);
+	const double referenceMilliseconds = reference.getSeconds() * 1e3;
+	double best = 1e30;
+	for (int i = 0; i < 5; i++)
+	{
+		const double milliseconds = pyramid.build(samples.data(), count);
+		best = milliseconds < best ? milliseconds : best;
+	}
+	bench::report("reference", referenceMilliseconds, "ms");
+	bench::report("build", best, "ms");
+	bench::report("speedup", referenceMilliseconds / best, "x");
+}
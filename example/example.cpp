@@ -1,120 +1,123 @@
 ﻿#include "example.h"
+#include "../func/Frustum.h"
 #include <string>
 
-class AudioResource
-{
-private:
-	HMMIO			hmmio;
-	BYTE*			pcmData;
-	DWORD			pcmDataSize;
-	WAVEFORMATEX	waveFormat;
-	std::string		filename;
-public:
-	AudioResource(std::string filename)
-		:hmmio(NULL), pcmData(NULL), pcmDataSize(), waveFormat(), filename(filename)
-	{
-		assert(!filename.empty());
-		hmmio = mmioOpenA(&filename.front(), NULL, MMIO_ALLOCBUF | MMIO_READ);
-		assert(hmmio != NULL);
-		MMCKINFO mainChunk = {};
-		MMCKINFO subChunk = {};
-		mainChunk.fccType = mmioFOURCC('W', 'A', 'V', 'E');
-		MMRESULT mr = mmioDescend(hmmio, &mainChunk, NULL, MMIO_FINDRIFF);
-		assert(mr == 0);
-		subChunk.ckid = mmioFOURCC('f', 'm', 't', ' ');
-		mr = mmioDescend(hmmio, &subChunk, &mainChunk, MMIO_FINDCHUNK);
-		assert(mr == 0);
-		mr = mmioRead(hmmio, (HPSTR)&waveFormat, sizeof(waveFormat)) != sizeof(waveFormat);
-		assert(mr == 0);
-		assert(waveFormat.wFormatTag == WAVE_FORMAT_PCM);
-		waveFormat.cbSize = 0;
-		mr = mmioAscend(hmmio, &subChunk, 0);
-		assert(mr == 0);
-		subChunk.ckid = mmioFOURCC('d', 'a', 't', 'a');
-		mr = mmioDescend(hmmio, &subChunk, &mainChunk, MMIO_FINDCHUNK);
-		assert(mr == 0);
-		pcmDataSize = subChunk.cksize;
-	}
-	LONG read(BYTE* buf, DWORD size)
-	{
-		return mmioRead(hmmio, (HPSTR)buf, size);
-	}
-	bool readAll()
-	{
-		if (pcmData == nullptr)
-		{
-			pcmData = new BYTE[pcmDataSize];
-		}
-		backToTop();
-		return read(pcmData, pcmDataSize) > 0;
-	}
-	LONG seek(LONG offset)
-	{
-		return mmioSeek(hmmio, offset, SEEK_CUR);
-	}
-	void backToTop()
-	{
-		mmioSeek(hmmio, 0, SEEK_END);
-		mmioSeek(hmmio, -(LONG)pcmDataSize, SEEK_CUR);
-	}
-	const std::string& getFilename()const { return filename; }
-	BYTE* getPcmData()const { return pcmData; }
-	const DWORD& getPcmDataSize()const { return pcmDataSize; }
-	const WAVEFORMATEX& getWaveFormat()const { return waveFormat; }
-	~AudioResource()
+#define hrInspection(hr) assert(hr == S_OK)
+
+//可視メッシュレットの連続区間ごとに描画する
+static void drawMeshletRanges(ID3D11DeviceContext* immediateContext, const std::vector<MeshletDrawRange>& ranges)
+{
+	for (const MeshletDrawRange& range : ranges)
 	{
-		if (hmmio) { mmioClose(hmmio, 0); }
-		if (pcmData != NULL) { delete pcmData; }
+		immediateContext->DrawIndexed(range.indexCount, range.indexOffset, 0);
 	}
-};
+}
 
-WavePainter::WavePainter(ID3D11Device* device, const char* waveFilename)
+WavePainter::WavePainter(ID3D11Device* device, const char* waveFilename, bool streaming, const SpectrogramConfig& spectrogramConfig)
 	:Painter(device)
 {
-	AudioResource audioResource{ waveFilename };
-	audioResource.readAll();
-	WAVEFORMATEX format = audioResource.getWaveFormat();
-	const UINT bytePerSample = (UINT)format.wBitsPerSample / 8;
-
-	data.sampleCount = (UINT)audioResource.getPcmDataSize() / bytePerSample;
-	data.samplePerSec = (UINT)format.nSamplesPerSec;
+	const WavParseResult result = wavFile.open(waveFilename);
+	assert(result == WavParseResult::ok && "The wave file is invalid.");
+	data.sampleCount = (UINT)wavFile.getFrameCount();
+	data.samplePerSec = wavFile.getFormat().samplesPerSec;
+	const WavFile* file = &wavFile;
+	auto source = [file](size_t first, size_t count, float* out) { file->readMono(first, count, out); };
 
-	float* wave = new float[data.sampleCount];
-
-	if (bytePerSample == 1)
+	//縮小表示用のエンベロープ
+	WaveformPyramid pyramid;
+	if (streaming)
 	{
-		BYTE* src = audioResource.getPcmData();
-		for (UINT i = 0; i < data.sampleCount; i++)
-		{
-			wave[i] = (src[i] / (float)BYTE_MAX) * 2.0f - 1.0f;
-		}
+		//全体をメモリに載せず, ファイルから直接エンベロープを作り表示範囲だけリングに置く
+		pyramid.build(source, data.sampleCount, streamingEnvelopeBlock);
+		window.open(source, data.sampleCount, (size_t)data.samplePerSec * streamingSeconds);
+		data.ringSize = (UINT)window.getCapacity();
+		createStructuredBuffer(device, &structuredBuffer, sizeof(float), data.ringSize);
+		window.waitForWindow();
 	}
 	else
 	{
-		short* src = (short*)audioResource.getPcmData();
-		for (UINT i = 0; i < data.sampleCount; i++)
-		{
-			wave[i] = (src[i] / (float)SHORT_MAX);
-		}
+		std::vector<float> wave(data.sampleCount);
+		wavFile.readMono(0, data.sampleCount, wave.data());
+		pyramid.build(wave.data(), data.sampleCount);
+		data.ringSize = data.sampleCount;
+		createStructuredBuffer(device, &structuredBuffer, sizeof(float), data.sampleCount, wave.data());
 	}
-
-	createStructuredBuffer(device, &structuredBuffer, sizeof(float), data.sampleCount, wave);
-	createConstantBuffer(device, &constantBuffer, sizeof(Data), &data);
-	delete[] wave;
+	data.levelCount = pyramid.getLevelCount();
+	data.envelopeBlock = pyramid.getBlock();
+	for (UINT i = 0; data.levelCount > 0 && i <= data.levelCount; i++) { data.levelOffsets[i] = pyramid.getLevelOffset(i); }
+	createStructuredBuffer(device, &envelopeBuffer, sizeof(WaveformEnvelope), (UINT)pyramid.getEntryCount(), (void*)pyramid.getEnvelopes());
+	createConstantBuffer(device, &constantBuffer, &data);
 
 	loadPixelShader(device, &pixelShader, "asset\\WavePaint_ps.cso");
-	loadVertexShader(device, &vertexShader, "asset\\WavePaint_vs.cso", 0, 0);
+	loadVertexShader(device, &vertexShader, "asset\\WavePaint_vs.cso");
+	bindingTable = makeStageBindingTable(&vertexShader, &pixelShader);
+
+	//スペクトログラムはファイルから必要なフレームだけ求める (1行が1フレーム)
+	spectrogram.init(spectrogramConfig, data.sampleCount, spectrogramColumns);
+	createTexture(device, &spectrogramTexture, (UINT)spectrogram.getBinCount(), spectrogramColumns, DXGI_FORMAT_R32_FLOAT);
+	createConstantBuffer(device, &spectrumBuffer);
+	loadPixelShader(device, &spectrumShader, "asset\\Spectrogram_ps.cso");
+	spectrumBindingTable = makeStageBindingTable(&vertexShader, &spectrumShader);
 }
 
 void WavePainter::draw(ID3D11DeviceContext* immediateContext)
+{
+	if (view != View::waveform)
+	{
+		drawSpectrum(immediateContext);
+		return;
+	}
+	updateWindow(immediateContext);
+	drawWaveform(immediateContext);
+}
+
+void WavePainter::updateWindow(ID3D11DeviceContext* immediateContext)
+{
+	if (!window.isOpen()) { return; }
+	//表示範囲の先頭から, 変換の済んだチャンクをリングへ送る
+	const size_t position = (size_t)(data.tick * data.samplePerSec);
+	window.update(position, [&](size_t ringOffset, const float* samples, size_t count)
+		{
+			structuredBuffer.updateSubresource(immediateContext, samples, (UINT)(ringOffset * sizeof(float)), (UINT)(count * sizeof(float)));
+		});
+}
+
+void WavePainter::drawWaveform(ID3D11DeviceContext* immediateContext)
 {
 	immediateContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
 	immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 	pixelShader.set(immediateContext);
 	vertexShader.set(immediateContext);
-	structuredBuffer.set(immediateContext, 0, 0, 1, 0, 0, 0);
-	constantBuffer.updateSubresource(immediateContext, &data);
-	constantBuffer.set(immediateContext, 0, 0, 1, 0, 0, 0);
+	structuredBuffer.set(immediateContext, 0, bindingTable);
+	envelopeBuffer.set(immediateContext, 1, bindingTable);
+	bindConstants(immediateContext, &constantBuffer, data, ConstantSlot::pass, bindingTable);
+	immediateContext->Draw(4, 0);
+}
+
+void WavePainter::drawSpectrum(ID3D11DeviceContext* immediateContext)
+{
+	//前回から表示に入ったフレームだけ変換して行ごとに送る
+	const WavFile* file = &wavFile;
+	auto source = [file](size_t first, size_t count, float* out) { file->readMono(first, count, out); };
+	const size_t position = (size_t)(data.tick * data.samplePerSec);
+	const UINT binCount = (UINT)spectrogram.getBinCount();
+	spectrogram.update(source, position, [&](size_t column, const float* bins)
+		{
+			spectrogramTexture.updateSubresource(immediateContext, bins, 0, (UINT)column, binCount, 1, binCount * sizeof(float));
+		});
+	SpectrumData spectrum;
+	spectrum.color = data.color;
+	spectrum.latestFrame = (UINT)spectrogram.getLatestFrame();
+	spectrum.columnCount = spectrogramColumns;
+	spectrum.binCount = binCount;
+	spectrum.showSpectrum = view == View::spectrum ? 1 : 0;
+
+	immediateContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
+	immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	spectrumShader.set(immediateContext);
+	vertexShader.set(immediateContext);
+	spectrogramTexture.set(immediateContext, 2, spectrumBindingTable);
+	bindConstants(immediateContext, &spectrumBuffer, spectrum, ConstantSlot::pass, spectrumBindingTable);
 	immediateContext->Draw(4, 0);
 }
 
@@ -126,60 +129,522 @@ void WavePainter::bake(ID3D11DeviceContext* immediateContext, Layer* layer)
 	popStates(immediateContext);
 }
 
+void WavePainter::bakeScrolling(ID3D11DeviceContext* immediateContext, Layer* layer)
+{
+	assert(view == View::waveform && "Only the waveform view scrolls.");
+	const UINT width = (UINT)layer->viewport.Width;
+	if (scrolling.getWidth() != width) { scrolling.reset(width); }
+	//左端の列を求め, 列の境界単位でスクロールする
+	const int64_t column = (int64_t)floor((double)data.tick * width / visibleSeconds);
+	ScrollColumns runs[ScrollingBake::maxRuns];
+	const uint32_t runCount = scrolling.scroll(column, runs);
+	updateWindow(immediateContext);
+	if (runCount == 0) { return; }
+
+	pushStates(immediateContext);
+	layer->switching(immediateContext);
+	//前の内容は重ねずに置き換える
+	setBlendState(immediateContext, BlendState::none);
+	setDepthStencilState(immediateContext, DepthStencilState::none);
+	setRasterizerState(immediateContext, RasterizerState::scissor);
+	const float tick = data.tick;
+	for (uint32_t i = 0; i < runCount; i++)
+	{
+		//物理列xに絶対列x + wrap * widthが来るよう, 時刻をwrap周分ずらして描く
+		const D3D11_RECT rect{ (LONG)runs[i].x, 0, (LONG)(runs[i].x + runs[i].width), (LONG)layer->viewport.Height };
+		immediateContext->RSSetScissorRects(1, &rect);
+		data.tick = (float)(runs[i].wrap * visibleSeconds);
+		drawWaveform(immediateContext);
+	}
+	data.tick = tick;
+	popStates(immediateContext);
+}
+
+void WavePainter::bake(FrameGraphExecutor* frameGraph, FrameGraph::Resource target)
+{
+	assert(frameGraph && "The frame graph is invalid.");
+	frameGraph->addPass("WavePainter::bake",
+		[target](FrameGraph::Builder& builder) { builder.write(target); },
+		[this](ID3D11DeviceContext* immediateContext, FrameGraphExecutor&) { draw(immediateContext); });
+}
+
+//レーンごとに色相をずらした色
+static void getLaneColor(size_t index, size_t count, float* outColor)
+{
+	const float hue = count > 0 ? (float)index / (float)count * 6.0f : 0.0f;
+	const float x = 1.0f - fabsf(fmodf(hue, 2.0f) - 1.0f);
+	const float rgb[6][3] = { {1,x,0},{x,1,0},{0,1,x},{0,x,1},{x,0,1},{1,0,x} };
+	const float* c = rgb[(int)hue % 6];
+	outColor[0] = 0.5f + 0.5f * c[0];
+	outColor[1] = 0.5f + 0.5f * c[1];
+	outColor[2] = 0.5f + 0.5f * c[2];
+	outColor[3] = 1.0f;
+}
+
+WaveTracksPainter::WaveTracksPainter(ID3D11Device* device, const TrackDesc* trackDescs, UINT count, float laneGap)
+	:Painter(device)
+{
+	tracks.resize(count);
+	std::vector<float> samples(layoutTracks(trackDescs, count, laneGap, tracks.data()));
+	packTracks(trackDescs, count, tracks.data(), samples.data());
+	createResources(device, samples);
+}
+
+WaveTracksPainter::WaveTracksPainter(ID3D11Device* device, const char* const* waveFilenames, UINT fileCount, float laneGap)
+	:Painter(device)
+{
+	std::vector<WavFile> files(fileCount);
+	std::vector<TrackDesc> descs;
+	for (UINT i = 0; i < fileCount; i++)
+	{
+		const WavParseResult result = files[i].open(waveFilenames[i]);
+		assert(result == WavParseResult::ok && "The wave file is invalid.");
+		for (uint32_t c = 0; c < files[i].getFormat().channels; c++)
+		{
+			TrackDesc desc;
+			desc.sampleCount = files[i].getFrameCount();
+			desc.samplePerSec = files[i].getFormat().samplesPerSec;
+			descs.push_back(desc);
+		}
+	}
+	for (size_t i = 0; i < descs.size(); i++) { getLaneColor(i, descs.size(), descs[i].color); }
+	tracks.resize(descs.size());
+	std::vector<float> samples(layoutTracks(descs.data(), descs.size(), laneGap, tracks.data()));
+
+	//各チャンネルを共有バッファ上のレーンの位置へ直接展開する (隙間は0のまま)
+	size_t track = 0;
+	for (WavFile& file : files)
+	{
+		const WavFormat& format = file.getFormat();
+		std::vector<float*> channels(format.channels);
+		for (uint32_t c = 0; c < format.channels; c++) { channels[c] = samples.data() + tracks[track++].sampleOffset; }
+		convertPcm(file.getData(), getPcmFormat(format), format.channels, file.getFrameCount(), channels.data());
+	}
+	createResources(device, samples);
+}
+
+void WaveTracksPainter::createResources(ID3D11Device* device, std::vector<float>& samples)
+{
+	assert(!tracks.empty() && "There are no tracks.");
+	data.trackCount = (UINT)tracks.size();
+	//空のバッファは作れないので最低1要素
+	if (samples.empty()) { samples.push_back(0.0f); }
+	createStructuredBuffer(device, &sampleBuffer, sizeof(float), (UINT)samples.size(), samples.data());
+	createStructuredBuffer(device, &trackBuffer, sizeof(PackedTrack), (UINT)tracks.size(), tracks.data());
+	createConstantBuffer(device, &constantBuffer, &data);
+	loadPixelShader(device, &pixelShader, "asset\\WaveTracks_ps.cso");
+	loadVertexShader(device, &vertexShader, "asset\\WaveTracks_vs.cso");
+	bindingTable = makeStageBindingTable(&vertexShader, &pixelShader);
+}
+
+void WaveTracksPainter::draw(ID3D11DeviceContext* immediateContext)
+{
+	//全レーンをインスタンスとして1回で描く
+	immediateContext->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
+	immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	pixelShader.set(immediateContext);
+	vertexShader.set(immediateContext);
+	sampleBuffer.set(immediateContext, 0, bindingTable);
+	trackBuffer.set(immediateContext, 1, bindingTable);
+	bindConstants(immediateContext, &constantBuffer, data, ConstantSlot::pass, bindingTable);
+	immediateContext->DrawInstanced(4, data.trackCount, 0, 0);
+}
+
 DestructionPainter::DestructionPainter(ID3D11Device* device)
 	:Painter(device)
 {
-	createConstantBuffer(device, &constantBuffer, sizeof(Data), &data);
+	createConstantBuffer(device, &constantBuffer);
+	createConstantBuffer(device, &materialBuffer, &materials);
+	createConstantBuffer(device, &objectBuffer);
 	loadPixelShader(device, &pixelShader, "asset\\Destruction_ps.cso");
-	D3D11_INPUT_ELEMENT_DESC inputElementDesc[] =
-	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	};
-	loadVertexShader(device, &vertexShader, "asset\\Destruction_vs.cso", inputElementDesc, 2);
+	const auto inputElements = InputElements<Geometry::Vertex>()
+		.add("POSITION", &Geometry::Vertex::position)
+		.add("NORMAL", &Geometry::Vertex::normal);
+	loadVertexShader(device, &vertexShader, "asset\\Destruction_vs.cso", inputElements);
+	const auto quantizedElements = InputElements<Geometry::QuantizedVertex>()
+		.add("POSITION", &Geometry::QuantizedVertex::position, DXGI_FORMAT_R16G16B16A16_UNORM)
+		.add("NORMAL", &Geometry::QuantizedVertex::normal, DXGI_FORMAT_R16G16_SNORM);
+	loadVertexShader(device, &quantizedVertexShader, "asset\\DestructionQuantized_vs.cso", quantizedElements);
 	loadDomainShader(device, &domainShader, "asset\\Destruction_ds.cso");
 	loadHullShader(device, &hullShader, "asset\\Destruction_hs.cso");
 	loadGeometryShader(device, &geometryShader, "asset\\Destruction_gs.cso");
+	bindingTables[0] = makeStageBindingTable(&vertexShader, &pixelShader, &domainShader, &hullShader, &geometryShader);
+	bindingTables[1] = makeStageBindingTable(&quantizedVertexShader, &pixelShader, &domainShader, &hullShader, &geometryShader);
+	//ドメインシェーダーの出力からPOSITIONとNORMALだけを書き出す
+	const D3D11_SO_DECLARATION_ENTRY soEntries[] =
+	{
+		{ 0, "POSITION", 0, 0, 3, 0 },
+		{ 0, "NORMAL", 0, 0, 3, 0 },
+	};
+	createStreamOutputShader(device, &captureShader, "asset\\Destruction_ds.cso", soEntries, ARRAYSIZE(soEntries), sizeof(TessellatedVertex));
+	const auto cachedElements = InputElements<TessellatedVertex>()
+		.add("POSITION", &TessellatedVertex::position)
+		.add("NORMAL", &TessellatedVertex::normal);
+	loadVertexShader(device, &cachedVertexShader, "asset\\DestructionCached_vs.cso", cachedElements);
+	cachedBindingTable = makeStageBindingTable(&cachedVertexShader, &pixelShader, nullptr, nullptr, &geometryShader);
+	const D3D11_SO_DECLARATION_ENTRY frameEntries[] =
+	{
+		{ 0, "CENTER", 0, 0, 3, 0 },
+		{ 0, "FACENORMAL", 0, 0, 3, 0 },
+	};
+	createStreamOutputShader(device, &frameCaptureShader, "asset\\DestructionFrame_gs.cso", frameEntries, ARRAYSIZE(frameEntries), sizeof(TriangleFrame));
+	loadVertexShader(device, &pulledVertexShader, "asset\\DestructionPulled_vs.cso");
+	pulledBindingTable = makeStageBindingTable(&pulledVertexShader, &pixelShader);
+	//適応分割の計測用. 毎フレーム作らずに使い回す
+	const D3D11_QUERY_DESC statisticsDesc{ D3D11_QUERY_PIPELINE_STATISTICS, 0 };
+	for (size_t i = 0; i < maxPendingQueries; i++)
+	{
+		ComPtr<ID3D11Query> query;
+		const HRESULT hr = device->CreateQuery(&statisticsDesc, query.GetAddressOf());
+		hrInspection(hr);
+		if (SUCCEEDED(hr)) { idleQueries.push_back(std::move(query)); }
+	}
+}
+
+DestructionPainter::PassConstants DestructionPainter::makePassConstants(const Geometry& geometry, bool adaptiveFactors)const
+{
+	PassConstants pass;
+	pass.data = data;
+	if (geometry.quantized)
+	{
+		pass.positionScale = Float4(geometry.dequantization._11, geometry.dequantization._22, geometry.dequantization._33, 0);
+		pass.positionBias = Float4(geometry.dequantization._41, geometry.dequantization._42, geometry.dequantization._43, 0);
+	}
+	if (!adaptiveFactors) { return pass; }
+	//視錐台はワールド空間で渡し, ハルシェーダーでパッチごとに判定する
+	TessellationConstants& tessellation = pass.tessellation;
+	extractFrustumPlanes(tessellation.frustumPlanes, &frame->data.viewProjection._11);
+	tessellation.pixelsPerUnit = adaptive.pixelsPerUnit;
+	tessellation.pixelsPerSegment = adaptive.pixelsPerSegment;
+	tessellation.budgetScale = budgetScale;
+	tessellation.adaptive = 1;
+	tessellation.backfaceCulling = adaptive.backfaceCulling ? 1 : 0;
+	return pass;
+}
+
+void DestructionPainter::drawBegin(ID3D11DeviceContext* immediateContext)
+{
+	Painter::drawBegin(immediateContext);
+	//前のキャプチャがCPUの参照と違う数を書いていたら, 以後はキャッシュせず毎回テッセレートする
+	captures.forEachValue([&](TessellationCapture& capture)
+	{
+		D3D11_QUERY_DATA_SO_STATISTICS captureStatistics{};
+		if (!capture.queryPending || immediateContext->GetData(capture.query.Get(), &captureStatistics, sizeof(captureStatistics), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) { return; }
+		capture.queryPending = false;
+		const bool matches = captureStatistics.NumPrimitivesWritten == capture.expectedPrimitives && captureStatistics.PrimitivesStorageNeeded == capture.expectedPrimitives;
+		assert(matches && "The tessellator output differs from the CPU reference.");
+		if (!matches) { captureMismatch = true; }
+	});
+	if (captureMismatch) { captures.clear(); }
+	//数フレーム前の計測結果で予算の倍率を合わせる
+	while (!statisticsQueries.empty())
+	{
+		D3D11_QUERY_DATA_PIPELINE_STATISTICS statistics{};
+		if (immediateContext->GetData(statisticsQueries.front().first.Get(), &statistics, sizeof(statistics), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) { break; }
+		budgetScale = adaptive.triangleBudget > 0 ? updateBudgetScale(budgetScale, statistics.CInvocations, adaptive.triangleBudget) : 1.0f;
+		report.fixedTriangles = statisticsQueries.front().second;
+		report.adaptiveTriangles = statistics.CInvocations;
+		report.budgetScale = budgetScale;
+		idleQueries.push_back(std::move(statisticsQueries.front().first));
+		statisticsQueries.pop_front();
+	}
+	//全部が結果待ちならこのフレームは計測しない
+	if (!adaptive.enabled || idleQueries.empty()) { return; }
+	activeQuery = std::move(idleQueries.back());
+	idleQueries.pop_back();
+	frameFixedTriangles = 0;
+	immediateContext->Begin(activeQuery.Get());
+}
+
+void DestructionPainter::drawEnd(ID3D11DeviceContext* immediateContext)
+{
+	if (activeQuery)
+	{
+		immediateContext->End(activeQuery.Get());
+		statisticsQueries.emplace_back(activeQuery, frameFixedTriangles);
+		activeQuery.Reset();
+	}
+	Painter::drawEnd(immediateContext);
 }
 
-void DestructionPainter::draw(ID3D11DeviceContext* immediateContext, Geometry* geometry)
+DestructionPainter::TessellationCapture* DestructionPainter::updateTessellationCache(ID3D11DeviceContext* immediateContext, Geometry* geometry, const MeshLod& level, const ObjectConstants& object)
 {
+	TessellationKey key;
+	key.geometryId = geometry->id;
+	key.indexOffset = level.indexOffset;
+	key.indexCount = level.indexCount;
+	key.divNum = data.divNum;
+	key.quantized = geometry->quantized;
+	if (captureMismatch) { return nullptr; }
+	//パッチごとの三角形数はCPUの参照テッセレーターと同じ
+	const UINT verticesPerPatch = getTessellatedTriangleCount(data.divNum) * 3;
+	const UINT64 vertexCount = UINT64(level.indexCount / 3) * verticesPerPatch;
+	if (vertexCount == 0 || vertexCount * sizeof(TessellatedVertex) > maxTessellationCacheBytes) { return nullptr; }
+	const UINT triangleCount = static_cast<UINT>(vertexCount / 3);
+	ComPtr<ID3D11Device> device;
+	immediateContext->GetDevice(device.GetAddressOf());
+	captures.setCapacity((std::max)(maxTessellationCaptures, 1u));
+	bool hit = false;
+	TessellationCapture& capture = captures.acquire(key, &hit);
+	if (hit) { return &capture; }
+	//キャプチャした三角形数の確認用. 枠ごとに一度だけ作り, 作れなければ確認せずに使う
+	if (!capture.query)
+	{
+		const D3D11_QUERY_DESC captureDesc{ D3D11_QUERY_SO_STATISTICS, 0 };
+		const HRESULT hr = device->CreateQuery(&captureDesc, capture.query.GetAddressOf());
+		hrInspection(hr);
+	}
+	//追い出されたキャプチャのバッファは足りる限りそのまま使う
+	if (vertexCount > capture.vertices.count)
+	{
+		if (FAILED(createStreamOutputBuffer(device.Get(), &capture.vertices, sizeof(TessellatedVertex), static_cast<UINT>(vertexCount), true)))
+		{
+			capture.vertices.count = 0;
+			captures.erase(key);
+			return nullptr;
+		}
+	}
+	if (triangleCount > capture.frames.count)
+	{
+		if (FAILED(createStreamOutputBuffer(device.Get(), &capture.frames, sizeof(TriangleFrame), triangleCount, true)))
+		{
+			capture.frames.count = 0;
+			captures.erase(key);
+			return nullptr;
+		}
+	}
+	//前回の頂点プル描画で読んでいたら外してから書き込む
+	ID3D11ShaderResourceView* nullViews[2] = {};
+	immediateContext->VSSetShaderResources(0, 2, nullViews);
+
+	//VS・HS・DSまで通し、ラスタライズせずに書き出す
+	const StageBindingTable& bindings = bindingTables[geometry->quantized ? 1 : 0];
 	immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
-	setDepthStencilState(immediateContext, DepthStencilState::common);
-	setRasterizerState(immediateContext, RasterizerState::solid);
-	pixelShader.set(immediateContext);
-	vertexShader.set(immediateContext);
-	domainShader.set(immediateContext);
+	if (geometry->quantized) { quantizedVertexShader.set(immediateContext); }
+	else { vertexShader.set(immediateContext); }
 	hullShader.set(immediateContext);
-	geometryShader.set(immediateContext);
-	constantBuffer.updateSubresource(immediateContext, &data);
-	constantBuffer.set(immediateContext, 0, true, true, true, true, true);
+	domainShader.set(immediateContext);
+	captureShader.set(immediateContext);
+	immediateContext->PSSetShader(nullptr, nullptr, 0);
+	frame->set(immediateContext, bindings);
+	constantBuffer.update(immediateContext, makePassConstants(*geometry, false));
+	constantBuffer.set(immediateContext, ConstantSlot::pass, bindings);
+	bindConstants(immediateContext, &objectBuffer, object, ConstantSlot::object, bindings);
 	geometry->set(immediateContext);
-	immediateContext->DrawIndexed(geometry->indexBuffer.count, 0, 0);
+	capture.vertices.setTarget(immediateContext);
+	//結果は後のdrawBeginで読む. 確認待ちの間に作り直したキャプチャは確認しない
+	const bool checkCapture = capture.query && !capture.queryPending;
+	if (checkCapture) { immediateContext->Begin(capture.query.Get()); }
+	immediateContext->DrawIndexed(level.indexCount, level.indexOffset, 0);
+	if (checkCapture)
+	{
+		immediateContext->End(capture.query.Get());
+		capture.expectedPrimitives = triangleCount;
+		capture.queryPending = true;
+	}
+	//三角形ごとの中心と面法線を一度だけ求めておく
+	immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	cachedVertexShader.set(immediateContext);
+	immediateContext->HSSetShader(nullptr, nullptr, 0);
+	immediateContext->DSSetShader(nullptr, nullptr, 0);
+	frameCaptureShader.set(immediateContext);
+	capture.frames.setTarget(immediateContext);
+	capture.vertices.set(immediateContext, 0);
+	//書き込まれた頂点数はバッファ側が覚えている
+	immediateContext->DrawAuto();
+	ID3D11Buffer* nullBuffer = nullptr;
+	const UINT offset = 0;
+	immediateContext->SOSetTargets(1, &nullBuffer, &offset);
+
+	capture.verticesPerPatch = verticesPerPatch;
+	return &capture;
 }
 
-ToonPainter::ToonPainter(ID3D11Device* device)
-	:Painter(device)
+void DestructionPainter::draw(ID3D11DeviceContext* immediateContext, Geometry* geometry, const Float4x4& world, UINT materialIndex, UINT lod)
 {
-	createConstantBuffer(device, &constantBuffer, ((sizeof(Data) + (15)) & ~15), &data);
-	D3D11_INPUT_ELEMENT_DESC inputElementDesc[] =
+	assert(frame && "The frame constants are not set.");
+	assert(materialIndex < maxMaterials && "The material index is out of range.");
+	setDepthStencilState(immediateContext, DepthStencilState::common);
+	setRasterizerState(immediateContext, RasterizerState::solid);
+	ObjectConstants object;
+	object.world = world;
+	object.materialIndex = materialIndex;
+	const MeshLod level = geometry->getLod(lod);
+	//適応分割は視点で変わるのでキャッシュしない
+	TessellationCapture* capture = cachedTessellation && !adaptive.enabled ? updateTessellationCache(immediateContext, geometry, level, object) : nullptr;
+	const bool cached = capture != nullptr;
+	const bool pulled = cached && vertexPulling;
+	const StageBindingTable& bindings = pulled ? pulledBindingTable : cached ? cachedBindingTable : bindingTables[geometry->quantized ? 1 : 0];
+	pixelShader.set(immediateContext);
+	if (pulled)
 	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	};
+		//頂点シェーダーだけで三角形ごとの拡大・回転・移動を行う
+		immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		pulledVertexShader.set(immediateContext);
+		immediateContext->HSSetShader(nullptr, nullptr, 0);
+		immediateContext->DSSetShader(nullptr, nullptr, 0);
+		immediateContext->GSSetShader(nullptr, nullptr, 0);
+		capture->vertices.view.set(immediateContext, 0, bindings);
+		capture->frames.view.set(immediateContext, 1, bindings);
+	}
+	else if (cached)
+	{
+		//テッセレーション済みの三角形をVS・GSだけで描く
+		immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		cachedVertexShader.set(immediateContext);
+		immediateContext->HSSetShader(nullptr, nullptr, 0);
+		immediateContext->DSSetShader(nullptr, nullptr, 0);
+		geometryShader.set(immediateContext);
+		capture->vertices.set(immediateContext, 0);
+	}
+	else
+	{
+		immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
+		if (geometry->quantized) { quantizedVertexShader.set(immediateContext); }
+		else { vertexShader.set(immediateContext); }
+		domainShader.set(immediateContext);
+		hullShader.set(immediateContext);
+		geometryShader.set(immediateContext);
+		geometry->set(immediateContext);
+	}
+	//フレーム・パス・マテリアルは変化したときだけ転送され、描画ごとに送るのはワールド行列のみ
+	frame->set(immediateContext, bindings);
+	constantBuffer.update(immediateContext, makePassConstants(*geometry, adaptive.enabled));
+	constantBuffer.set(immediateContext, ConstantSlot::pass, bindings);
+	materialBuffer.update(immediateContext, materials);
+	materialBuffer.set(immediateContext, ConstantSlot::material, bindings);
+	bindConstants(immediateContext, &objectBuffer, object, ConstantSlot::object, bindings);
+	if (frustumCulling && geometry->meshlets.count > 0 && (lod == 0 || geometry->getLodCount() == 1))
+	{
+		MeshletCullParams params = getMeshletCullParams(world, frame->data.viewProjection);
+		//ジオメトリシェーダーによる拡大・回転・移動の分だけ境界球を広げる
+		const Matrix worldMatrix = XMLoadFloat4x4(&world);
+		const float scale = fabsf(data.scale);
+		params.radiusScale = (data.rotation == 0 && scale <= 1) ? 1.0f : 1.0f + 2.0f * scale;
+		const float minWorldScale = sqrtf((std::min)(XMVectorGetX(XMVector3LengthSq(worldMatrix.r[0])),
+			(std::min)(XMVectorGetX(XMVector3LengthSq(worldMatrix.r[1])), XMVectorGetX(XMVector3LengthSq(worldMatrix.r[2])))));
+		params.radiusBias = fabsf(data.move) / (std::max)(minWorldScale, 1e-6f);
+		cullMeshlets(drawRanges, geometry->meshlets, params);
+		if (activeQuery)
+		{
+			for (const MeshletDrawRange& range : drawRanges) { frameFixedTriangles += range.indexCount / 3 * UINT64(getTessellatedTriangleCount(data.divNum)); }
+		}
+		if (!cached)
+		{
+			drawMeshletRanges(immediateContext, drawRanges);
+			return;
+		}
+		//パッチは同じ数の三角形になるので, インデックス区間をそのまま頂点区間に置き換えられる
+		for (const MeshletDrawRange& range : drawRanges)
+		{
+			immediateContext->Draw(range.indexCount / 3 * capture->verticesPerPatch, (range.indexOffset - level.indexOffset) / 3 * capture->verticesPerPatch);
+		}
+		return;
+	}
+	if (activeQuery) { frameFixedTriangles += level.indexCount / 3 * UINT64(getTessellatedTriangleCount(data.divNum)); }
+	if (cached)
+	{
+		//頂点プルはキャッシュを頂点バッファとして束ねないのでDrawAutoは使えない
+		if (pulled) { immediateContext->Draw(level.indexCount / 3 * capture->verticesPerPatch, 0); }
+		else { immediateContext->DrawAuto(); }
+		return;
+	}
+	immediateContext->DrawIndexed(level.indexCount, level.indexOffset, 0);
+}
+
+ToonPainter::ToonPainter(ID3D11Device* device, UINT maxInstances)
+	:Painter(device), instanceCapacity(maxInstances)
+{
+	createConstantBuffer(device, &constantBuffer, &data);
+	createConstantBuffer(device, &materialBuffer, &materials);
+	createConstantBuffer(device, &objectBuffer);
+	const auto inputElements = InputElements<Geometry::Vertex>()
+		.add("POSITION", &Geometry::Vertex::position)
+		.add("NORMAL", &Geometry::Vertex::normal);
 	loadPixelShader(device, &pixelShader, "asset\\Toon_ps.cso");
-	loadVertexShader(device, &vertexShader, "asset\\Toon_vs.cso", inputElementDesc, 2);
+	loadVertexShader(device, &vertexShader, "asset\\Toon_vs.cso", inputElements);
+	const auto quantizedElements = InputElements<Geometry::QuantizedVertex>()
+		.add("POSITION", &Geometry::QuantizedVertex::position, DXGI_FORMAT_R16G16B16A16_UNORM)
+		.add("NORMAL", &Geometry::QuantizedVertex::normal, DXGI_FORMAT_R16G16_SNORM);
+	loadVertexShader(device, &quantizedVertexShader, "asset\\ToonQuantized_vs.cso", quantizedElements);
+	assert(maxInstances > 0 && "The instance capacity is invalid.");
+	loadPixelShader(device, &instancedPixelShader, "asset\\ToonInstanced_ps.cso");
+	loadVertexShader(device, &instancedVertexShader, "asset\\ToonInstanced_vs.cso", inputElements);
+	loadVertexShader(device, &instancedQuantizedVertexShader, "asset\\ToonInstancedQuantized_vs.cso", quantizedElements);
+	createStructuredBuffer(device, &instanceBuffer, sizeof(PackedInstance), instanceCapacity);
+	packedInstances.resize(instanceCapacity);
+	bindingTables[0] = makeStageBindingTable(&vertexShader, &pixelShader);
+	bindingTables[1] = makeStageBindingTable(&quantizedVertexShader, &pixelShader);
+	instancedBindingTables[0] = makeStageBindingTable(&instancedVertexShader, &instancedPixelShader);
+	instancedBindingTables[1] = makeStageBindingTable(&instancedQuantizedVertexShader, &instancedPixelShader);
 }
 
-void ToonPainter::draw(ID3D11DeviceContext* immediateContext, Geometry* geometry)
+void ToonPainter::draw(ID3D11DeviceContext* immediateContext, Geometry* geometry, const Float4x4& world, UINT materialIndex, UINT lod)
 {
+	assert(frame && "The frame constants are not set.");
+	assert(materialIndex < maxMaterials && "The material index is out of range.");
 	immediateContext->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	setDepthStencilState(immediateContext, DepthStencilState::common);
 	setRasterizerState(immediateContext, RasterizerState::solid);
+	const StageBindingTable& bindings = bindingTables[geometry->quantized ? 1 : 0];
 	pixelShader.set(immediateContext);
-	vertexShader.set(immediateContext);
-	constantBuffer.updateSubresource(immediateContext, &data);
-	constantBuffer.set(immediateContext, 0, true, true, true, true, true);
+	if (geometry->quantized) { quantizedVertexShader.set(immediateContext); }
+	else { vertexShader.set(immediateContext); }
+	//フレーム・パス・マテリアルは変化したときだけ転送され、描画ごとに送るのはワールド行列のみ
+	frame->set(immediateContext, bindings);
+	constantBuffer.update(immediateContext, data);
+	constantBuffer.set(immediateContext, ConstantSlot::pass, bindings);
+	materialBuffer.update(immediateContext, materials);
+	materialBuffer.set(immediateContext, ConstantSlot::material, bindings);
+	//量子化された頂点の逆量子化はworldに畳み込んで送る
+	bindConstants(immediateContext, &objectBuffer, makeObjectConstants(*geometry, world, materialIndex), ConstantSlot::object, bindings);
+	geometry->set(immediateContext);
+	if (frustumCulling && geometry->meshlets.count > 0 && (lod == 0 || geometry->getLodCount() == 1))
+	{
+		MeshletCullParams params = getMeshletCullParams(world, frame->data.viewProjection, coneCulling ? &frame->data.eyePos : nullptr);
+		cullMeshlets(drawRanges, geometry->meshlets, params);
+		drawMeshletRanges(immediateContext, drawRanges);
+		return;
+	}
+	MeshLod level = geometry->getLod(lod);
+	immediateContext->DrawIndexed(level.indexCount, level.indexOffset, 0);
+}
+
+void ToonPainter::drawInstanced(ID3D11DeviceContext* immediateContext, Geometry* geometry,
+	const Float4x4* worlds, const Float4* colors, UINT count, UINT lod)
+{
+	static_assert(sizeof(Float4x4) == sizeof(float) * 16 && sizeof(Float4) == sizeof(float) * 4, "Instance arrays must be tightly packed");
+	if (count == 0) { return; }
+	assert(frame && "The frame constants are not set.");
+	immediateContext->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	setDepthStencilState(immediateContext, DepthStencilState::common);
+	setRasterizerState(immediateContext, RasterizerState::solid);
+	const StageBindingTable& bindings = instancedBindingTables[geometry->quantized ? 1 : 0];
+	instancedPixelShader.set(immediateContext);
+	if (geometry->quantized)
+	{
+		//逆量子化はインスタンスの行列に畳み込み, 法線の拡大だけをオブジェクトの定数で送る
+		bindConstants(immediateContext, &objectBuffer, makeObjectConstants(*geometry, Float4x4()), ConstantSlot::object, bindings);
+		instancedQuantizedVertexShader.set(immediateContext);
+	}
+	else
+	{
+		instancedVertexShader.set(immediateContext);
+	}
+	//インスタンス間で共通のデータは一度だけ転送する
+	frame->set(immediateContext, bindings);
+	constantBuffer.update(immediateContext, data);
+	constantBuffer.set(immediateContext, ConstantSlot::pass, bindings);
 	geometry->set(immediateContext);
-	immediateContext->DrawIndexed(geometry->indexBuffer.count, 0, 0);
+	MeshLod level = geometry->getLod(lod);
+	//全インスタンスを一度に (大きければ並列に) 詰めてから, バッファに収まる分ずつ描く
+	if (packedInstances.size() < count) { packedInstances.resize(count); }
+	packInstances(packedInstances.data(), &worlds[0]._11, colors ? &colors[0].x : nullptr, count, geometry->quantized ? &geometry->dequantization._11 : nullptr);
+	for (UINT first = 0; first < count; first += instanceCapacity)
+	{
+		const UINT batch = (std::min)(count - first, instanceCapacity);
+		instanceBuffer.updateSubresource(immediateContext, &packedInstances[first], 0, batch * (UINT)sizeof(PackedInstance));
+		instanceBuffer.set(immediateContext, 0, bindings);
+		immediateContext->DrawIndexedInstanced(level.indexCount, batch, level.indexOffset, 0, 0);
+	}
 }
@@ -1,6 +1,37 @@
 ﻿#pragma once
 #include "../painter/Painter.h"
+#include "../painter/FrameGraphExecutor.h"
+#include "../func/AdaptiveTessellation.h"
+#include "../func/DestructionMath.h"
+#include "../func/InstancePacking.h"
+#include "../func/LruCache.h"
+#include "../func/ScrollingBake.h"
+#include "../func/Spectrogram.h"
+#include "../func/StreamingWindow.h"
+#include "../func/TrackPacking.h"
+#include "../func/TriangleTessellator.h"
+#include "../func/WavFile.h"
+#include "../func/WaveformPyramid.h"
 #include <cereal/cereal.hpp>
+#include <cereal/types/common.hpp>
+#include <deque>
+
+//blocks shared by the painters; world and matColor used to live in each painter's Data
+template<class T>
+void serialize(T& archive, FrameConstants& frame)
+{
+	archive(
+		cereal::make_nvp("viewProjection", frame.viewProjection),
+		cereal::make_nvp("eyePos", frame.eyePos),
+		cereal::make_nvp("lightDir", frame.lightDir)
+	);
+}
+
+template<class T>
+void serialize(T& archive, MaterialConstants& materials)
+{
+	archive(cereal::make_nvp("colors", materials.colors));
+}
 
 class WavePainter :public Painter
 {
@@ -8,8 +39,26 @@ private:
 	PixelShader			pixelShader;
 	VertexShader		vertexShader;
 	StructuredBuffer	structuredBuffer;
-	ConstantBuffer		constantBuffer;
+	StructuredBuffer	envelopeBuffer;
+	StageBindingTable	bindingTable;
+	WavFile				wavFile;
+	StreamingWindow		window;
+	PixelShader			spectrumShader;
+	StageBindingTable	spectrumBindingTable;
+	Texture				spectrogramTexture;
+	Spectrogram			spectrogram;
+	ScrollingBake		scrolling;
 public:
+	//Seconds across the target (fineness in WavePaint_ps)
+	static constexpr float visibleSeconds = 50;
+	enum class View { waveform, spectrum, spectrogram };
+	View view = View::waveform;
+	//Frames kept in the spectrogram texture
+	static constexpr UINT spectrogramColumns = 1024;
+	//Ring length when streaming, longer than the 50 seconds WavePaint_ps shows
+	static constexpr UINT streamingSeconds = 64;
+	//Coarser level 0 when streaming keeps the pyramid at 0.375 bytes per sample
+	static constexpr UINT streamingEnvelopeBlock = 64;
 	struct Data
 	{
 		Float4 color{1,1,1,1};
@@ -17,6 +66,13 @@ public:
 		UINT samplePerSec = 0;
 		float tick = 0;
 		float thickness = 0.02f;
+		//WaveformPyramid layout, filled at load time
+		UINT levelCount = 0;
+		UINT envelopeBlock = 0;
+		//Length of structuredBuffer (the ring when streaming)
+		UINT ringSize = 0;
+		UINT padding = 0;
+		UINT levelOffsets[WaveformPyramid::maxLevels + 1] = {};
 
 		template<class T>
 		void serialize(T& archive)
@@ -30,10 +86,73 @@ public:
 			);
 		}
 	}data;
-	WavePainter(ID3D11Device* device, const char* waveFilename);
+	struct SpectrumData
+	{
+		Float4 color{1,1,1,1};
+		UINT latestFrame = 0;
+		UINT columnCount = 0;
+		UINT binCount = 0;
+		UINT showSpectrum = 0;
+	};
+private:
+	ConstantBuffer<Data> constantBuffer;
+	ConstantBuffer<SpectrumData> spectrumBuffer;
+	void updateWindow(ID3D11DeviceContext* immediateContext);
+	void drawWaveform(ID3D11DeviceContext* immediateContext);
+	void drawSpectrum(ID3D11DeviceContext* immediateContext);
+public:
+	//streaming maps the file and keeps only a window around tick on the GPU
+	WavePainter(ID3D11Device* device, const char* waveFilename, bool streaming = false, const SpectrogramConfig& spectrogramConfig = SpectrogramConfig());
 	void tick(float elapsedTime) { data.tick += elapsedTime; }
 	void draw(ID3D11DeviceContext* immediateContext);
 	void bake(ID3D11DeviceContext* immediateContext, Layer* layer);
+	void bake(FrameGraphExecutor* frameGraph, FrameGraph::Resource target);
+	//Waveform view only: layer is a circular buffer and only the columns scrolled into view are drawn.
+	//Composite it with getScrollTexcoordOffset() added to texcoord.x (SpritePainter::Data).
+	void bakeScrolling(ID3D11DeviceContext* immediateContext, Layer* layer);
+	float getScrollTexcoordOffset()const { return scrolling.getTexcoordOffset(); }
+	//Redraws the whole layer on the next bakeScrolling (after changing data)
+	void invalidateScrolling() { scrolling.invalidate(); }
+};
+HLSL_PACKING_CHECK(WavePainter::Data, sampleCount);
+HLSL_PACKING_CHECK(WavePainter::Data, thickness);
+HLSL_PACKING_CHECK(WavePainter::Data, levelOffsets);
+HLSL_PACKING_CHECK(WavePainter::SpectrumData, latestFrame);
+
+/****************************************************************
+	Many waveforms as lanes stacked top to bottom, drawn with one
+	DrawInstanced: the samples of every lane share one
+	StructuredBuffer and each instance reads its PackedTrack
+	(color, rectangle, offset) from another.
+	From files every channel becomes a lane.
+****************************************************************/
+class WaveTracksPainter :public Painter
+{
+private:
+	PixelShader			pixelShader;
+	VertexShader		vertexShader;
+	StructuredBuffer	sampleBuffer;
+	StructuredBuffer	trackBuffer;
+	StageBindingTable	bindingTable;
+	std::vector<PackedTrack> tracks;
+public:
+	struct Data
+	{
+		float tick = 0;
+		UINT trackCount = 0;
+		Float2 padding{};
+	}data;
+private:
+	ConstantBuffer<Data> constantBuffer;
+	void createResources(ID3D11Device* device, std::vector<float>& samples);
+public:
+	//laneGap = part of each lane left empty below the waveform
+	WaveTracksPainter(ID3D11Device* device, const TrackDesc* trackDescs, UINT count, float laneGap = 0.1f);
+	WaveTracksPainter(ID3D11Device* device, const char* const* waveFilenames, UINT fileCount, float laneGap = 0.1f);
+	void tick(float elapsedTime) { data.tick += elapsedTime; }
+	void draw(ID3D11DeviceContext* immediateContext);
+	UINT getTrackCount()const { return (UINT)tracks.size(); }
+	const PackedTrack& getTrack(UINT index)const { return tracks[index]; }
 };
 
 class DestructionPainter :public Painter
@@ -44,14 +163,54 @@ private:
 	DomainShader		domainShader;
 	HullShader			hullShader;
 	GeometryShader		geometryShader;
-	ConstantBuffer		constantBuffer;
+	VertexShader		quantizedVertexShader;
+	std::vector<MeshletDrawRange> drawRanges;
+	//[0] = float vertices, [1] = quantized
+	StageBindingTable	bindingTables[2];
+	//tessellated triangles captured by stream output, redrawn with VS + GS
+	struct TessellatedVertex
+	{
+		Float3 position;
+		Float3 normal;
+	};
+	struct TessellationKey
+	{
+		UINT64 geometryId = 0;
+		UINT indexOffset = 0;
+		UINT indexCount = 0;
+		float divNum = 0;
+		bool quantized = false;
+		bool operator==(const TessellationKey& other)const
+		{
+			return geometryId == other.geometryId && indexOffset == other.indexOffset && indexCount == other.indexCount
+				&& divNum == other.divNum && quantized == other.quantized;
+		}
+	};
+	//one capture per key; an evicted capture keeps its buffers and query for the next key
+	struct TessellationCapture
+	{
+		StreamOutputBuffer	vertices;
+		//vertex pulling path: TriangleFrame per cached triangle, read with the vertices by pulledVertexShader
+		StreamOutputBuffer	frames;
+		UINT				verticesPerPatch = 0;
+		//primitives written by the capture, read a few frames late; a count other than the CPU one disables the cache
+		ComPtr<ID3D11Query>	query;
+		UINT64				expectedPrimitives = 0;
+		bool				queryPending = false;
+	};
+	GeometryShader		captureShader;
+	VertexShader		cachedVertexShader;
+	StageBindingTable	cachedBindingTable;
+	GeometryShader		frameCaptureShader;
+	VertexShader		pulledVertexShader;
+	StageBindingTable	pulledBindingTable;
+	LruCache<TessellationKey, TessellationCapture> captures;
+	bool				captureMismatch = false;
 
 public:
+	//per pass
 	struct Data
 	{
-		Float4x4 world = {};
-		Float4x4 viewProjection = {};
-		Float4 color = { 1,1,1,1 };
 		float divNum = 6;
 		float move = 0;
 		float scale = 1;
@@ -61,9 +220,6 @@ public:
 		void serialize(T& archive)
 		{
 			archive(
-				CEREAL_NVP(world),
-				CEREAL_NVP(viewProjection),
-				CEREAL_NVP(color),
 				CEREAL_NVP(divNum),
 				CEREAL_NVP(move),
 				CEREAL_NVP(scale),
@@ -71,8 +227,82 @@ public:
 			);
 		}
 	}data;
+	//colors selected by the materialIndex of draw
+	MaterialConstants materials;
+
+	template<class T>
+	void serialize(T& archive)
+	{
+		archive(
+			CEREAL_NVP(data),
+			CEREAL_NVP(materials)
+		);
+	}
+	//Screen-space tessellation factors per edge, capped by divNum; ignores cachedTessellation
+	struct Adaptive
+	{
+		bool enabled = false;
+		//also drop patches facing away from the eye (the rasterizer does not cull)
+		bool backfaceCulling = true;
+		float pixelsPerSegment = 8;
+		//getPixelsPerUnit(projection, viewport height)
+		float pixelsPerUnit = 540;
+		//tessellated triangles per frame (drawBegin to drawEnd), 0 = no limit
+		UINT64 triangleBudget = 1 << 21;
+	}adaptive;
+	//Triangles of the last measured frame and what fixed divNum would have produced
+	struct TessellationReport
+	{
+		UINT64 fixedTriangles = 0;
+		UINT64 adaptiveTriangles = 0;
+		//factor scale now in use
+		float budgetScale = 1;
+	};
+private:
+	//b1: Data followed by the adaptive tessellation block and the dequantization of the drawn geometry.
+	//The destruction stages work in object space, so it cannot be folded into world as ToonPainter does.
+	struct PassConstants
+	{
+		Data data;
+		TessellationConstants tessellation;
+		Float4 positionScale = { 1,1,1,0 };
+		Float4 positionBias = { 0,0,0,0 };
+	};
+	ConstantBuffer<PassConstants> constantBuffer;
+	ConstantBuffer<MaterialConstants> materialBuffer;
+	ConstantBuffer<ObjectConstants> objectBuffer;
+	//pipeline statistics of adaptive frames, read a few frames late; the queries are created once and recycled
+	static constexpr size_t maxPendingQueries = 4;
+	std::vector<ComPtr<ID3D11Query>> idleQueries;
+	std::deque<std::pair<ComPtr<ID3D11Query>, UINT64>> statisticsQueries;
+	ComPtr<ID3D11Query> activeQuery;
+	UINT64 frameFixedTriangles = 0;
+	float budgetScale = 1;
+	TessellationReport report;
+	PassConstants makePassConstants(const Geometry& geometry, bool adaptiveFactors)const;
+public:
+	//meshlet culling, only applied to lod 0
+	bool frustumCulling = true;
+	//Tessellate once into a stream output buffer and redraw it while the geometry, lod and divNum stay the same.
+	//The key holds Geometry::id, which changes whenever a geometry is created or rebuilt.
+	bool cachedTessellation = false;
+	//Captures kept at once; draws alternating between more keys than this recapture every time
+	UINT maxTessellationCaptures = 8;
+	//Draws the cache with a vertex shader that pulls its triangle's frame instead of the geometry shader (needs cachedTessellation)
+	bool vertexPulling = false;
+	//Captures larger than this tessellate every frame instead (the limit is per capture)
+	UINT maxTessellationCacheBytes = 64 << 20;
+	//viewProjection comes from the frame block (setFrame)
 	DestructionPainter(ID3D11Device* device);
-	void draw(ID3D11DeviceContext* immediateContext, Geometry* geometry);
+	//Measure the tessellated triangles of the draws in between for adaptive.triangleBudget
+	virtual void drawBegin(ID3D11DeviceContext* immediateContext)override;
+	virtual void drawEnd(ID3D11DeviceContext* immediateContext)override;
+	void draw(ID3D11DeviceContext* immediateContext, Geometry* geometry, const Float4x4& world, UINT materialIndex = 0, UINT lod = 0);
+	void invalidateTessellationCache() { captures.clear(); }
+	const TessellationReport& getTessellationReport()const { return report; }
+private:
+	//Captures level of geometry unless its key is held. Returns nullptr when the cache cannot be used.
+	TessellationCapture* updateTessellationCache(ID3D11DeviceContext* immediateContext, Geometry* geometry, const MeshLod& level, const ObjectConstants& object);
 };
 
 class ToonPainter :public Painter
@@ -80,34 +310,65 @@ class ToonPainter :public Painter
 private:
 	PixelShader			pixelShader;
 	VertexShader		vertexShader;
-	ConstantBuffer		constantBuffer;
+	VertexShader		quantizedVertexShader;
+	std::vector<MeshletDrawRange> drawRanges;
+	PixelShader			instancedPixelShader;
+	VertexShader		instancedVertexShader;
+	VertexShader		instancedQuantizedVertexShader;
+	StructuredBuffer	instanceBuffer;
+	UINT				instanceCapacity;
+	//every instance of the last drawInstanced, grown to the largest count
+	std::vector<PackedInstance> packedInstances;
+	//[0] = float vertices, [1] = quantized
+	StageBindingTable	bindingTables[2];
+	StageBindingTable	instancedBindingTables[2];
 public:
+	//per pass
 	struct Data
 	{
-		Float4x4 world = {};
-		Float4x4 viewProjection = {};
-		Float4 matColor = { 1,1,1,1 };
 		Float4 rimColor = { 0,0,0,1 };
-		Float3 lightDir = { 0,-1,0 };
 		int toonLevels = { 5 };
-		Float3 eyePos = { 0,0,0 };
 		float outlineThreshold = { 0 };
+		float padding[2] = {};
 
 		template<class T>
 		void serialize(T& archive)
 		{
 			archive(
-				CEREAL_NVP(world),
-				CEREAL_NVP(viewProjection),
-				CEREAL_NVP(matColor),
 				CEREAL_NVP(rimColor),
-				CEREAL_NVP(lightDir),
 				CEREAL_NVP(toonLevels),
-				CEREAL_NVP(eyePos),
 				CEREAL_NVP(outlineThreshold)
 			);
 		}
 	}data;
-	ToonPainter(ID3D11Device* device);
-	void draw(ID3D11DeviceContext* immediateContext, Geometry* geometry);
+	//colors selected by the materialIndex of draw
+	MaterialConstants materials;
+
+	template<class T>
+	void serialize(T& archive)
+	{
+		archive(
+			CEREAL_NVP(data),
+			CEREAL_NVP(materials)
+		);
+	}
+private:
+	ConstantBuffer<Data> constantBuffer;
+	ConstantBuffer<MaterialConstants> materialBuffer;
+	ConstantBuffer<ObjectConstants> objectBuffer;
+public:
+	//meshlet culling, only applied to lod 0
+	//cone culling removes back faces, which RasterizerState::solid would draw
+	//back faces follow PipelineState (CCW fronts); makeSphere winds the other way, so keep it off there
+	bool frustumCulling = true;
+	bool coneCulling = false;
+	//maxInstances = instances per DrawIndexedInstanced, larger counts are split
+	//viewProjection, eyePos and lightDir come from the frame block (setFrame)
+	ToonPainter(ID3D11Device* device, UINT maxInstances = 1024);
+	void draw(ID3D11DeviceContext* immediateContext, Geometry* geometry, const Float4x4& world, UINT materialIndex = 0, UINT lod = 0);
+	//materials are replaced by colors (null = white)
+	void drawInstanced(ID3D11DeviceContext* immediateContext, Geometry* geometry,
+		const Float4x4* worlds, const Float4* colors, UINT count, UINT lod = 0);
 };
+HLSL_PACKING_CHECK(ToonPainter::Data, toonLevels);
+HLSL_PACKING_CHECK(ToonPainter::Data, outlineThreshold);
@@ -0,0 +1,58 @@
+// Screen-space tessellation factors, mirrored by func/AdaptiveTessellation.cpp
+// Positions and normals are in world space.
+
+struct TessellationPass
+{
+	float divNum;
+	float move;
+	float scale;
+	float rotation;
+};
+
+float getEdgeTessFactor(float3 p0, float3 p1, float3 eye, TessellationPass pass)
+{
+	float3 midpoint = (p0 + p1) * 0.5f;
+	float dist = max(distance(midpoint, eye), 1e-4f);
+	float pixels = distance(p0, p1) * abs(pass.scale) * pixelsPerUnit / dist;
+	return clamp(pixels / pixelsPerSegment * budgetScale, 1.0f, max(pass.divNum, 1.0f));
+}
+
+bool isPatchVisible(float3 p[3], float3 n[3], float3 eye, TessellationPass pass)
+{
+	float3 center = (p[0] + p[1] + p[2]) / 3.0f;
+	// split triangles spread around their own centers and move along the face normal
+	float radiusScale = (pass.rotation == 0.0f && abs(pass.scale) <= 1.0f) ? 1.0f : 1.0f + 2.0f * abs(pass.scale);
+	float radius = max(distance(center, p[0]), max(distance(center, p[1]), distance(center, p[2]))) * radiusScale + abs(pass.move);
+	[unroll]
+	for (uint i = 0; i < 6; i++)
+	{
+		if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius) { return false; }
+	}
+	if (backfaceCulling == 0) { return true; }
+
+	// the rotation is about the face normal, so the plane only moves; vertex normals pick the front side
+	float3 faceNormal = cross(p[1] - p[0], p[2] - p[0]);
+	float len = length(faceNormal);
+	if (!(len > 0.0f)) { return true; }
+	float side = dot(faceNormal, n[0] + n[1] + n[2]) < 0.0f ? -1.0f : 1.0f;
+	return side * dot(faceNormal, eye - center) / len + abs(pass.move) > 0.0f;
+}
+
+// edges[k] is the edge opposite corner k
+void getPatchTessFactors(float3 p[3], float3 n[3], float3 eye, TessellationPass pass, out float edges[3], out float inside)
+{
+	if (adaptive == 0)
+	{
+		edges[0] = edges[1] = edges[2] = inside = pass.divNum;
+		return;
+	}
+	if (!isPatchVisible(p, n, eye, pass))
+	{
+		edges[0] = edges[1] = edges[2] = inside = 0.0f;
+		return;
+	}
+	edges[0] = getEdgeTessFactor(p[1], p[2], eye, pass);
+	edges[1] = getEdgeTessFactor(p[2], p[0], eye, pass);
+	edges[2] = getEdgeTessFactor(p[0], p[1], eye, pass);
+	inside = max(edges[0], max(edges[1], edges[2]));
+}
@@ -0,0 +1,32 @@
+//Constant blocks by update frequency (Painter.h: ConstantSlot)
+
+//once per frame
+cbuffer FrameConstants : register(b0)
+{
+	row_major float4x4 viewProjection;
+	float3 eyePos;
+	float framePadding0;
+	float3 lightDir;
+	float framePadding1;
+};
+
+//b1: per pass, declared by each painter
+
+#define MAX_MATERIALS 64
+cbuffer MaterialConstants : register(b2)
+{
+	float4 materialColors[MAX_MATERIALS];
+};
+
+//per draw
+cbuffer ObjectConstants : register(b3)
+{
+	row_major float4x4 world;
+	uint materialIndex;
+	float3 normalScale;
+};
+
+float4 getMaterialColor()
+{
+	return materialColors[materialIndex];
+}
@@ -5,13 +5,23 @@ struct LAYOUT
 	float3 normal : NORMAL;
 };
 
-cbuffer ConstantData : register(b0)
+#include "Constants.hlsli"
+
+cbuffer DestructionPass : register(b1)
 {
-	float4x4 world;
-	float4x4 viewProjection;
-	float4 color;
 	float divNum;
 	float move;
 	float scale;
 	float rotation;
+	// adaptive tessellation (AdaptiveTessellation.h: TessellationConstants)
+	float4 frustumPlanes[6];
+	float pixelsPerUnit;
+	float pixelsPerSegment;
+	float budgetScale;
+	uint adaptive;
+	uint backfaceCulling;
+	float3 tessellationPadding;
+	// quantized vertices: object position = position * positionScale + positionBias
+	float4 positionScale;
+	float4 positionBias;
 };
\ No newline at end of file
@@ -0,0 +1,10 @@
+#include "Destruction.hlsli"
+// Tessellated vertices captured by stream output, still in object space
+LAYOUT main(float3 position : POSITION, float3 normal : NORMAL)
+{
+	LAYOUT vout;
+	vout.sv_position = mul(float4(position, 1.0), mul(world, viewProjection));
+	vout.position = position;
+	vout.normal = normal;
+	return vout;
+}
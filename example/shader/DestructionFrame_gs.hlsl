@@ -0,0 +1,19 @@
+#include "Destruction.hlsli"
+// Object-space center and face normal of each cached triangle, streamed out once per capture
+struct FRAME
+{
+	float3 center : CENTER;
+	float3 faceNormal : FACENORMAL;
+};
+
+[maxvertexcount(1)]
+void main(
+	triangle LAYOUT gin[3],
+	inout PointStream<FRAME> gout
+)
+{
+	FRAME frame;
+	frame.center = (gin[0].position + gin[1].position + gin[2].position) / 3.0f;
+	frame.faceNormal = normalize(cross(gin[1].position - gin[0].position, gin[2].position - gin[0].position));
+	gout.Append(frame);
+}
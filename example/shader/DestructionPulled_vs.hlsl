@@ -0,0 +1,34 @@
+#include "Destruction.hlsli"
+// Destruction without the geometry shader: each vertex pulls itself and its triangle's frame
+ByteAddressBuffer vertices : register(t0);		// float3 position, float3 normal
+ByteAddressBuffer frames : register(t1);		// float3 center, float3 faceNormal per triangle
+
+LAYOUT main(uint vertexId : SV_VertexID)
+{
+	float3 position = asfloat(vertices.Load3(vertexId * 24));
+	float3 normal = asfloat(vertices.Load3(vertexId * 24 + 12));
+	uint triangleId = vertexId / 3;
+	float3 center = asfloat(frames.Load3(triangleId * 24));
+	float3 faceNormal = asfloat(frames.Load3(triangleId * 24 + 12));
+
+	float3 worldPos = mul(float4(position, 1.0f), world).xyz;
+	float3 centerPos = mul(float4(center, 1.0f), world).xyz;
+	// cofactor of world, so the normal follows the transformed edges like in Destruction_gs
+	float3 surfaceNormal = normalize(
+		faceNormal.x * cross(world[1].xyz, world[2].xyz)
+		+ faceNormal.y * cross(world[2].xyz, world[0].xyz)
+		+ faceNormal.z * cross(world[0].xyz, world[1].xyz));
+
+	// same rotation as axisRotationMatrix, without building the matrix
+	float c = cos(rotation);
+	float s = sin(rotation);
+	float3 tempPos = (worldPos - centerPos) * scale;
+	tempPos = tempPos * c + cross(tempPos, surfaceNormal) * s + surfaceNormal * (dot(tempPos, surfaceNormal) * (1.0f - c));
+	tempPos += centerPos + (surfaceNormal * move);
+
+	LAYOUT vout;
+	vout.sv_position = mul(float4(tempPos, 1.0f), viewProjection);
+	vout.position = tempPos;
+	vout.normal = mul(float4(normal, 0.0f), world).xyz;
+	return vout;
+}
@@ -0,0 +1,13 @@
+#include "Destruction.hlsli"
+#include "Quantization.hlsli"
+
+//The hull, domain and geometry shaders work in object space, so the position is dequantized here (DestructionPass)
+LAYOUT main(QuantizedVertexInput vin)
+{
+	LAYOUT vout;
+	float4 position = float4(vin.position.xyz * positionScale.xyz + positionBias.xyz, 1);
+	vout.sv_position = mul(position, mul(world, viewProjection));
+	vout.position = position.xyz;
+	vout.normal = decodeOctahedral(vin.normal);
+	return vout;
+}
@@ -1,4 +1,5 @@
 #include "Destruction.hlsli"
+#include "AdaptiveTessellation.hlsli"
 
 struct HS_CONSTANT_DATA_OUTPUT
 {
@@ -14,10 +15,20 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(
 {
 	HS_CONSTANT_DATA_OUTPUT Output;
 
-	Output.EdgeTessFactor[0] = 
-	Output.EdgeTessFactor[1] = 
-	Output.EdgeTessFactor[2] = 
-	Output.InsideTessFactor = divNum;
+	TessellationPass pass;
+	pass.divNum = divNum;
+	pass.move = move;
+	pass.scale = scale;
+	pass.rotation = rotation;
+	float3 p[3];
+	float3 n[3];
+	[unroll]
+	for (uint i = 0; i < NUM_CONTROL_POINTS; i++)
+	{
+		p[i] = mul(float4(ip[i].position, 1.0f), world).xyz;
+		n[i] = mul(float4(ip[i].normal, 0.0f), world).xyz;
+	}
+	getPatchTessFactors(p, n, eyePos, pass, Output.EdgeTessFactor, Output.InsideTessFactor);
 
 	return Output;
 }
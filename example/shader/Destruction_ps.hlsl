@@ -1,5 +1,5 @@
 #include "Destruction.hlsli"
 float4 main(LAYOUT pin) : SV_TARGET
 {
-	return color;
+	return getMaterialColor();
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+struct QuantizedVertexInput
+{
+	float4 position : POSITION;
+	float2 normal : NORMAL;
+};
+
+//The dequantization is folded into world (ObjectConstants / instance rows) on the CPU;
+//normals go through normalScale first so they see world alone.
+
+float3 decodeOctahedral(float2 encoded)
+{
+	float3 n = float3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-n.z);
+	n.xy += (n.xy >= 0.0) ? -t : t;
+	return normalize(n);
+}
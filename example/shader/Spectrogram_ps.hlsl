@@ -0,0 +1,37 @@
+//Level of bin x of frame f at (x, f % columnCount), 0 ~ 1 (Spectrogram)
+Texture2D<float> levels : register(t2);
+
+cbuffer SpectrumData : register(b1)
+{
+	float4 lineColor;
+	uint latestFrame;//newest frame in the ring
+	uint columnCount;//frames in the ring
+	uint binCount;
+	uint showSpectrum;//1 = bars of the newest frame, 0 = scrolling spectrogram
+};
+
+float loadLevel(uint bin, uint frame)
+{
+	return levels.Load(int3(min(bin, binCount - 1), frame % columnCount, 0));
+}
+
+float4 main(in float4 sv_position : SV_POSITION, in float2 texcoord : TEXCOORD) : SV_TARGET
+{
+	float height = 1.0 - texcoord.y;
+	if (showSpectrum)
+	{
+		//low frequencies on the left, the bar height is the level
+		float level = loadLevel((uint) (texcoord.x * binCount), latestFrame);
+		return lineColor * step(height, level);
+	}
+
+	//time runs left to right and ends at latestFrame, low frequencies at the bottom
+	uint column = min((uint) (texcoord.x * columnCount), columnCount - 1);
+	uint age = columnCount - 1 - column;
+	if (age > latestFrame)
+	{
+		return float4(0, 0, 0, 0);
+	}
+	float level = loadLevel((uint) (height * binCount), latestFrame - age);
+	return lineColor * level;
+}
@@ -1,13 +1,11 @@
-cbuffer ConstantData : register(b0)
+#include "Constants.hlsli"
+
+cbuffer ToonPass : register(b1)
 {
-	row_major float4x4 world;
-	row_major float4x4 viewProjection;
-	float4 matColor;
 	float4 rimColor;
-	float3 lightDir;
 	int toonLevels;
-	float3 eyePos;
 	float outlineThreshold;
+	float2 passPadding;
 };
 
 struct VertexInput
@@ -23,3 +21,46 @@ struct VertexOutput
 	float3 normal : NORMAL;
 };
 typedef VertexOutput PixelInput;
+
+struct InstancedVertexOutput
+{
+	float4 sv_position : SV_POSITION;
+	float3 position : POSITION;
+	float3 normal : NORMAL;
+	float4 color : COLOR;
+};
+typedef InstancedVertexOutput InstancedPixelInput;
+
+//world = first three columns of the instance world matrix
+struct Instance
+{
+	float4 world[3];
+	float4 color;
+};
+
+float3 transformInstance(Instance instance, float4 position)
+{
+	return float3(dot(instance.world[0], position), dot(instance.world[1], position), dot(instance.world[2], position));
+}
+
+float4 toonShader(
+float3 lightDirection,
+float3 viewDirection,
+float3 normal,
+float4 baseColor,
+float4 rimColor,
+int toneLevels,
+float outlineThreshold)
+{
+	// Cg̕Ɩ@xNg̓ςvZ
+	float NdotL = saturate(dot(-lightDirection, normal));
+
+	// K̐
+	float threshold = 1.0 / (float) toneLevels;
+	float intensity = floor(NdotL / threshold) * threshold + threshold;
+
+	float rim = saturate(dot(-viewDirection, normal));
+	
+	// ŏIIȐF̌vZ
+	return lerp(rimColor, baseColor * intensity, step(outlineThreshold, rim));
+}
@@ -0,0 +1,16 @@
+#include "Toon.hlsli"
+#include "Quantization.hlsli"
+
+StructuredBuffer<Instance> instances : register(t0);
+
+//instance rows = dequantization * world, normalScale from the object block of the draw
+InstancedVertexOutput main(QuantizedVertexInput vin, uint instanceId : SV_InstanceID)
+{
+	Instance instance = instances[instanceId];
+	InstancedVertexOutput vout;
+	vout.position = transformInstance(instance, float4(vin.position.xyz, 1));
+	vout.sv_position = mul(float4(vout.position, 1), viewProjection);
+	vout.normal = transformInstance(instance, float4(decodeOctahedral(vin.normal) * normalScale, 0));
+	vout.color = instance.color;
+	return vout;
+}
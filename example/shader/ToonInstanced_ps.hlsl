@@ -0,0 +1,13 @@
+#include "Toon.hlsli"
+
+float4 main(InstancedPixelInput pin) : SV_TARGET
+{
+	return toonShader(
+	normalize(lightDir),
+	normalize(pin.position - eyePos),
+	normalize(pin.normal),
+	pin.color,
+	rimColor,
+	toonLevels,
+	outlineThreshold);
+}
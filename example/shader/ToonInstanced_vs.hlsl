@@ -0,0 +1,14 @@
+#include "Toon.hlsli"
+
+StructuredBuffer<Instance> instances : register(t0);
+
+InstancedVertexOutput main(VertexInput vin, uint instanceId : SV_InstanceID)
+{
+	Instance instance = instances[instanceId];
+	InstancedVertexOutput vout;
+	vout.position = transformInstance(instance, float4(vin.position, 1));
+	vout.sv_position = mul(float4(vout.position, 1), viewProjection);
+	vout.normal = transformInstance(instance, float4(vin.normal, 0));
+	vout.color = instance.color;
+	return vout;
+}
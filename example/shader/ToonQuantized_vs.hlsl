@@ -0,0 +1,12 @@
+#include "Toon.hlsli"
+#include "Quantization.hlsli"
+
+//world = dequantization * world
+VertexOutput main(QuantizedVertexInput vin)
+{
+	VertexOutput vout;
+	vout.position = mul(float4(vin.position.xyz, 1), world).xyz;
+	vout.sv_position = mul(float4(vout.position, 1), viewProjection);
+	vout.normal = mul(float4(decodeOctahedral(vin.normal) * normalScale, 0), world).xyz;
+	return vout;
+}
@@ -1,13 +1,29 @@
-//g`f[^
+//g`f[^ (ʒup̃Tvp % ringSizeɂ)
 StructuredBuffer<float> amplitudes : register(t0);
 
-cbuffer WaveData : register(b0)
+//g`̍ŏl, ől, 敽ϕ (WaveformEnvelope)
+struct Envelope
+{
+	float minimum;
+	float maximum;
+	float rms;
+};
+
+//SiAGx[ṽs~bh
+StructuredBuffer<Envelope> envelopes : register(t1);
+
+cbuffer WaveData : register(b1)
 {
 	float4 lineColor;//̐F
 	uint frameCount;//g`f[^̃Tv
 	uint samplingRate;//TvO[g
 	float tick;//oߎ
 	float thickness;//̌
+	uint levelCount;//s~bh̒i
+	uint envelopeBlock;//0iڂ1vf̃Tv
+	uint ringSize;//amplitudes̗vf (Xg[~O̓Ȏ傫)
+	uint wavePadding;
+	uint4 levelOffsets[8];//ei̐擪vf (levelCount + 1)
 };
 
 float isRange(float x, float a, float b)
@@ -15,35 +31,78 @@ float isRange(float x, float a, float b)
 	return step(min(a, b), x) * step(x, max(a, b));
 }
 
-float4 main(in float4 sv_position : SV_POSITION, in float2 texcoord : TEXCOORD) : SV_TARGET
+uint getLevelOffset(uint level)
 {
-	const float fineness = 50;
-
-	//TvJnʒuZo
-	float samplingPositionBegin = samplingRate * tick;
-
-	//TvʒuZo
-	float samplingPosition = samplingPositionBegin + samplingRate * trunc(texcoord.x * fineness);
-
-	//g`f[^TvO-0.5 ~ 0.5֕ϊ(1)
-	float amplitudeBegin = amplitudes[(uint) samplingPosition % frameCount] * 0.5 + 0.5;
+	return levelOffsets[level >> 2][level & 3];
+}
 
-	//1Tvړ
-	samplingPosition += samplingRate;
+//`ԂTvl
+float sampleAmplitude(float position)
+{
+	uint index = (uint) position;
+	return lerp(amplitudes[index % ringSize], amplitudes[(index + 1) % ringSize], frac(position));
+}
 
-	//g`f[^TvO-0.5 ~ 0.5֕ϊ(2)
-	float amplitudeEnd = amplitudes[(uint) samplingPosition % frameCount] * 0.5 + 0.5;
+float4 main(in float4 sv_position : SV_POSITION, in float2 texcoord : TEXCOORD) : SV_TARGET
+{
+	const float fineness = 50;
 
-	float4 outColor = (float4) 0;
+	//1sNZTvԂZo
+	float samplesPerPixel = max(abs(ddx(texcoord.x)) * samplingRate * fineness, 1e-3);
+	float samplingPosition = samplingRate * tick + samplingRate * texcoord.x * fineness;
+	float begin = max(samplingPosition - samplesPerPixel * 0.5, 0.0);
+	float end = begin + samplesPerPixel;
 
-	//݌ĂsNZ2̃TvԂ̂ǂɈʒûZo
-	float amplitude = lerp(amplitudeBegin, amplitudeEnd, frac(texcoord.x * fineness));
+	float minimum, maximum, rms;
+	if (levelCount == 0 || samplesPerPixel < envelopeBlock)
+	{
+		//g厞͋Ԃ̗[Ɠ̐Tvǂ (envelopeBlock + 3܂)
+		minimum = sampleAmplitude(begin);
+		maximum = minimum;
+		float last = sampleAmplitude(end);
+		minimum = min(minimum, last);
+		maximum = max(maximum, last);
+		float sumSquares = 0;
+		uint first = (uint) ceil(begin);
+		uint count = min((uint) max(floor(end) - first + 1, 0), envelopeBlock + 1);
+		[loop]
+		for (uint i = 0; i < count; i++)
+		{
+			float amplitude = amplitudes[(first + i) % ringSize];
+			minimum = min(minimum, amplitude);
+			maximum = max(maximum, amplitude);
+			sumSquares += amplitude * amplitude;
+		}
+		rms = count > 0 ? sqrt(sumSquares / count) : max(abs(minimum), abs(maximum));
+	}
+	else
+	{
+		//1vf1sNZȉɂȂiIԂ̂, ǂނ̂3vf܂
+		uint level = min((uint) log2(samplesPerPixel / envelopeBlock), levelCount - 1);
+		float span = (float) (envelopeBlock << level);
+		uint offset = getLevelOffset(level);
+		uint size = getLevelOffset(level + 1) - offset;
+		uint first = (uint) (begin / span);
+		uint count = min((uint) (end / span) - first + 1, 3);
+		minimum = 1;
+		maximum = -1;
+		float sumSquares = 0;
+		[loop]
+		for (uint i = 0; i < count; i++)
+		{
+			Envelope envelope = envelopes[offset + (first + i) % size];
+			minimum = min(minimum, envelope.minimum);
+			maximum = max(maximum, envelope.maximum);
+			sumSquares += envelope.rms * envelope.rms;
+		}
+		rms = sqrt(sumSquares / count);
+	}
 
-	//̕Zo
+	//-1 ~ 10 ~ 1֕ϊ, ̌L
 	float width = thickness * 0.5;
+	float peak = isRange(texcoord.y, minimum * 0.5 + 0.5 - width, maximum * 0.5 + 0.5 + width);
+	float body = isRange(texcoord.y, 0.5 - rms * 0.5 - width, 0.5 + rms * 0.5 + width);
 
-	//݌ĂsNZɂ邩
-	outColor = lerp(outColor, lineColor, isRange(texcoord.y, amplitude - width, amplitude + width));
-
-	return outColor;
+	//s[N͔, l͈̔͂͐̐Fœh
+	return lineColor * peak * lerp(0.5, 1.0, body);
 }
@@ -0,0 +1,28 @@
+//One lane per instance (PackedTrack)
+struct Track
+{
+	float4 color;
+	float4 rect;//left, top, width, height in 0 ~ 1 target space
+	uint sampleOffset;//first sample of the lane in samples
+	uint sampleCount;
+	uint samplingRate;
+	float thickness;
+};
+
+StructuredBuffer<float> samples : register(t0);
+StructuredBuffer<Track> tracks : register(t1);
+
+cbuffer TracksData : register(b1)
+{
+	float tick;
+	uint trackCount;
+	float2 tracksPadding;
+};
+
+struct TrackVertexOutput
+{
+	float4 sv_position : SV_POSITION;
+	float2 texcoord : TEXCOORD;
+	nointerpolation uint track : TRACK;
+};
+typedef TrackVertexOutput TrackPixelInput;
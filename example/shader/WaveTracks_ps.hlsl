@@ -0,0 +1,59 @@
+#include "WaveTracks.hlsli"
+
+float isRange(float x, float a, float b)
+{
+	return step(min(a, b), x) * step(x, max(a, b));
+}
+
+//interpolated sample of the lane, looping at its end
+float sampleTrack(Track track, float position)
+{
+	uint index = (uint) position;
+	float a = samples[track.sampleOffset + index % track.sampleCount];
+	float b = samples[track.sampleOffset + (index + 1) % track.sampleCount];
+	return lerp(a, b, frac(position));
+}
+
+float4 main(TrackPixelInput pin) : SV_TARGET
+{
+	const float fineness = 50;
+	//more samples per pixel than this are read at even steps
+	const uint maxReads = 32;
+
+	Track track = tracks[pin.track];
+	if (track.sampleCount == 0)
+	{
+		return float4(0, 0, 0, 0);
+	}
+
+	float samplesPerPixel = max(abs(ddx(pin.texcoord.x)) * track.samplingRate * fineness, 1e-3);
+	float samplingPosition = track.samplingRate * tick + track.samplingRate * pin.texcoord.x * fineness;
+	float begin = max(samplingPosition - samplesPerPixel * 0.5, 0.0);
+	float end = begin + samplesPerPixel;
+
+	float minimum = sampleTrack(track, begin);
+	float maximum = minimum;
+	float last = sampleTrack(track, end);
+	minimum = min(minimum, last);
+	maximum = max(maximum, last);
+	float first = ceil(begin);
+	uint count = (uint) max(floor(end) - first + 1, 0);
+	float stride = count > maxReads ? (float) count / maxReads : 1.0;
+	count = min(count, maxReads);
+	float sumSquares = 0;
+	[loop]
+	for (uint i = 0; i < count; i++)
+	{
+		uint index = (uint) (first + i * stride);
+		float amplitude = samples[track.sampleOffset + index % track.sampleCount];
+		minimum = min(minimum, amplitude);
+		maximum = max(maximum, amplitude);
+		sumSquares += amplitude * amplitude;
+	}
+	float rms = count > 0 ? sqrt(sumSquares / count) : max(abs(minimum), abs(maximum));
+
+	float width = track.thickness * 0.5;
+	float peak = isRange(pin.texcoord.y, minimum * 0.5 + 0.5 - width, maximum * 0.5 + 0.5 + width);
+	float body = isRange(pin.texcoord.y, 0.5 - rms * 0.5 - width, 0.5 + rms * 0.5 + width);
+	return track.color * peak * lerp(0.5, 1.0, body);
+}
@@ -0,0 +1,13 @@
+#include "WaveTracks.hlsli"
+
+//4 vertices per instance, stretched over the lane rectangle
+TrackVertexOutput main(uint vertex_id : SV_VERTEXID, uint instance_id : SV_INSTANCEID)
+{
+	Track track = tracks[instance_id];
+	TrackVertexOutput vout;
+	vout.texcoord = float2(vertex_id & 1, vertex_id >> 1);
+	float2 position = track.rect.xy + vout.texcoord * track.rect.zw;
+	vout.sv_position = float4(position * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+	vout.track = instance_id;
+	return vout;
+}
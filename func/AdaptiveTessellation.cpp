@@ -0,0 +1,77 @@
+﻿#include "AdaptiveTessellation.h"
+#include <math.h>
+
+namespace detail
+{
+	constexpr float minBudgetScale = 1.0f / 64.0f;
+
+	inline float dot3(const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	inline float distance3(const float* a, const float* b)
+	{
+		const float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+		return sqrtf(dot3(d, d));
+	}
+	inline float clampf(float x, float low, float high) { return x < low ? low : (x > high ? high : x); }
+}
+
+float getEdgeTessFactor(const float p0[3], const float p1[3], const float eyePos[3], const TessellationPass& pass, const TessellationConstants& constants)
+{
+	const float midpoint[3] = { (p0[0] + p1[0]) * 0.5f, (p0[1] + p1[1]) * 0.5f, (p0[2] + p1[2]) * 0.5f };
+	const float distance = fmaxf(detail::distance3(midpoint, eyePos), 1e-4f);
+	const float pixels = detail::distance3(p0, p1) * fabsf(pass.scale) * constants.pixelsPerUnit / distance;
+	return detail::clampf(pixels / constants.pixelsPerSegment * constants.budgetScale, 1.0f, fmaxf(pass.divNum, 1.0f));
+}
+
+bool isPatchVisible(const float positions[9], const float normals[9], const float eyePos[3], const TessellationPass& pass, const TessellationConstants& constants)
+{
+	const float* p0 = positions;
+	const float* p1 = positions + 3;
+	const float* p2 = positions + 6;
+	const float center[3] = { (p0[0] + p1[0] + p2[0]) / 3.0f, (p0[1] + p1[1] + p2[1]) / 3.0f, (p0[2] + p1[2] + p2[2]) / 3.0f };
+	//分割後の三角形は拡大・回転で自分の中心の周りに広がり, 面法線方向にmoveだけ動く
+	const float radiusScale = (pass.rotation == 0.0f && fabsf(pass.scale) <= 1.0f) ? 1.0f : 1.0f + 2.0f * fabsf(pass.scale);
+	const float radius = fmaxf(detail::distance3(center, p0), fmaxf(detail::distance3(center, p1), detail::distance3(center, p2))) * radiusScale + fabsf(pass.move);
+	for (int p = 0; p < 6; p++)
+	{
+		if (detail::dot3(constants.frustumPlanes[p], center) + constants.frustumPlanes[p][3] < -radius) { return false; }
+	}
+	if (!constants.backfaceCulling) { return true; }
+
+	//回転は面法線まわりなので面は平行移動するだけ. 向きは頂点法線で表側に合わせる
+	const float edge1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const float edge2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	float faceNormal[3] = { edge1[1] * edge2[2] - edge1[2] * edge2[1], edge1[2] * edge2[0] - edge1[0] * edge2[2], edge1[0] * edge2[1] - edge1[1] * edge2[0] };
+	const float length = sqrtf(detail::dot3(faceNormal, faceNormal));
+	if (!(length > 0.0f)) { return true; }
+	const float vertexNormal[3] = { normals[0] + normals[3] + normals[6], normals[1] + normals[4] + normals[7], normals[2] + normals[5] + normals[8] };
+	const float side = detail::dot3(faceNormal, vertexNormal) < 0.0f ? -1.0f : 1.0f;
+	const float toEye[3] = { eyePos[0] - center[0], eyePos[1] - center[1], eyePos[2] - center[2] };
+	return side * detail::dot3(faceNormal, toEye) / length + fabsf(pass.move) > 0.0f;
+}
+
+void getPatchTessFactors(const float positions[9], const float normals[9], const float eyePos[3], const TessellationPass& pass,
+	const TessellationConstants& constants, float outEdges[3], float* outInside)
+{
+	if (!constants.adaptive)
+	{
+		outEdges[0] = outEdges[1] = outEdges[2] = *outInside = pass.divNum;
+		return;
+	}
+	if (!isPatchVisible(positions, normals, eyePos, pass, constants))
+	{
+		outEdges[0] = outEdges[1] = outEdges[2] = *outInside = 0.0f;
+		return;
+	}
+	outEdges[0] = getEdgeTessFactor(positions + 3, positions + 6, eyePos, pass, constants);
+	outEdges[1] = getEdgeTessFactor(positions + 6, positions + 0, eyePos, pass, constants);
+	outEdges[2] = getEdgeTessFactor(positions + 0, positions + 3, eyePos, pass, constants);
+	*outInside = fmaxf(outEdges[0], fmaxf(outEdges[1], outEdges[2]));
+}
+
+float updateBudgetScale(float budgetScale, uint64_t measuredTriangles, uint64_t triangleBudget)
+{
+	//1回で動かすのは2倍まで. 予算内なら1へ戻していく
+	float ratio = 2.0f;
+	if (measuredTriangles > 0) { ratio = detail::clampf(sqrtf(static_cast<float>(triangleBudget) / static_cast<float>(measuredTriangles)), 0.5f, 2.0f); }
+	return detail::clampf(budgetScale * ratio, detail::minBudgetScale, 1.0f);
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************
+	Screen-space tessellation factors for Destruction_hs.
+	These functions mirror example/shader/AdaptiveTessellation.hlsli
+	line by line, so the factors can be checked and counted on the
+	CPU. Positions and normals are in world space; matrices are
+	row-major for row vectors, as in the cbuffers.
+	An edge gets one segment per pixelsPerSegment of its projected
+	length, measured from its midpoint so both patches that share
+	it agree, and is clamped to [1, divNum]. The inside factor is
+	the largest edge factor.
+	A patch is culled (all factors 0) when the sphere bounding its
+	displaced triangles is outside a frustum plane, or, with
+	backfaceCulling, when its plane faces away from the eye even
+	after moving it by move along either side of the normal.
+	budgetScale multiplies every factor; updateBudgetScale steers it
+	from the triangle count measured a few frames earlier, assuming
+	the count grows with the square of the factors.
+****************************************************************/
+struct TessellationConstants
+{
+	float frustumPlanes[6][4] = {};	// world space, extractFrustumPlanes(viewProjection)
+	float pixelsPerUnit = 0;		// getPixelsPerUnit
+	float pixelsPerSegment = 8;
+	float budgetScale = 1;
+	uint32_t adaptive = 0;			// 0 = divNum on every edge
+	uint32_t backfaceCulling = 0;
+	float padding[3] = {};
+};
+static_assert(sizeof(TessellationConstants) == 128, "TessellationConstants must match the HLSL layout");
+
+// Destruction pass values the factors depend on.
+struct TessellationPass
+{
+	float divNum;
+	float move;
+	float scale;
+	float rotation;
+};
+
+// Pixels per world unit at distance 1: projection._22 * viewport height / 2.
+inline float getPixelsPerUnit(const float projection[16], float viewportHeight)
+{
+	return projection[5] * viewportHeight * 0.5f;
+}
+
+float getEdgeTessFactor(const float p0[3], const float p1[3], const float eyePos[3], const TessellationPass& pass, const TessellationConstants& constants);
+bool isPatchVisible(const float positions[9], const float normals[9], const float eyePos[3], const TessellationPass& pass, const TessellationConstants& constants);
+// EdgeTessFactor[k] is the edge opposite corner k, as in the tri domain.
+void getPatchTessFactors(const float positions[9], const float normals[9], const float eyePos[3], const TessellationPass& pass,
+	const TessellationConstants& constants, float outEdges[3], float* outInside);
+
+float updateBudgetScale(float budgetScale, uint64_t measuredTriangles, uint64_t triangleBudget);
@@ -1,6 +1,7 @@
 ﻿#include "CameraControl.h"
 #include "KeyInput.h"
 #include "FrameworkConfig.h"
+#include "Frustum.h"
 
 #define SWING_WIDTH		toRadian(60.0f)
 
@@ -41,6 +42,14 @@ Float4x4 CameraControl::getOrthographic() const
 	return matrixToFloat4x4(XMMatrixOrthographicLH(width, height, znear, zfar));
 }
 
+void CameraControl::getFrustumPlanes(float outPlanes[6][4]) const
+{
+	Float4x4 view = getView();
+	Float4x4 projection = getProjection();
+	Float4x4 viewProjection = matrixToFloat4x4(XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection));
+	extractFrustumPlanes(outPlanes, &viewProjection._11);
+}
+
 void CameraControl::update(float elapsedTime, float moveSpeed, float rotationSpeed)
 {
 	const Mouse* mouse = Mouse::instance();
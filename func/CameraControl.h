@@ -35,6 +35,8 @@ public:
 	Float4x4 getView()const;
 	Float4x4 getProjection()const;
 	Float4x4 getOrthographic()const;
+	// World-space planes of getView() * getProjection(), see extractFrustumPlanes.
+	void getFrustumPlanes(float outPlanes[6][4])const;
 
 	/// <summary>
 	/// J̍XV܂B
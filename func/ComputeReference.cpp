@@ -0,0 +1,23 @@
+﻿#include "ComputeReference.h"
+
+//アドレスの下位2ビットは無視される (D3D11のByteAddressBufferと同じ)
+uint32_t ReferenceByteAddressBuffer::load(uint32_t byteOffset)const
+{
+	const size_t index = byteOffset / 4;
+	return index < words.size() ? words[index] : 0;
+}
+
+void ReferenceByteAddressBuffer::store(uint32_t byteOffset, uint32_t value)
+{
+	const size_t index = byteOffset / 4;
+	if (index < words.size()) { words[index] = value; }
+}
+
+uint32_t ReferenceByteAddressBuffer::interlockedAdd(uint32_t byteOffset, uint32_t value)
+{
+	const size_t index = byteOffset / 4;
+	if (index >= words.size()) { return 0; }
+	const uint32_t original = words[index];
+	words[index] = original + value;
+	return original;
+}
@@ -0,0 +1,128 @@
+﻿#pragma once
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+/****************************************************************
+	Dispatch math and a CPU executor for simple compute kernels.
+	The argument structs match the layouts D3D11 reads for
+	DispatchIndirect, DrawInstancedIndirect and
+	DrawIndexedInstancedIndirect, so a buffer filled by a kernel can
+	be checked on the CPU before it drives the GPU.
+	dispatchReference calls kernel(const ComputeThread&) once per
+	thread, group by group and in SV_GroupIndex order within a
+	group. Threads run one after another, so kernels that need
+	groupshared memory or barriers are out of scope.
+	ReferenceByteAddressBuffer follows the D3D11 out-of-bounds
+	rules: reads past the end return 0 and writes are dropped.
+****************************************************************/
+struct DispatchIndirectArgs
+{
+	uint32_t threadGroupCountX;
+	uint32_t threadGroupCountY;
+	uint32_t threadGroupCountZ;
+};
+static_assert(sizeof(DispatchIndirectArgs) == 12, "DispatchIndirectArgs must match D3D11");
+
+struct DrawInstancedIndirectArgs
+{
+	uint32_t vertexCountPerInstance;
+	uint32_t instanceCount;
+	uint32_t startVertexLocation;
+	uint32_t startInstanceLocation;
+};
+static_assert(sizeof(DrawInstancedIndirectArgs) == 16, "DrawInstancedIndirectArgs must match D3D11");
+
+struct DrawIndexedInstancedIndirectArgs
+{
+	uint32_t indexCountPerInstance;
+	uint32_t instanceCount;
+	uint32_t startIndexLocation;
+	int32_t baseVertexLocation;
+	uint32_t startInstanceLocation;
+};
+static_assert(sizeof(DrawIndexedInstancedIndirectArgs) == 20, "DrawIndexedInstancedIndirectArgs must match D3D11");
+
+// D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION
+constexpr uint32_t maxThreadGroupsPerDimension = 65535;
+
+// Groups of groupSize threads that cover threadCount threads.
+inline uint32_t getThreadGroupCount(uint32_t threadCount, uint32_t groupSize)
+{
+	assert(groupSize > 0 && "The group size is invalid.");
+	return threadCount / groupSize + (threadCount % groupSize != 0 ? 1 : 0);
+}
+
+// Groups to cover x * y * z threads with [numthreads(groupSize)].
+inline DispatchIndirectArgs getDispatchArgs(uint32_t x, uint32_t y, uint32_t z, const uint32_t groupSize[3])
+{
+	return { getThreadGroupCount(x, groupSize[0]), getThreadGroupCount(y, groupSize[1]), getThreadGroupCount(z, groupSize[2]) };
+}
+
+// System values of one thread.
+struct ComputeThread
+{
+	uint32_t groupId[3];			// SV_GroupID
+	uint32_t groupThreadId[3];		// SV_GroupThreadID
+	uint32_t dispatchThreadId[3];	// SV_DispatchThreadID
+	uint32_t groupIndex;			// SV_GroupIndex
+};
+
+template<class Kernel>
+void dispatchReference(const DispatchIndirectArgs& groups, const uint32_t groupSize[3], Kernel&& kernel)
+{
+	assert(groups.threadGroupCountX <= maxThreadGroupsPerDimension && groups.threadGroupCountY <= maxThreadGroupsPerDimension &&
+		groups.threadGroupCountZ <= maxThreadGroupsPerDimension && "Too many thread groups in one dimension.");
+	ComputeThread thread{};
+	for (uint32_t gz = 0; gz < groups.threadGroupCountZ; gz++)
+	for (uint32_t gy = 0; gy < groups.threadGroupCountY; gy++)
+	for (uint32_t gx = 0; gx < groups.threadGroupCountX; gx++)
+	{
+		thread.groupId[0] = gx;
+		thread.groupId[1] = gy;
+		thread.groupId[2] = gz;
+		thread.groupIndex = 0;
+		for (uint32_t tz = 0; tz < groupSize[2]; tz++)
+		for (uint32_t ty = 0; ty < groupSize[1]; ty++)
+		for (uint32_t tx = 0; tx < groupSize[0]; tx++)
+		{
+			thread.groupThreadId[0] = tx;
+			thread.groupThreadId[1] = ty;
+			thread.groupThreadId[2] = tz;
+			thread.dispatchThreadId[0] = gx * groupSize[0] + tx;
+			thread.dispatchThreadId[1] = gy * groupSize[1] + ty;
+			thread.dispatchThreadId[2] = gz * groupSize[2] + tz;
+			kernel(static_cast<const ComputeThread&>(thread));
+			thread.groupIndex++;
+		}
+	}
+}
+
+// DispatchIndirect: the group counts are read from args at byteOffset (4-byte aligned).
+template<class Kernel>
+void dispatchIndirectReference(const void* args, size_t byteOffset, const uint32_t groupSize[3], Kernel&& kernel)
+{
+	assert(byteOffset % 4 == 0 && "The indirect argument offset is not 4-byte aligned.");
+	DispatchIndirectArgs groups;
+	memcpy(&groups, static_cast<const unsigned char*>(args) + byteOffset, sizeof(groups));
+	dispatchReference(groups, groupSize, kernel);
+}
+
+// RWByteAddressBuffer on the CPU.
+class ReferenceByteAddressBuffer
+{
+private:
+	std::vector<uint32_t> words;
+public:
+	explicit ReferenceByteAddressBuffer(size_t byteWidth = 0) :words(byteWidth / 4, 0) {}
+	size_t getByteWidth()const { return words.size() * 4; }
+	const uint32_t* data()const { return words.data(); }
+	uint32_t* data() { return words.data(); }
+
+	uint32_t load(uint32_t byteOffset)const;
+	void store(uint32_t byteOffset, uint32_t value);
+	// InterlockedAdd; returns the original value (0 out of bounds).
+	uint32_t interlockedAdd(uint32_t byteOffset, uint32_t value);
+};
@@ -0,0 +1,77 @@
+﻿#pragma once
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+/****************************************************************
+	HLSL cbuffer packing checks.
+	A member may not straddle a 16 byte register unless it starts
+	on one (matrices, float4 arrays), and the whole buffer is a
+	multiple of 16 bytes.
+		HLSL_PACKING_CHECK(FrameConstants, lightDir);
+****************************************************************/
+constexpr bool isHlslPackedMember(size_t offset, size_t size)
+{
+	return offset % 16 == 0 || (offset / 16 == (offset + size - 1) / 16);
+}
+
+#define HLSL_PACKING_CHECK(type, member) \
+	static_assert(isHlslPackedMember(offsetof(type, member), sizeof(((type*)nullptr)->member)), \
+		#type "::" #member " straddles a 16 byte register")
+
+template<class T>
+struct IsConstantData
+{
+	static constexpr bool value = std::is_trivially_copyable<T>::value && sizeof(T) % 16 == 0;
+};
+
+/****************************************************************
+	CPU copy of what the GPU constant buffer holds.
+	update returns true only when the new contents differ, so the
+	caller can skip the upload. The comparison is a memcmp against
+	the shadow, which for cbuffer sized data is cheaper than a
+	hash and never misses a change.
+****************************************************************/
+template<class T>
+class ConstantShadow
+{
+	static_assert(IsConstantData<T>::value, "Constant data must be trivially copyable and 16 byte aligned in size");
+private:
+	T value;
+	bool valid = false;
+	size_t generation = 0;
+	size_t uploadCount = 0;
+	size_t skipCount = 0;
+public:
+	// Returns true if data has to be uploaded.
+	bool update(const T& data)
+	{
+		if (valid && memcmp(&value, &data, sizeof(T)) == 0)
+		{
+			skipCount++;
+			return false;
+		}
+		memcpy(&value, &data, sizeof(T));
+		valid = true;
+		generation++;
+		uploadCount++;
+		return true;
+	}
+	// The GPU buffer was written with data outside update (creation).
+	void reset(const T& data)
+	{
+		memcpy(&value, &data, sizeof(T));
+		valid = true;
+		generation++;
+	}
+	// Forces the next update to upload.
+	void invalidate() { valid = false; }
+
+	const T& get()const { return value; }
+	bool isValid()const { return valid; }
+	// Incremented whenever the contents change.
+	size_t getGeneration()const { return generation; }
+	size_t getUploadCount()const { return uploadCount; }
+	size_t getSkipCount()const { return skipCount; }
+	void resetCounters() { uploadCount = skipCount = 0; }
+};
@@ -0,0 +1,128 @@
+﻿#include "DestructionMath.h"
+#include <math.h>
+
+namespace detail
+{
+	inline void cross(const float* a, const float* b, float* out)
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	//HLSLのnormalizeと同じくrsqrtを掛ける (長さ0ならNaN)
+	inline void normalize(float* v)
+	{
+		const float inverse = 1.0f / sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		for (int c = 0; c < 3; c++) { v[c] *= inverse; }
+	}
+
+	//mul(float4(p, w), world).xyz
+	inline void transform(const float* world, const float* p, float w, float* out)
+	{
+		for (int c = 0; c < 3; c++) { out[c] = p[0] * world[c] + p[1] * world[4 + c] + p[2] * world[8 + c] + w * world[12 + c]; }
+	}
+}
+
+void computeTriangleFrames(const float* positions, size_t stride, size_t triangleCount, TriangleFrame* out)
+{
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const float* p0 = positions + (t * 3 + 0) * stride;
+		const float* p1 = positions + (t * 3 + 1) * stride;
+		const float* p2 = positions + (t * 3 + 2) * stride;
+		float edge1[3];
+		float edge2[3];
+		for (int c = 0; c < 3; c++)
+		{
+			out[t].center[c] = (p0[c] + p1[c] + p2[c]) / 3.0f;
+			edge1[c] = p1[c] - p0[c];
+			edge2[c] = p2[c] - p0[c];
+		}
+		detail::cross(edge1, edge2, out[t].faceNormal);
+		detail::normalize(out[t].faceNormal);
+	}
+}
+
+void destructTriangleReference(const float world[16], const DestructionParams& params, const float positions[9], float out[9])
+{
+	float layout[3][3];
+	float center[3] = { 0, 0, 0 };
+	for (int i = 0; i < 3; i++)
+	{
+		detail::transform(world, positions + i * 3, 1.0f, layout[i]);
+		for (int c = 0; c < 3; c++) { center[c] += layout[i][c]; }
+	}
+	for (int c = 0; c < 3; c++) { center[c] /= 3.0f; }
+	float edge1[3];
+	float edge2[3];
+	float normal[3];
+	for (int c = 0; c < 3; c++)
+	{
+		edge1[c] = layout[1][c] - layout[0][c];
+		edge2[c] = layout[2][c] - layout[0][c];
+	}
+	detail::cross(edge1, edge2, normal);
+	detail::normalize(normal);
+
+	//axisRotationMatrix
+	const float cosine = cosf(params.rotation);
+	const float sine = sinf(params.rotation);
+	const float x = normal[0];
+	const float y = normal[1];
+	const float z = normal[2];
+	const float m1[3][3] =
+	{
+		{ cosine, -z * sine, y * sine },
+		{ z * sine, cosine, -x * sine },
+		{ -y * sine, x * sine, cosine },
+	};
+	float m2[3][3];
+	for (int r = 0; r < 3; r++)
+	{
+		for (int c = 0; c < 3; c++) { m2[r][c] = normal[r] * normal[c] * (1 - cosine) + m1[r][c]; }
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		float temp[3];
+		for (int c = 0; c < 3; c++) { temp[c] = (layout[i][c] - center[c]) * params.scale; }
+		for (int c = 0; c < 3; c++)
+		{
+			const float rotated = temp[0] * m2[0][c] + temp[1] * m2[1][c] + temp[2] * m2[2][c];
+			out[i * 3 + c] = rotated + center[c] + normal[c] * params.move;
+		}
+	}
+}
+
+void destructVertex(const float world[16], const DestructionParams& params, const float position[3], const TriangleFrame& frame, float out[3])
+{
+	float worldPosition[3];
+	float center[3];
+	detail::transform(world, position, 1.0f, worldPosition);
+	detail::transform(world, frame.center, 1.0f, center);
+	//(a W) x (b W) = (a x b)の各成分で行の外積を重ねたもの
+	float cofactor[3][3];
+	detail::cross(world + 4, world + 8, cofactor[0]);
+	detail::cross(world + 8, world + 0, cofactor[1]);
+	detail::cross(world + 0, world + 4, cofactor[2]);
+	float normal[3];
+	for (int c = 0; c < 3; c++)
+	{
+		normal[c] = frame.faceNormal[0] * cofactor[0][c] + frame.faceNormal[1] * cofactor[1][c] + frame.faceNormal[2] * cofactor[2][c];
+	}
+	detail::normalize(normal);
+
+	//軸回転はロドリゲスの式で, 行列を作らない
+	const float cosine = cosf(params.rotation);
+	const float sine = sinf(params.rotation);
+	float v[3];
+	for (int c = 0; c < 3; c++) { v[c] = (worldPosition[c] - center[c]) * params.scale; }
+	float vCrossAxis[3];
+	detail::cross(v, normal, vCrossAxis);
+	const float along = (v[0] * normal[0] + v[1] * normal[1] + v[2] * normal[2]) * (1 - cosine);
+	for (int c = 0; c < 3; c++)
+	{
+		out[c] = v[c] * cosine + vCrossAxis[c] * sine + normal[c] * along + center[c] + normal[c] * params.move;
+	}
+}
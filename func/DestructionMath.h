@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <stddef.h>
+
+/****************************************************************
+	CPU side of the Destruction effect, which moves every
+	tessellated triangle along its face normal, scales it about its
+	center and rotates it around the normal.
+	destructTriangleReference follows Destruction_gs step by step
+	(world transform, centroid, axisRotationMatrix).
+	The geometry-shader-free path splits that work in two:
+	computeTriangleFrames is the one-time precompute of
+	DestructionFrame_gs (object-space center and face normal per
+	triangle), and destructVertex is DestructionPulled_vs, which
+	moves one vertex from its triangle's frame. The face normal is
+	taken to world space with the cofactor of world, which is the
+	direction of the cross product of the transformed edges, so
+	non-uniform and mirrored worlds match the geometry shader.
+	Matrices are row-major and multiply row vectors, as in HLSL.
+****************************************************************/
+struct TriangleFrame
+{
+	float center[3];
+	float faceNormal[3];		// unit length, NaN for a degenerate triangle
+};
+
+struct DestructionParams
+{
+	float move = 0;
+	float scale = 1;
+	float rotation = 0;
+};
+
+// positions holds 3 floats per vertex every stride floats, 3 vertices per triangle.
+void computeTriangleFrames(const float* positions, size_t stride, size_t triangleCount, TriangleFrame* out);
+// World-space positions of one triangle as Destruction_gs emits them.
+void destructTriangleReference(const float world[16], const DestructionParams& params, const float positions[9], float out[9]);
+// World-space position of one vertex as DestructionPulled_vs computes it.
+void destructVertex(const float world[16], const DestructionParams& params, const float position[3], const TriangleFrame& frame, float out[3]);
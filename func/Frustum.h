@@ -0,0 +1,43 @@
+﻿#pragma once
+#include <math.h>
+
+/****************************************************************
+	Frustum planes (a, b, c, d) with a*x + b*y + c*z + d >= 0 inside.
+	matrix is row-major for row vectors (DirectXMath layout) and
+	maps to D3D clip space (0 <= z <= w).
+	Pass world * viewProjection to get object-space planes.
+	Order: left, right, bottom, top, near, far.
+****************************************************************/
+inline void extractFrustumPlanes(float outPlanes[6][4], const float matrix[16])
+{
+	for (int i = 0; i < 4; i++)
+	{
+		const float x = matrix[i * 4 + 0];
+		const float y = matrix[i * 4 + 1];
+		const float z = matrix[i * 4 + 2];
+		const float w = matrix[i * 4 + 3];
+		outPlanes[0][i] = w + x;
+		outPlanes[1][i] = w - x;
+		outPlanes[2][i] = w + y;
+		outPlanes[3][i] = w - y;
+		outPlanes[4][i] = z;
+		outPlanes[5][i] = w - z;
+	}
+	for (int p = 0; p < 6; p++)
+	{
+		const float length = sqrtf(outPlanes[p][0] * outPlanes[p][0] + outPlanes[p][1] * outPlanes[p][1] + outPlanes[p][2] * outPlanes[p][2]);
+		if (length > 0.0f)
+		{
+			for (int i = 0; i < 4; i++) { outPlanes[p][i] /= length; }
+		}
+	}
+}
+
+inline bool isSphereInFrustum(const float planes[6][4], const float center[3], float radius)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		if (planes[p][0] * center[0] + planes[p][1] * center[1] + planes[p][2] * center[2] + planes[p][3] < -radius) { return false; }
+	}
+	return true;
+}
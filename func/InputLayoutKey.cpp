@@ -0,0 +1,69 @@
+﻿#include "InputLayoutKey.h"
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void InputLayoutKey::append(const void* data, size_t size)
+{
+	bytes.append(static_cast<const char*>(data), size);
+	hash = hashBytes(data, size, hash);
+}
+
+void InputLayoutKey::appendName(const char* name)
+{
+	//セマンティクスは大文字小文字を区別しない
+	for (; *name; name++)
+	{
+		const char c = (*name >= 'a' && *name <= 'z') ? static_cast<char>(*name - 'a' + 'A') : *name;
+		append(&c, 1);
+	}
+	append("", 1);
+}
+
+void InputLayoutKey::addElement(const char* semanticName, uint32_t semanticIndex, uint32_t format,
+	uint32_t inputSlot, uint32_t alignedByteOffset, uint32_t inputSlotClass, uint32_t instanceDataStepRate)
+{
+	append("E", 1);
+	appendName(semanticName);
+	appendU32(semanticIndex);
+	appendU32(format);
+	appendU32(inputSlot);
+	appendU32(alignedByteOffset);
+	appendU32(inputSlotClass);
+	appendU32(instanceDataStepRate);
+}
+
+void InputLayoutKey::addSignature(const std::vector<InputSignatureElement>& elements)
+{
+	//SV_VertexIDなどは入力レイアウトから供給されないので含めない
+	for (const InputSignatureElement& element : elements)
+	{
+		if (element.systemValue != 0) { continue; }
+		append("S", 1);
+		appendName(element.semanticName.c_str());
+		appendU32(element.semanticIndex);
+		appendU32(element.registerIndex);
+		appendU32(element.componentType);
+	}
+}
+
+void InputLayoutKey::addBytecode(const void* bytecode, size_t size)
+{
+	append("B", 1);
+	appendU32(static_cast<uint32_t>(size));
+	append(bytecode, size);
+}
+
+void InputLayoutKey::clear()
+{
+	bytes.clear();
+	hash = fnvOffsetBasis;
+}
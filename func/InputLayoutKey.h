@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ShaderReflection.h"
+
+/****************************************************************
+	Cache key of an input layout.
+	An ID3D11InputLayout depends only on the element descriptions
+	and on which inputs the vertex shader declares, so the key is
+	built from those two and not from the shader path:
+		key.addElement(...) for each D3D11_INPUT_ELEMENT_DESC
+		key.addSignature(reflectInputSignature(...))
+	Semantic names are compared case-insensitively like D3D does.
+	Component masks and system values are left out of the signature,
+	so Toon_vs (float3 inputs) and Destruction_vs (float4) share one
+	layout. The hash is 64-bit FNV-1a and equality compares the
+	serialized bytes, so a collision never returns a wrong layout.
+****************************************************************/
+
+constexpr uint64_t fnvOffsetBasis = 14695981039346656037ull;
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = fnvOffsetBasis);
+
+class InputLayoutKey
+{
+private:
+	std::string bytes;
+	uint64_t hash = fnvOffsetBasis;
+
+	void append(const void* data, size_t size);
+	void appendU32(uint32_t value) { append(&value, sizeof(value)); }
+	void appendName(const char* name);
+public:
+	// Fields of D3D11_INPUT_ELEMENT_DESC in declaration order.
+	void addElement(const char* semanticName, uint32_t semanticIndex, uint32_t format,
+		uint32_t inputSlot, uint32_t alignedByteOffset, uint32_t inputSlotClass, uint32_t instanceDataStepRate);
+	void addSignature(const std::vector<InputSignatureElement>& elements);
+	// Fallback when the signature cannot be reflected: the whole bytecode.
+	void addBytecode(const void* bytecode, size_t size);
+	void clear();
+
+	uint64_t getHash()const { return hash; }
+	const std::string& getBytes()const { return bytes; }
+	bool operator==(const InputLayoutKey& other)const { return hash == other.hash && bytes == other.bytes; }
+	bool operator!=(const InputLayoutKey& other)const { return !(*this == other); }
+
+	struct Hasher
+	{
+		size_t operator()(const InputLayoutKey& key)const { return static_cast<size_t>(key.getHash()); }
+	};
+};
@@ -0,0 +1,141 @@
+﻿#include "InstancePacking.h"
+#include "ParallelFor.h"
+#include <string.h>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define INSTANCE_PACKING_SSE2
+#endif
+
+namespace detail
+{
+	constexpr float white[4] = { 1.0f,1.0f,1.0f,1.0f };
+	//これより大きな出力はキャッシュに残らないので, 読み込みを伴わないストリーミングストアで書く
+	constexpr size_t streamingBytes = 4 << 20;
+
+	//objectTransform * worldの1行. 参照実装とSIMDで同じ順に足す
+	inline void transformRow(const float* transformRow, const float* world, float* outRow)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			outRow[c] = transformRow[0] * world[c] + transformRow[1] * world[4 + c] + transformRow[2] * world[8 + c] + transformRow[3] * world[12 + c];
+		}
+	}
+
+#ifdef INSTANCE_PACKING_SSE2
+	template<bool streaming>
+	inline void storeRow(float* dst, __m128 value)
+	{
+		if (streaming) { _mm_stream_ps(dst, value); }
+		else { _mm_store_ps(dst, value); }
+	}
+
+	inline __m128 transformRow(const __m128* transformRow, __m128 row0, __m128 row1, __m128 row2, __m128 row3)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(transformRow[0], row0), _mm_mul_ps(transformRow[1], row1)), _mm_mul_ps(transformRow[2], row2)), _mm_mul_ps(transformRow[3], row3));
+	}
+#endif
+
+	template<bool streaming, bool transformed>
+	void packInstanceRange(PackedInstance* dst, const float* worlds, const float* colors, const float* objectTransform, size_t begin, size_t end)
+	{
+		//色の有無はループの外で決める
+		const float* color = colors ? colors : white;
+		const size_t colorStride = colors ? 4 : 0;
+#ifdef INSTANCE_PACKING_SSE2
+		__m128 transform[4][4];
+		if (transformed)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				for (int k = 0; k < 4; k++) { transform[r][k] = _mm_set1_ps(objectTransform[r * 4 + k]); }
+			}
+		}
+#endif
+		for (size_t i = begin; i < end; i++)
+		{
+			const float* m = worlds + i * 16;
+#ifdef INSTANCE_PACKING_SSE2
+			//使わない4列目を作らない分、_MM_TRANSPOSE4_PSよりシャッフルが2つ少ない
+			__m128 row0 = _mm_loadu_ps(m);
+			__m128 row1 = _mm_loadu_ps(m + 4);
+			__m128 row2 = _mm_loadu_ps(m + 8);
+			__m128 row3 = _mm_loadu_ps(m + 12);
+			if (transformed)
+			{
+				const __m128 world0 = row0, world1 = row1, world2 = row2, world3 = row3;
+				row0 = transformRow(transform[0], world0, world1, world2, world3);
+				row1 = transformRow(transform[1], world0, world1, world2, world3);
+				row2 = transformRow(transform[2], world0, world1, world2, world3);
+				row3 = transformRow(transform[3], world0, world1, world2, world3);
+			}
+			const __m128 low01 = _mm_unpacklo_ps(row0, row1);
+			const __m128 low23 = _mm_unpacklo_ps(row2, row3);
+			const __m128 high01 = _mm_unpackhi_ps(row0, row1);
+			const __m128 high23 = _mm_unpackhi_ps(row2, row3);
+			storeRow<streaming>(dst[i].world[0], _mm_movelh_ps(low01, low23));
+			storeRow<streaming>(dst[i].world[1], _mm_movehl_ps(low23, low01));
+			storeRow<streaming>(dst[i].world[2], _mm_movelh_ps(high01, high23));
+			storeRow<streaming>(dst[i].color, _mm_loadu_ps(color + i * colorStride));
+#else
+			float folded[16];
+			if (transformed)
+			{
+				for (int r = 0; r < 4; r++) { transformRow(objectTransform + r * 4, m, folded + r * 4); }
+				m = folded;
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				for (int r = 0; r < 4; r++) { dst[i].world[c][r] = m[r * 4 + c]; }
+			}
+			memcpy(dst[i].color, color + i * colorStride, sizeof(dst[i].color));
+#endif
+		}
+#ifdef INSTANCE_PACKING_SSE2
+		//ストリーミングストアを他のスレッドやアップロードから見えるようにする
+		if (streaming) { _mm_sfence(); }
+#endif
+	}
+
+	template<bool streaming>
+	void packInstanceRange(PackedInstance* dst, const float* worlds, const float* colors, const float* objectTransform, size_t begin, size_t end)
+	{
+		if (objectTransform) { packInstanceRange<streaming, true>(dst, worlds, colors, objectTransform, begin, end); }
+		else { packInstanceRange<streaming, false>(dst, worlds, colors, objectTransform, begin, end); }
+	}
+}
+
+void packInstances(PackedInstance* dst, const float* worlds, const float* colors, size_t count, const float* objectTransform)
+{
+	//小さなバッチはスレッドを起こす方が高くつく
+	constexpr size_t minRange = 4096;
+	const bool streaming = count * sizeof(PackedInstance) >= detail::streamingBytes;
+	if (count <= minRange)
+	{
+		detail::packInstanceRange<false>(dst, worlds, colors, objectTransform, 0, count);
+		return;
+	}
+	parallelForRanges(count, minRange, [&](size_t begin, size_t end, size_t)
+		{
+			if (streaming) { detail::packInstanceRange<true>(dst, worlds, colors, objectTransform, begin, end); }
+			else { detail::packInstanceRange<false>(dst, worlds, colors, objectTransform, begin, end); }
+		});
+}
+
+void packInstancesReference(PackedInstance* dst, const float* worlds, const float* colors, size_t count, const float* objectTransform)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* m = worlds + i * 16;
+		float folded[16];
+		if (objectTransform)
+		{
+			for (int r = 0; r < 4; r++) { detail::transformRow(objectTransform + r * 4, m, folded + r * 4); }
+			m = folded;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			for (int r = 0; r < 4; r++) { dst[i].world[c][r] = m[r * 4 + c]; }
+		}
+		memcpy(dst[i].color, colors ? colors + i * 4 : detail::white, sizeof(dst[i].color));
+	}
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <stddef.h>
+
+/****************************************************************
+	64-byte per-instance record for StructuredBuffer<Instance>.
+	world holds the first three columns of a row-major row-vector
+	matrix, so the shader transforms with three dot products.
+	The last column (0, 0, 0, 1) is dropped.
+****************************************************************/
+struct alignas(16) PackedInstance
+{
+	float world[3][4];
+	float color[4];
+};
+static_assert(sizeof(PackedInstance) == 64, "PackedInstance must match the HLSL layout");
+
+/****************************************************************
+	Pack count instances. worlds are 16 floats each, colors 4 floats
+	each (null packs white). Transposes with SSE2 and splits large
+	batches across all cores. Outputs larger than the cache are
+	written with streaming stores, which skip reading the lines
+	first. Matches the scalar reference exactly.
+	Pack a whole frame's instances in one call and upload them in
+	draw batches from the result; each call costs a few
+	microseconds before the first instance.
+	objectTransform (16 floats, may be null) is applied before every
+	world, e.g. the dequantization of quantized vertices, so the
+	shader does not need a second matrix.
+****************************************************************/
+void packInstances(PackedInstance* dst, const float* worlds, const float* colors, size_t count, const float* objectTransform = nullptr);
+void packInstancesReference(PackedInstance* dst, const float* worlds, const float* colors, size_t count, const float* objectTransform = nullptr);
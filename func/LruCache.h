@@ -0,0 +1,118 @@
+﻿#pragma once
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/****************************************************************
+	Fixed number of values keyed by Key, evicting the least
+	recently used one. acquire hands back the value for a key; on a
+	miss it is an unused slot or the evicted one with its old
+	contents kept, so GPU buffers in it can be reused instead of
+	created again. Capacities are small (a few captures), so lookup
+	is a linear scan over operator==.
+****************************************************************/
+template<class Key, class Value>
+class LruCache
+{
+private:
+	struct Entry
+	{
+		Key key{};
+		Value value{};
+		uint64_t lastUse = 0;
+		bool valid = false;
+	};
+	std::vector<Entry> entries;
+	uint64_t useCount = 0;
+	size_t hitCount = 0;
+	size_t missCount = 0;
+	size_t evictionCount = 0;
+public:
+	explicit LruCache(size_t capacity = 4) :entries(capacity) { assert(capacity > 0 && "The capacity is invalid."); }
+
+	// Shrinking drops the least recently used keys.
+	void setCapacity(size_t capacity)
+	{
+		assert(capacity > 0 && "The capacity is invalid.");
+		if (capacity == entries.size()) { return; }
+		while (entries.size() > capacity)
+		{
+			size_t oldest = 0;
+			for (size_t i = 1; i < entries.size(); i++)
+			{
+				if (!entries[i].valid || (entries[oldest].valid && entries[i].lastUse < entries[oldest].lastUse)) { oldest = i; }
+			}
+			evictionCount += entries[oldest].valid;
+			entries.erase(entries.begin() + oldest);
+		}
+		entries.resize(capacity);
+	}
+	// Marks key as used; nullptr if it is not held.
+	Value* find(const Key& key)
+	{
+		for (Entry& entry : entries)
+		{
+			if (entry.valid && entry.key == key)
+			{
+				entry.lastUse = ++useCount;
+				return &entry.value;
+			}
+		}
+		return nullptr;
+	}
+	// *outHit is false when the value has to be filled for key.
+	Value& acquire(const Key& key, bool* outHit)
+	{
+		if (Value* value = find(key))
+		{
+			hitCount++;
+			*outHit = true;
+			return *value;
+		}
+		missCount++;
+		*outHit = false;
+		//空きがなければ一番長く使っていないものを追い出す
+		Entry* slot = &entries[0];
+		for (Entry& entry : entries)
+		{
+			if (!entry.valid) { slot = &entry; break; }
+			if (entry.lastUse < slot->lastUse) { slot = &entry; }
+		}
+		evictionCount += slot->valid;
+		slot->key = key;
+		slot->valid = true;
+		slot->lastUse = ++useCount;
+		return slot->value;
+	}
+	// Forgets key (filling it failed); the value stays for reuse.
+	void erase(const Key& key)
+	{
+		for (Entry& entry : entries)
+		{
+			if (entry.valid && entry.key == key) { entry.valid = false; }
+		}
+	}
+	// Forgets every key; the values stay for reuse.
+	void clear()
+	{
+		for (Entry& entry : entries) { entry.valid = false; }
+	}
+	// Calls function(value) for every held key and every reusable slot.
+	template<class Function>
+	void forEachValue(Function&& function)
+	{
+		for (Entry& entry : entries) { function(entry.value); }
+	}
+
+	size_t getCapacity()const { return entries.size(); }
+	size_t getSize()const
+	{
+		size_t size = 0;
+		for (const Entry& entry : entries) { size += entry.valid; }
+		return size;
+	}
+	size_t getHitCount()const { return hitCount; }
+	size_t getMissCount()const { return missCount; }
+	size_t getEvictionCount()const { return evictionCount; }
+};
@@ -0,0 +1,86 @@
+﻿#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path)
+{
+	close();
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) { return false; }
+	file = handle;
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		close();
+		return false;
+	}
+	data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!data)
+	{
+		close();
+		return false;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data) { UnmapViewOfFile(data); }
+	if (mapping) { CloseHandle(mapping); }
+	if (file) { CloseHandle(file); }
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+	file = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const char* path)
+{
+	close();
+	file = ::open(path, O_RDONLY);
+	if (file < 0) { return false; }
+	struct stat status {};
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close();
+		return false;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	if (view == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	madvise(view, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+	data = static_cast<const unsigned char*>(view);
+	size = static_cast<size_t>(status.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data) { munmap(const_cast<unsigned char*>(data), size); }
+	if (file >= 0) { ::close(file); }
+	data = nullptr;
+	size = 0;
+	file = -1;
+}
+
+#endif
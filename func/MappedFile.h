@@ -0,0 +1,32 @@
+﻿#pragma once
+#include <stddef.h>
+
+/****************************************************************
+	Read-only memory mapped file.
+	Uses CreateFileMapping on Windows and mmap elsewhere.
+****************************************************************/
+class MappedFile
+{
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#else
+	int file = -1;
+#endif
+public:
+	MappedFile() = default;
+	explicit MappedFile(const char* path) { open(path); }
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* path);
+	void close();
+
+	bool isOpen()const { return data != nullptr; }
+	const unsigned char* getData()const { return data; }
+	size_t getSize()const { return size; }
+};
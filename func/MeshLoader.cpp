@@ -0,0 +1,1233 @@
+﻿#include "MeshLoader.h"
+#include "ParallelFor.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace detail
+{
+	/****************************************************************
+		Text parsing
+	****************************************************************/
+	inline bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && isSpace(*p)) { p++; }
+		return p;
+	}
+
+	inline const char* findLineEnd(const char* p, const char* end)
+	{
+		const void* newline = memchr(p, '\n', static_cast<size_t>(end - p));
+		return newline ? static_cast<const char*>(newline) : end;
+	}
+
+	const double powersOf10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	// Locale independent strtod replacement. Returns null when no digits were read.
+	inline const char* parseNumber(const char* p, const char* end, double& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		int digits = 0;
+		bool any = false;
+		for (; p < end && isDigit(*p); p++)
+		{
+			any = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				digits += mantissa != 0;
+			}
+			else
+			{
+				exponent++;
+			}
+		}
+		if (p < end && *p == '.')
+		{
+			for (p++; p < end && isDigit(*p); p++)
+			{
+				any = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+					digits += mantissa != 0;
+					exponent--;
+				}
+			}
+		}
+		if (!any) { return nullptr; }
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char* q = p + 1;
+			bool negativeExponent = false;
+			if (q < end && (*q == '-' || *q == '+'))
+			{
+				negativeExponent = *q == '-';
+				q++;
+			}
+			if (q < end && isDigit(*q))
+			{
+				int value = 0;
+				for (; q < end && isDigit(*q); q++)
+				{
+					if (value < 10000) { value = value * 10 + (*q - '0'); }
+				}
+				exponent += negativeExponent ? -value : value;
+				p = q;
+			}
+		}
+		double value = static_cast<double>(mantissa);
+		if (mantissa != 0)
+		{
+			if (exponent < 0)
+			{
+				value = exponent >= -22 ? value / powersOf10[-exponent] : value * pow(10.0, exponent);
+			}
+			else if (exponent > 0)
+			{
+				value = exponent <= 22 ? value * powersOf10[exponent] : value * pow(10.0, exponent);
+			}
+		}
+		out = negative ? -value : value;
+		return p;
+	}
+
+	inline const char* parseFloat(const char* p, const char* end, float& out)
+	{
+		double value = 0.0;
+		p = parseNumber(skipSpaces(p, end), end, value);
+		out = static_cast<float>(value);
+		return p;
+	}
+
+	inline const char* parseInteger(const char* p, const char* end, long long& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+		if (p >= end || !isDigit(*p)) { return nullptr; }
+		long long value = 0;
+		for (; p < end && isDigit(*p); p++)
+		{
+			if (value < (1ll << 40)) { value = value * 10 + (*p - '0'); }
+		}
+		out = negative ? -value : value;
+		return p;
+	}
+
+	/****************************************************************
+		Shared mesh helpers
+	****************************************************************/
+	constexpr int noNormal = -1;
+
+	// Area weighted face normals for the flagged vertices (left-handed, CCW front).
+	void generateNormals(MeshData* mesh, const std::vector<unsigned char>& missingNormals)
+	{
+		std::vector<MeshVertex>& vertices = mesh->vertices;
+		const std::vector<unsigned int>& indices = mesh->indices;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			if (missingNormals[i]) { memset(vertices[i].normal, 0, sizeof(vertices[i].normal)); }
+		}
+		for (size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			const unsigned int corner[3] = { indices[t],indices[t + 1],indices[t + 2] };
+			if (!missingNormals[corner[0]] && !missingNormals[corner[1]] && !missingNormals[corner[2]]) { continue; }
+			const float* a = vertices[corner[0]].position;
+			const float* b = vertices[corner[1]].position;
+			const float* c = vertices[corner[2]].position;
+			const float e1[3] = { b[0] - a[0],b[1] - a[1],b[2] - a[2] };
+			const float e2[3] = { c[0] - a[0],c[1] - a[1],c[2] - a[2] };
+			const float n[3] =
+			{
+				e2[1] * e1[2] - e2[2] * e1[1],
+				e2[2] * e1[0] - e2[0] * e1[2],
+				e2[0] * e1[1] - e2[1] * e1[0],
+			};
+			for (unsigned int v : corner)
+			{
+				if (!missingNormals[v]) { continue; }
+				vertices[v].normal[0] += n[0];
+				vertices[v].normal[1] += n[1];
+				vertices[v].normal[2] += n[2];
+			}
+		}
+		parallelFor(vertices.size(), 1 << 16, [&](size_t i)
+			{
+				if (!missingNormals[i]) { return; }
+				float* n = vertices[i].normal;
+				const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length > 0.0f)
+				{
+					n[0] /= length;
+					n[1] /= length;
+					n[2] /= length;
+				}
+				else
+				{
+					n[0] = 0.0f;
+					n[1] = 1.0f;
+					n[2] = 0.0f;
+				}
+			});
+	}
+
+	/****************************************************************
+		OBJ
+	****************************************************************/
+	enum class ObjLine { other, position, normal, face };
+
+	inline ObjLine classifyObjLine(const char*& p, const char* lineEnd)
+	{
+		p = skipSpaces(p, lineEnd);
+		if (lineEnd - p < 2) { return ObjLine::other; }
+		if (p[0] == 'v')
+		{
+			if (isSpace(p[1]))
+			{
+				p += 1;
+				return ObjLine::position;
+			}
+			if (p[1] == 'n' && lineEnd - p > 2 && isSpace(p[2]))
+			{
+				p += 2;
+				return ObjLine::normal;
+			}
+		}
+		else if (p[0] == 'f' && isSpace(p[1]))
+		{
+			p += 1;
+			return ObjLine::face;
+		}
+		return ObjLine::other;
+	}
+
+	struct ObjCorner
+	{
+		int position;
+		int normal;
+	};
+
+	struct ObjChunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+		size_t positionCount = 0;
+		size_t normalCount = 0;
+		size_t triangleCount = 0;
+		size_t positionBase = 0;
+		size_t normalBase = 0;
+		size_t triangleBase = 0;
+		bool valid = true;
+	};
+
+	inline size_t countFaceCorners(const char* p, const char* lineEnd)
+	{
+		size_t count = 0;
+		while (true)
+		{
+			p = skipSpaces(p, lineEnd);
+			if (p >= lineEnd || *p == '#') { break; }
+			count++;
+			while (p < lineEnd && !isSpace(*p)) { p++; }
+		}
+		return count;
+	}
+
+	void countObjChunk(ObjChunk& chunk)
+	{
+		for (const char* line = chunk.begin; line < chunk.end;)
+		{
+			const char* lineEnd = findLineEnd(line, chunk.end);
+			const char* p = line;
+			switch (classifyObjLine(p, lineEnd))
+			{
+			case ObjLine::position: chunk.positionCount++; break;
+			case ObjLine::normal: chunk.normalCount++; break;
+			case ObjLine::face:
+			{
+				const size_t corners = countFaceCorners(p, lineEnd);
+				chunk.triangleCount += corners >= 3 ? corners - 2 : 0;
+				break;
+			}
+			default: break;
+			}
+			line = lineEnd + 1;
+		}
+	}
+
+	// Resolves 1-based and negative (relative) OBJ indices to 0-based.
+	inline bool resolveObjIndex(long long index, size_t definedSoFar, int& out)
+	{
+		if (index > 0) { index -= 1; }
+		else if (index < 0) { index += static_cast<long long>(definedSoFar); }
+		else { return false; }
+		if (index < 0 || index > 0x7FFFFFFF) { return false; }
+		out = static_cast<int>(index);
+		return true;
+	}
+
+	inline bool parseObjCorner(const char*& p, const char* lineEnd, size_t positionsSoFar, size_t normalsSoFar, ObjCorner& corner)
+	{
+		long long index = 0;
+		p = parseInteger(p, lineEnd, index);
+		if (!p || !resolveObjIndex(index, positionsSoFar, corner.position)) { return false; }
+		corner.normal = noNormal;
+		if (p < lineEnd && *p == '/')
+		{
+			p++;
+			if (p < lineEnd && *p != '/')
+			{
+				// Texture coordinates are not used by Geometry.
+				const char* next = parseInteger(p, lineEnd, index);
+				if (next) { p = next; }
+			}
+			if (p < lineEnd && *p == '/')
+			{
+				p++;
+				p = parseInteger(p, lineEnd, index);
+				if (!p || !resolveObjIndex(index, normalsSoFar, corner.normal)) { return false; }
+			}
+		}
+		return p >= lineEnd || isSpace(*p) || *p == '#';
+	}
+
+	void parseObjChunk(ObjChunk& chunk, float* positions, float* normals, ObjCorner* corners)
+	{
+		size_t positionCount = 0;
+		size_t normalCount = 0;
+		size_t triangleCount = 0;
+		for (const char* line = chunk.begin; line < chunk.end && chunk.valid;)
+		{
+			const char* lineEnd = findLineEnd(line, chunk.end);
+			const char* p = line;
+			switch (classifyObjLine(p, lineEnd))
+			{
+			case ObjLine::position:
+			{
+				float* v = positions + (chunk.positionBase + positionCount++) * 3;
+				chunk.valid = (p = parseFloat(p, lineEnd, v[0])) && (p = parseFloat(p, lineEnd, v[1])) && (p = parseFloat(p, lineEnd, v[2]));
+				break;
+			}
+			case ObjLine::normal:
+			{
+				float* n = normals + (chunk.normalBase + normalCount++) * 3;
+				chunk.valid = (p = parseFloat(p, lineEnd, n[0])) && (p = parseFloat(p, lineEnd, n[1])) && (p = parseFloat(p, lineEnd, n[2]));
+				break;
+			}
+			case ObjLine::face:
+			{
+				ObjCorner first{}, previous{}, corner{};
+				for (size_t cornerIndex = 0;; cornerIndex++)
+				{
+					p = skipSpaces(p, lineEnd);
+					if (p >= lineEnd || *p == '#') { break; }
+					if (!parseObjCorner(p, lineEnd, chunk.positionBase + positionCount, chunk.normalBase + normalCount, corner))
+					{
+						chunk.valid = false;
+						break;
+					}
+					//扇状に三角形分割
+					if (cornerIndex == 0) { first = corner; }
+					else if (cornerIndex >= 2 && triangleCount < chunk.triangleCount)
+					{
+						ObjCorner* triangle = corners + (chunk.triangleBase + triangleCount++) * 3;
+						triangle[0] = first;
+						triangle[1] = previous;
+						triangle[2] = corner;
+					}
+					previous = corner;
+				}
+				break;
+			}
+			default: break;
+			}
+			line = lineEnd + 1;
+		}
+		chunk.valid = chunk.valid && triangleCount == chunk.triangleCount;
+	}
+
+	/****************************************************************
+		JSON (glTF header only, so a small DOM is enough)
+	****************************************************************/
+	struct JsonValue
+	{
+		enum class Type { null, boolean, number, string, array, object };
+		Type type = Type::null;
+		double number = 0.0;
+		std::string string;
+		std::vector<std::string> keys;
+		std::vector<JsonValue> elements;
+
+		const JsonValue* find(const char* key)const
+		{
+			if (type != Type::object) { return nullptr; }
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				if (keys[i] == key) { return &elements[i]; }
+			}
+			return nullptr;
+		}
+
+		const JsonValue* at(size_t index)const
+		{
+			return type == Type::array && index < elements.size() ? &elements[index] : nullptr;
+		}
+
+		bool getNumber(const char* key, double& out)const
+		{
+			const JsonValue* value = find(key);
+			if (!value || value->type != Type::number) { return false; }
+			out = value->number;
+			return true;
+		}
+
+		bool getIndex(const char* key, size_t& out)const
+		{
+			double value = 0.0;
+			if (!getNumber(key, value) || value < 0.0 || value != floor(value)) { return false; }
+			out = static_cast<size_t>(value);
+			return true;
+		}
+	};
+
+	class JsonParser
+	{
+	private:
+		const char* p;
+		const char* end;
+
+		void skipWhitespace()
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) { p++; }
+		}
+
+		bool parseLiteral(const char* literal)
+		{
+			const size_t length = strlen(literal);
+			if (static_cast<size_t>(end - p) < length || memcmp(p, literal, length) != 0) { return false; }
+			p += length;
+			return true;
+		}
+
+		bool parseString(std::string& out)
+		{
+			if (p >= end || *p != '"') { return false; }
+			p++;
+			out.clear();
+			while (p < end && *p != '"')
+			{
+				if (*p != '\\')
+				{
+					out.push_back(*p++);
+					continue;
+				}
+				if (++p >= end) { return false; }
+				switch (*p++)
+				{
+				case '"': out.push_back('"'); break;
+				case '\\': out.push_back('\\'); break;
+				case '/': out.push_back('/'); break;
+				case 'b': out.push_back('\b'); break;
+				case 'f': out.push_back('\f'); break;
+				case 'n': out.push_back('\n'); break;
+				case 'r': out.push_back('\r'); break;
+				case 't': out.push_back('\t'); break;
+				case 'u':
+				{
+					if (end - p < 4) { return false; }
+					unsigned int code = 0;
+					for (int i = 0; i < 4; i++, p++)
+					{
+						const char c = *p;
+						code <<= 4;
+						if (isDigit(c)) { code |= static_cast<unsigned int>(c - '0'); }
+						else if (c >= 'a' && c <= 'f') { code |= static_cast<unsigned int>(c - 'a' + 10); }
+						else if (c >= 'A' && c <= 'F') { code |= static_cast<unsigned int>(c - 'A' + 10); }
+						else { return false; }
+					}
+					if (code < 0x80)
+					{
+						out.push_back(static_cast<char>(code));
+					}
+					else if (code < 0x800)
+					{
+						out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+						out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+					}
+					else
+					{
+						out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+						out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+						out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+					}
+					break;
+				}
+				default: return false;
+				}
+			}
+			if (p >= end) { return false; }
+			p++;
+			return true;
+		}
+
+		bool parseValue(JsonValue& out, int depth)
+		{
+			if (depth > 64) { return false; }
+			skipWhitespace();
+			if (p >= end) { return false; }
+			switch (*p)
+			{
+			case '{':
+			{
+				out.type = JsonValue::Type::object;
+				p++;
+				skipWhitespace();
+				if (p < end && *p == '}')
+				{
+					p++;
+					return true;
+				}
+				while (true)
+				{
+					skipWhitespace();
+					out.keys.emplace_back();
+					if (!parseString(out.keys.back())) { return false; }
+					skipWhitespace();
+					if (p >= end || *p != ':') { return false; }
+					p++;
+					out.elements.emplace_back();
+					if (!parseValue(out.elements.back(), depth + 1)) { return false; }
+					skipWhitespace();
+					if (p < end && *p == ',')
+					{
+						p++;
+						continue;
+					}
+					if (p < end && *p == '}')
+					{
+						p++;
+						return true;
+					}
+					return false;
+				}
+			}
+			case '[':
+			{
+				out.type = JsonValue::Type::array;
+				p++;
+				skipWhitespace();
+				if (p < end && *p == ']')
+				{
+					p++;
+					return true;
+				}
+				while (true)
+				{
+					out.elements.emplace_back();
+					if (!parseValue(out.elements.back(), depth + 1)) { return false; }
+					skipWhitespace();
+					if (p < end && *p == ',')
+					{
+						p++;
+						continue;
+					}
+					if (p < end && *p == ']')
+					{
+						p++;
+						return true;
+					}
+					return false;
+				}
+			}
+			case '"':
+				out.type = JsonValue::Type::string;
+				return parseString(out.string);
+			case 't':
+				out.type = JsonValue::Type::boolean;
+				out.number = 1.0;
+				return parseLiteral("true");
+			case 'f':
+				out.type = JsonValue::Type::boolean;
+				out.number = 0.0;
+				return parseLiteral("false");
+			case 'n':
+				out.type = JsonValue::Type::null;
+				return parseLiteral("null");
+			default:
+				out.type = JsonValue::Type::number;
+				p = parseNumber(p, end, out.number);
+				return p != nullptr;
+			}
+		}
+	public:
+		JsonParser(const char* text, size_t size) :p(text), end(text + size) {}
+
+		bool parse(JsonValue& out)
+		{
+			if (!parseValue(out, 0)) { return false; }
+			skipWhitespace();
+			while (p < end && *p == '\0') { p++; }
+			return p == end;
+		}
+	};
+
+	/****************************************************************
+		glTF binary
+	****************************************************************/
+	inline uint32_t readU32(const unsigned char* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	constexpr uint32_t glbMagic = 0x46546C67;		// "glTF"
+	constexpr uint32_t glbChunkJson = 0x4E4F534A;	// "JSON"
+	constexpr uint32_t glbChunkBin = 0x004E4942;	// "BIN\0"
+
+	enum GltfComponent
+	{
+		gltfByte = 5120,
+		gltfUnsignedByte = 5121,
+		gltfShort = 5122,
+		gltfUnsignedShort = 5123,
+		gltfUnsignedInt = 5125,
+		gltfFloat = 5126,
+	};
+
+	inline size_t getComponentSize(size_t componentType)
+	{
+		switch (componentType)
+		{
+		case gltfByte: case gltfUnsignedByte: return 1;
+		case gltfShort: case gltfUnsignedShort: return 2;
+		case gltfUnsignedInt: case gltfFloat: return 4;
+		default: return 0;
+		}
+	}
+
+	inline size_t getComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") { return 1; }
+		if (type == "VEC2") { return 2; }
+		if (type == "VEC3") { return 3; }
+		if (type == "VEC4") { return 4; }
+		if (type == "MAT4") { return 16; }
+		return 0;
+	}
+
+	struct AccessorView
+	{
+		const unsigned char* data = nullptr;
+		size_t count = 0;
+		size_t stride = 0;
+		size_t componentType = 0;
+		size_t componentCount = 0;
+	};
+
+	struct GlbContext
+	{
+		const JsonValue* root;
+		const unsigned char* bin;
+		size_t binSize;
+		MeshData* mesh;
+		std::vector<unsigned char>* missingNormals;
+	};
+
+	MeshLoadResult getAccessor(const GlbContext& context, size_t accessorIndex, AccessorView& out)
+	{
+		const JsonValue* accessors = context.root->find("accessors");
+		const JsonValue* bufferViews = context.root->find("bufferViews");
+		const JsonValue* accessor = accessors ? accessors->at(accessorIndex) : nullptr;
+		if (!accessor || !bufferViews) { return MeshLoadResult::invalidData; }
+		if (accessor->find("sparse")) { return MeshLoadResult::unsupportedFormat; }
+		const JsonValue* type = accessor->find("type");
+		size_t viewIndex = 0;
+		if (!type || !accessor->getIndex("bufferView", viewIndex) ||
+			!accessor->getIndex("componentType", out.componentType) ||
+			!accessor->getIndex("count", out.count)) { return MeshLoadResult::invalidData; }
+		out.componentCount = getComponentCount(type->string);
+		const size_t elementSize = getComponentSize(out.componentType) * out.componentCount;
+		if (elementSize == 0) { return MeshLoadResult::invalidData; }
+
+		const JsonValue* view = bufferViews->at(viewIndex);
+		size_t buffer = 0, viewOffset = 0, viewLength = 0, accessorOffset = 0;
+		if (!view || !view->getIndex("byteLength", viewLength)) { return MeshLoadResult::invalidData; }
+		view->getIndex("buffer", buffer);
+		view->getIndex("byteOffset", viewOffset);
+		accessor->getIndex("byteOffset", accessorOffset);
+		out.stride = elementSize;
+		view->getIndex("byteStride", out.stride);
+		// Only the embedded BIN chunk (buffer 0) is supported.
+		if (buffer != 0 || !context.bin) { return MeshLoadResult::unsupportedFormat; }
+		if (out.stride < elementSize || viewOffset > context.binSize || viewLength > context.binSize - viewOffset) { return MeshLoadResult::invalidData; }
+		if (out.count > 0 && (accessorOffset > viewLength ||
+			(out.count - 1) > (viewLength - accessorOffset) / out.stride ||
+			(out.count - 1) * out.stride + elementSize > viewLength - accessorOffset)) { return MeshLoadResult::invalidData; }
+		out.data = context.bin + viewOffset + accessorOffset;
+		return MeshLoadResult::ok;
+	}
+
+	// Column-major 4x4 matrices as stored by glTF.
+	inline void multiplyMatrix(float out[16], const float a[16], const float b[16])
+	{
+		float r[16];
+		for (int c = 0; c < 4; c++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				r[c * 4 + row] = a[0 * 4 + row] * b[c * 4 + 0] + a[1 * 4 + row] * b[c * 4 + 1] + a[2 * 4 + row] * b[c * 4 + 2] + a[3 * 4 + row] * b[c * 4 + 3];
+			}
+		}
+		memcpy(out, r, sizeof(r));
+	}
+
+	inline void getNodeMatrix(const JsonValue& node, float out[16])
+	{
+		static const float identity[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+		memcpy(out, identity, sizeof(identity));
+		const JsonValue* matrix = node.find("matrix");
+		if (matrix && matrix->type == JsonValue::Type::array && matrix->elements.size() == 16)
+		{
+			for (int i = 0; i < 16; i++) { out[i] = static_cast<float>(matrix->elements[i].number); }
+			return;
+		}
+		float t[3] = { 0,0,0 }, r[4] = { 0,0,0,1 }, s[3] = { 1,1,1 };
+		const JsonValue* translation = node.find("translation");
+		const JsonValue* rotation = node.find("rotation");
+		const JsonValue* scale = node.find("scale");
+		if (translation && translation->elements.size() == 3) { for (int i = 0; i < 3; i++) { t[i] = static_cast<float>(translation->elements[i].number); } }
+		if (rotation && rotation->elements.size() == 4) { for (int i = 0; i < 4; i++) { r[i] = static_cast<float>(rotation->elements[i].number); } }
+		if (scale && scale->elements.size() == 3) { for (int i = 0; i < 3; i++) { s[i] = static_cast<float>(scale->elements[i].number); } }
+		const float x = r[0], y = r[1], z = r[2], w = r[3];
+		out[0] = (1 - 2 * (y * y + z * z)) * s[0];
+		out[1] = (2 * (x * y + z * w)) * s[0];
+		out[2] = (2 * (x * z - y * w)) * s[0];
+		out[4] = (2 * (x * y - z * w)) * s[1];
+		out[5] = (1 - 2 * (x * x + z * z)) * s[1];
+		out[6] = (2 * (y * z + x * w)) * s[1];
+		out[8] = (2 * (x * z + y * w)) * s[2];
+		out[9] = (2 * (y * z - x * w)) * s[2];
+		out[10] = (1 - 2 * (x * x + y * y)) * s[2];
+		out[12] = t[0];
+		out[13] = t[1];
+		out[14] = t[2];
+	}
+
+	inline void cross(float out[3], const float a[3], const float b[3])
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	MeshLoadResult appendPrimitive(const GlbContext& context, const JsonValue& primitive, const float matrix[16])
+	{
+		double mode = 4.0;
+		primitive.getNumber("mode", mode);
+		if (mode != 4.0) { return MeshLoadResult::ok; }	// points and lines are skipped
+		const JsonValue* attributes = primitive.find("attributes");
+		size_t positionAccessor = 0;
+		if (!attributes || !attributes->getIndex("POSITION", positionAccessor)) { return MeshLoadResult::invalidData; }
+
+		AccessorView positions, normals, indices;
+		MeshLoadResult result = getAccessor(context, positionAccessor, positions);
+		if (result != MeshLoadResult::ok) { return result; }
+		if (positions.componentType != gltfFloat || positions.componentCount != 3) { return MeshLoadResult::unsupportedFormat; }
+		size_t normalAccessor = 0;
+		const bool hasNormals = attributes->getIndex("NORMAL", normalAccessor);
+		if (hasNormals)
+		{
+			result = getAccessor(context, normalAccessor, normals);
+			if (result != MeshLoadResult::ok) { return result; }
+			if (normals.componentType != gltfFloat || normals.componentCount != 3 || normals.count != positions.count) { return MeshLoadResult::unsupportedFormat; }
+		}
+		size_t indexAccessor = 0;
+		const bool hasIndices = primitive.getIndex("indices", indexAccessor);
+		if (hasIndices)
+		{
+			result = getAccessor(context, indexAccessor, indices);
+			if (result != MeshLoadResult::ok) { return result; }
+			if (indices.componentCount != 1 || (indices.componentType != gltfUnsignedByte &&
+				indices.componentType != gltfUnsignedShort && indices.componentType != gltfUnsignedInt)) { return MeshLoadResult::invalidData; }
+		}
+
+		//法線は余因子行列で変換し、鏡像なら巻き順を反転する
+		const float* column0 = matrix + 0;
+		const float* column1 = matrix + 4;
+		const float* column2 = matrix + 8;
+		float normalMatrix[9];
+		cross(normalMatrix + 0, column1, column2);
+		cross(normalMatrix + 3, column2, column0);
+		cross(normalMatrix + 6, column0, column1);
+		const float determinant = column0[0] * normalMatrix[0] + column0[1] * normalMatrix[1] + column0[2] * normalMatrix[2];
+		const bool mirrored = determinant < 0.0f;
+
+		MeshData* mesh = context.mesh;
+		const size_t base = mesh->vertices.size();
+		const size_t vertexCount = positions.count;
+		if (base + vertexCount > 0xFFFFFFFFull) { return MeshLoadResult::unsupportedFormat; }
+		mesh->vertices.resize(base + vertexCount);
+		context.missingNormals->resize(base + vertexCount, hasNormals ? 0 : 1);
+		MeshVertex* vertices = mesh->vertices.data() + base;
+		parallelFor(vertexCount, 1 << 14, [&](size_t i)
+			{
+				float p[3], n[3] = { 0,0,0 };
+				memcpy(p, positions.data + i * positions.stride, sizeof(p));
+				MeshVertex& v = vertices[i];
+				v.position[0] = matrix[0] * p[0] + matrix[4] * p[1] + matrix[8] * p[2] + matrix[12];
+				v.position[1] = matrix[1] * p[0] + matrix[5] * p[1] + matrix[9] * p[2] + matrix[13];
+				v.position[2] = -(matrix[2] * p[0] + matrix[6] * p[1] + matrix[10] * p[2] + matrix[14]);
+				if (hasNormals)
+				{
+					memcpy(n, normals.data + i * normals.stride, sizeof(n));
+					float t[3] =
+					{
+						normalMatrix[0] * n[0] + normalMatrix[3] * n[1] + normalMatrix[6] * n[2],
+						normalMatrix[1] * n[0] + normalMatrix[4] * n[1] + normalMatrix[7] * n[2],
+						normalMatrix[2] * n[0] + normalMatrix[5] * n[1] + normalMatrix[8] * n[2],
+					};
+					const float length = sqrtf(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+					const float inverse = length > 0.0f ? (mirrored ? -1.0f : 1.0f) / length : 0.0f;
+					n[0] = t[0] * inverse;
+					n[1] = t[1] * inverse;
+					n[2] = t[2] * inverse;
+				}
+				v.normal[0] = n[0];
+				v.normal[1] = n[1];
+				v.normal[2] = -n[2];
+			});
+
+		const size_t indexCount = hasIndices ? indices.count : vertexCount;
+		const size_t firstIndex = mesh->indices.size();
+		mesh->indices.resize(firstIndex + indexCount / 3 * 3);
+		unsigned int* dst = mesh->indices.data() + firstIndex;
+		bool valid = true;
+		for (size_t i = 0; i < indexCount / 3 * 3; i++)
+		{
+			size_t index = i;
+			if (hasIndices)
+			{
+				const unsigned char* src = indices.data + i * indices.stride;
+				switch (indices.componentType)
+				{
+				case gltfUnsignedByte: index = src[0]; break;
+				case gltfUnsignedShort: { unsigned short value; memcpy(&value, src, sizeof(value)); index = value; break; }
+				default: index = readU32(src); break;
+				}
+			}
+			valid = valid && index < vertexCount;
+			dst[i] = static_cast<unsigned int>(base + (index < vertexCount ? index : 0));
+		}
+		if (mirrored)
+		{
+			for (size_t i = 0; i + 2 < indexCount; i += 3)
+			{
+				const unsigned int swap = dst[i + 1];
+				dst[i + 1] = dst[i + 2];
+				dst[i + 2] = swap;
+			}
+		}
+		return valid ? MeshLoadResult::ok : MeshLoadResult::invalidData;
+	}
+
+	MeshLoadResult appendMesh(const GlbContext& context, size_t meshIndex, const float matrix[16])
+	{
+		const JsonValue* meshes = context.root->find("meshes");
+		const JsonValue* mesh = meshes ? meshes->at(meshIndex) : nullptr;
+		const JsonValue* primitives = mesh ? mesh->find("primitives") : nullptr;
+		if (!primitives || primitives->type != JsonValue::Type::array) { return MeshLoadResult::invalidData; }
+		for (const JsonValue& primitive : primitives->elements)
+		{
+			MeshLoadResult result = appendPrimitive(context, primitive, matrix);
+			if (result != MeshLoadResult::ok) { return result; }
+		}
+		return MeshLoadResult::ok;
+	}
+
+	/****************************************************************
+		Binary cache
+	****************************************************************/
+	struct MeshCacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t vertexStride;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint64_t vertexCount;
+		uint64_t indexCount;
+		uint64_t lodCount;
+		uint64_t meshletCount;
+	};
+	static_assert(sizeof(MeshCacheHeader) == 64, "MeshCacheHeader layout changed");
+
+	constexpr char meshCacheMagic[8] = { 'M','E','S','H','B','I','N','\0' };
+	constexpr uint32_t meshCacheVersion = 3;
+
+	bool getSourceStamp(const char* path, uint64_t& outSize, int64_t& outTime)
+	{
+#ifdef _WIN32
+		struct _stat64 status {};
+		if (_stat64(path, &status) != 0) { return false; }
+#else
+		struct stat status {};
+		if (stat(path, &status) != 0) { return false; }
+#endif
+		outSize = static_cast<uint64_t>(status.st_size);
+		outTime = static_cast<int64_t>(status.st_mtime);
+		return true;
+	}
+}
+
+MeshLoadResult importObj(const char* text, size_t size, MeshData* outMesh)
+{
+	assert(outMesh && "The mesh is invalid.");
+	using namespace detail;
+	outMesh->vertices.clear();
+	outMesh->indices.clear();
+	const char* end = text + size;
+
+	//行境界でチャンク分割
+	constexpr size_t minChunkSize = 1 << 20;
+	size_t chunkCount = size / minChunkSize;
+	if (chunkCount > getWorkerCount()) { chunkCount = getWorkerCount(); }
+	if (chunkCount < 1) { chunkCount = 1; }
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* chunkBegin = text;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		const char* chunkEnd = end;
+		if (c + 1 < chunkCount)
+		{
+			chunkEnd = findLineEnd(text + size * (c + 1) / chunkCount, end);
+			chunkEnd = chunkEnd < end ? chunkEnd + 1 : end;
+			if (chunkEnd < chunkBegin) { chunkEnd = chunkBegin; }
+		}
+		chunks[c].begin = chunkBegin;
+		chunks[c].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	//要素数を数えてから一括確保する
+	parallelFor(chunkCount, 1, [&](size_t c) { countObjChunk(chunks[c]); });
+	size_t positionCount = 0, normalCount = 0, triangleCount = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		chunk.positionBase = positionCount;
+		chunk.normalBase = normalCount;
+		chunk.triangleBase = triangleCount;
+		positionCount += chunk.positionCount;
+		normalCount += chunk.normalCount;
+		triangleCount += chunk.triangleCount;
+	}
+	if (positionCount > 0x7FFFFFFF || normalCount > 0x7FFFFFFF || triangleCount * 3 > 0xFFFFFFFFull) { return MeshLoadResult::unsupportedFormat; }
+	std::vector<float> positions(positionCount * 3);
+	std::vector<float> normals(normalCount * 3);
+	std::vector<ObjCorner> corners(triangleCount * 3);
+	parallelFor(chunkCount, 1, [&](size_t c) { parseObjChunk(chunks[c], positions.data(), normals.data(), corners.data()); });
+	for (const ObjChunk& chunk : chunks)
+	{
+		if (!chunk.valid) { return MeshLoadResult::invalidData; }
+	}
+
+	//位置と法線の組で頂点を共有する
+	std::vector<unsigned int> head(positionCount, ~0u);
+	std::vector<unsigned int> next;
+	std::vector<unsigned int> vertexPositions;
+	std::vector<int> vertexNormals;
+	next.reserve(positionCount);
+	vertexPositions.reserve(positionCount);
+	vertexNormals.reserve(positionCount);
+	outMesh->indices.resize(corners.size());
+	for (size_t i = 0; i < corners.size(); i++)
+	{
+		const ObjCorner& corner = corners[i];
+		if (static_cast<size_t>(corner.position) >= positionCount ||
+			(corner.normal != noNormal && static_cast<size_t>(corner.normal) >= normalCount)) { return MeshLoadResult::invalidData; }
+		unsigned int vertex = head[corner.position];
+		while (vertex != ~0u && vertexNormals[vertex] != corner.normal) { vertex = next[vertex]; }
+		if (vertex == ~0u)
+		{
+			vertex = static_cast<unsigned int>(vertexPositions.size());
+			vertexPositions.push_back(static_cast<unsigned int>(corner.position));
+			vertexNormals.push_back(corner.normal);
+			next.push_back(head[corner.position]);
+			head[corner.position] = vertex;
+		}
+		outMesh->indices[i] = vertex;
+	}
+
+	const size_t vertexCount = vertexPositions.size();
+	outMesh->vertices.resize(vertexCount);
+	std::vector<unsigned char> missingNormals(vertexCount);
+	bool anyMissing = false;
+	parallelFor(vertexCount, 1 << 14, [&](size_t i)
+		{
+			MeshVertex& v = outMesh->vertices[i];
+			const float* p = &positions[static_cast<size_t>(vertexPositions[i]) * 3];
+			v.position[0] = p[0];
+			v.position[1] = p[1];
+			v.position[2] = -p[2];
+			if (vertexNormals[i] == noNormal)
+			{
+				missingNormals[i] = 1;
+				return;
+			}
+			const float* n = &normals[static_cast<size_t>(vertexNormals[i]) * 3];
+			v.normal[0] = n[0];
+			v.normal[1] = n[1];
+			v.normal[2] = -n[2];
+		});
+	for (unsigned char missing : missingNormals) { anyMissing = anyMissing || missing; }
+	if (anyMissing) { generateNormals(outMesh, missingNormals); }
+	return MeshLoadResult::ok;
+}
+
+MeshLoadResult importGlb(const unsigned char* data, size_t size, MeshData* outMesh)
+{
+	assert(outMesh && "The mesh is invalid.");
+	using namespace detail;
+	outMesh->vertices.clear();
+	outMesh->indices.clear();
+	if (size < 12 || readU32(data) != glbMagic) { return MeshLoadResult::invalidData; }
+	if (readU32(data + 4) != 2) { return MeshLoadResult::unsupportedFormat; }
+	const size_t length = readU32(data + 8);
+	if (length > size) { return MeshLoadResult::invalidData; }
+
+	const char* json = nullptr;
+	size_t jsonSize = 0;
+	const unsigned char* bin = nullptr;
+	size_t binSize = 0;
+	for (size_t offset = 12; offset + 8 <= length;)
+	{
+		const size_t chunkLength = readU32(data + offset);
+		const uint32_t chunkType = readU32(data + offset + 4);
+		offset += 8;
+		if (chunkLength > length - offset) { return MeshLoadResult::invalidData; }
+		if (chunkType == glbChunkJson && !json)
+		{
+			json = reinterpret_cast<const char*>(data + offset);
+			jsonSize = chunkLength;
+		}
+		else if (chunkType == glbChunkBin && !bin)
+		{
+			bin = data + offset;
+			binSize = chunkLength;
+		}
+		offset += (chunkLength + 3) & ~static_cast<size_t>(3);
+	}
+	if (!json) { return MeshLoadResult::invalidData; }
+	JsonValue root;
+	if (!JsonParser(json, jsonSize).parse(root)) { return MeshLoadResult::invalidData; }
+
+	std::vector<unsigned char> missingNormals;
+	const GlbContext context{ &root, bin, binSize, outMesh, &missingNormals };
+	const float identity[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+	const JsonValue* nodes = root.find("nodes");
+	const JsonValue* scenes = root.find("scenes");
+	size_t sceneIndex = 0;
+	root.getIndex("scene", sceneIndex);
+	const JsonValue* scene = scenes ? scenes->at(sceneIndex) : nullptr;
+	MeshLoadResult result = MeshLoadResult::ok;
+	if (scene && nodes)
+	{
+		//シーングラフを辿ってワールド行列を焼き込む
+		struct NodeEntry
+		{
+			size_t node;
+			float matrix[16];
+		};
+		std::vector<NodeEntry> stack;
+		if (const JsonValue* roots = scene->find("nodes"))
+		{
+			for (const JsonValue& node : roots->elements)
+			{
+				NodeEntry entry{ static_cast<size_t>(node.number), {} };
+				memcpy(entry.matrix, identity, sizeof(identity));
+				stack.push_back(entry);
+			}
+		}
+		size_t visits = 0;
+		while (!stack.empty() && result == MeshLoadResult::ok)
+		{
+			NodeEntry entry = stack.back();
+			stack.pop_back();
+			const JsonValue* node = nodes->at(entry.node);
+			if (!node || ++visits > nodes->elements.size()) { return MeshLoadResult::invalidData; }
+			float local[16];
+			getNodeMatrix(*node, local);
+			multiplyMatrix(entry.matrix, entry.matrix, local);
+			size_t meshIndex = 0;
+			if (node->getIndex("mesh", meshIndex)) { result = appendMesh(context, meshIndex, entry.matrix); }
+			if (const JsonValue* children = node->find("children"))
+			{
+				for (const JsonValue& child : children->elements)
+				{
+					NodeEntry childEntry = entry;
+					childEntry.node = static_cast<size_t>(child.number);
+					stack.push_back(childEntry);
+				}
+			}
+		}
+	}
+	else if (const JsonValue* meshes = root.find("meshes"))
+	{
+		for (size_t i = 0; i < meshes->elements.size() && result == MeshLoadResult::ok; i++)
+		{
+			result = appendMesh(context, i, identity);
+		}
+	}
+	if (result != MeshLoadResult::ok) { return result; }
+	bool anyMissing = false;
+	for (unsigned char missing : missingNormals) { anyMissing = anyMissing || missing; }
+	if (anyMissing) { generateNormals(outMesh, missingNormals); }
+	return MeshLoadResult::ok;
+}
+
+MeshLoadResult importMesh(const char* path, MeshData* outMesh)
+{
+	assert(path && outMesh);
+	const char* extension = strrchr(path, '.');
+	if (!extension) { return MeshLoadResult::unsupportedFormat; }
+	std::string lower(extension);
+	for (char& c : lower) { c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+	const bool obj = lower == ".obj";
+	const bool glb = lower == ".glb";
+	if (!obj && !glb) { return MeshLoadResult::unsupportedFormat; }
+
+	MappedFile file;
+	if (!file.open(path)) { return MeshLoadResult::fileNotFound; }
+	return obj ?
+		importObj(reinterpret_cast<const char*>(file.getData()), file.getSize(), outMesh) :
+		importGlb(file.getData(), file.getSize(), outMesh);
+}
+
+bool saveMeshCache(const char* cachePath, const char* sourcePath,
+	const MeshVertex* vertices, size_t vertexCount,
+	const unsigned int* indices, size_t indexCount,
+	const MeshLod* lods, size_t lodCount,
+	const Meshlet* meshlets, size_t meshletCount)
+{
+	detail::MeshCacheHeader header{};
+	memcpy(header.magic, detail::meshCacheMagic, sizeof(header.magic));
+	header.version = detail::meshCacheVersion;
+	header.vertexStride = sizeof(MeshVertex);
+	header.vertexCount = vertexCount;
+	header.indexCount = indexCount;
+	header.lodCount = lodCount;
+	header.meshletCount = meshletCount;
+	if (!detail::getSourceStamp(sourcePath, header.sourceSize, header.sourceTime)) { return false; }
+
+	std::ofstream ofs{ cachePath, std::ios::out | std::ios::binary | std::ios::trunc };
+	if (!ofs) { return false; }
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	ofs.write(reinterpret_cast<const char*>(vertices), static_cast<std::streamsize>(vertexCount * sizeof(MeshVertex)));
+	ofs.write(reinterpret_cast<const char*>(indices), static_cast<std::streamsize>(indexCount * sizeof(unsigned int)));
+	ofs.write(reinterpret_cast<const char*>(lods), static_cast<std::streamsize>(lodCount * sizeof(MeshLod)));
+	ofs.write(reinterpret_cast<const char*>(meshlets), static_cast<std::streamsize>(meshletCount * sizeof(Meshlet)));
+	return static_cast<bool>(ofs);
+}
+
+bool MeshCache::open(const char* cachePath, const char* sourcePath)
+{
+	close();
+	if (!file.open(cachePath)) { return false; }
+	detail::MeshCacheHeader header{};
+	if (file.getSize() < sizeof(header))
+	{
+		close();
+		return false;
+	}
+	memcpy(&header, file.getData(), sizeof(header));
+	bool valid = memcmp(header.magic, detail::meshCacheMagic, sizeof(header.magic)) == 0 &&
+		header.version == detail::meshCacheVersion &&
+		header.vertexStride == sizeof(MeshVertex) &&
+		header.indexCount % 3 == 0 &&
+		header.vertexCount <= (file.getSize() - sizeof(header)) / sizeof(MeshVertex) &&
+		header.indexCount <= (file.getSize() - sizeof(header)) / sizeof(unsigned int) &&
+		header.lodCount <= (file.getSize() - sizeof(header)) / sizeof(MeshLod) &&
+		header.meshletCount <= (file.getSize() - sizeof(header)) / sizeof(Meshlet) &&
+		sizeof(header) + header.vertexCount * sizeof(MeshVertex) + header.indexCount * sizeof(unsigned int) +
+		header.lodCount * sizeof(MeshLod) + header.meshletCount * sizeof(Meshlet) == file.getSize();
+	if (valid && sourcePath)
+	{
+		uint64_t sourceSize = 0;
+		int64_t sourceTime = 0;
+		valid = detail::getSourceStamp(sourcePath, sourceSize, sourceTime) &&
+			sourceSize == header.sourceSize && sourceTime == header.sourceTime;
+	}
+	if (!valid)
+	{
+		close();
+		return false;
+	}
+	vertexCount = static_cast<size_t>(header.vertexCount);
+	indexCount = static_cast<size_t>(header.indexCount);
+	lodCount = static_cast<size_t>(header.lodCount);
+	meshletCount = static_cast<size_t>(header.meshletCount);
+	vertices = reinterpret_cast<const MeshVertex*>(file.getData() + sizeof(header));
+	indices = reinterpret_cast<const unsigned int*>(file.getData() + sizeof(header) + vertexCount * sizeof(MeshVertex));
+	lods = reinterpret_cast<const MeshLod*>(file.getData() + sizeof(header) + vertexCount * sizeof(MeshVertex) + indexCount * sizeof(unsigned int));
+	meshlets = reinterpret_cast<const Meshlet*>(reinterpret_cast<const unsigned char*>(lods) + lodCount * sizeof(MeshLod));
+	for (size_t i = 0; i < lodCount; i++)
+	{
+		if (static_cast<size_t>(lods[i].indexOffset) + lods[i].indexCount > indexCount)
+		{
+			close();
+			return false;
+		}
+	}
+	for (size_t i = 0; i < meshletCount; i++)
+	{
+		if (static_cast<size_t>(meshlets[i].indexOffset) + static_cast<size_t>(meshlets[i].triangleCount) * 3 > indexCount)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void MeshCache::close()
+{
+	file.close();
+	vertices = nullptr;
+	indices = nullptr;
+	lods = nullptr;
+	meshlets = nullptr;
+	vertexCount = 0;
+	indexCount = 0;
+	lodCount = 0;
+	meshletCount = 0;
+}
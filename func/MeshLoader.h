@@ -0,0 +1,82 @@
+﻿#pragma once
+#include <stddef.h>
+#include <vector>
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+
+/****************************************************************
+	Imported vertex. Same layout as Geometry::Vertex.
+	Positions and normals are converted to left-handed coordinates
+	by negating z. Fronts stay CCW as PipelineState expects.
+****************************************************************/
+struct MeshVertex
+{
+	float position[3];
+	float normal[3];
+};
+
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<unsigned int> indices;
+};
+
+enum class MeshLoadResult { ok, fileNotFound, unsupportedFormat, invalidData };
+
+/****************************************************************
+	Wavefront OBJ (v, vn, f; polygons are fan triangulated).
+	The text is split at line boundaries and parsed on every core.
+	Missing normals are generated from the faces.
+****************************************************************/
+MeshLoadResult importObj(const char* text, size_t size, MeshData* outMesh);
+
+/****************************************************************
+	glTF 2.0 binary (.glb) with triangle primitives and an embedded
+	BIN chunk. Node transforms of the default scene are applied.
+****************************************************************/
+MeshLoadResult importGlb(const unsigned char* data, size_t size, MeshData* outMesh);
+
+/****************************************************************
+	Map a file and import it by extension (.obj / .glb).
+****************************************************************/
+MeshLoadResult importMesh(const char* path, MeshData* outMesh);
+
+/****************************************************************
+	Preprocessed binary cache.
+	The header records the size and time stamp of the source file,
+	so a stale cache is rejected by MeshCache::open.
+****************************************************************/
+bool saveMeshCache(const char* cachePath, const char* sourcePath,
+	const MeshVertex* vertices, size_t vertexCount,
+	const unsigned int* indices, size_t indexCount,
+	const MeshLod* lods = nullptr, size_t lodCount = 0,
+	const Meshlet* meshlets = nullptr, size_t meshletCount = 0);
+
+class MeshCache
+{
+private:
+	MappedFile file;
+	const MeshVertex* vertices = nullptr;
+	const unsigned int* indices = nullptr;
+	const MeshLod* lods = nullptr;
+	const Meshlet* meshlets = nullptr;
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	size_t lodCount = 0;
+	size_t meshletCount = 0;
+public:
+	// sourcePath may be null to skip the staleness check.
+	bool open(const char* cachePath, const char* sourcePath);
+	void close();
+
+	bool isOpen()const { return file.isOpen(); }
+	const MeshVertex* getVertices()const { return vertices; }
+	const unsigned int* getIndices()const { return indices; }
+	size_t getVertexCount()const { return vertexCount; }
+	size_t getIndexCount()const { return indexCount; }
+	const MeshLod* getLods()const { return lods; }
+	size_t getLodCount()const { return lodCount; }
+	const Meshlet* getMeshlets()const { return meshlets; }
+	size_t getMeshletCount()const { return meshletCount; }
+};
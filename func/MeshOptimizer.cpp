@@ -0,0 +1,414 @@
+﻿#include "MeshOptimizer.h"
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+namespace detail
+{
+	inline unsigned int hashBytes(const unsigned char* data, size_t size)
+	{
+		// FNV-1a
+		unsigned int h = 2166136261u;
+		for (size_t i = 0; i < size; i++)
+		{
+			h ^= data[i];
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	namespace forsyth
+	{
+		constexpr int cacheSize = 32;
+		constexpr float cacheDecayPower = 1.5f;
+		constexpr float lastTriangleScore = 0.75f;
+		constexpr float valenceBoostScale = 2.0f;
+		constexpr float valenceBoostPower = 0.5f;
+		constexpr unsigned int maxValence = 64;
+
+		struct Tables
+		{
+			float cache[cacheSize];
+			float valence[maxValence];
+			Tables()
+			{
+				for (int i = 0; i < cacheSize; i++)
+				{
+					if (i < 3)
+					{
+						cache[i] = lastTriangleScore;
+					}
+					else
+					{
+						const float scaler = 1.0f / (cacheSize - 3);
+						cache[i] = powf(1.0f - (i - 3) * scaler, cacheDecayPower);
+					}
+				}
+				valence[0] = 0.0f;
+				for (unsigned int i = 1; i < maxValence; i++)
+				{
+					valence[i] = valenceBoostScale * powf(static_cast<float>(i), -valenceBoostPower);
+				}
+			}
+		};
+
+		inline float vertexScore(const Tables& tables, int cachePosition, unsigned int remaining)
+		{
+			if (remaining == 0) { return -1.0f; }
+			float score = cachePosition < 0 ? 0.0f : tables.cache[cachePosition];
+			return score + tables.valence[std::min(remaining, maxValence - 1)];
+		}
+	}
+}
+
+size_t weldVertices(std::vector<unsigned int>& outRemap, const void* vertices, size_t vertexCount, size_t stride)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+	outRemap.assign(vertexCount, ~0u);
+
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2) { tableSize <<= 1; }
+	std::vector<unsigned int> table(tableSize, ~0u);
+	const size_t mask = tableSize - 1;
+
+	unsigned int unique = 0;
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		const unsigned char* vertex = bytes + v * stride;
+		size_t slot = detail::hashBytes(vertex, stride) & mask;
+		// Open addressing with linear probing; table stores the first vertex of each class.
+		while (table[slot] != ~0u && memcmp(bytes + static_cast<size_t>(table[slot]) * stride, vertex, stride) != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+		if (table[slot] == ~0u)
+		{
+			table[slot] = static_cast<unsigned int>(v);
+			outRemap[v] = unique++;
+		}
+		else
+		{
+			outRemap[v] = outRemap[table[slot]];
+		}
+	}
+	return unique;
+}
+
+void remapVertexBuffer(void* dst, const void* src, size_t vertexCount, size_t stride, const std::vector<unsigned int>& remap)
+{
+	assert(dst != src && "remapVertexBuffer can not work in place.");
+	const unsigned char* in = static_cast<const unsigned char*>(src);
+	unsigned char* out = static_cast<unsigned char*>(dst);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == ~0u) { continue; }
+		memcpy(out + static_cast<size_t>(remap[v]) * stride, in + v * stride, stride);
+	}
+}
+
+void remapIndexBuffer(unsigned int* indices, size_t indexCount, const std::vector<unsigned int>& remap)
+{
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		indices[i] = remap[indices[i]];
+	}
+}
+
+void optimizeVertexCache(unsigned int* dst, const unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+	using namespace detail::forsyth;
+	static const Tables tables{};
+	assert(indexCount % 3 == 0);
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) { return; }
+
+	// Vertex to triangle adjacency.
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; i++) { remaining[indices[i]]++; }
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) { offsets[v + 1] = offsets[v] + remaining[v]; }
+	std::vector<unsigned int> adjacency(indexCount);
+	{
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+			}
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = vertexScore(tables, -1, remaining[v]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+	}
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> result(indexCount);
+
+	unsigned int cache[cacheSize + 3];
+	int cacheCount = 0;
+	size_t cursor = 0;
+	size_t bestTriangle = 0;
+	for (size_t t = 1; t < triangleCount; t++)
+	{
+		if (triangleScores[t] > triangleScores[bestTriangle]) { bestTriangle = t; }
+	}
+
+	for (size_t out = 0; out < triangleCount; out++)
+	{
+		if (bestTriangle == ~size_t(0))
+		{
+			// Nothing adjacent to the cache; continue from the first unemitted triangle.
+			while (emitted[cursor]) { cursor++; }
+			bestTriangle = cursor;
+		}
+		const unsigned int* triangle = indices + bestTriangle * 3;
+		emitted[bestTriangle] = true;
+		result[out * 3 + 0] = triangle[0];
+		result[out * 3 + 1] = triangle[1];
+		result[out * 3 + 2] = triangle[2];
+
+		// Push the triangle's vertices to the front of the LRU cache.
+		unsigned int next[cacheSize + 3];
+		int nextCount = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			next[nextCount++] = triangle[k];
+			unsigned int v = triangle[k];
+			unsigned int* adj = adjacency.data() + offsets[v];
+			for (unsigned int a = 0; a < remaining[v]; a++)
+			{
+				if (adj[a] == bestTriangle)
+				{
+					std::swap(adj[a], adj[remaining[v] - 1]);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+		for (int c = 0; c < cacheCount; c++)
+		{
+			unsigned int v = cache[c];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2]) { next[nextCount++] = v; }
+		}
+		for (int c = cacheSize; c < nextCount; c++) { cachePosition[next[c]] = -1; }
+		cacheCount = std::min(nextCount, cacheSize);
+		for (int c = 0; c < cacheCount; c++)
+		{
+			cache[c] = next[c];
+			cachePosition[next[c]] = c;
+		}
+
+		// Rescore the triangles touching the cache.
+		bestTriangle = ~size_t(0);
+		float bestScore = -1.0f;
+		for (int c = 0; c < nextCount; c++)
+		{
+			unsigned int v = next[c];
+			float newScore = vertexScore(tables, cachePosition[v], remaining[v]);
+			float delta = newScore - vertexScores[v];
+			vertexScores[v] = newScore;
+			const unsigned int* adj = adjacency.data() + offsets[v];
+			for (unsigned int a = 0; a < remaining[v]; a++)
+			{
+				unsigned int t = adj[a];
+				triangleScores[t] += delta;
+				if (c < cacheSize && triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+	std::copy(result.begin(), result.end(), dst);
+}
+
+void optimizeOverdraw(unsigned int* dst, const unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, float threshold)
+{
+	assert(indexCount % 3 == 0);
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) { return; }
+	const unsigned char* base = reinterpret_cast<const unsigned char*>(positions);
+	auto position = [&](unsigned int v) { return reinterpret_cast<const float*>(base + static_cast<size_t>(v) * positionStride); };
+
+	// Clusters start where the FIFO cache misses every vertex of a triangle,
+	// so moving whole clusters around costs (almost) no extra transforms.
+	const unsigned int cacheSize = 16;
+	std::vector<unsigned int> timestamps(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	std::vector<size_t> clusters{};
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = indices[t * 3 + k];
+			if (time - timestamps[v] > cacheSize)
+			{
+				timestamps[v] = time++;
+				misses++;
+			}
+		}
+		if (t == 0 || misses == 3) { clusters.push_back(t); }
+	}
+	const size_t clusterCount = clusters.size();
+	clusters.push_back(triangleCount);
+
+	float meshCenter[3] = {};
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		const float* p = position(indices[i]);
+		meshCenter[0] += p[0]; meshCenter[1] += p[1]; meshCenter[2] += p[2];
+	}
+	for (float& c : meshCenter) { c /= static_cast<float>(indexCount); }
+
+	// Outward facing clusters far from the center tend to occlude the rest.
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float center[3] = {};
+		float normal[3] = {};
+		float area = 0.0f;
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const float* p0 = position(indices[t * 3 + 0]);
+			const float* p1 = position(indices[t * 3 + 1]);
+			const float* p2 = position(indices[t * 3 + 2]);
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const float a = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int k = 0; k < 3; k++)
+			{
+				center[k] += (p0[k] + p1[k] + p2[k]) * (a / 3.0f);
+				normal[k] += n[k];
+			}
+			area += a;
+		}
+		const float inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+		const float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		const float inverseNormal = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+		float key = 0.0f;
+		for (int k = 0; k < 3; k++)
+		{
+			key += (center[k] * inverseArea - meshCenter[k]) * normal[k] * inverseNormal;
+		}
+		sortKeys[c] = key;
+	}
+	std::vector<size_t> clusterOrder(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++) { clusterOrder[c] = c; }
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> result{};
+	result.reserve(indexCount);
+	for (size_t c : clusterOrder)
+	{
+		result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+	}
+
+	const float before = analyzeMesh(indices, indexCount, vertexCount, 0).acmr;
+	const float after = analyzeMesh(result.data(), indexCount, vertexCount, 0).acmr;
+	if (after > before * threshold)
+	{
+		if (dst != indices) { std::copy(indices, indices + indexCount, dst); }
+		return;
+	}
+	std::copy(result.begin(), result.end(), dst);
+}
+
+size_t optimizeVertexFetchRemap(std::vector<unsigned int>& outRemap, const unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+	outRemap.assign(vertexCount, ~0u);
+	unsigned int next = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int& r = outRemap[indices[i]];
+		if (r == ~0u) { r = next++; }
+	}
+	return next;
+}
+
+MeshStatistics analyzeMesh(const unsigned int* indices, size_t indexCount, size_t vertexCount, size_t vertexStride, unsigned int cacheSize)
+{
+	MeshStatistics stats{};
+	stats.vertexCount = vertexCount;
+	stats.indexCount = indexCount;
+	stats.vertexBytes = vertexCount * vertexStride;
+	stats.indexBytes = indexCount * (fitsIn16BitIndices(vertexCount) ? 2 : 4);
+	if (indexCount == 0 || vertexCount == 0) { return stats; }
+
+	std::vector<unsigned int> timestamps(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	size_t misses = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		if (time - timestamps[v] > cacheSize)
+		{
+			timestamps[v] = time++;
+			misses++;
+		}
+	}
+	stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+	stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+	return stats;
+}
+
+void convertTo16BitIndices(unsigned short* dst, const unsigned int* src, size_t indexCount)
+{
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		assert(src[i] <= 0xFFFF);
+		dst[i] = static_cast<unsigned short>(src[i]);
+	}
+}
+
+MeshOptimizeReport optimizeMesh(std::vector<unsigned char>& vertices, size_t stride, std::vector<unsigned int>& indices)
+{
+	MeshOptimizeReport report{};
+	size_t vertexCount = vertices.size() / stride;
+	// Sizes are reported as 32-bit indices before, as chosen after.
+	report.before = analyzeMesh(indices.data(), indices.size(), vertexCount, stride);
+	report.before.indexBytes = indices.size() * sizeof(unsigned int);
+	if (indices.empty() || vertexCount == 0) { report.after = report.before; return report; }
+
+	std::vector<unsigned int> remap{};
+	std::vector<unsigned char> scratch{};
+
+	//重複頂点の結合
+	size_t unique = weldVertices(remap, vertices.data(), vertexCount, stride);
+	if (unique != vertexCount)
+	{
+		scratch.resize(unique * stride);
+		remapVertexBuffer(scratch.data(), vertices.data(), vertexCount, stride, remap);
+		remapIndexBuffer(indices.data(), indices.size(), remap);
+		vertices.swap(scratch);
+		vertexCount = unique;
+	}
+
+	//キャッシュ最適化とオーバードロー最適化
+	optimizeVertexCache(indices.data(), indices.data(), indices.size(), vertexCount);
+	optimizeOverdraw(indices.data(), indices.data(), indices.size(),
+		reinterpret_cast<const float*>(vertices.data()), vertexCount, stride);
+
+	//フェッチ順への並べ替え
+	size_t used = optimizeVertexFetchRemap(remap, indices.data(), indices.size(), vertexCount);
+	scratch.assign(used * stride, 0);
+	remapVertexBuffer(scratch.data(), vertices.data(), vertexCount, stride, remap);
+	remapIndexBuffer(indices.data(), indices.size(), remap);
+	vertices.swap(scratch);
+
+	report.after = analyzeMesh(indices.data(), indices.size(), used, stride);
+	report.use16BitIndices = fitsIn16BitIndices(used);
+	return report;
+}
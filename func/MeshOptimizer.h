@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+/****************************************************************
+	Post-transform vertex cache statistics of an index buffer.
+	acmr = transformed vertices per triangle (0.5 is ideal),
+	atvr = transformed vertices per unique vertex (1.0 is ideal).
+****************************************************************/
+struct MeshStatistics
+{
+	float acmr = 0.0f;
+	float atvr = 0.0f;
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	size_t vertexBytes = 0;
+	size_t indexBytes = 0;
+};
+
+struct MeshOptimizeReport
+{
+	MeshStatistics before;
+	MeshStatistics after;
+	bool use16BitIndices = false;
+
+	long long getBytesSaved()const
+	{
+		return static_cast<long long>(before.vertexBytes + before.indexBytes) -
+			static_cast<long long>(after.vertexBytes + after.indexBytes);
+	}
+};
+
+/****************************************************************
+	Build a remap table that merges bit-identical vertices.
+	Returns the number of unique vertices.
+****************************************************************/
+size_t weldVertices(std::vector<unsigned int>& outRemap, const void* vertices, size_t vertexCount, size_t stride);
+
+/****************************************************************
+	Apply a remap table to vertex and index data.
+	dst must hold the remapped vertex count; src and dst may not overlap.
+****************************************************************/
+void remapVertexBuffer(void* dst, const void* src, size_t vertexCount, size_t stride, const std::vector<unsigned int>& remap);
+void remapIndexBuffer(unsigned int* indices, size_t indexCount, const std::vector<unsigned int>& remap);
+
+/****************************************************************
+	Reorder triangles for post-transform cache hits (Forsyth).
+	dst may be the same pointer as indices.
+****************************************************************/
+void optimizeVertexCache(unsigned int* dst, const unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+/****************************************************************
+	Reorder cache-optimized triangle clusters so outward facing
+	clusters come first (Tipsify-style, view independent).
+	The result is rejected when ACMR grows beyond threshold.
+	positions point at the first float3 of each vertex.
+****************************************************************/
+void optimizeOverdraw(unsigned int* dst, const unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f);
+
+/****************************************************************
+	Build a remap table that orders vertices by first use.
+	Unreferenced vertices are dropped. Returns the new vertex count.
+****************************************************************/
+size_t optimizeVertexFetchRemap(std::vector<unsigned int>& outRemap, const unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+/****************************************************************
+	Simulate a FIFO post-transform cache.
+****************************************************************/
+MeshStatistics analyzeMesh(const unsigned int* indices, size_t indexCount, size_t vertexCount, size_t vertexStride, unsigned int cacheSize = 16);
+
+/****************************************************************
+	16-bit indices are usable while every index fits below the
+	strip cut value.
+****************************************************************/
+inline bool fitsIn16BitIndices(size_t vertexCount)
+{
+	return vertexCount <= 0xFFFF;
+}
+void convertTo16BitIndices(unsigned short* dst, const unsigned int* src, size_t indexCount);
+
+/****************************************************************
+	Weld, cache-optimize, overdraw-optimize and fetch-optimize
+	vertex and index data in place.
+****************************************************************/
+MeshOptimizeReport optimizeMesh(std::vector<unsigned char>& vertices, size_t stride, std::vector<unsigned int>& indices);
+
+template<class V>
+MeshOptimizeReport optimizeMesh(std::vector<V>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned char> bytes(vertices.size() * sizeof(V));
+	if (!bytes.empty()) { memcpy(bytes.data(), vertices.data(), bytes.size()); }
+	MeshOptimizeReport report = optimizeMesh(bytes, sizeof(V), indices);
+	vertices.resize(bytes.size() / sizeof(V));
+	if (!bytes.empty()) { memcpy(vertices.data(), bytes.data(), bytes.size()); }
+	return report;
+}
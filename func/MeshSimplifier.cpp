@@ -0,0 +1,352 @@
+﻿#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+namespace detail
+{
+	inline const float* positionAt(const float* positions, size_t index, size_t stride)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + index * stride);
+	}
+
+	inline float getMaxExtent(const float* positions, size_t vertexCount, size_t stride)
+	{
+		if (vertexCount == 0) { return 0.0f; }
+		float mn[3], mx[3];
+		memcpy(mn, positions, sizeof(mn));
+		memcpy(mx, positions, sizeof(mx));
+		for (size_t i = 1; i < vertexCount; i++)
+		{
+			const float* p = positionAt(positions, i, stride);
+			for (int k = 0; k < 3; k++)
+			{
+				mn[k] = p[k] < mn[k] ? p[k] : mn[k];
+				mx[k] = p[k] > mx[k] ? p[k] : mx[k];
+			}
+		}
+		return std::max(mx[0] - mn[0], std::max(mx[1] - mn[1], mx[2] - mn[2]));
+	}
+
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+
+		void addPlane(const double n[3], double d)
+		{
+			a00 += n[0] * n[0]; a01 += n[0] * n[1]; a02 += n[0] * n[2];
+			a11 += n[1] * n[1]; a12 += n[1] * n[2]; a22 += n[2] * n[2];
+			b0 += n[0] * d; b1 += n[1] * d; b2 += n[2] * d;
+			c += d * d;
+		}
+
+		void add(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02;
+			a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+		}
+
+		// Sum of squared distances to the accumulated planes.
+		double evaluate(const float* p)const
+		{
+			const double x = p[0], y = p[1], z = p[2];
+			const double error =
+				a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z +
+				a11 * y * y + 2 * a12 * y * z + a22 * z * z +
+				2 * (b0 * x + b1 * y + b2 * z) + c;
+			return error > 0.0 ? error : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		unsigned int from;
+		unsigned int to;
+
+		bool operator<(const Collapse& other)const
+		{
+			if (cost != other.cost) { return cost < other.cost; }
+			if (from != other.from) { return from < other.from; }
+			return to < other.to;
+		}
+	};
+
+	inline void triangleNormal(double out[3], const float* a, const float* b, const float* c)
+	{
+		const double e1[3] = { double(b[0]) - a[0],double(b[1]) - a[1],double(b[2]) - a[2] };
+		const double e2[3] = { double(c[0]) - a[0],double(c[1]) - a[1],double(c[2]) - a[2] };
+		out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	inline uint64_t edgeKey(unsigned int a, unsigned int b)
+	{
+		return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+	}
+
+	struct Adjacency
+	{
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+
+		void build(const std::vector<unsigned int>& indices, size_t vertexCount)
+		{
+			offsets.assign(vertexCount + 1, 0);
+			for (unsigned int v : indices) { offsets[v + 1]++; }
+			for (size_t i = 0; i < vertexCount; i++) { offsets[i + 1] += offsets[i]; }
+			triangles.resize(indices.size());
+			std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				triangles[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+			}
+		}
+	};
+
+	// Rejects collapses that flip or degenerate a surviving triangle around from.
+	bool keepsOrientation(unsigned int from, unsigned int to, const std::vector<unsigned int>& indices,
+		const Adjacency& adjacency, const std::vector<float>& positions)
+	{
+		for (unsigned int i = adjacency.offsets[from]; i < adjacency.offsets[from + 1]; i++)
+		{
+			const unsigned int* triangle = &indices[static_cast<size_t>(adjacency.triangles[i]) * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to) { continue; }
+			const float* p[3];
+			const float* q[3];
+			for (int k = 0; k < 3; k++)
+			{
+				p[k] = &positions[static_cast<size_t>(triangle[k]) * 3];
+				q[k] = &positions[static_cast<size_t>(triangle[k] == from ? to : triangle[k]) * 3];
+			}
+			double before[3], after[3];
+			triangleNormal(before, p[0], p[1], p[2]);
+			triangleNormal(after, q[0], q[1], q[2]);
+			const double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+			const double lengthAfter = after[0] * after[0] + after[1] * after[1] + after[2] * after[2];
+			if (dot <= 0.0 || lengthAfter <= 0.0) { return false; }
+		}
+		return true;
+	}
+}
+
+size_t simplifyMesh(unsigned int* dst, const unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t stride,
+	size_t targetIndexCount, float targetError, float* outError)
+{
+	assert(indexCount % 3 == 0 && "The index count must be a multiple of 3.");
+	using namespace detail;
+	std::vector<unsigned int> triangles(indices, indices + indexCount);
+	double maxCost = 0.0;
+
+	//範囲を[0,1]に正規化して誤差を相対値で扱う
+	const float extent = getMaxExtent(positions, vertexCount, stride);
+	const float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+	std::vector<float> local(vertexCount * 3);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const float* p = positionAt(positions, i, stride);
+		local[i * 3 + 0] = p[0] * scale;
+		local[i * 3 + 1] = p[1] * scale;
+		local[i * 3 + 2] = p[2] * scale;
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t t = 0; t < indexCount; t += 3)
+	{
+		const float* a = &local[static_cast<size_t>(triangles[t]) * 3];
+		double n[3];
+		triangleNormal(n, a, &local[static_cast<size_t>(triangles[t + 1]) * 3], &local[static_cast<size_t>(triangles[t + 2]) * 3]);
+		const double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length <= 0.0) { continue; }
+		n[0] /= length;
+		n[1] /= length;
+		n[2] /= length;
+		const double d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+		for (int k = 0; k < 3; k++) { quadrics[triangles[t + k]].addPlane(n, d); }
+	}
+
+	//境界辺と非多様体辺の頂点は固定する(属性の継ぎ目も境界として現れる)
+	std::vector<unsigned char> locked(vertexCount, 0);
+	std::vector<uint64_t> edges;
+	edges.reserve(indexCount);
+	for (size_t t = 0; t < indexCount; t += 3)
+	{
+		for (int k = 0; k < 3; k++) { edges.push_back(edgeKey(triangles[t + k], triangles[t + (k + 1) % 3])); }
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size();)
+	{
+		size_t j = i + 1;
+		while (j < edges.size() && edges[j] == edges[i]) { j++; }
+		if (j - i != 2)
+		{
+			locked[edges[i] >> 32] = 1;
+			locked[edges[i] & 0xFFFFFFFFu] = 1;
+		}
+		i = j;
+	}
+
+	const double errorLimit = static_cast<double>(targetError) * targetError;
+	std::vector<Collapse> collapses;
+	std::vector<unsigned int> remap(vertexCount);
+	std::vector<unsigned char> touched(vertexCount);
+	Adjacency adjacency;
+	while (triangles.size() > targetIndexCount)
+	{
+		edges.clear();
+		for (size_t t = 0; t < triangles.size(); t += 3)
+		{
+			for (int k = 0; k < 3; k++) { edges.push_back(edgeKey(triangles[t + k], triangles[t + (k + 1) % 3])); }
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		collapses.clear();
+		for (uint64_t key : edges)
+		{
+			const unsigned int a = static_cast<unsigned int>(key >> 32);
+			const unsigned int b = static_cast<unsigned int>(key & 0xFFFFFFFFu);
+			if (locked[a] && locked[b]) { continue; }
+			Quadric q = quadrics[a];
+			q.add(quadrics[b]);
+			const double costAB = locked[a] ? HUGE_VAL : q.evaluate(&local[static_cast<size_t>(b) * 3]);
+			const double costBA = locked[b] ? HUGE_VAL : q.evaluate(&local[static_cast<size_t>(a) * 3]);
+			if (costAB <= costBA) { collapses.push_back(Collapse{ costAB,a,b }); }
+			else { collapses.push_back(Collapse{ costBA,b,a }); }
+		}
+		if (collapses.empty()) { break; }
+		std::sort(collapses.begin(), collapses.end());
+
+		//互いに独立な辺だけを安い順に潰す
+		adjacency.build(triangles, vertexCount);
+		std::fill(touched.begin(), touched.end(), 0);
+		for (size_t i = 0; i < vertexCount; i++) { remap[i] = static_cast<unsigned int>(i); }
+		const size_t removable = (triangles.size() - targetIndexCount) / 3;
+		size_t removed = 0;
+		size_t applied = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.cost > errorLimit) { break; }
+			if (touched[collapse.from] || touched[collapse.to]) { continue; }
+			if (!keepsOrientation(collapse.from, collapse.to, triangles, adjacency, local)) { continue; }
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			for (unsigned int i = adjacency.offsets[collapse.from]; i < adjacency.offsets[collapse.from + 1]; i++)
+			{
+				const unsigned int* triangle = &triangles[static_cast<size_t>(adjacency.triangles[i]) * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+				removed += (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to);
+			}
+			maxCost = std::max(maxCost, collapse.cost);
+			applied++;
+			if (removed >= removable) { break; }
+		}
+		if (applied == 0) { break; }
+
+		size_t write = 0;
+		for (size_t t = 0; t < triangles.size(); t += 3)
+		{
+			const unsigned int a = remap[triangles[t]];
+			const unsigned int b = remap[triangles[t + 1]];
+			const unsigned int c = remap[triangles[t + 2]];
+			if (a == b || b == c || c == a) { continue; }
+			triangles[write++] = a;
+			triangles[write++] = b;
+			triangles[write++] = c;
+		}
+		triangles.resize(write);
+	}
+
+	if (!triangles.empty()) { memcpy(dst, triangles.data(), triangles.size() * sizeof(unsigned int)); }
+	if (outError) { (*outError) = static_cast<float>(sqrt(maxCost)); }
+	return triangles.size();
+}
+
+void buildLodChain(std::vector<unsigned int>& indices, std::vector<MeshLod>& outLods,
+	const float* positions, size_t vertexCount, size_t stride, const LodChainDesc& desc)
+{
+	outLods.clear();
+	MeshLod base{};
+	base.indexCount = static_cast<unsigned int>(indices.size());
+	outLods.push_back(base);
+	if (vertexCount == 0 || indices.empty()) { return; }
+
+	const float extent = detail::getMaxExtent(positions, vertexCount, stride);
+	std::vector<unsigned int> level(indices);
+	std::vector<unsigned int> next(indices.size());
+	float accumulatedError = 0.0f;
+	while (outLods.size() < desc.maxLevels && accumulatedError < desc.maxError)
+	{
+		const size_t targetIndexCount = static_cast<size_t>(level.size() / 3 * desc.reduction) * 3;
+		if (targetIndexCount < desc.minIndexCount) { break; }
+		float error = 0.0f;
+		const size_t count = simplifyMesh(next.data(), level.data(), level.size(), positions, vertexCount, stride,
+			targetIndexCount, desc.maxError - accumulatedError, &error);
+		//削減が1割未満なら打ち切る
+		if (count == 0 || count * 10 > level.size() * 9) { break; }
+		//前段からの誤差を足して元メッシュに対する上限とする
+		accumulatedError += error;
+		optimizeVertexCache(next.data(), next.data(), count, vertexCount);
+		MeshLod lod{};
+		lod.indexOffset = static_cast<unsigned int>(indices.size());
+		lod.indexCount = static_cast<unsigned int>(count);
+		lod.error = accumulatedError * extent;
+		outLods.push_back(lod);
+		indices.insert(indices.end(), next.begin(), next.begin() + count);
+		level.assign(next.begin(), next.begin() + count);
+	}
+}
+
+unsigned int selectLod(const MeshLod* lods, size_t lodCount, float errorToPixels,
+	unsigned int currentLod, float pixelThreshold, float hysteresis)
+{
+	if (lodCount == 0) { return 0; }
+	if (currentLod >= lodCount) { currentLod = static_cast<unsigned int>(lodCount - 1); }
+	unsigned int coarsest = 0;
+	unsigned int coarsestWithMargin = 0;
+	const float marginThreshold = pixelThreshold * (1.0f - hysteresis);
+	for (unsigned int i = 1; i < lodCount; i++)
+	{
+		const float pixels = lods[i].error * errorToPixels;
+		if (pixels <= pixelThreshold) { coarsest = i; }
+		if (pixels <= marginThreshold) { coarsestWithMargin = i; }
+	}
+	if (coarsest < currentLod) { return coarsest; }
+	return std::max(currentLod, coarsestWithMargin);
+}
+
+void computeBoundingSphere(float outSphere[4], const float* positions, size_t vertexCount, size_t stride)
+{
+	memset(outSphere, 0, sizeof(float) * 4);
+	if (vertexCount == 0) { return; }
+	float mn[3], mx[3];
+	memcpy(mn, positions, sizeof(mn));
+	memcpy(mx, positions, sizeof(mx));
+	for (size_t i = 1; i < vertexCount; i++)
+	{
+		const float* p = detail::positionAt(positions, i, stride);
+		for (int k = 0; k < 3; k++)
+		{
+			mn[k] = p[k] < mn[k] ? p[k] : mn[k];
+			mx[k] = p[k] > mx[k] ? p[k] : mx[k];
+		}
+	}
+	float radius = 0.0f;
+	for (int k = 0; k < 3; k++) { outSphere[k] = (mn[k] + mx[k]) * 0.5f; }
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const float* p = detail::positionAt(positions, i, stride);
+		const float dx = p[0] - outSphere[0], dy = p[1] - outSphere[1], dz = p[2] - outSphere[2];
+		radius = std::max(radius, dx * dx + dy * dy + dz * dz);
+	}
+	outSphere[3] = sqrtf(radius);
+}
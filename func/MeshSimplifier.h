@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <stddef.h>
+#include <vector>
+
+/****************************************************************
+	One level of an LOD chain. All levels share the vertex buffer
+	and live back to back in one index buffer.
+	error = object-space deviation bound from the full mesh.
+****************************************************************/
+struct MeshLod
+{
+	unsigned int indexOffset = 0;
+	unsigned int indexCount = 0;
+	float error = 0.0f;
+	unsigned int reserved = 0;
+};
+static_assert(sizeof(MeshLod) == 16, "MeshLod is stored in mesh caches");
+
+struct LodChainDesc
+{
+	float reduction = 0.5f;			// triangle ratio between neighbouring levels
+	float maxError = 0.05f;			// relative to the mesh extent
+	size_t minIndexCount = 64 * 3;
+	size_t maxLevels = 8;
+};
+
+/****************************************************************
+	Quadric error edge collapse (Garland & Heckbert).
+	Vertices collapse onto existing vertices, so the result indexes
+	the same vertex buffer. Border and seam vertices stay locked.
+	Deterministic: ties are broken by vertex index.
+	targetError and outError are relative to the mesh extent.
+	Returns the index count written to dst.
+****************************************************************/
+size_t simplifyMesh(unsigned int* dst, const unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t stride,
+	size_t targetIndexCount, float targetError, float* outError = nullptr);
+
+/****************************************************************
+	Append coarser levels to indices (which holds level 0) until the
+	reduction stalls or an error / size limit is reached.
+	Every level is vertex cache optimized.
+****************************************************************/
+void buildLodChain(std::vector<unsigned int>& indices, std::vector<MeshLod>& outLods,
+	const float* positions, size_t vertexCount, size_t stride, const LodChainDesc& desc = LodChainDesc());
+
+/****************************************************************
+	Pick the coarsest level whose projected error stays below
+	pixelThreshold. errorToPixels converts object-space error to
+	pixels. Coarser levels are only taken once they are below
+	pixelThreshold * (1 - hysteresis), so levels do not flicker.
+****************************************************************/
+unsigned int selectLod(const MeshLod* lods, size_t lodCount, float errorToPixels,
+	unsigned int currentLod, float pixelThreshold = 1.0f, float hysteresis = 0.25f);
+
+/****************************************************************
+	Bounding sphere (center xyz, radius w) around the AABB center.
+****************************************************************/
+void computeBoundingSphere(float outSphere[4], const float* positions, size_t vertexCount, size_t stride);
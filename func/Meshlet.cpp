@@ -0,0 +1,355 @@
+﻿#include "Meshlet.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHLET_SSE2
+#endif
+
+namespace detail
+{
+	inline const float* meshletPosition(const float* positions, size_t index, size_t stride)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + index * stride);
+	}
+
+	// Outward unit normal for CCW front faces (left-handed).
+	inline void outwardNormal(float out[3], const float* a, const float* b, const float* c)
+	{
+		const float e1[3] = { b[0] - a[0],b[1] - a[1],b[2] - a[2] };
+		const float e2[3] = { c[0] - a[0],c[1] - a[1],c[2] - a[2] };
+		out[0] = e2[1] * e1[2] - e2[2] * e1[1];
+		out[1] = e2[2] * e1[0] - e2[0] * e1[2];
+		out[2] = e2[0] * e1[1] - e2[1] * e1[0];
+		const float length = sqrtf(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+		const float inverse = length > 0.0f ? 1.0f / length : 0.0f;
+		out[0] *= inverse;
+		out[1] *= inverse;
+		out[2] *= inverse;
+	}
+
+	void computeMeshletBounds(Meshlet& meshlet, const unsigned int* indices, const float* positions, size_t stride)
+	{
+		const size_t indexCount = static_cast<size_t>(meshlet.triangleCount) * 3;
+		float mn[3] = { HUGE_VALF,HUGE_VALF,HUGE_VALF };
+		float mx[3] = { -HUGE_VALF,-HUGE_VALF,-HUGE_VALF };
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			const float* p = meshletPosition(positions, indices[i], stride);
+			for (int k = 0; k < 3; k++)
+			{
+				mn[k] = std::min(mn[k], p[k]);
+				mx[k] = std::max(mx[k], p[k]);
+			}
+		}
+		float radius = 0.0f;
+		for (int k = 0; k < 3; k++) { meshlet.center[k] = (mn[k] + mx[k]) * 0.5f; }
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			const float* p = meshletPosition(positions, indices[i], stride);
+			const float dx = p[0] - meshlet.center[0], dy = p[1] - meshlet.center[1], dz = p[2] - meshlet.center[2];
+			radius = std::max(radius, dx * dx + dy * dy + dz * dz);
+		}
+		meshlet.radius = sqrtf(radius);
+
+		//法線コーン: 平均法線からの最大の開き
+		float axis[3] = { 0.0f,0.0f,0.0f };
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			float n[3];
+			outwardNormal(n, meshletPosition(positions, indices[i], stride), meshletPosition(positions, indices[i + 1], stride), meshletPosition(positions, indices[i + 2], stride));
+			axis[0] += n[0];
+			axis[1] += n[1];
+			axis[2] += n[2];
+		}
+		const float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		meshlet.coneCutoff = 1.0f;
+		memset(meshlet.coneAxis, 0, sizeof(meshlet.coneAxis));
+		if (length <= 0.0f) { return; }
+		for (int k = 0; k < 3; k++) { axis[k] /= length; }
+		float minDot = 1.0f;
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			float n[3];
+			outwardNormal(n, meshletPosition(positions, indices[i], stride), meshletPosition(positions, indices[i + 1], stride), meshletPosition(positions, indices[i + 2], stride));
+			if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f) { continue; }
+			minDot = std::min(minDot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+		}
+		memcpy(meshlet.coneAxis, axis, sizeof(axis));
+		// Cones wider than ~84 degrees never cull anything useful.
+		if (minDot <= 0.1f) { return; }
+		meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+
+	inline bool isMeshletVisible(const MeshletCullData& data, size_t i, const MeshletCullParams& params)
+	{
+		const float radius = data.radius[i] * params.radiusScale + params.radiusBias;
+		for (int p = 0; p < 6; p++)
+		{
+			const float* plane = params.planes[p];
+			if (plane[0] * data.centerX[i] + plane[1] * data.centerY[i] + plane[2] * data.centerZ[i] + plane[3] < -radius) { return false; }
+		}
+		if (params.coneCulling)
+		{
+			const float dx = data.centerX[i] - params.cameraPosition[0];
+			const float dy = data.centerY[i] - params.cameraPosition[1];
+			const float dz = data.centerZ[i] - params.cameraPosition[2];
+			const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+			if (dx * data.axisX[i] + dy * data.axisY[i] + dz * data.axisZ[i] >= data.cutoff[i] * distance + radius) { return false; }
+		}
+		return true;
+	}
+
+	inline void emitMeshlet(std::vector<MeshletDrawRange>& ranges, const MeshletCullData& data, size_t i)
+	{
+		if (!ranges.empty() && ranges.back().indexOffset + ranges.back().indexCount == data.indexOffset[i])
+		{
+			ranges.back().indexCount += data.indexCount[i];
+			return;
+		}
+		ranges.push_back(MeshletDrawRange{ data.indexOffset[i], data.indexCount[i] });
+	}
+}
+
+void buildMeshlets(std::vector<Meshlet>& outMeshlets, unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t stride,
+	unsigned int baseIndexOffset, size_t maxVertices, size_t maxTriangles, float coneWeight)
+{
+	assert(indexCount % 3 == 0 && "The index count must be a multiple of 3.");
+	assert(maxVertices >= 3 && maxTriangles >= 1);
+	using namespace detail;
+	outMeshlets.clear();
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) { return; }
+
+	std::vector<float> normals(triangleCount * 3);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		outwardNormal(&normals[t * 3], meshletPosition(positions, indices[t * 3], stride),
+			meshletPosition(positions, indices[t * 3 + 1], stride), meshletPosition(positions, indices[t * 3 + 2], stride));
+	}
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < indexCount; i++) { offsets[indices[i] + 1]++; }
+	for (size_t v = 0; v < vertexCount; v++) { offsets[v + 1] += offsets[v]; }
+	std::vector<unsigned int> adjacent(indexCount);
+	{
+		std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i++) { adjacent[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3); }
+	}
+
+	std::vector<unsigned char> emitted(triangleCount, 0);
+	std::vector<unsigned int> vertexStamp(vertexCount, 0);
+	std::vector<unsigned int> candidateStamp(triangleCount, 0);
+	std::vector<unsigned int> order;
+	std::vector<unsigned int> candidates;
+	order.reserve(triangleCount);
+	size_t cursor = 0;
+	unsigned int stamp = 0;
+	unsigned int seedHint = ~0u;
+	while (order.size() < triangleCount)
+	{
+		stamp++;
+		Meshlet meshlet{};
+		meshlet.indexOffset = baseIndexOffset + static_cast<unsigned int>(order.size() * 3);
+		float axis[3] = { 0.0f,0.0f,0.0f };
+		candidates.clear();
+		auto addTriangle = [&](unsigned int t)
+		{
+			emitted[t] = 1;
+			order.push_back(t);
+			meshlet.triangleCount++;
+			for (int k = 0; k < 3; k++)
+			{
+				const unsigned int v = indices[t * 3 + k];
+				axis[k] += normals[t * 3 + k];
+				if (vertexStamp[v] == stamp) { continue; }
+				vertexStamp[v] = stamp;
+				meshlet.vertexCount++;
+				for (unsigned int i = offsets[v]; i < offsets[v + 1]; i++)
+				{
+					const unsigned int u = adjacent[i];
+					if (emitted[u] || candidateStamp[u] == stamp) { continue; }
+					candidateStamp[u] = stamp;
+					candidates.push_back(u);
+				}
+			}
+		};
+
+		//前のメッシュレットに隣接する三角形から始めて空間的にまとめる
+		if (seedHint == ~0u || emitted[seedHint])
+		{
+			while (emitted[cursor]) { cursor++; }
+			seedHint = static_cast<unsigned int>(cursor);
+		}
+		addTriangle(seedHint);
+		seedHint = ~0u;
+
+		while (meshlet.triangleCount < maxTriangles)
+		{
+			const float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			const float inverse = length > 0.0f ? 1.0f / length : 0.0f;
+			unsigned int best = ~0u;
+			float bestScore = HUGE_VALF;
+			size_t write = 0;
+			for (size_t i = 0; i < candidates.size(); i++)
+			{
+				const unsigned int u = candidates[i];
+				if (emitted[u]) { continue; }
+				candidates[write++] = u;
+				size_t extra = 0;
+				for (int k = 0; k < 3; k++) { extra += vertexStamp[indices[u * 3 + k]] != stamp; }
+				if (meshlet.vertexCount + extra > maxVertices) { continue; }
+				//新しい頂点の少なさを優先し、法線の揃い具合で順位を付ける
+				const float* n = &normals[static_cast<size_t>(u) * 3];
+				const float spread = 1.0f - (n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]) * inverse;
+				const float score = static_cast<float>(extra) + coneWeight * spread;
+				if (score < bestScore || (score == bestScore && u < best))
+				{
+					bestScore = score;
+					best = u;
+				}
+			}
+			candidates.resize(write);
+			if (best == ~0u) { break; }
+			addTriangle(best);
+		}
+		for (unsigned int u : candidates)
+		{
+			if (!emitted[u])
+			{
+				seedHint = u;
+				break;
+			}
+		}
+		outMeshlets.push_back(meshlet);
+	}
+
+	std::vector<unsigned int> reordered(indexCount);
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		memcpy(&reordered[i * 3], &indices[static_cast<size_t>(order[i]) * 3], sizeof(unsigned int) * 3);
+	}
+	memcpy(indices, reordered.data(), indexCount * sizeof(unsigned int));
+	for (Meshlet& meshlet : outMeshlets)
+	{
+		computeMeshletBounds(meshlet, indices + (meshlet.indexOffset - baseIndexOffset), positions, stride);
+	}
+}
+
+MeshletStatistics analyzeMeshlets(const Meshlet* meshlets, size_t meshletCount, size_t uniqueVertexCount,
+	size_t maxVertices, size_t maxTriangles)
+{
+	MeshletStatistics statistics{};
+	statistics.meshletCount = meshletCount;
+	if (meshletCount == 0) { return statistics; }
+	size_t vertices = 0, triangles = 0, cullable = 0;
+	for (size_t i = 0; i < meshletCount; i++)
+	{
+		vertices += meshlets[i].vertexCount;
+		triangles += meshlets[i].triangleCount;
+		cullable += meshlets[i].coneCutoff < 1.0f;
+	}
+	statistics.averageVertices = static_cast<float>(vertices) / meshletCount;
+	statistics.averageTriangles = static_cast<float>(triangles) / meshletCount;
+	statistics.vertexFill = statistics.averageVertices / maxVertices;
+	statistics.triangleFill = statistics.averageTriangles / maxTriangles;
+	statistics.vertexRedundancy = uniqueVertexCount ? static_cast<float>(vertices) / uniqueVertexCount : 0.0f;
+	statistics.coneCullable = static_cast<float>(cullable) / meshletCount;
+	return statistics;
+}
+
+void MeshletCullData::build(const Meshlet* meshlets, size_t meshletCount)
+{
+	count = meshletCount;
+	const size_t padded = (meshletCount + 3) & ~static_cast<size_t>(3);
+	for (std::vector<float>* array : { &centerX,&centerY,&centerZ,&radius,&axisX,&axisY,&axisZ,&cutoff })
+	{
+		array->assign(padded, 0.0f);
+	}
+	indexOffset.assign(padded, 0);
+	indexCount.assign(padded, 0);
+	for (size_t i = 0; i < meshletCount; i++)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		centerX[i] = meshlet.center[0];
+		centerY[i] = meshlet.center[1];
+		centerZ[i] = meshlet.center[2];
+		radius[i] = meshlet.radius;
+		axisX[i] = meshlet.coneAxis[0];
+		axisY[i] = meshlet.coneAxis[1];
+		axisZ[i] = meshlet.coneAxis[2];
+		cutoff[i] = meshlet.coneCutoff;
+		indexOffset[i] = meshlet.indexOffset;
+		indexCount[i] = meshlet.triangleCount * 3;
+	}
+}
+
+size_t cullMeshletsReference(std::vector<MeshletDrawRange>& outRanges, const MeshletCullData& data, const MeshletCullParams& params)
+{
+	outRanges.clear();
+	size_t visible = 0;
+	for (size_t i = 0; i < data.count; i++)
+	{
+		if (!detail::isMeshletVisible(data, i, params)) { continue; }
+		detail::emitMeshlet(outRanges, data, i);
+		visible++;
+	}
+	return visible;
+}
+
+size_t cullMeshlets(std::vector<MeshletDrawRange>& outRanges, const MeshletCullData& data, const MeshletCullParams& params)
+{
+#ifdef MESHLET_SSE2
+	outRanges.clear();
+	size_t visible = 0;
+	const __m128 radiusScale = _mm_set1_ps(params.radiusScale);
+	const __m128 radiusBias = _mm_set1_ps(params.radiusBias);
+	const __m128 cameraX = _mm_set1_ps(params.cameraPosition[0]);
+	const __m128 cameraY = _mm_set1_ps(params.cameraPosition[1]);
+	const __m128 cameraZ = _mm_set1_ps(params.cameraPosition[2]);
+	__m128 planes[6][4];
+	for (int p = 0; p < 6; p++)
+	{
+		for (int k = 0; k < 4; k++) { planes[p][k] = _mm_set1_ps(params.planes[p][k]); }
+	}
+	for (size_t i = 0; i < data.count; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(&data.centerX[i]);
+		const __m128 y = _mm_loadu_ps(&data.centerY[i]);
+		const __m128 z = _mm_loadu_ps(&data.centerZ[i]);
+		const __m128 r = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&data.radius[i]), radiusScale), radiusBias);
+		const __m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planes[p][0]), _mm_mul_ps(y, planes[p][1])),
+				_mm_add_ps(_mm_mul_ps(z, planes[p][2]), planes[p][3]));
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(distance, negativeR));
+		}
+		if (params.coneCulling)
+		{
+			const __m128 dx = _mm_sub_ps(x, cameraX);
+			const __m128 dy = _mm_sub_ps(y, cameraY);
+			const __m128 dz = _mm_sub_ps(z, cameraZ);
+			const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&data.axisX[i])), _mm_mul_ps(dy, _mm_loadu_ps(&data.axisY[i]))),
+				_mm_mul_ps(dz, _mm_loadu_ps(&data.axisZ[i])));
+			const __m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&data.cutoff[i]), distance), r);
+			mask = _mm_andnot_ps(_mm_cmpge_ps(dot, limit), mask);
+		}
+		int bits = _mm_movemask_ps(mask);
+		if (data.count - i < 4) { bits &= (1 << (data.count - i)) - 1; }
+		for (int lane = 0; bits; lane++, bits >>= 1)
+		{
+			if (!(bits & 1)) { continue; }
+			detail::emitMeshlet(outRanges, data, i + lane);
+			visible++;
+		}
+	}
+	return visible;
+#else
+	return cullMeshletsReference(outRanges, data, params);
+#endif
+}
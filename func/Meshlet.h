@@ -0,0 +1,87 @@
+﻿#pragma once
+#include <stddef.h>
+#include <vector>
+
+/****************************************************************
+	A cluster of triangles stored as one contiguous index range.
+	center / radius bound the vertices, coneAxis / coneCutoff bound
+	the triangle normals (coneCutoff = 1 disables cone culling).
+****************************************************************/
+struct Meshlet
+{
+	unsigned int indexOffset = 0;
+	unsigned int triangleCount = 0;
+	unsigned int vertexCount = 0;
+	float coneCutoff = 1.0f;
+	float center[3] = { 0.0f,0.0f,0.0f };
+	float radius = 0.0f;
+	float coneAxis[3] = { 0.0f,0.0f,0.0f };
+	unsigned int reserved = 0;
+};
+static_assert(sizeof(Meshlet) == 48, "Meshlet is stored in mesh caches");
+
+struct MeshletStatistics
+{
+	size_t meshletCount = 0;
+	float averageVertices = 0.0f;
+	float averageTriangles = 0.0f;
+	float vertexFill = 0.0f;			// averageVertices / maxVertices
+	float triangleFill = 0.0f;			// averageTriangles / maxTriangles
+	float vertexRedundancy = 0.0f;		// meshlet vertices / unique vertices (1.0 is ideal)
+	float coneCullable = 0.0f;			// ratio of meshlets with a usable normal cone
+};
+
+/****************************************************************
+	Greedy clustering over shared vertices.
+	indices are reordered in place so every meshlet is one range
+	starting at indexOffset (+ baseIndexOffset).
+****************************************************************/
+void buildMeshlets(std::vector<Meshlet>& outMeshlets, unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t stride,
+	unsigned int baseIndexOffset = 0, size_t maxVertices = 64, size_t maxTriangles = 124, float coneWeight = 0.25f);
+
+MeshletStatistics analyzeMeshlets(const Meshlet* meshlets, size_t meshletCount, size_t uniqueVertexCount,
+	size_t maxVertices = 64, size_t maxTriangles = 124);
+
+/****************************************************************
+	Structure of arrays copy of the bounds for the SIMD culler.
+	Arrays are padded to a multiple of 4.
+****************************************************************/
+struct MeshletCullData
+{
+	size_t count = 0;
+	std::vector<float> centerX, centerY, centerZ, radius;
+	std::vector<float> axisX, axisY, axisZ, cutoff;
+	std::vector<unsigned int> indexOffset, indexCount;
+
+	void build(const Meshlet* meshlets, size_t meshletCount);
+	void clear() { build(nullptr, 0); }
+};
+
+/****************************************************************
+	Object-space culling input.
+	radius' = radius * radiusScale + radiusBias, for shaders that
+	move vertices after the bounds were taken.
+****************************************************************/
+struct MeshletCullParams
+{
+	float planes[6][4] = {};
+	float cameraPosition[3] = { 0.0f,0.0f,0.0f };
+	bool coneCulling = false;
+	float radiusScale = 1.0f;
+	float radiusBias = 0.0f;
+};
+
+struct MeshletDrawRange
+{
+	unsigned int indexOffset;
+	unsigned int indexCount;
+};
+
+/****************************************************************
+	Frustum and normal cone culling, 4 meshlets per step (SSE2).
+	Adjacent visible meshlets are merged into one draw range.
+	Returns the number of visible meshlets.
+****************************************************************/
+size_t cullMeshlets(std::vector<MeshletDrawRange>& outRanges, const MeshletCullData& data, const MeshletCullParams& params);
+size_t cullMeshletsReference(std::vector<MeshletDrawRange>& outRanges, const MeshletCullData& data, const MeshletCullParams& params);
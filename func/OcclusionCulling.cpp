@@ -0,0 +1,311 @@
+﻿#include "OcclusionCulling.h"
+#include "ParallelFor.h"
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2
+#endif
+
+namespace detail
+{
+	constexpr float occlusionUnbounded = 1e30f;
+
+	inline void transformPoint(float out[4], const float* p, const float m[16])
+	{
+#ifdef OCCLUSION_SSE2
+		__m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), _mm_loadu_ps(m)), _mm_mul_ps(_mm_set1_ps(p[1]), _mm_loadu_ps(m + 4)));
+		r = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[2]), _mm_loadu_ps(m + 8)), _mm_loadu_ps(m + 12)));
+		_mm_storeu_ps(out, r);
+#else
+		for (int k = 0; k < 4; k++) { out[k] = p[0] * m[k] + p[1] * m[4 + k] + p[2] * m[8 + k] + m[12 + k]; }
+#endif
+	}
+
+	//行ごとの被覆区間 [first, last] (ピクセル中心で判定)
+	void computeSpans(int first[8], int last[8], const float leftK[3], const float leftM[3],
+		const float rightK[3], const float rightM[3], float y0, float maxPixel)
+	{
+#ifdef OCCLUSION_SSE2
+		for (int half = 0; half < 8; half += 4)
+		{
+			const __m128 y = _mm_add_ps(_mm_set1_ps(y0 + half), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+			__m128 left = _mm_set1_ps(-occlusionUnbounded);
+			__m128 right = _mm_set1_ps(occlusionUnbounded);
+			for (int e = 0; e < 3; e++)
+			{
+				left = _mm_max_ps(left, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(leftK[e]), y), _mm_set1_ps(leftM[e])));
+				right = _mm_min_ps(right, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(rightK[e]), y), _mm_set1_ps(rightM[e])));
+			}
+			const __m128 half0 = _mm_set1_ps(0.5f);
+			left = _mm_max_ps(_mm_sub_ps(left, half0), _mm_setzero_ps());
+			right = _mm_max_ps(_mm_min_ps(_mm_sub_ps(right, half0), _mm_set1_ps(maxPixel)), _mm_set1_ps(-1.0f));
+			//SSE2には floor / ceil が無いので切り捨てから補正する
+			__m128i leftI = _mm_cvttps_epi32(left);
+			leftI = _mm_sub_epi32(leftI, _mm_castps_si128(_mm_cmplt_ps(_mm_cvtepi32_ps(leftI), left)));
+			__m128i rightI = _mm_cvttps_epi32(right);
+			rightI = _mm_add_epi32(rightI, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(rightI), right)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(first + half), leftI);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(last + half), rightI);
+		}
+#else
+		for (int r = 0; r < 8; r++)
+		{
+			const float y = y0 + r + 0.5f;
+			float left = -occlusionUnbounded, right = occlusionUnbounded;
+			for (int e = 0; e < 3; e++)
+			{
+				left = std::max(left, leftK[e] * y + leftM[e]);
+				right = std::min(right, rightK[e] * y + rightM[e]);
+			}
+			first[r] = static_cast<int>(ceilf(std::max(left - 0.5f, 0.0f)));
+			last[r] = static_cast<int>(floorf(std::max(std::min(right - 0.5f, maxPixel), -1.0f)));
+		}
+#endif
+	}
+
+	inline uint32_t spanBits(int first, int last)
+	{
+		return (0xFFFFFFFFu >> (31 - (last - first))) << first;
+	}
+}
+
+void MaskedOcclusionBuffer::resize(unsigned int newWidth, unsigned int newHeight)
+{
+	width = newWidth;
+	height = newHeight;
+	tilesX = (width + tileWidth - 1) / tileWidth;
+	tilesY = (height + tileHeight - 1) / tileHeight;
+	masks.resize(static_cast<size_t>(tilesX) * tilesY * tileHeight);
+	layerDepth.resize(static_cast<size_t>(tilesX) * tilesY);
+	tileDepth.resize(static_cast<size_t>(tilesX) * tilesY);
+	clear();
+}
+
+void MaskedOcclusionBuffer::clear()
+{
+	std::fill(masks.begin(), masks.end(), 0u);
+	std::fill(layerDepth.begin(), layerDepth.end(), 0.0f);
+	std::fill(tileDepth.begin(), tileDepth.end(), 1.0f);
+	triangles.clear();
+}
+
+void MaskedOcclusionBuffer::addOccluder(const float* positions, size_t stride, const unsigned int* indices, size_t triangleCount,
+	const float worldViewProjection[16], bool backfaceCulling)
+{
+	const float halfWidth = width * 0.5f;
+	const float halfHeight = height * 0.5f;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		float x[3], y[3], z[3];
+		bool clipped = false;
+		for (int v = 0; v < 3; v++)
+		{
+			float clip[4];
+			const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + indices[t * 3 + v] * stride);
+			detail::transformPoint(clip, p, worldViewProjection);
+			//近平面をまたぐ三角形は捨てても保守的
+			if (clip[3] <= 1e-6f || clip[2] < 0.0f)
+			{
+				clipped = true;
+				break;
+			}
+			const float inverseW = 1.0f / clip[3];
+			x[v] = (clip[0] * inverseW + 1.0f) * halfWidth;
+			y[v] = (1.0f - clip[1] * inverseW) * halfHeight;
+			z[v] = clip[2] * inverseW;
+		}
+		if (clipped) { continue; }
+		//描画先で反時計回り(y下向きでは負の面積)が表
+		const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (area == 0.0f || (backfaceCulling && area > 0.0f)) { continue; }
+
+		Triangle triangle;
+		triangle.minX = std::min(x[0], std::min(x[1], x[2]));
+		triangle.maxX = std::max(x[0], std::max(x[1], x[2]));
+		triangle.minY = std::min(y[0], std::min(y[1], y[2]));
+		triangle.maxY = std::max(y[0], std::max(y[1], y[2]));
+		if (triangle.maxX < 0.0f || triangle.maxY < 0.0f || triangle.minX > width || triangle.minY > height) { continue; }
+		const float sign = area > 0.0f ? 1.0f : -1.0f;
+		for (int e = 0; e < 3; e++)
+		{
+			const int j = (e + 1) % 3;
+			const float a = y[e] - y[j];
+			const float b = x[j] - x[e];
+			const float c = -(a * x[e] + b * y[e]);
+			triangle.leftK[e] = 0.0f;
+			triangle.leftM[e] = -detail::occlusionUnbounded;
+			triangle.rightK[e] = 0.0f;
+			triangle.rightM[e] = detail::occlusionUnbounded;
+			//水平な辺は行の範囲(minY / maxY)で制限される
+			if (a * sign > 0.0f)
+			{
+				triangle.leftK[e] = -b / a;
+				triangle.leftM[e] = -c / a;
+			}
+			else if (a * sign < 0.0f)
+			{
+				triangle.rightK[e] = -b / a;
+				triangle.rightM[e] = -c / a;
+			}
+		}
+		triangle.depthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+		triangle.depthY = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+		triangle.depthC = z[0] - triangle.depthX * x[0] - triangle.depthY * y[0];
+		triangle.maxZ = std::max(z[0], std::max(z[1], z[2]));
+		triangles.push_back(triangle);
+	}
+}
+
+uint32_t MaskedOcclusionBuffer::getValidBits(unsigned int tileX, unsigned int row, unsigned int tileY)const
+{
+	if (tileY * tileHeight + row >= height) { return 0; }
+	const unsigned int columns = std::min(tileWidth, width - tileX * tileWidth);
+	return columns == tileWidth ? 0xFFFFFFFFu : (1u << columns) - 1;
+}
+
+void MaskedOcclusionBuffer::rasterizeRows(unsigned int firstTileRow, unsigned int lastTileRow)
+{
+	const float maxPixel = static_cast<float>(width - 1);
+	for (const Triangle& triangle : triangles)
+	{
+		//ピクセル中心が三角形の上下端の内側にある行だけを対象にする
+		const int firstRow = std::max(static_cast<int>(ceilf(triangle.minY - 0.5f)), static_cast<int>(firstTileRow * tileHeight));
+		const int lastRow = std::min(std::min(static_cast<int>(floorf(triangle.maxY - 0.5f)), static_cast<int>(lastTileRow * tileHeight) - 1),
+			static_cast<int>(height) - 1);
+		if (firstRow > lastRow) { continue; }
+		for (unsigned int tileY = firstRow / tileHeight; tileY <= static_cast<unsigned int>(lastRow) / tileHeight; tileY++)
+		{
+			const int rowBase = static_cast<int>(tileY * tileHeight);
+			int first[tileHeight], last[tileHeight];
+			detail::computeSpans(first, last, triangle.leftK, triangle.leftM, triangle.rightK, triangle.rightM, static_cast<float>(rowBase), maxPixel);
+			int spanMin = static_cast<int>(width), spanMax = -1;
+			for (int r = 0; r < static_cast<int>(tileHeight); r++)
+			{
+				if (rowBase + r < firstRow || rowBase + r > lastRow) { last[r] = -1; }
+				if (first[r] > last[r]) { continue; }
+				spanMin = std::min(spanMin, first[r]);
+				spanMax = std::max(spanMax, last[r]);
+			}
+			if (spanMin > spanMax) { continue; }
+			const float ya = std::max(static_cast<float>(rowBase), triangle.minY);
+			const float yb = std::min(static_cast<float>(rowBase + tileHeight), triangle.maxY);
+			for (unsigned int tileX = spanMin / tileWidth; tileX <= static_cast<unsigned int>(spanMax) / tileWidth; tileX++)
+			{
+				const int columnBase = static_cast<int>(tileX * tileWidth);
+				uint32_t cover[tileHeight];
+				uint32_t any = 0;
+				for (int r = 0; r < static_cast<int>(tileHeight); r++)
+				{
+					const int a = std::max(first[r], columnBase) - columnBase;
+					const int b = std::min(last[r], columnBase + static_cast<int>(tileWidth) - 1) - columnBase;
+					cover[r] = a <= b ? detail::spanBits(a, b) : 0u;
+					any |= cover[r];
+				}
+				if (!any) { continue; }
+
+				//タイルと三角形の外接矩形の重なりで平面の最大深度を取る
+				const float xa = std::max(static_cast<float>(columnBase), triangle.minX);
+				const float xb = std::min(static_cast<float>(columnBase + tileWidth), triangle.maxX);
+				const float z = std::min(triangle.maxZ, triangle.depthC +
+					std::max(triangle.depthX * xa, triangle.depthX * xb) + std::max(triangle.depthY * ya, triangle.depthY * yb));
+				const size_t tile = static_cast<size_t>(tileY) * tilesX + tileX;
+				if (z >= tileDepth[tile]) { continue; }
+				uint32_t* mask = &masks[tile * tileHeight];
+				uint32_t covered = 0;
+				for (unsigned int r = 0; r < tileHeight; r++) { covered |= mask[r]; }
+				//作業層より大きく奥にある場合は作業層を捨てて深度の悪化を防ぐ
+				if (covered && z > layerDepth[tile] && z - layerDepth[tile] > tileDepth[tile] - z)
+				{
+					for (unsigned int r = 0; r < tileHeight; r++) { mask[r] = 0; }
+					covered = 0;
+				}
+				layerDepth[tile] = covered ? std::max(layerDepth[tile], z) : z;
+				bool full = true;
+				for (unsigned int r = 0; r < tileHeight; r++)
+				{
+					mask[r] |= cover[r];
+					full &= (mask[r] | ~getValidBits(tileX, r, tileY)) == 0xFFFFFFFFu;
+				}
+				if (full)
+				{
+					tileDepth[tile] = std::min(tileDepth[tile], layerDepth[tile]);
+					layerDepth[tile] = 0.0f;
+					for (unsigned int r = 0; r < tileHeight; r++) { mask[r] = 0; }
+				}
+			}
+		}
+	}
+}
+
+void MaskedOcclusionBuffer::rasterize()
+{
+	parallelForRanges(tilesY, 1, [&](size_t begin, size_t end, size_t)
+		{
+			rasterizeRows(static_cast<unsigned int>(begin), static_cast<unsigned int>(end));
+		});
+	triangles.clear();
+}
+
+OcclusionResult MaskedOcclusionBuffer::testRect(float minX, float minY, float maxX, float maxY, float nearestDepth)const
+{
+	if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height || nearestDepth > 1.0f) { return OcclusionResult::viewCulled; }
+	const int x0 = std::max(static_cast<int>(floorf(minX)), 0);
+	const int y0 = std::max(static_cast<int>(floorf(minY)), 0);
+	const int x1 = std::min(static_cast<int>(floorf(maxX)), static_cast<int>(width) - 1);
+	const int y1 = std::min(static_cast<int>(floorf(maxY)), static_cast<int>(height) - 1);
+	for (unsigned int tileY = y0 / tileHeight; tileY <= static_cast<unsigned int>(y1) / tileHeight; tileY++)
+	{
+		for (unsigned int tileX = x0 / tileWidth; tileX <= static_cast<unsigned int>(x1) / tileWidth; tileX++)
+		{
+			const size_t tile = static_cast<size_t>(tileY) * tilesX + tileX;
+			if (nearestDepth >= tileDepth[tile]) { continue; }
+			if (nearestDepth < layerDepth[tile]) { return OcclusionResult::visible; }
+			//作業層が矩形の全ピクセルを覆っていれば隠れている
+			const int columnBase = static_cast<int>(tileX * tileWidth);
+			const uint32_t bits = detail::spanBits(std::max(x0, columnBase) - columnBase,
+				std::min(x1, columnBase + static_cast<int>(tileWidth) - 1) - columnBase);
+			const uint32_t* mask = &masks[tile * tileHeight];
+			for (unsigned int r = 0; r < tileHeight; r++)
+			{
+				const int y = static_cast<int>(tileY * tileHeight + r);
+				if (y < y0 || y > y1) { continue; }
+				if (bits & ~mask[r]) { return OcclusionResult::visible; }
+			}
+		}
+	}
+	return OcclusionResult::occluded;
+}
+
+OcclusionResult MaskedOcclusionBuffer::testAabb(const float min[3], const float max[3], const float viewProjection[16])const
+{
+	float minX = detail::occlusionUnbounded, minY = detail::occlusionUnbounded, minZ = detail::occlusionUnbounded;
+	float maxX = -detail::occlusionUnbounded, maxY = -detail::occlusionUnbounded;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const float p[3] = { corner & 1 ? max[0] : min[0],corner & 2 ? max[1] : min[1],corner & 4 ? max[2] : min[2] };
+		float clip[4];
+		detail::transformPoint(clip, p, viewProjection);
+		//近平面をまたぐ物体は常に見える扱い
+		if (clip[3] <= 1e-6f || clip[2] < 0.0f) { return OcclusionResult::visible; }
+		const float inverseW = 1.0f / clip[3];
+		const float x = clip[0] * inverseW, y = clip[1] * inverseW;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minZ = std::min(minZ, clip[2] * inverseW);
+	}
+	if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) { return OcclusionResult::viewCulled; }
+	return testRect((minX + 1.0f) * 0.5f * width, (1.0f - maxY) * 0.5f * height,
+		(maxX + 1.0f) * 0.5f * width, (1.0f - minY) * 0.5f * height, minZ);
+}
+
+float MaskedOcclusionBuffer::getPixelDepth(unsigned int x, unsigned int y)const
+{
+	assert(x < width && y < height);
+	const size_t tile = static_cast<size_t>(y / tileHeight) * tilesX + x / tileWidth;
+	const bool masked = (masks[tile * tileHeight + y % tileHeight] >> (x % tileWidth)) & 1;
+	return masked ? std::min(layerDepth[tile], tileDepth[tile]) : tileDepth[tile];
+}
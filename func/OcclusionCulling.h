@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum class OcclusionResult { visible, occluded, viewCulled };
+
+/****************************************************************
+	Masked software occlusion buffer (Andersson et al.).
+	The screen is split into 32x8 pixel tiles. Each tile keeps a
+	coverage mask with its farthest depth (working layer) and a
+	conservative farthest depth for the whole tile. No per-pixel
+	depth is stored.
+	Depth is D3D clip space z/w, 0 = near. Matrices are row-major
+	for row vectors (DirectXMath layout).
+
+	Usage per frame:
+		clear -> addOccluder (a few large meshes) -> rasterize
+		-> testAabb for every object before handing it to a painter
+		(Geometry::getWorldBounds gives the box).
+****************************************************************/
+class MaskedOcclusionBuffer
+{
+public:
+	static constexpr unsigned int tileWidth = 32;
+	static constexpr unsigned int tileHeight = 8;
+private:
+	struct Triangle
+	{
+		float leftK[3], leftM[3];		// x >= k * y + m
+		float rightK[3], rightM[3];		// x <= k * y + m
+		float minX, maxX, minY, maxY;
+		float depthX, depthY, depthC;	// z = depthX * x + depthY * y + depthC
+		float maxZ;
+	};
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int tilesX = 0;
+	unsigned int tilesY = 0;
+	std::vector<uint32_t> masks;		// tileHeight rows per tile
+	std::vector<float> layerDepth;		// farthest depth of the masked coverage
+	std::vector<float> tileDepth;		// farthest depth of the whole tile
+	std::vector<Triangle> triangles;
+
+	void rasterizeRows(unsigned int firstTileRow, unsigned int lastTileRow);
+	uint32_t getValidBits(unsigned int tileX, unsigned int row, unsigned int tileY)const;
+public:
+	MaskedOcclusionBuffer() = default;
+	MaskedOcclusionBuffer(unsigned int width, unsigned int height) { resize(width, height); }
+
+	void resize(unsigned int width, unsigned int height);
+	void clear();
+
+	/****************************************************************
+		Queue an indexed float3 mesh (stride in bytes) transformed by
+		worldViewProjection. Back faces (CCW front) and triangles that
+		cross the near plane are dropped, which keeps it conservative.
+	****************************************************************/
+	void addOccluder(const float* positions, size_t stride, const unsigned int* indices, size_t triangleCount,
+		const float worldViewProjection[16], bool backfaceCulling = true);
+	// Rasterize the queued occluders, one band of tile rows per core.
+	void rasterize();
+
+	// min / max in pixels, nearestDepth = smallest z of the object.
+	OcclusionResult testRect(float minX, float minY, float maxX, float maxY, float nearestDepth)const;
+	OcclusionResult testAabb(const float min[3], const float max[3], const float viewProjection[16])const;
+
+	unsigned int getWidth()const { return width; }
+	unsigned int getHeight()const { return height; }
+	size_t getQueuedTriangleCount()const { return triangles.size(); }
+	// Conservative depth of one pixel (1 = nothing known), for debugging.
+	float getPixelDepth(unsigned int x, unsigned int y)const;
+};
@@ -0,0 +1,152 @@
+﻿#include "ParallelFor.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Set on pool threads and on the owner while it dispatches.
+	// std::mutex::try_lock from the owning thread is undefined, so nesting is detected here.
+	thread_local bool insidePool = false;
+
+	/****************************************************************
+		Threads started on the first dispatch and kept until exit.
+		One caller owns the pool at a time; it publishes a job, runs
+		ranges itself and waits for the ranges the workers took.
+	****************************************************************/
+	class WorkerPool
+	{
+		std::mutex ownerMutex;			// held by the dispatching thread
+		std::mutex mutex;				// guards everything below but the atomics
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::vector<std::thread> threads;
+		std::atomic<size_t> workerCount;
+		uint64_t generation = 0;
+		size_t activeWorkers = 0;		// workers that picked up the current generation
+		bool stopping = false;
+		void (*invoke)(void*, size_t) = nullptr;
+		void* context = nullptr;
+		size_t rangeCount = 0;
+		std::atomic<size_t> nextRange{ 0 };
+		std::atomic<size_t> finishedRanges{ 0 };
+
+		void runRanges()
+		{
+			for (size_t r = nextRange++; r < rangeCount; r = nextRange++)
+			{
+				invoke(context, r);
+				if (++finishedRanges == rangeCount)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					done.notify_all();
+				}
+			}
+		}
+
+		void work(uint64_t seen)
+		{
+			insidePool = true;
+			std::unique_lock<std::mutex> lock(mutex);
+			for (;;)
+			{
+				wake.wait(lock, [&]() { return stopping || generation != seen; });
+				if (stopping) { return; }
+				seen = generation;
+				activeWorkers++;
+				lock.unlock();
+				runRanges();
+				lock.lock();
+				if (--activeWorkers == 0) { done.notify_all(); }
+			}
+		}
+
+		void stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& thread : threads) { thread.join(); }
+			threads.clear();
+			stopping = false;
+		}
+
+		void start(size_t threadCount)
+		{
+			threads.reserve(threadCount);
+			for (size_t t = 0; t < threadCount; t++)
+			{
+				threads.emplace_back(&WorkerPool::work, this, generation);
+			}
+		}
+	public:
+		WorkerPool()
+		{
+			const unsigned int count = std::thread::hardware_concurrency();
+			workerCount = count > 0 ? count : 1;
+		}
+		~WorkerPool() { stop(); }
+		size_t getWorkerCount()const { return workerCount; }
+		void setWorkerCount(size_t count) { workerCount = count > 0 ? count : 1; }
+
+		void dispatch(size_t newRangeCount, void (*newInvoke)(void*, size_t), void* newContext)
+		{
+			std::unique_lock<std::mutex> owner;
+			if (!insidePool) { owner = std::unique_lock<std::mutex>(ownerMutex, std::try_to_lock); }
+			if (!owner.owns_lock())
+			{
+				//入れ子の呼び出しや別スレッドが使用中のときは呼び出し元で全部回す
+				for (size_t r = 0; r < newRangeCount; r++) { newInvoke(newContext, r); }
+				return;
+			}
+			//スレッドの生成は最初の呼び出しと setWorkerCount の後だけ
+			if (threads.size() + 1 != workerCount)
+			{
+				stop();
+				start(workerCount - 1);
+			}
+			{
+				//前の世代を拾い遅れたワーカーが抜けるまで待ってから差し替える
+				std::unique_lock<std::mutex> lock(mutex);
+				done.wait(lock, [&]() { return activeWorkers == 0; });
+				invoke = newInvoke;
+				context = newContext;
+				rangeCount = newRangeCount;
+				nextRange = 0;
+				finishedRanges = 0;
+				generation++;
+			}
+			wake.notify_all();
+			insidePool = true;
+			runRanges();
+			insidePool = false;
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [&]() { return finishedRanges == rangeCount; });
+		}
+	};
+
+	WorkerPool& getWorkerPool()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+}
+
+size_t getWorkerCount()
+{
+	return getWorkerPool().getWorkerCount();
+}
+
+void setWorkerCount(size_t count)
+{
+	getWorkerPool().setWorkerCount(count);
+}
+
+void detail::dispatchRanges(size_t rangeCount, void (*invoke)(void* context, size_t range), void* context)
+{
+	getWorkerPool().dispatch(rangeCount, invoke, context);
+}
@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <stddef.h>
+
+/****************************************************************
+	Number of worker threads used by parallelFor, including the
+	calling thread. Defaults to the hardware thread count and is
+	read once.
+****************************************************************/
+size_t getWorkerCount();
+
+/****************************************************************
+	Change the worker count. The pool is resized on the next
+	parallelFor; call it while no parallelFor is running.
+****************************************************************/
+void setWorkerCount(size_t count);
+
+namespace detail
+{
+	/****************************************************************
+		Run invoke(context, r) for every r in [0, rangeCount) on the
+		persistent worker pool and the calling thread, and return
+		when all of them are done. Nested calls, and calls made while
+		another thread owns the pool, run every range on the caller.
+	****************************************************************/
+	void dispatchRanges(size_t rangeCount, void (*invoke)(void* context, size_t range), void* context);
+}
+
+/****************************************************************
+	Split [0, count) into contiguous ranges and run
+	function(begin, end, rangeIndex) for each range on the worker
+	pool. Ranges hold at least minRange items. Returns the range
+	count, which never exceeds getWorkerCount().
+****************************************************************/
+template<class Function>
+size_t parallelForRanges(size_t count, size_t minRange, Function function)
+{
+	if (count == 0) { return 0; }
+	if (minRange == 0) { minRange = 1; }
+	size_t rangeCount = getWorkerCount();
+	if (rangeCount > (count + minRange - 1) / minRange) { rangeCount = (count + minRange - 1) / minRange; }
+	if (rangeCount <= 1)
+	{
+		function(size_t(0), count, size_t(0));
+		return 1;
+	}
+	struct Job
+	{
+		Function& function;
+		size_t count;
+		size_t rangeCount;
+	} job{ function,count,rangeCount };
+	detail::dispatchRanges(rangeCount, [](void* context, size_t r)
+		{
+			Job& job = *static_cast<Job*>(context);
+			job.function(job.count * r / job.rangeCount, job.count * (r + 1) / job.rangeCount, r);
+		}, &job);
+	return rangeCount;
+}
+
+/****************************************************************
+	Run function(i) for every i in [0, count).
+****************************************************************/
+template<class Function>
+void parallelFor(size_t count, size_t minRange, Function function)
+{
+	parallelForRanges(count, minRange, [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t i = begin; i < end; i++) { function(i); }
+		});
+}
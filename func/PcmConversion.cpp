@@ -0,0 +1,639 @@
+﻿#include "PcmConversion.h"
+#include "ParallelFor.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_CONVERSION_SSE2
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#define PCM_CONVERSION_AVX2
+#define PCM_AVX2_TARGET
+#elif defined(__GNUC__)
+#include <immintrin.h>
+#define PCM_CONVERSION_AVX2
+#define PCM_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace detail
+{
+	using DecodeFloat = void(*)(const unsigned char* src, size_t count, float* out);
+	using DecodeInt16 = void(*)(const unsigned char* src, size_t count, int16_t* out);
+
+	constexpr float scale8 = 1.0f / 128.0f;
+	constexpr float scale16 = 1.0f / 32768.0f;
+	constexpr float scale32 = 1.0f / 2147483648.0f;
+
+	inline int32_t load24(const unsigned char* p)
+	{
+		return static_cast<int32_t>((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24));
+	}
+
+	inline int32_t load32(const unsigned char* p)
+	{
+		return static_cast<int32_t>(uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24));
+	}
+
+	inline int16_t load16(const unsigned char* p)
+	{
+		return static_cast<int16_t>(p[0] | (p[1] << 8));
+	}
+
+	//SSEのmaxps / minps / cvtps2dqと同じ順序で丸める
+	inline int16_t floatToInt16(float value)
+	{
+		float v = value * 32768.0f;
+		v = v > -32768.0f ? v : -32768.0f;
+		v = v < 32767.0f ? v : 32767.0f;
+		return static_cast<int16_t>(lrintf(v));
+	}
+
+	inline float decodeFloat(PcmFormat format, const unsigned char* p)
+	{
+		switch (format)
+		{
+		case PcmFormat::unsigned8: return (static_cast<int>(p[0]) - 128) * scale8;
+		case PcmFormat::signed16: return load16(p) * scale16;
+		case PcmFormat::signed24: return static_cast<float>(load24(p)) * scale32;
+		case PcmFormat::signed32: return static_cast<float>(load32(p)) * scale32;
+		default:
+		{
+			float value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+		}
+	}
+
+	inline int16_t decodeInt16(PcmFormat format, const unsigned char* p)
+	{
+		switch (format)
+		{
+		case PcmFormat::unsigned8: return static_cast<int16_t>((static_cast<int>(p[0]) - 128) * 256);
+		case PcmFormat::signed16: return load16(p);
+		case PcmFormat::signed24: return load16(p + 1);
+		case PcmFormat::signed32: return load16(p + 2);
+		default:
+		{
+			float value;
+			memcpy(&value, p, sizeof(value));
+			return floatToInt16(value);
+		}
+		}
+	}
+
+	template<PcmFormat Format>
+	void decodeFloatScalar(const unsigned char* src, size_t count, float* out)
+	{
+		const size_t size = getPcmSampleSize(Format);
+		for (size_t i = 0; i < count; i++) { out[i] = decodeFloat(Format, src + i * size); }
+	}
+
+	template<PcmFormat Format>
+	void decodeInt16Scalar(const unsigned char* src, size_t count, int16_t* out)
+	{
+		const size_t size = getPcmSampleSize(Format);
+		for (size_t i = 0; i < count; i++) { out[i] = decodeInt16(Format, src + i * size); }
+	}
+
+#ifdef PCM_CONVERSION_SSE2
+	inline __m128i load24x4(const unsigned char* p)
+	{
+		return _mm_setr_epi32(load24(p), load24(p + 3), load24(p + 6), load24(p + 9));
+	}
+
+	//16ビット整数を符号拡張して32ビットへ
+	inline __m128 int16LowToFloat(__m128i v) { return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)); }
+	inline __m128 int16HighToFloat(__m128i v) { return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)); }
+
+	inline __m128i floatToInt16x8(__m128 a, __m128 b)
+	{
+		const __m128 scale = _mm_set1_ps(32768.0f);
+		const __m128 low = _mm_set1_ps(-32768.0f);
+		const __m128 high = _mm_set1_ps(32767.0f);
+		a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(a, scale), low), high);
+		b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(b, scale), low), high);
+		return _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+	}
+
+	template<PcmFormat Format>
+	void decodeFloatSse2(const unsigned char* src, size_t count, float* out)
+	{
+		size_t i = 0;
+		if (Format == PcmFormat::unsigned8)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i bias = _mm_set1_epi16(128);
+			const __m128 scale = _mm_set1_ps(scale8);
+			for (; i + 16 <= count; i += 16)
+			{
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				const __m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(bytes, zero), bias);
+				const __m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(bytes, zero), bias);
+				_mm_storeu_ps(out + i, _mm_mul_ps(int16LowToFloat(low), scale));
+				_mm_storeu_ps(out + i + 4, _mm_mul_ps(int16HighToFloat(low), scale));
+				_mm_storeu_ps(out + i + 8, _mm_mul_ps(int16LowToFloat(high), scale));
+				_mm_storeu_ps(out + i + 12, _mm_mul_ps(int16HighToFloat(high), scale));
+			}
+		}
+		else if (Format == PcmFormat::signed16)
+		{
+			const __m128 scale = _mm_set1_ps(scale16);
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+				_mm_storeu_ps(out + i, _mm_mul_ps(int16LowToFloat(v), scale));
+				_mm_storeu_ps(out + i + 4, _mm_mul_ps(int16HighToFloat(v), scale));
+			}
+		}
+		else if (Format == PcmFormat::signed24)
+		{
+			//SSE2にはバイトシャッフルがないので4サンプルずつ組み立てる
+			const __m128 scale = _mm_set1_ps(scale32);
+			for (; i + 4 <= count; i += 4)
+			{
+				_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(load24x4(src + i * 3)), scale));
+			}
+		}
+		else if (Format == PcmFormat::signed32)
+		{
+			const __m128 scale = _mm_set1_ps(scale32);
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+				_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+			}
+		}
+		else
+		{
+			memcpy(out, src, count * sizeof(float));
+			return;
+		}
+		decodeFloatScalar<Format>(src + i * getPcmSampleSize(Format), count - i, out + i);
+	}
+
+	template<PcmFormat Format>
+	void decodeInt16Sse2(const unsigned char* src, size_t count, int16_t* out)
+	{
+		size_t i = 0;
+		if (Format == PcmFormat::unsigned8)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i bias = _mm_set1_epi16(128);
+			for (; i + 16 <= count; i += 16)
+			{
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				const __m128i low = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(bytes, zero), bias), 8);
+				const __m128i high = _mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(bytes, zero), bias), 8);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), low);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), high);
+			}
+		}
+		else if (Format == PcmFormat::signed16)
+		{
+			memcpy(out, src, count * sizeof(int16_t));
+			return;
+		}
+		else if (Format == PcmFormat::signed24)
+		{
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m128i a = _mm_srai_epi32(load24x4(src + i * 3), 16);
+				const __m128i b = _mm_srai_epi32(load24x4(src + i * 3 + 12), 16);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+			}
+		}
+		else if (Format == PcmFormat::signed32)
+		{
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m128i a = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)), 16);
+				const __m128i b = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16)), 16);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+			}
+		}
+		else
+		{
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(src + i * 4));
+				const __m128 b = _mm_loadu_ps(reinterpret_cast<const float*>(src + i * 4 + 16));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), floatToInt16x8(a, b));
+			}
+		}
+		decodeInt16Scalar<Format>(src + i * getPcmSampleSize(Format), count - i, out + i);
+	}
+#endif
+
+#ifdef PCM_CONVERSION_AVX2
+	//24バイトを2レーンに振り分け, 各サンプルを32ビットの上位3バイトへ
+	PCM_AVX2_TARGET inline __m256i load24x8(const unsigned char* p)
+	{
+		const __m256i lanes = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),
+			_mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6));
+		const __m256i shuffle = _mm256_setr_epi8(
+			-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+			-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+		return _mm256_shuffle_epi8(lanes, shuffle);
+	}
+
+	//packsはレーンごとに詰めるので並びを戻す
+	PCM_AVX2_TARGET inline __m256i packInt32x16(__m256i a, __m256i b)
+	{
+		return _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+	}
+
+	template<PcmFormat Format>
+	PCM_AVX2_TARGET void decodeFloatAvx2(const unsigned char* src, size_t count, float* out)
+	{
+		size_t i = 0;
+		if (Format == PcmFormat::unsigned8)
+		{
+			const __m256i bias = _mm256_set1_epi32(128);
+			const __m256 scale = _mm256_set1_ps(scale8);
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+				_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v, bias)), scale));
+			}
+		}
+		else if (Format == PcmFormat::signed16)
+		{
+			const __m256 scale = _mm256_set1_ps(scale16);
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)));
+				_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+			}
+		}
+		else if (Format == PcmFormat::signed24)
+		{
+			//32バイト読むので末尾の3サンプル分はスカラーで
+			const __m256 scale = _mm256_set1_ps(scale32);
+			for (; i + 11 <= count; i += 8)
+			{
+				_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(load24x8(src + i * 3)), scale));
+			}
+		}
+		else if (Format == PcmFormat::signed32)
+		{
+			const __m256 scale = _mm256_set1_ps(scale32);
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+				_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+			}
+		}
+		else
+		{
+			memcpy(out, src, count * sizeof(float));
+			return;
+		}
+		decodeFloatScalar<Format>(src + i * getPcmSampleSize(Format), count - i, out + i);
+	}
+
+	template<PcmFormat Format>
+	PCM_AVX2_TARGET void decodeInt16Avx2(const unsigned char* src, size_t count, int16_t* out)
+	{
+		size_t i = 0;
+		if (Format == PcmFormat::unsigned8)
+		{
+			const __m256i bias = _mm256_set1_epi16(128);
+			for (; i + 16 <= count; i += 16)
+			{
+				const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_slli_epi16(_mm256_sub_epi16(v, bias), 8));
+			}
+		}
+		else if (Format == PcmFormat::signed16)
+		{
+			memcpy(out, src, count * sizeof(int16_t));
+			return;
+		}
+		else if (Format == PcmFormat::signed24)
+		{
+			for (; i + 19 <= count; i += 16)
+			{
+				const __m256i a = _mm256_srai_epi32(load24x8(src + i * 3), 16);
+				const __m256i b = _mm256_srai_epi32(load24x8(src + i * 3 + 24), 16);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packInt32x16(a, b));
+			}
+		}
+		else if (Format == PcmFormat::signed32)
+		{
+			for (; i + 16 <= count; i += 16)
+			{
+				const __m256i a = _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4)), 16);
+				const __m256i b = _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4 + 32)), 16);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packInt32x16(a, b));
+			}
+		}
+		else
+		{
+			const __m256 scale = _mm256_set1_ps(32768.0f);
+			const __m256 low = _mm256_set1_ps(-32768.0f);
+			const __m256 high = _mm256_set1_ps(32767.0f);
+			for (; i + 16 <= count; i += 16)
+			{
+				__m256 a = _mm256_loadu_ps(reinterpret_cast<const float*>(src + i * 4));
+				__m256 b = _mm256_loadu_ps(reinterpret_cast<const float*>(src + i * 4 + 32));
+				a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(a, scale), low), high);
+				b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(b, scale), low), high);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packInt32x16(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b)));
+			}
+		}
+		decodeInt16Scalar<Format>(src + i * getPcmSampleSize(Format), count - i, out + i);
+	}
+
+	bool hasAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!osxsave || (_xgetbv(0) & 6) != 6) { return false; }
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	struct PcmDecoders
+	{
+		DecodeFloat toFloat[5];
+		DecodeInt16 toInt16[5];
+	};
+
+	template<template<PcmFormat> class Table>
+	PcmDecoders makeDecoders()
+	{
+		return PcmDecoders{
+			{ Table<PcmFormat::unsigned8>::toFloat, Table<PcmFormat::signed16>::toFloat, Table<PcmFormat::signed24>::toFloat,
+				Table<PcmFormat::signed32>::toFloat, Table<PcmFormat::float32>::toFloat },
+			{ Table<PcmFormat::unsigned8>::toInt16, Table<PcmFormat::signed16>::toInt16, Table<PcmFormat::signed24>::toInt16,
+				Table<PcmFormat::signed32>::toInt16, Table<PcmFormat::float32>::toInt16 } };
+	}
+
+	template<PcmFormat Format>
+	struct ScalarTable
+	{
+		static constexpr DecodeFloat toFloat = &decodeFloatScalar<Format>;
+		static constexpr DecodeInt16 toInt16 = &decodeInt16Scalar<Format>;
+	};
+#ifdef PCM_CONVERSION_SSE2
+	template<PcmFormat Format>
+	struct Sse2Table
+	{
+		static constexpr DecodeFloat toFloat = &decodeFloatSse2<Format>;
+		static constexpr DecodeInt16 toInt16 = &decodeInt16Sse2<Format>;
+	};
+#endif
+#ifdef PCM_CONVERSION_AVX2
+	template<PcmFormat Format>
+	struct Avx2Table
+	{
+		static constexpr DecodeFloat toFloat = &decodeFloatAvx2<Format>;
+		static constexpr DecodeInt16 toInt16 = &decodeInt16Avx2<Format>;
+	};
+#endif
+
+	//使えない命令セットは1段下へ落とす
+	const PcmDecoders& getDecoders(PcmKernel kernel)
+	{
+		static const PcmDecoders scalar = makeDecoders<ScalarTable>();
+#ifdef PCM_CONVERSION_SSE2
+		static const PcmDecoders sse2 = makeDecoders<Sse2Table>();
+#endif
+#ifdef PCM_CONVERSION_AVX2
+		static const PcmDecoders avx2 = makeDecoders<Avx2Table>();
+		if (kernel == PcmKernel::avx2 && getPcmKernel() == PcmKernel::avx2) { return avx2; }
+#endif
+#ifdef PCM_CONVERSION_SSE2
+		if (kernel != PcmKernel::scalar) { return sse2; }
+#endif
+		(void)kernel;
+		return scalar;
+	}
+
+	//インターリーブされたfloatを各チャンネルへ
+	void splitChannels(const float* src, uint32_t channels, size_t frames, float* const* out, bool simd)
+	{
+#ifdef PCM_CONVERSION_SSE2
+		if (simd && channels == 2)
+		{
+			size_t i = 0;
+			for (; i + 4 <= frames; i += 4)
+			{
+				const __m128 a = _mm_loadu_ps(src + i * 2);
+				const __m128 b = _mm_loadu_ps(src + i * 2 + 4);
+				_mm_storeu_ps(out[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+				_mm_storeu_ps(out[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			}
+			for (; i < frames; i++)
+			{
+				out[0][i] = src[i * 2];
+				out[1][i] = src[i * 2 + 1];
+			}
+			return;
+		}
+#endif
+		(void)simd;
+		for (size_t i = 0; i < frames; i++)
+		{
+			for (uint32_t c = 0; c < channels; c++) { out[c][i] = src[i * channels + c]; }
+		}
+	}
+
+	void splitChannels(const int16_t* src, uint32_t channels, size_t frames, int16_t* const* out, bool simd)
+	{
+#ifdef PCM_CONVERSION_SSE2
+		if (simd && channels == 2)
+		{
+			size_t i = 0;
+			for (; i + 8 <= frames; i += 8)
+			{
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 8));
+				const __m128i leftA = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+				const __m128i leftB = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out[0] + i), _mm_packs_epi32(leftA, leftB));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out[1] + i), _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)));
+			}
+			for (; i < frames; i++)
+			{
+				out[0][i] = src[i * 2];
+				out[1][i] = src[i * 2 + 1];
+			}
+			return;
+		}
+#endif
+		(void)simd;
+		for (size_t i = 0; i < frames; i++)
+		{
+			for (uint32_t c = 0; c < channels; c++) { out[c][i] = src[i * channels + c]; }
+		}
+	}
+
+	void mixChannels(const float* src, uint32_t channels, size_t frames, float* out, bool simd)
+	{
+		const float scale = 1.0f / static_cast<float>(channels);
+		size_t i = 0;
+#ifdef PCM_CONVERSION_SSE2
+		if (simd && channels == 2)
+		{
+			const __m128 half = _mm_set1_ps(scale);
+			for (; i + 4 <= frames; i += 4)
+			{
+				const __m128 a = _mm_loadu_ps(src + i * 2);
+				const __m128 b = _mm_loadu_ps(src + i * 2 + 4);
+				const __m128 sum = _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+				_mm_storeu_ps(out + i, _mm_mul_ps(sum, half));
+			}
+		}
+#endif
+		(void)simd;
+		for (; i < frames; i++)
+		{
+			float sum = src[i * channels];
+			for (uint32_t c = 1; c < channels; c++) { sum += src[i * channels + c]; }
+			out[i] = sum * scale;
+		}
+	}
+
+	enum class PcmOutput { planar, mono };
+
+	//ブロックごとにデコードしてからチャンネルを振り分ける
+	template<class T, class Store>
+	void convertRange(const unsigned char* src, size_t sampleSize, uint32_t channels, size_t frames,
+		void(*decode)(const unsigned char*, size_t, T*), Store store)
+	{
+		const size_t blockFrames = channels < 4096 ? 4096 / channels : 1;
+		std::vector<T> buffer(blockFrames * channels);
+		for (size_t first = 0; first < frames; first += blockFrames)
+		{
+			const size_t count = frames - first < blockFrames ? frames - first : blockFrames;
+			decode(src + first * channels * sampleSize, count * channels, buffer.data());
+			store(buffer.data(), first, count);
+		}
+	}
+
+	template<class T>
+	void convertPlanar(const void* src, PcmFormat format, uint32_t channels, size_t frames, T* const* out,
+		void(*decode)(const unsigned char*, size_t, T*), bool simd)
+	{
+		const size_t sampleSize = getPcmSampleSize(format);
+		const size_t frameSize = sampleSize * channels;
+		//大きな入力はフレーム単位で分けて全コアで変換する
+		parallelForRanges(frames, size_t(1) << 16, [&](size_t begin, size_t end, size_t)
+			{
+				const unsigned char* bytes = static_cast<const unsigned char*>(src) + begin * frameSize;
+				if (channels == 1)
+				{
+					decode(bytes, end - begin, out[0] + begin);
+					return;
+				}
+				std::vector<T*> channelOut(channels);
+				convertRange<T>(bytes, sampleSize, channels, end - begin, decode, [&](const T* block, size_t first, size_t count)
+					{
+						for (uint32_t c = 0; c < channels; c++) { channelOut[c] = out[c] + begin + first; }
+						splitChannels(block, channels, count, channelOut.data(), simd);
+					});
+			});
+	}
+}
+
+size_t getPcmSampleSize(PcmFormat format)
+{
+	switch (format)
+	{
+	case PcmFormat::unsigned8: return 1;
+	case PcmFormat::signed16: return 2;
+	case PcmFormat::signed24: return 3;
+	default: return 4;
+	}
+}
+
+PcmKernel getPcmKernel()
+{
+#if defined(PCM_CONVERSION_AVX2)
+	static const PcmKernel kernel = detail::hasAvx2() ? PcmKernel::avx2 : PcmKernel::sse2;
+	return kernel;
+#elif defined(PCM_CONVERSION_SSE2)
+	return PcmKernel::sse2;
+#else
+	return PcmKernel::scalar;
+#endif
+}
+
+void convertPcm(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* const* out, PcmKernel kernel)
+{
+	if (channels == 0) { return; }
+	const detail::DecodeFloat decode = detail::getDecoders(kernel).toFloat[static_cast<int>(format)];
+	detail::convertPlanar<float>(src, format, channels, frames, out, decode, kernel != PcmKernel::scalar);
+}
+
+void convertPcm(const void* src, PcmFormat format, uint32_t channels, size_t frames, int16_t* const* out, PcmKernel kernel)
+{
+	if (channels == 0) { return; }
+	const detail::DecodeInt16 decode = detail::getDecoders(kernel).toInt16[static_cast<int>(format)];
+	detail::convertPlanar<int16_t>(src, format, channels, frames, out, decode, kernel != PcmKernel::scalar);
+}
+
+void convertPcmMono(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* out, PcmKernel kernel)
+{
+	if (channels == 0) { return; }
+	const detail::DecodeFloat decode = detail::getDecoders(kernel).toFloat[static_cast<int>(format)];
+	const bool simd = kernel != PcmKernel::scalar;
+	const size_t sampleSize = getPcmSampleSize(format);
+	parallelForRanges(frames, size_t(1) << 16, [&](size_t begin, size_t end, size_t)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(src) + begin * sampleSize * channels;
+			if (channels == 1)
+			{
+				decode(bytes, end - begin, out + begin);
+				return;
+			}
+			detail::convertRange<float>(bytes, sampleSize, channels, end - begin, decode, [&](const float* block, size_t first, size_t count)
+				{
+					detail::mixChannels(block, channels, count, out + begin + first, simd);
+				});
+		});
+}
+
+void convertPcmReference(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* const* out)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(src);
+	const size_t sampleSize = getPcmSampleSize(format);
+	for (size_t i = 0; i < frames; i++)
+	{
+		for (uint32_t c = 0; c < channels; c++) { out[c][i] = detail::decodeFloat(format, bytes + (i * channels + c) * sampleSize); }
+	}
+}
+
+void convertPcmReference(const void* src, PcmFormat format, uint32_t channels, size_t frames, int16_t* const* out)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(src);
+	const size_t sampleSize = getPcmSampleSize(format);
+	for (size_t i = 0; i < frames; i++)
+	{
+		for (uint32_t c = 0; c < channels; c++) { out[c][i] = detail::decodeInt16(format, bytes + (i * channels + c) * sampleSize); }
+	}
+}
+
+void convertPcmMonoReference(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* out)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(src);
+	const size_t sampleSize = getPcmSampleSize(format);
+	const float scale = 1.0f / static_cast<float>(channels);
+	for (size_t i = 0; i < frames; i++)
+	{
+		float sum = detail::decodeFloat(format, bytes + i * channels * sampleSize);
+		for (uint32_t c = 1; c < channels; c++) { sum += detail::decodeFloat(format, bytes + (i * channels + c) * sampleSize); }
+		out[i] = sum * scale;
+	}
+}
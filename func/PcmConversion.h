@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************
+	Interleaved PCM to float / int16.
+	Input formats: unsigned 8-bit, signed 16-bit, packed 24-bit,
+	signed 32-bit and 32-bit float, little endian as in WAV.
+	Output is planar (one array per channel) or a mono mix that
+	averages the channels. Float output is normalized to [-1, 1):
+	integer samples are scaled by 2^-(bits - 1), so it is exact.
+	Int16 output keeps the top 16 bits of integer samples and
+	rounds float samples to nearest even after clamping, NaN -> -32768.
+	The SSE2 and AVX2 kernels give bit-identical results to the
+	scalar reference; AVX2 is chosen at run time when the CPU has it.
+	Inputs over 64K frames are split across all cores.
+****************************************************************/
+
+enum class PcmFormat { unsigned8, signed16, signed24, signed32, float32 };
+
+enum class PcmKernel { scalar, sse2, avx2 };
+
+size_t getPcmSampleSize(PcmFormat format);
+
+// Best kernel this CPU supports.
+PcmKernel getPcmKernel();
+
+// out[c] receives frames samples of channel c.
+void convertPcm(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* const* out, PcmKernel kernel = getPcmKernel());
+void convertPcm(const void* src, PcmFormat format, uint32_t channels, size_t frames, int16_t* const* out, PcmKernel kernel = getPcmKernel());
+// out[i] = (channel 0 + channel 1 + ...) * (1 / channels), summed in channel order.
+void convertPcmMono(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* out, PcmKernel kernel = getPcmKernel());
+
+// Plain per-sample loops on one thread, for comparison.
+void convertPcmReference(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* const* out);
+void convertPcmReference(const void* src, PcmFormat format, uint32_t channels, size_t frames, int16_t* const* out);
+void convertPcmMonoReference(const void* src, PcmFormat format, uint32_t channels, size_t frames, float* out);
@@ -0,0 +1,177 @@
+﻿#include "RealFft.h"
+#include <assert.h>
+#include <math.h>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define REAL_FFT_SSE2
+#endif
+
+namespace detail
+{
+	constexpr double pi = 3.14159265358979323846;
+
+	//複素数長さの後半と前半を足し引きする (長さ2 * halfの1段)
+	void butterflyPass(float* re, float* im, size_t count, size_t half, const float* wRe, const float* wIm)
+	{
+		for (size_t start = 0; start < count; start += half * 2)
+		{
+			float* lowRe = re + start;
+			float* lowIm = im + start;
+			float* highRe = lowRe + half;
+			float* highIm = lowIm + half;
+			size_t j = 0;
+#ifdef REAL_FFT_SSE2
+			for (; j + 4 <= half; j += 4)
+			{
+				const __m128 ur = _mm_loadu_ps(highRe + j);
+				const __m128 ui = _mm_loadu_ps(highIm + j);
+				const __m128 wr = _mm_loadu_ps(wRe + j);
+				const __m128 wi = _mm_loadu_ps(wIm + j);
+				const __m128 tr = _mm_sub_ps(_mm_mul_ps(ur, wr), _mm_mul_ps(ui, wi));
+				const __m128 ti = _mm_add_ps(_mm_mul_ps(ur, wi), _mm_mul_ps(ui, wr));
+				const __m128 lr = _mm_loadu_ps(lowRe + j);
+				const __m128 li = _mm_loadu_ps(lowIm + j);
+				_mm_storeu_ps(lowRe + j, _mm_add_ps(lr, tr));
+				_mm_storeu_ps(lowIm + j, _mm_add_ps(li, ti));
+				_mm_storeu_ps(highRe + j, _mm_sub_ps(lr, tr));
+				_mm_storeu_ps(highIm + j, _mm_sub_ps(li, ti));
+			}
+#endif
+			for (; j < half; j++)
+			{
+				const float tr = highRe[j] * wRe[j] - highIm[j] * wIm[j];
+				const float ti = highRe[j] * wIm[j] + highIm[j] * wRe[j];
+				const float lr = lowRe[j];
+				const float li = lowIm[j];
+				lowRe[j] = lr + tr;
+				lowIm[j] = li + ti;
+				highRe[j] = lr - tr;
+				highIm[j] = li - ti;
+			}
+		}
+	}
+}
+
+void RealFft::init(size_t size)
+{
+	assert(size >= 8 && (size & (size - 1)) == 0 && "The size must be a power of two of at least 8.");
+	this->size = size;
+	const size_t count = size / 2;
+	uint32_t bits = 0;
+	while ((size_t(1) << bits) < count) { bits++; }
+	bitReverse.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t reversed = 0;
+		for (uint32_t b = 0; b < bits; b++) { reversed |= ((i >> b) & 1) << (bits - 1 - b); }
+		bitReverse[i] = reversed;
+	}
+	twiddleRe.resize(count - 1);
+	twiddleIm.resize(count - 1);
+	for (size_t half = 1; half < count; half *= 2)
+	{
+		for (size_t j = 0; j < half; j++)
+		{
+			const double angle = -detail::pi * static_cast<double>(j) / static_cast<double>(half);
+			twiddleRe[half - 1 + j] = static_cast<float>(cos(angle));
+			twiddleIm[half - 1 + j] = static_cast<float>(sin(angle));
+		}
+	}
+	splitRe.resize(size / 4 + 1);
+	splitIm.resize(size / 4 + 1);
+	for (size_t k = 0; k <= size / 4; k++)
+	{
+		const double angle = -2.0 * detail::pi * static_cast<double>(k) / static_cast<double>(size);
+		splitRe[k] = static_cast<float>(cos(angle));
+		splitIm[k] = static_cast<float>(sin(angle));
+	}
+}
+
+void RealFft::transform(float* re, float* im)const
+{
+	const size_t count = size / 2;
+	//最初の2段は回転因子が1と-iだけなので基数4でまとめる
+	for (size_t i = 0; i < count; i += 4)
+	{
+		const float a0r = re[i] + re[i + 1], a0i = im[i] + im[i + 1];
+		const float a1r = re[i] - re[i + 1], a1i = im[i] - im[i + 1];
+		const float a2r = re[i + 2] + re[i + 3], a2i = im[i + 2] + im[i + 3];
+		const float a3r = re[i + 2] - re[i + 3], a3i = im[i + 2] - im[i + 3];
+		re[i] = a0r + a2r; im[i] = a0i + a2i;
+		re[i + 2] = a0r - a2r; im[i + 2] = a0i - a2i;
+		re[i + 1] = a1r + a3i; im[i + 1] = a1i - a3r;
+		re[i + 3] = a1r - a3i; im[i + 3] = a1i + a3r;
+	}
+	for (size_t half = 4; half < count; half *= 2)
+	{
+		detail::butterflyPass(re, im, count, half, twiddleRe.data() + half - 1, twiddleIm.data() + half - 1);
+	}
+}
+
+void RealFft::forward(const float* input, float* re, float* im)const
+{
+	assert(size > 0 && "The FFT is not initialized.");
+	const size_t count = size / 2;
+	//偶数番目を実部, 奇数番目を虚部としてn / 2点の複素FFTにする
+	for (size_t i = 0; i < count; i++)
+	{
+		re[bitReverse[i]] = input[i * 2];
+		im[bitReverse[i]] = input[i * 2 + 1];
+	}
+	transform(re, im);
+
+	//Z[k]とZ[n/2 - k]から実信号のX[k]とX[n/2 - k]を求める
+	const float z0r = re[0];
+	const float z0i = im[0];
+	re[0] = z0r + z0i;
+	im[0] = 0.0f;
+	re[count] = z0r - z0i;
+	im[count] = 0.0f;
+	for (size_t k = 1; k <= count / 2; k++)
+	{
+		const size_t m = count - k;
+		const float evenRe = (re[k] + re[m]) * 0.5f;
+		const float evenIm = (im[k] - im[m]) * 0.5f;
+		const float oddRe = (im[k] + im[m]) * 0.5f;
+		const float oddIm = (re[m] - re[k]) * 0.5f;
+		const float tr = oddRe * splitRe[k] - oddIm * splitIm[k];
+		const float ti = oddRe * splitIm[k] + oddIm * splitRe[k];
+		re[k] = evenRe + tr;
+		im[k] = evenIm + ti;
+		re[m] = evenRe - tr;
+		im[m] = ti - evenIm;
+	}
+}
+
+void dftReference(const float* input, size_t size, double* re, double* im)
+{
+	for (size_t k = 0; k <= size / 2; k++)
+	{
+		double sumRe = 0.0;
+		double sumIm = 0.0;
+		for (size_t t = 0; t < size; t++)
+		{
+			//k * tはsizeで割った余りにして角度の誤差を抑える
+			const double angle = -2.0 * detail::pi * static_cast<double>((k * t) % size) / static_cast<double>(size);
+			sumRe += input[t] * cos(angle);
+			sumIm += input[t] * sin(angle);
+		}
+		re[k] = sumRe;
+		im[k] = sumIm;
+	}
+}
+
+double makeFftWindow(FftWindow window, size_t size, float* out)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < size; i++)
+	{
+		const double phase = 2.0 * detail::pi * static_cast<double>(i) / static_cast<double>(size);
+		double value = 1.0;
+		if (window == FftWindow::hann) { value = 0.5 - 0.5 * cos(phase); }
+		else if (window == FftWindow::blackman) { value = 0.42 - 0.5 * cos(phase) + 0.08 * cos(phase * 2.0); }
+		out[i] = static_cast<float>(value);
+		sum += out[i];
+	}
+	return sum;
+}
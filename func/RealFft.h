@@ -0,0 +1,43 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/****************************************************************
+	FFT of a real signal of n = 2^k samples (n >= 8).
+	The n reals are packed into n / 2 complex values, transformed by
+	a radix-4 first pass and radix-2 passes (SSE2 from the third pass
+	on), then split into the n / 2 + 1 bins of the real spectrum:
+		X[k] = sum x[t] * e^(-2 pi i k t / n)
+	Tables are built by init; forward only reads them, so one
+	RealFft can serve several threads.
+	dftReference is the naive O(n^2) sum in double for comparison.
+****************************************************************/
+class RealFft
+{
+private:
+	size_t size = 0;
+	std::vector<uint32_t> bitReverse;		// n / 2
+	// Complex pass twiddles, pass of length 2h at offset h - 1.
+	std::vector<float> twiddleRe;
+	std::vector<float> twiddleIm;
+	// e^(-2 pi i k / n), k <= n / 4, for the real split.
+	std::vector<float> splitRe;
+	std::vector<float> splitIm;
+
+	void transform(float* re, float* im)const;
+public:
+	void init(size_t size);
+	size_t getSize()const { return size; }
+	size_t getBinCount()const { return size / 2 + 1; }
+
+	// re and im receive getBinCount() values each and may not alias input.
+	void forward(const float* input, float* re, float* im)const;
+};
+
+void dftReference(const float* input, size_t size, double* re, double* im);
+
+enum class FftWindow { rectangle, hann, blackman };
+
+// Periodic window of size samples; returns the sum of the coefficients.
+double makeFftWindow(FftWindow window, size_t size, float* out);
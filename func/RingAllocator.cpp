@@ -0,0 +1,55 @@
+﻿#include "RingAllocator.h"
+#include <assert.h>
+
+void RingAllocator::create(size_t newCapacity, size_t newAlignment)
+{
+	assert(newAlignment > 0 && (newAlignment & (newAlignment - 1)) == 0 && "The alignment must be a power of two.");
+	capacity = newCapacity;
+	alignment = newAlignment;
+	reset();
+}
+
+size_t RingAllocator::allocate(size_t size)
+{
+	if (size == 0 || size > capacity) { return invalidOffset; }
+	if (used == 0) { head = 0; }
+	size_t offset = (head + alignment - 1) & ~(alignment - 1);
+	size_t padding = offset - head;
+	//末尾に収まらなければ先頭へ折り返し、残りは詰め物として扱う
+	if (offset + size > capacity)
+	{
+		offset = 0;
+		padding = capacity - head;
+	}
+	//使用中の領域 (tail = head - used) を追い越さないか
+	if (used + padding + size > capacity) { return invalidOffset; }
+	used += padding + size;
+	frameBytes += padding + size;
+	head = offset + size;
+	if (head == capacity) { head = 0; }
+	return offset;
+}
+
+void RingAllocator::endFrame(uint64_t fence)
+{
+	assert((frames.empty() || frames.back().fence <= fence) && "Fences must not decrease.");
+	frames.push_back(Frame{ fence, frameBytes });
+	frameBytes = 0;
+}
+
+void RingAllocator::retire(uint64_t completedFence)
+{
+	while (!frames.empty() && frames.front().fence <= completedFence)
+	{
+		used -= frames.front().bytes;
+		frames.pop_front();
+	}
+}
+
+void RingAllocator::reset()
+{
+	head = 0;
+	used = 0;
+	frameBytes = 0;
+	frames.clear();
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+
+/****************************************************************
+	Linear allocator over a ring of capacity bytes, fenced per
+	frame. Allocations of the current frame are appended at aligned
+	offsets; endFrame tags them with a fence value and retire frees
+	every frame whose fence the GPU has passed. When the space ahead
+	is still held by frames in flight, allocate fails and the caller
+	can discard the whole buffer (reset) instead of waiting.
+	Holds no GPU objects, so it runs headless.
+****************************************************************/
+class RingAllocator
+{
+public:
+	static constexpr size_t invalidOffset = ~size_t(0);
+private:
+	struct Frame
+	{
+		uint64_t fence;
+		size_t bytes;				// allocations + alignment padding
+	};
+	size_t capacity = 0;
+	size_t alignment = 256;
+	size_t head = 0;				// next free byte
+	size_t used = 0;				// bytes held by the current and in flight frames
+	size_t frameBytes = 0;
+	std::deque<Frame> frames;
+public:
+	RingAllocator() = default;
+	RingAllocator(size_t capacity, size_t alignment = 256) { create(capacity, alignment); }
+
+	// alignment must be a power of two.
+	void create(size_t capacity, size_t alignment = 256);
+	// Returns the offset, or invalidOffset if the ring is full.
+	size_t allocate(size_t size);
+	void endFrame(uint64_t fence);
+	// Frees the frames with fence <= completedFence.
+	void retire(uint64_t completedFence);
+	// Forgets every allocation (the buffer was discarded).
+	void reset();
+
+	size_t getCapacity()const { return capacity; }
+	size_t getUsed()const { return used; }
+	size_t getHead()const { return head; }
+	size_t getFramesInFlight()const { return frames.size(); }
+};
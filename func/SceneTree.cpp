@@ -0,0 +1,415 @@
+﻿#include "SceneTree.h"
+#include "ParallelFor.h"
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SCENE_TREE_SSE2
+#endif
+
+namespace detail
+{
+	inline SceneAabb combine(const SceneAabb& a, const SceneAabb& b)
+	{
+		SceneAabb result;
+		for (int k = 0; k < 3; k++)
+		{
+			result.min[k] = std::min(a.min[k], b.min[k]);
+			result.max[k] = std::max(a.max[k], b.max[k]);
+		}
+		return result;
+	}
+
+	inline float perimeter(const SceneAabb& box)
+	{
+		const float x = box.max[0] - box.min[0];
+		const float y = box.max[1] - box.min[1];
+		const float z = box.max[2] - box.min[2];
+		return x * y + y * z + z * x;
+	}
+
+	inline bool contains(const SceneAabb& outer, const SceneAabb& inner)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			if (inner.min[k] < outer.min[k] || inner.max[k] > outer.max[k]) { return false; }
+		}
+		return true;
+	}
+
+	enum class Containment { outside, intersecting, inside };
+
+	/****************************************************************
+		Planes in structure of arrays form, padded to 8 with planes
+		that contain everything.
+	****************************************************************/
+	struct FrustumSoA
+	{
+		float x[8], y[8], z[8], w[8];
+		float absX[8], absY[8], absZ[8];
+
+		explicit FrustumSoA(const float planes[6][4])
+		{
+			for (int p = 0; p < 8; p++)
+			{
+				x[p] = p < 6 ? planes[p][0] : 0.0f;
+				y[p] = p < 6 ? planes[p][1] : 0.0f;
+				z[p] = p < 6 ? planes[p][2] : 0.0f;
+				w[p] = p < 6 ? planes[p][3] : 1.0f;
+				absX[p] = fabsf(x[p]);
+				absY[p] = fabsf(y[p]);
+				absZ[p] = fabsf(z[p]);
+			}
+		}
+
+		Containment classify(const SceneAabb& box)const
+		{
+			const float cx = (box.min[0] + box.max[0]) * 0.5f, ex = (box.max[0] - box.min[0]) * 0.5f;
+			const float cy = (box.min[1] + box.max[1]) * 0.5f, ey = (box.max[1] - box.min[1]) * 0.5f;
+			const float cz = (box.min[2] + box.max[2]) * 0.5f, ez = (box.max[2] - box.min[2]) * 0.5f;
+#ifdef SCENE_TREE_SSE2
+			int outside = 0, partial = 0;
+			for (int g = 0; g < 8; g += 4)
+			{
+				const __m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(x + g), _mm_set1_ps(cx)), _mm_mul_ps(_mm_loadu_ps(y + g), _mm_set1_ps(cy))),
+					_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(z + g), _mm_set1_ps(cz)), _mm_loadu_ps(w + g)));
+				const __m128 radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(absX + g), _mm_set1_ps(ex)), _mm_mul_ps(_mm_loadu_ps(absY + g), _mm_set1_ps(ey))),
+					_mm_mul_ps(_mm_loadu_ps(absZ + g), _mm_set1_ps(ez)));
+				outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)));
+				partial |= _mm_movemask_ps(_mm_cmplt_ps(distance, radius));
+			}
+			if (outside) { return Containment::outside; }
+			return partial ? Containment::intersecting : Containment::inside;
+#else
+			bool partial = false;
+			for (int p = 0; p < 6; p++)
+			{
+				const float distance = x[p] * cx + y[p] * cy + z[p] * cz + w[p];
+				const float radius = absX[p] * ex + absY[p] * ey + absZ[p] * ez;
+				if (distance < -radius) { return Containment::outside; }
+				partial |= distance < radius;
+			}
+			return partial ? Containment::intersecting : Containment::inside;
+#endif
+		}
+	};
+
+	struct QueryNode
+	{
+		int node;
+		bool inside;
+	};
+}
+
+int SceneTree::allocateNode()
+{
+	if (freeList < 0)
+	{
+		nodes.push_back(Node{});
+		freeList = static_cast<int>(nodes.size()) - 1;
+		nodes[freeList].parent = -1;
+	}
+	const int node = freeList;
+	freeList = nodes[node].parent;
+	nodes[node].parent = -1;
+	nodes[node].child1 = -1;
+	nodes[node].child2 = -1;
+	nodes[node].height = 0;
+	nodes[node].userData = 0;
+	return node;
+}
+
+void SceneTree::freeNode(int node)
+{
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void SceneTree::refit(int node)
+{
+	Node& n = nodes[node];
+	n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+	n.box = detail::combine(nodes[n.child1].box, nodes[n.child2].box);
+}
+
+void SceneTree::insertLeaf(int leaf)
+{
+	if (root < 0)
+	{
+		root = leaf;
+		nodes[root].parent = -1;
+		return;
+	}
+	//表面積が最も増えない兄弟を探す
+	const SceneAabb box = nodes[leaf].box;
+	int index = root;
+	while (nodes[index].height > 0)
+	{
+		const Node& node = nodes[index];
+		const float area = detail::perimeter(node.box);
+		const float combinedArea = detail::perimeter(detail::combine(node.box, box));
+		const float cost = 2.0f * combinedArea;
+		const float inheritance = 2.0f * (combinedArea - area);
+		float childCost[2];
+		const int children[2] = { node.child1,node.child2 };
+		for (int i = 0; i < 2; i++)
+		{
+			const Node& child = nodes[children[i]];
+			const float enlarged = detail::perimeter(detail::combine(box, child.box));
+			childCost[i] = (child.height == 0 ? enlarged : enlarged - detail::perimeter(child.box)) + inheritance;
+		}
+		if (cost < childCost[0] && cost < childCost[1]) { break; }
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	const int sibling = index;
+	const int oldParent = nodes[sibling].parent;
+	const int newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = detail::combine(box, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if (oldParent < 0) { root = newParent; }
+	else if (nodes[oldParent].child1 == sibling) { nodes[oldParent].child1 = newParent; }
+	else { nodes[oldParent].child2 = newParent; }
+
+	for (index = nodes[leaf].parent; index >= 0; index = nodes[index].parent)
+	{
+		index = balance(index);
+		refit(index);
+	}
+}
+
+void SceneTree::removeLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = -1;
+		return;
+	}
+	const int parent = nodes[leaf].parent;
+	const int grandParent = nodes[parent].parent;
+	const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+	nodes[sibling].parent = grandParent;
+	freeNode(parent);
+	if (grandParent < 0)
+	{
+		root = sibling;
+		return;
+	}
+	if (nodes[grandParent].child1 == parent) { nodes[grandParent].child1 = sibling; }
+	else { nodes[grandParent].child2 = sibling; }
+	for (int index = grandParent; index >= 0; index = nodes[index].parent)
+	{
+		index = balance(index);
+		refit(index);
+	}
+}
+
+//高さの差が2以上なら子を持ち上げる(AVL回転)
+int SceneTree::balance(int a)
+{
+	if (nodes[a].height < 2) { return a; }
+	const int b = nodes[a].child1;
+	const int c = nodes[a].child2;
+	const int difference = nodes[c].height - nodes[b].height;
+	if (difference >= -1 && difference <= 1) { return a; }
+
+	//背の高い方の子upをaの位置へ持ち上げる
+	const bool liftC = difference > 1;
+	const int up = liftC ? c : b;
+	const int f = nodes[up].child1;
+	const int g = nodes[up].child2;
+
+	nodes[up].child1 = a;
+	nodes[up].parent = nodes[a].parent;
+	nodes[a].parent = up;
+	if (nodes[up].parent < 0) { root = up; }
+	else if (nodes[nodes[up].parent].child1 == a) { nodes[nodes[up].parent].child1 = up; }
+	else { nodes[nodes[up].parent].child2 = up; }
+
+	//高い方の孫をupに残し、低い方をaへ移す
+	const int high = nodes[f].height > nodes[g].height ? f : g;
+	const int low = high == f ? g : f;
+	nodes[up].child2 = high;
+	if (liftC) { nodes[a].child2 = low; }
+	else { nodes[a].child1 = low; }
+	nodes[low].parent = a;
+	refit(a);
+	refit(up);
+	return up;
+}
+
+int SceneTree::insert(const SceneAabb& box, unsigned int userData)
+{
+	const int proxy = allocateNode();
+	for (int k = 0; k < 3; k++)
+	{
+		nodes[proxy].box.min[k] = box.min[k] - margin;
+		nodes[proxy].box.max[k] = box.max[k] + margin;
+	}
+	nodes[proxy].userData = userData;
+	insertLeaf(proxy);
+	objectCount++;
+	return proxy;
+}
+
+void SceneTree::remove(int proxy)
+{
+	assert(proxy >= 0 && proxy < static_cast<int>(nodes.size()) && nodes[proxy].height == 0 && "The proxy is invalid.");
+	removeLeaf(proxy);
+	freeNode(proxy);
+	objectCount--;
+}
+
+bool SceneTree::update(int proxy, const SceneAabb& box)
+{
+	assert(proxy >= 0 && proxy < static_cast<int>(nodes.size()) && nodes[proxy].height == 0 && "The proxy is invalid.");
+	if (detail::contains(nodes[proxy].box, box)) { return false; }
+	removeLeaf(proxy);
+	for (int k = 0; k < 3; k++)
+	{
+		nodes[proxy].box.min[k] = box.min[k] - margin;
+		nodes[proxy].box.max[k] = box.max[k] + margin;
+	}
+	insertLeaf(proxy);
+	return true;
+}
+
+void SceneTree::clear()
+{
+	nodes.clear();
+	root = -1;
+	freeList = -1;
+	objectCount = 0;
+}
+
+size_t SceneTree::querySerial(const float planes[6][4], std::vector<unsigned int>& outVisible)const
+{
+	if (root < 0) { return 0; }
+	const detail::FrustumSoA frustum(planes);
+	const size_t first = outVisible.size();
+	std::vector<detail::QueryNode> stack;
+	stack.reserve(64);
+	stack.push_back({ root,false });
+	while (!stack.empty())
+	{
+		const detail::QueryNode entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry.node];
+		bool inside = entry.inside;
+		if (!inside)
+		{
+			const detail::Containment containment = frustum.classify(node.box);
+			if (containment == detail::Containment::outside) { continue; }
+			inside = containment == detail::Containment::inside;
+		}
+		if (node.height == 0)
+		{
+			outVisible.push_back(node.userData);
+			continue;
+		}
+		stack.push_back({ node.child2,inside });
+		stack.push_back({ node.child1,inside });
+	}
+	return outVisible.size() - first;
+}
+
+size_t SceneTree::query(const float planes[6][4], std::vector<unsigned int>& outVisible)const
+{
+	constexpr size_t parallelThreshold = 16384;
+	const size_t workerCount = getWorkerCount();
+	if (root < 0 || objectCount < parallelThreshold || workerCount <= 1)
+	{
+		return querySerial(planes, outVisible);
+	}
+
+	//上位の階層を幅優先で分割し、部分木を並列に走査する
+	const detail::FrustumSoA frustum(planes);
+	std::vector<detail::QueryNode> tasks{ { root,false } };
+	std::vector<detail::QueryNode> next;
+	const size_t targetTaskCount = workerCount * 8;
+	while (tasks.size() < targetTaskCount)
+	{
+		next.clear();
+		bool split = false;
+		for (const detail::QueryNode& task : tasks)
+		{
+			const Node& node = nodes[task.node];
+			if (task.inside || node.height == 0)
+			{
+				next.push_back(task);
+				continue;
+			}
+			const detail::Containment containment = frustum.classify(node.box);
+			if (containment == detail::Containment::outside) { continue; }
+			if (containment == detail::Containment::inside)
+			{
+				next.push_back({ task.node,true });
+				continue;
+			}
+			next.push_back({ node.child1,false });
+			next.push_back({ node.child2,false });
+			split = true;
+		}
+		tasks.swap(next);
+		if (!split) { break; }
+	}
+
+	std::vector<std::vector<unsigned int>> results(workerCount);
+	const size_t rangeCount = parallelForRanges(tasks.size(), 1, [&](size_t begin, size_t end, size_t range)
+		{
+			std::vector<unsigned int>& result = results[range];
+			std::vector<detail::QueryNode> stack;
+			for (size_t t = begin; t < end; t++)
+			{
+				stack.push_back(tasks[t]);
+				while (!stack.empty())
+				{
+					const detail::QueryNode entry = stack.back();
+					stack.pop_back();
+					const Node& node = nodes[entry.node];
+					bool inside = entry.inside;
+					if (!inside)
+					{
+						const detail::Containment containment = frustum.classify(node.box);
+						if (containment == detail::Containment::outside) { continue; }
+						inside = containment == detail::Containment::inside;
+					}
+					if (node.height == 0)
+					{
+						result.push_back(node.userData);
+						continue;
+					}
+					stack.push_back({ node.child2,inside });
+					stack.push_back({ node.child1,inside });
+				}
+			}
+		});
+	size_t total = 0;
+	for (size_t r = 0; r < rangeCount; r++) { total += results[r].size(); }
+	outVisible.reserve(outVisible.size() + total);
+	for (size_t r = 0; r < rangeCount; r++) { outVisible.insert(outVisible.end(), results[r].begin(), results[r].end()); }
+	return total;
+}
+
+SceneAabb transformBoundingSphere(const float sphere[4], const float world[16])
+{
+	SceneAabb box;
+	for (int k = 0; k < 3; k++)
+	{
+		const float center = sphere[0] * world[k] + sphere[1] * world[4 + k] + sphere[2] * world[8 + k] + world[12 + k];
+		//楕円体の軸方向の広がりは列ベクトルの長さに比例する
+		const float extent = sphere[3] * sqrtf(world[k] * world[k] + world[4 + k] * world[4 + k] + world[8 + k] * world[8 + k]);
+		box.min[k] = center - extent;
+		box.max[k] = center + extent;
+	}
+	return box;
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <stddef.h>
+#include <vector>
+
+struct SceneAabb
+{
+	float min[3];
+	float max[3];
+};
+
+/****************************************************************
+	Dynamic AABB tree over object bounds.
+	Leaves store a fattened box, so objects that move a little stay
+	in place. Leaving the fat box removes and reinserts the leaf
+	(surface area heuristic) and refits only its ancestors.
+	Subtrees are kept balanced by rotations.
+	Proxy ids stay valid until remove.
+****************************************************************/
+class SceneTree
+{
+private:
+	struct Node
+	{
+		SceneAabb box;
+		int parent;			// next free node while unused
+		int child1;
+		int child2;
+		int height;			// 0 = leaf, -1 = free
+		unsigned int userData;
+	};
+	std::vector<Node> nodes;
+	int root = -1;
+	int freeList = -1;
+	size_t objectCount = 0;
+	float margin;
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	void refit(int node);
+	int balance(int node);
+public:
+	// margin fattens every leaf box on all sides (world units).
+	explicit SceneTree(float margin = 0.1f) :margin(margin) {}
+
+	int insert(const SceneAabb& box, unsigned int userData);
+	void remove(int proxy);
+	// Returns true when the proxy had to be reinserted.
+	bool update(int proxy, const SceneAabb& box);
+	void clear();
+
+	unsigned int getUserData(int proxy)const { return nodes[proxy].userData; }
+	const SceneAabb& getFatBox(int proxy)const { return nodes[proxy].box; }
+	size_t getObjectCount()const { return objectCount; }
+	int getHeight()const { return root < 0 ? 0 : nodes[root].height; }
+
+	/****************************************************************
+		Append the userData of every object whose fat box touches the
+		frustum (planes from extractFrustumPlanes). Subtrees fully
+		inside are appended without further tests. Large trees are
+		split into subtrees and traversed on every core.
+		Returns the number of objects appended.
+	****************************************************************/
+	size_t query(const float planes[6][4], std::vector<unsigned int>& outVisible)const;
+	size_t querySerial(const float planes[6][4], std::vector<unsigned int>& outVisible)const;
+};
+
+/****************************************************************
+	World AABB of a bounding sphere (center xyz, radius w) under a
+	row-vector world matrix (DirectXMath layout).
+****************************************************************/
+SceneAabb transformBoundingSphere(const float sphere[4], const float world[16]);
@@ -0,0 +1,46 @@
+﻿#include "ScrollingBake.h"
+
+void ScrollingBake::reset(uint32_t width)
+{
+	this->width = width;
+	firstColumn = 0;
+	valid = false;
+}
+
+uint32_t ScrollingBake::split(int64_t begin, int64_t end, ScrollColumns* out)const
+{
+	uint32_t count = 0;
+	while (begin < end)
+	{
+		const int64_t wrap = floorDivide(begin, width);
+		const int64_t wrapEnd = (wrap + 1) * width;
+		const int64_t runEnd = end < wrapEnd ? end : wrapEnd;
+		out[count].x = static_cast<uint32_t>(begin - wrap * width);
+		out[count].width = static_cast<uint32_t>(runEnd - begin);
+		out[count].wrap = wrap;
+		count++;
+		begin = runEnd;
+	}
+	return count;
+}
+
+uint32_t ScrollingBake::scroll(int64_t column, ScrollColumns* out)
+{
+	if (width == 0) { return 0; }
+	const int64_t previous = firstColumn;
+	const bool wasValid = valid;
+	firstColumn = column;
+	valid = true;
+	const int64_t w = width;
+	//離れすぎたら全体を描き直す
+	if (!wasValid || column >= previous + w || column <= previous - w) { return split(column, column + w, out); }
+	//右へ進んだら右端に, 戻ったら左端に出てきた列だけ
+	if (column > previous) { return split(previous + w, column + w, out); }
+	return split(column, previous, out);
+}
+
+uint32_t ScrollingBake::getWrapOffset()const
+{
+	if (width == 0) { return 0; }
+	return static_cast<uint32_t>(firstColumn - floorDivide(firstColumn, width) * width);
+}
@@ -0,0 +1,54 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************
+	Columns of a layer that is used as a circular buffer.
+	Absolute column a (time a / columnsPerSecond) is kept at
+	physical column a mod width. When the view scrolls, only the
+	columns that came into view are rendered, and the compositor
+	shifts its texcoord.x by getTexcoordOffset() with a wrapping
+	sampler so the leftmost visible column lands on the left edge.
+	Each exposed run is cut where it wraps, so scroll returns at
+	most two runs; a jump farther than the width exposes the whole
+	layer.
+****************************************************************/
+struct ScrollColumns
+{
+	uint32_t x;			// first physical column
+	uint32_t width;
+	int64_t wrap;		// absolute column = x + wrap * layer width
+};
+
+class ScrollingBake
+{
+public:
+	static constexpr uint32_t maxRuns = 2;
+private:
+	uint32_t width = 0;
+	int64_t firstColumn = 0;
+	bool valid = false;
+
+	// Cuts absolute columns [begin, end) at multiples of width.
+	uint32_t split(int64_t begin, int64_t end, ScrollColumns* out)const;
+public:
+	void reset(uint32_t width);
+	// Next scroll renders the whole layer (resize, content change).
+	void invalidate() { valid = false; }
+
+	// Makes column the leftmost visible one and writes the runs to render. Returns the run count.
+	uint32_t scroll(int64_t column, ScrollColumns* out);
+
+	uint32_t getWidth()const { return width; }
+	int64_t getFirstColumn()const { return firstColumn; }
+	// Physical column shown at the left edge.
+	uint32_t getWrapOffset()const;
+	float getTexcoordOffset()const { return width > 0 ? static_cast<float>(getWrapOffset()) / static_cast<float>(width) : 0.0f; }
+};
+
+// floor(value / divisor) for a positive divisor.
+inline int64_t floorDivide(int64_t value, int64_t divisor)
+{
+	const int64_t quotient = value / divisor;
+	return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+}
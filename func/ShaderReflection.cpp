@@ -0,0 +1,276 @@
+﻿#include "ShaderReflection.h"
+#include <string.h>
+
+namespace detail
+{
+	inline uint32_t readU32(const unsigned char* p)
+	{
+		return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+	}
+
+	inline bool readName(const unsigned char* chunk, size_t chunkSize, uint32_t offset, std::string& outName)
+	{
+		if (offset >= chunkSize) { return false; }
+		const unsigned char* begin = chunk + offset;
+		const void* end = memchr(begin, 0, chunkSize - offset);
+		if (!end) { return false; }
+		outName.assign(reinterpret_cast<const char*>(begin), static_cast<const unsigned char*>(end) - begin);
+		return true;
+	}
+
+	ShaderStage toStage(uint32_t programType)
+	{
+		switch (programType)
+		{
+		case 0xFFFE: return ShaderStage::vertex;
+		case 0xFFFF: return ShaderStage::pixel;
+		case 0x4453: return ShaderStage::domain;
+		case 0x4853: return ShaderStage::hull;
+		case 0x4753: return ShaderStage::geometry;
+		case 0x4353: return ShaderStage::compute;
+		default: return ShaderStage::unknown;
+		}
+	}
+
+	//D3D_SHADER_INPUT_TYPE
+	bool toInputType(uint32_t type, ShaderInputType& outType)
+	{
+		switch (type)
+		{
+		case 0: outType = ShaderInputType::constantBuffer; return true;
+		case 1: outType = ShaderInputType::textureBuffer; return true;
+		case 2: outType = ShaderInputType::texture; return true;
+		case 3: outType = ShaderInputType::sampler; return true;
+		case 5: outType = ShaderInputType::structured; return true;
+		case 7: outType = ShaderInputType::byteAddress; return true;
+		case 4: case 6: case 8: case 9: case 10: case 11:
+			outType = ShaderInputType::unorderedAccess; return true;
+		default: return false;
+		}
+	}
+
+	template<class Mask>
+	void setBits(Mask& mask, uint32_t first, uint32_t count)
+	{
+		for (uint32_t i = first; i < first + count && i < sizeof(Mask) * 8; i++) { mask |= Mask(1) << i; }
+	}
+}
+
+const ShaderBinding* ShaderReflection::findConstantBuffer(uint32_t slot)const
+{
+	for (const ShaderBinding& binding : bindings)
+	{
+		if (binding.type == ShaderInputType::constantBuffer && slot >= binding.bindPoint && slot < binding.bindPoint + binding.bindCount)
+		{
+			return &binding;
+		}
+	}
+	return nullptr;
+}
+
+ShaderReflectResult findShaderChunk(const void* bytecode, size_t size, const char* fourCc, const unsigned char** outChunk, size_t* outChunkSize)
+{
+	using detail::readU32;
+	const unsigned char* data = static_cast<const unsigned char*>(bytecode);
+	*outChunk = nullptr;
+	*outChunkSize = 0;
+
+	//コンテナ: "DXBC", チェックサム, 1, 全体サイズ, チャンク数, チャンクのオフセット
+	if (!data || size < 32 || memcmp(data, "DXBC", 4) != 0) { return ShaderReflectResult::invalidContainer; }
+	const uint32_t chunkCount = readU32(data + 28);
+	if (readU32(data + 24) > size || 32 + size_t(chunkCount) * 4 > size) { return ShaderReflectResult::invalidContainer; }
+	for (uint32_t i = 0; i < chunkCount; i++)
+	{
+		const uint32_t offset = readU32(data + 32 + i * 4);
+		if (size_t(offset) + 8 > size) { return ShaderReflectResult::invalidContainer; }
+		if (memcmp(data + offset, fourCc, 4) != 0) { continue; }
+		const size_t chunkSize = readU32(data + offset + 4);
+		if (size_t(offset) + 8 + chunkSize > size) { return ShaderReflectResult::invalidContainer; }
+		*outChunk = data + offset + 8;
+		*outChunkSize = chunkSize;
+		return ShaderReflectResult::ok;
+	}
+	return ShaderReflectResult::missingResourceDefinition;
+}
+
+ShaderReflectResult reflectShader(const void* bytecode, size_t size, ShaderReflection* outReflection)
+{
+	using detail::readU32;
+	*outReflection = ShaderReflection();
+
+	const unsigned char* chunk = nullptr;
+	size_t chunkSize = 0;
+	const ShaderReflectResult found = findShaderChunk(bytecode, size, "RDEF", &chunk, &chunkSize);
+	if (found != ShaderReflectResult::ok) { return found; }
+
+	//RDEF: cbuffer数, オフセット, バインド数, オフセット, バージョン, フラグ, 作成者
+	if (chunkSize < 28) { return ShaderReflectResult::invalidData; }
+	const uint32_t cbufferCount = readU32(chunk);
+	const uint32_t cbufferOffset = readU32(chunk + 4);
+	const uint32_t bindingCount = readU32(chunk + 8);
+	const uint32_t bindingOffset = readU32(chunk + 12);
+	const uint32_t version = readU32(chunk + 16);
+	outReflection->slots.stage = detail::toStage(version >> 16);
+	//SM5以降はRD11ヘッダーに各構造体のサイズがある (5.1はバインドが40バイト)
+	uint32_t bindingStride = 32;
+	uint32_t cbufferStride = 24;
+	if (((version >> 8) & 0xFF) >= 5 && chunkSize >= 60 && memcmp(chunk + 28, "RD11", 4) == 0)
+	{
+		cbufferStride = readU32(chunk + 36);
+		bindingStride = readU32(chunk + 40);
+		if (cbufferStride < 24 || bindingStride < 32) { return ShaderReflectResult::invalidData; }
+	}
+	if (size_t(bindingOffset) + size_t(bindingCount) * bindingStride > chunkSize ||
+		size_t(cbufferOffset) + size_t(cbufferCount) * cbufferStride > chunkSize)
+	{
+		return ShaderReflectResult::invalidData;
+	}
+
+	ShaderBindings& slots = outReflection->slots;
+	outReflection->bindings.reserve(bindingCount);
+	for (uint32_t i = 0; i < bindingCount; i++)
+	{
+		const unsigned char* entry = chunk + bindingOffset + size_t(i) * bindingStride;
+		ShaderBinding binding{};
+		if (!detail::readName(chunk, chunkSize, readU32(entry), binding.name) ||
+			!detail::toInputType(readU32(entry + 4), binding.type))
+		{
+			return ShaderReflectResult::invalidData;
+		}
+		binding.bindPoint = readU32(entry + 20);
+		binding.bindCount = readU32(entry + 24);
+		switch (binding.type)
+		{
+		case ShaderInputType::constantBuffer: detail::setBits(slots.constantBuffers, binding.bindPoint, binding.bindCount); break;
+		case ShaderInputType::sampler: detail::setBits(slots.samplers, binding.bindPoint, binding.bindCount); break;
+		case ShaderInputType::unorderedAccess: detail::setBits(slots.unorderedAccess, binding.bindPoint, binding.bindCount); break;
+		default: detail::setBits(slots.shaderResources, binding.bindPoint, binding.bindCount); break;
+		}
+		outReflection->bindings.push_back(binding);
+	}
+
+	//cbufferのサイズは名前で対応付ける
+	for (uint32_t i = 0; i < cbufferCount; i++)
+	{
+		const unsigned char* entry = chunk + cbufferOffset + size_t(i) * cbufferStride;
+		std::string name;
+		if (!detail::readName(chunk, chunkSize, readU32(entry), name)) { return ShaderReflectResult::invalidData; }
+		for (ShaderBinding& binding : outReflection->bindings)
+		{
+			if (binding.type == ShaderInputType::constantBuffer && binding.name == name) { binding.size = readU32(entry + 12); }
+		}
+	}
+	return ShaderReflectResult::ok;
+}
+
+ShaderReflectResult reflectInputSignature(const void* bytecode, size_t size, std::vector<InputSignatureElement>* outElements)
+{
+	using detail::readU32;
+	outElements->clear();
+
+	//SM5.1はISG1 (要素の前にストリーム, 後ろに最小精度が付く)
+	const unsigned char* chunk = nullptr;
+	size_t chunkSize = 0;
+	size_t elementSize = 24;
+	size_t fieldOffset = 0;
+	ShaderReflectResult found = findShaderChunk(bytecode, size, "ISGN", &chunk, &chunkSize);
+	if (found == ShaderReflectResult::missingResourceDefinition)
+	{
+		found = findShaderChunk(bytecode, size, "ISG1", &chunk, &chunkSize);
+		elementSize = 32;
+		fieldOffset = 4;
+	}
+	if (found != ShaderReflectResult::ok) { return found; }
+
+	//要素数, 8, 要素 (名前のオフセット, インデックス, システム値, 成分の型, レジスタ, マスク, 読み取りマスク)
+	if (chunkSize < 8) { return ShaderReflectResult::invalidData; }
+	const uint32_t elementCount = readU32(chunk);
+	if (8 + size_t(elementCount) * elementSize > chunkSize) { return ShaderReflectResult::invalidData; }
+	outElements->reserve(elementCount);
+	for (uint32_t i = 0; i < elementCount; i++)
+	{
+		const unsigned char* entry = chunk + 8 + size_t(i) * elementSize + fieldOffset;
+		InputSignatureElement element{};
+		if (!detail::readName(chunk, chunkSize, readU32(entry), element.semanticName)) { return ShaderReflectResult::invalidData; }
+		element.semanticIndex = readU32(entry + 4);
+		element.systemValue = readU32(entry + 8);
+		element.componentType = readU32(entry + 12);
+		element.registerIndex = readU32(entry + 16);
+		element.mask = entry[20];
+		element.readMask = entry[21];
+		outElements->push_back(element);
+	}
+	return ShaderReflectResult::ok;
+}
+
+ShaderReflectResult reflectThreadGroupSize(const void* bytecode, size_t size, uint32_t outSize[3])
+{
+	using detail::readU32;
+	outSize[0] = outSize[1] = outSize[2] = 1;
+	const unsigned char* chunk = nullptr;
+	size_t chunkSize = 0;
+	ShaderReflectResult found = findShaderChunk(bytecode, size, "SHEX", &chunk, &chunkSize);
+	if (found == ShaderReflectResult::missingResourceDefinition) { found = findShaderChunk(bytecode, size, "SHDR", &chunk, &chunkSize); }
+	if (found != ShaderReflectResult::ok) { return found; }
+
+	//バージョン, 全体のDWORD数, 命令列 (オペコードは下位11ビット, 長さはビット24-30)
+	constexpr uint32_t customData = 53;
+	constexpr uint32_t dclThreadGroup = 155;
+	if (chunkSize < 8) { return ShaderReflectResult::invalidData; }
+	const size_t tokenCount = readU32(chunk + 4);
+	if (tokenCount < 2 || tokenCount * 4 > chunkSize) { return ShaderReflectResult::invalidData; }
+	size_t position = 2;
+	while (position < tokenCount)
+	{
+		const uint32_t token = readU32(chunk + position * 4);
+		const uint32_t opcode = token & 0x7FF;
+		size_t length = (token >> 24) & 0x7F;
+		//カスタムデータ (即値定数バッファなど) は次のDWORDが長さ
+		if (opcode == customData)
+		{
+			if (position + 1 >= tokenCount) { return ShaderReflectResult::invalidData; }
+			length = readU32(chunk + (position + 1) * 4);
+		}
+		if (length == 0 || position + length > tokenCount) { return ShaderReflectResult::invalidData; }
+		if (opcode == dclThreadGroup)
+		{
+			if (length < 4) { return ShaderReflectResult::invalidData; }
+			for (int i = 0; i < 3; i++) { outSize[i] = readU32(chunk + (position + 1 + i) * 4); }
+			return ShaderReflectResult::ok;
+		}
+		position += length;
+	}
+	return ShaderReflectResult::missingResourceDefinition;
+}
+
+void StageBindingTable::clear()
+{
+	for (ShaderBindings& stage : stages) { stage = ShaderBindings(); }
+}
+
+void StageBindingTable::setStage(const ShaderBindings& bindings)
+{
+	const int stage = static_cast<int>(bindings.stage);
+	if (stage < 5) { stages[stage] = bindings; }
+}
+
+unsigned int StageBindingTable::getConstantBufferStages(uint32_t slot)const
+{
+	unsigned int mask = 0;
+	for (int i = 0; i < 5; i++) { mask |= ((stages[i].constantBuffers >> slot) & 1u) << i; }
+	return slot < 32 ? mask : 0;
+}
+
+unsigned int StageBindingTable::getShaderResourceStages(uint32_t slot)const
+{
+	unsigned int mask = 0;
+	for (int i = 0; i < 5; i++) { mask |= static_cast<unsigned int>((stages[i].shaderResources >> slot) & 1u) << i; }
+	return slot < 64 ? mask : 0;
+}
+
+unsigned int StageBindingTable::getSamplerStages(uint32_t slot)const
+{
+	unsigned int mask = 0;
+	for (int i = 0; i < 5; i++) { mask |= ((stages[i].samplers >> slot) & 1u) << i; }
+	return slot < 32 ? mask : 0;
+}
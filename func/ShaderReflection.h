@@ -0,0 +1,102 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/****************************************************************
+	Resource bindings read from compiled shader bytecode (.cso).
+	Only the DXBC container and its RDEF / ISGN chunks are parsed,
+	so it does not need d3dcompiler and works on any platform.
+	RDEF lists the resources a shader actually references; unused
+	cbuffers are stripped by the compiler.
+****************************************************************/
+
+// Same order as the use{Vs,Ps,Ds,Hs,Gs} flags of the painters.
+enum class ShaderStage { vertex, pixel, domain, hull, geometry, compute, unknown };
+
+enum class ShaderInputType { constantBuffer, textureBuffer, texture, sampler, unorderedAccess, structured, byteAddress };
+
+enum class ShaderReflectResult { ok, invalidContainer, missingResourceDefinition, invalidData };
+
+struct ShaderBinding
+{
+	std::string name;
+	ShaderInputType type;
+	uint32_t bindPoint;
+	uint32_t bindCount;
+	uint32_t size;				// cbuffer size in bytes, 0 for other types
+};
+
+/****************************************************************
+	Slot masks of one shader (bit n = register n).
+	shaderResources covers t0-t63, samplers s0-s15.
+****************************************************************/
+struct ShaderBindings
+{
+	ShaderStage stage = ShaderStage::unknown;
+	uint32_t constantBuffers = 0;
+	uint64_t shaderResources = 0;
+	uint32_t samplers = 0;
+	uint32_t unorderedAccess = 0;
+};
+
+struct ShaderReflection
+{
+	ShaderBindings slots;
+	std::vector<ShaderBinding> bindings;
+	// Returns null if no cbuffer is bound to slot.
+	const ShaderBinding* findConstantBuffer(uint32_t slot)const;
+};
+
+ShaderReflectResult reflectShader(const void* bytecode, size_t size, ShaderReflection* outReflection);
+
+/****************************************************************
+	One input of a vertex shader (ISGN / ISG1 chunk).
+	systemValue is D3D_NAME, 0 for inputs fed by the input layout.
+	componentType is D3D_REGISTER_COMPONENT_TYPE (1 uint, 2 sint,
+	3 float). mask holds the declared components, readMask the ones
+	the shader actually reads.
+****************************************************************/
+struct InputSignatureElement
+{
+	std::string semanticName;
+	uint32_t semanticIndex;
+	uint32_t systemValue;
+	uint32_t componentType;
+	uint32_t registerIndex;
+	uint8_t mask;
+	uint8_t readMask;
+};
+
+ShaderReflectResult reflectInputSignature(const void* bytecode, size_t size, std::vector<InputSignatureElement>* outElements);
+
+/****************************************************************
+	[numthreads] of a compute shader, from the dcl_thread_group
+	declaration in its SHEX / SHDR chunk.
+	missingResourceDefinition if the program declares none (not a
+	compute shader).
+****************************************************************/
+ShaderReflectResult reflectThreadGroupSize(const void* bytecode, size_t size, uint32_t outSize[3]);
+
+// Body of the chunk named fourCc. missingResourceDefinition if the container has none.
+ShaderReflectResult findShaderChunk(const void* bytecode, size_t size, const char* fourCc, const unsigned char** outChunk, size_t* outChunkSize);
+
+/****************************************************************
+	Which stages of a pipeline read each slot.
+	Stage masks use bit (1 << ShaderStage).
+****************************************************************/
+class StageBindingTable
+{
+private:
+	ShaderBindings stages[5];
+public:
+	void clear();
+	void setStage(const ShaderBindings& bindings);
+
+	unsigned int getConstantBufferStages(uint32_t slot)const;
+	unsigned int getShaderResourceStages(uint32_t slot)const;
+	unsigned int getSamplerStages(uint32_t slot)const;
+
+	static bool hasStage(unsigned int stageMask, ShaderStage stage) { return (stageMask >> static_cast<int>(stage)) & 1; }
+};
@@ -0,0 +1,438 @@
+﻿#include "SoftwareRasterizer.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SOFTWARE_RASTERIZER_SSE2
+#endif
+
+namespace detail
+{
+	inline double elapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	inline void lerpVertex(SoftwareVertex& out, const SoftwareVertex& a, const SoftwareVertex& b, float t, size_t varyingCount)
+	{
+		for (int k = 0; k < 4; k++) { out.position[k] = a.position[k] + (b.position[k] - a.position[k]) * t; }
+		for (size_t i = 0; i < varyingCount; i++) { out.varyings[i] = a.varyings[i] + (b.varyings[i] - a.varyings[i]) * t; }
+	}
+
+	//1画素分のブレンド (PipelineStateの各BlendStateと同じ式)
+	inline void blendPixel(float* dst, const float* src, SoftwareBlend blend)
+	{
+#ifdef SOFTWARE_RASTERIZER_SSE2
+		const __m128 s = _mm_loadu_ps(src);
+		if (blend == SoftwareBlend::none)
+		{
+			_mm_storeu_ps(dst, s);
+			return;
+		}
+		const __m128 d = _mm_loadu_ps(dst);
+		const __m128 alpha = _mm_set1_ps(src[3]);
+		if (blend == SoftwareBlend::alpha)
+		{
+			//rgb = src * a + dst * (1 - a), a = src.a + dst.a * (1 - src.a)
+			const __m128 sourceFactor = _mm_set_ps(1.0f, src[3], src[3], src[3]);
+			_mm_storeu_ps(dst, _mm_add_ps(_mm_mul_ps(s, sourceFactor), _mm_mul_ps(d, _mm_sub_ps(_mm_set1_ps(1.0f), alpha))));
+			return;
+		}
+		//rgb = src * a + dst, a = dst.a
+		const __m128 sourceFactor = _mm_set_ps(0.0f, src[3], src[3], src[3]);
+		_mm_storeu_ps(dst, _mm_add_ps(_mm_mul_ps(s, sourceFactor), d));
+#else
+		const float a = src[3];
+		switch (blend)
+		{
+		case SoftwareBlend::none:
+			memcpy(dst, src, sizeof(float) * 4);
+			break;
+		case SoftwareBlend::alpha:
+			for (int k = 0; k < 3; k++) { dst[k] = src[k] * a + dst[k] * (1.0f - a); }
+			dst[3] = a + dst[3] * (1.0f - a);
+			break;
+		case SoftwareBlend::add:
+			for (int k = 0; k < 3; k++) { dst[k] += src[k] * a; }
+			break;
+		}
+#endif
+	}
+}
+
+void SoftwareRenderTarget::resize(unsigned int newWidth, unsigned int newHeight)
+{
+	width = newWidth;
+	height = newHeight;
+	color.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+	depth.assign(static_cast<size_t>(width) * height, 1.0f);
+}
+
+void SoftwareRenderTarget::clear(float r, float g, float b, float a)
+{
+	for (size_t i = 0; i < color.size(); i += 4)
+	{
+		color[i] = r;
+		color[i + 1] = g;
+		color[i + 2] = b;
+		color[i + 3] = a;
+	}
+}
+
+void SoftwareRenderTarget::clearDepth(float value)
+{
+	std::fill(depth.begin(), depth.end(), value);
+}
+
+void SoftwareRenderTarget::getRgba8(std::vector<uint8_t>& outPixels)const
+{
+	outPixels.resize(color.size());
+	for (size_t i = 0; i < color.size(); i++)
+	{
+		const float c = std::min(std::max(color[i], 0.0f), 1.0f);
+		outPixels[i] = static_cast<uint8_t>(c * 255.0f + 0.5f);
+	}
+}
+
+bool SoftwareRenderTarget::savePpm(const char* path)const
+{
+	std::vector<uint8_t> rgba;
+	getRgba8(rgba);
+	std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+	for (size_t i = 0, n = static_cast<size_t>(width) * height; i < n; i++)
+	{
+		rgb[i * 3] = rgba[i * 4];
+		rgb[i * 3 + 1] = rgba[i * 4 + 1];
+		rgb[i * 3 + 2] = rgba[i * 4 + 2];
+	}
+	std::ofstream ofs{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+	if (!ofs) { return false; }
+	ofs << "P6\n" << width << " " << height << "\n255\n";
+	ofs.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+	return static_cast<bool>(ofs);
+}
+
+void SoftwareTexture::create(unsigned int newWidth, unsigned int newHeight, const float* rgba)
+{
+	width = newWidth;
+	height = newHeight;
+	texels.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+	if (rgba) { memcpy(texels.data(), rgba, texels.size() * sizeof(float)); }
+}
+
+void SoftwareTexture::createFromRgba8(unsigned int newWidth, unsigned int newHeight, const uint8_t* rgba)
+{
+	create(newWidth, newHeight);
+	for (size_t i = 0; i < texels.size(); i++) { texels[i] = rgba[i] / 255.0f; }
+}
+
+void SoftwareTexture::sample(float outColor[4], float u, float v)const
+{
+	assert(width > 0 && height > 0 && "The texture is empty.");
+	//テクセル中心基準の双線形補間、アドレスはWRAP
+	const float x = u * width - 0.5f;
+	const float y = v * height - 0.5f;
+	const float fx = floorf(x), fy = floorf(y);
+	const float tx = x - fx, ty = y - fy;
+	auto wrap = [](float value, unsigned int size)
+	{
+		const long long i = static_cast<long long>(value) % static_cast<long long>(size);
+		return static_cast<size_t>(i < 0 ? i + size : i);
+	};
+	const size_t x0 = wrap(fx, width), x1 = wrap(fx + 1.0f, width);
+	const size_t y0 = wrap(fy, height), y1 = wrap(fy + 1.0f, height);
+	const float* t00 = &texels[(y0 * width + x0) * 4];
+	const float* t10 = &texels[(y0 * width + x1) * 4];
+	const float* t01 = &texels[(y1 * width + x0) * 4];
+	const float* t11 = &texels[(y1 * width + x1) * 4];
+	for (int k = 0; k < 4; k++)
+	{
+		const float top = t00[k] + (t10[k] - t00[k]) * tx;
+		const float bottom = t01[k] + (t11[k] - t01[k]) * tx;
+		outColor[k] = top + (bottom - top) * ty;
+	}
+}
+
+void SoftwareRasterizer::setTarget(SoftwareRenderTarget* newTarget)
+{
+	assert(triangles.empty() && "Flush before changing the target.");
+	target = newTarget;
+	tilesX = target ? (target->getWidth() + tileSize - 1) / tileSize : 0;
+	tilesY = target ? (target->getHeight() + tileSize - 1) / tileSize : 0;
+	bins.resize(static_cast<size_t>(tilesX) * tilesY);
+}
+
+void SoftwareRasterizer::submit(const SoftwareDrawState& state, const SoftwareVertex* vertices, size_t vertexCount,
+	const unsigned int* indices, size_t indexCount, size_t varyingCount,
+	std::shared_ptr<const void> shader, SoftwarePixelFunction function)
+{
+	assert(target && "The target is not set.");
+	const auto start = std::chrono::steady_clock::now();
+	const unsigned int draw = static_cast<unsigned int>(draws.size());
+	draws.push_back(DrawRecord{ state, varyingCount, std::move(shader), function });
+	statistics.drawCount++;
+	const size_t count = indices ? indexCount : vertexCount;
+	auto fetch = [&](size_t i) -> const SoftwareVertex& { return vertices[indices ? indices[i] : i]; };
+	if (state.topology == SoftwareTopology::triangleList)
+	{
+		for (size_t i = 0; i + 2 < count; i += 3) { assembleTriangle(fetch(i), fetch(i + 1), fetch(i + 2), draw, varyingCount); }
+	}
+	else
+	{
+		//奇数番目は巻き順を揃えるために入れ替える
+		for (size_t i = 0; i + 2 < count; i++)
+		{
+			if (i & 1) { assembleTriangle(fetch(i + 1), fetch(i), fetch(i + 2), draw, varyingCount); }
+			else { assembleTriangle(fetch(i), fetch(i + 1), fetch(i + 2), draw, varyingCount); }
+		}
+	}
+	statistics.binMilliseconds += detail::elapsedMilliseconds(start);
+}
+
+//近平面 (z >= 0) でクリップしてから三角形を設定する
+void SoftwareRasterizer::assembleTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2, unsigned int draw, size_t varyingCount)
+{
+	const SoftwareVertex* input[3] = { &v0,&v1,&v2 };
+	const bool inside[3] = { v0.position[2] >= 0.0f,v1.position[2] >= 0.0f,v2.position[2] >= 0.0f };
+	if (inside[0] && inside[1] && inside[2])
+	{
+		setupTriangle(input, draw, varyingCount);
+		return;
+	}
+	if (!inside[0] && !inside[1] && !inside[2]) { return; }
+	SoftwareVertex polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const SoftwareVertex& a = *input[i];
+		const SoftwareVertex& b = *input[(i + 1) % 3];
+		const bool insideB = inside[(i + 1) % 3];
+		if (inside[i]) { polygon[count++] = a; }
+		if (inside[i] != insideB)
+		{
+			const float t = a.position[2] / (a.position[2] - b.position[2]);
+			detail::lerpVertex(polygon[count++], a, b, t, varyingCount);
+		}
+	}
+	for (int i = 1; i + 1 < count; i++)
+	{
+		const SoftwareVertex* fan[3] = { &polygon[0],&polygon[i],&polygon[i + 1] };
+		setupTriangle(fan, draw, varyingCount);
+	}
+}
+
+void SoftwareRasterizer::setupTriangle(const SoftwareVertex* const vertices[3], unsigned int draw, size_t varyingCount)
+{
+	const float width = static_cast<float>(target->getWidth());
+	const float height = static_cast<float>(target->getHeight());
+	float x[3], y[3], z[3], inverseW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const float* p = vertices[i]->position;
+		if (p[3] <= 0.0f) { return; }
+		inverseW[i] = 1.0f / p[3];
+		x[i] = (p[0] * inverseW[i] + 1.0f) * 0.5f * width;
+		y[i] = (1.0f - p[1] * inverseW[i]) * 0.5f * height;
+		z[i] = p[2] * inverseW[i];
+	}
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area != 0.0f)) { return; }
+	//カリング無し: 裏面は頂点を入れ替えて表と同じ向きで扱う
+	int order[3] = { 0,1,2 };
+	if (area < 0.0f)
+	{
+		std::swap(order[1], order[2]);
+		area = -area;
+	}
+
+	SetupTriangle triangle;
+	float minX = width, minY = height, maxX = 0.0f, maxY = 0.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		minX = std::min(minX, x[i]);
+		maxX = std::max(maxX, x[i]);
+		minY = std::min(minY, y[i]);
+		maxY = std::max(maxY, y[i]);
+	}
+	triangle.minX = std::max(static_cast<int>(floorf(minX - 0.5f)), 0);
+	triangle.minY = std::max(static_cast<int>(floorf(minY - 0.5f)), 0);
+	triangle.maxX = std::min(static_cast<int>(floorf(maxX)), static_cast<int>(width) - 1);
+	triangle.maxY = std::min(static_cast<int>(floorf(maxY)), static_cast<int>(height) - 1);
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) { return; }
+
+	for (int i = 0; i < 3; i++)
+	{
+		//辺 j -> k (頂点 i の対辺)、三角形の内側で正
+		const int j = order[(i + 1) % 3], k = order[(i + 2) % 3];
+		const float a = y[j] - y[k];
+		const float b = x[k] - x[j];
+		triangle.edgeA[i] = a;
+		triangle.edgeB[i] = b;
+		triangle.edgeC[i] = -(a * x[j] + b * y[j]);
+		triangle.topLeft[i] = a > 0.0f || (a == 0.0f && b > 0.0f);
+		triangle.z[i] = z[order[i]];
+		triangle.inverseW[i] = inverseW[order[i]];
+	}
+	triangle.inverseArea = 1.0f / area;
+	triangle.draw = draw;
+	triangle.varyingOffset = varyingPool.size();
+	for (int i = 0; i < 3; i++)
+	{
+		const SoftwareVertex& vertex = *vertices[order[i]];
+		for (size_t v = 0; v < varyingCount; v++) { varyingPool.push_back(vertex.varyings[v] * triangle.inverseW[i]); }
+	}
+
+	const unsigned int index = static_cast<unsigned int>(triangles.size());
+	triangles.push_back(triangle);
+	statistics.triangleCount++;
+	for (unsigned int tileY = triangle.minY / tileSize; tileY <= static_cast<unsigned int>(triangle.maxY) / tileSize; tileY++)
+	{
+		for (unsigned int tileX = triangle.minX / tileSize; tileX <= static_cast<unsigned int>(triangle.maxX) / tileSize; tileX++)
+		{
+			bins[static_cast<size_t>(tileY) * tilesX + tileX].push_back(index);
+			statistics.binnedCount++;
+		}
+	}
+}
+
+size_t SoftwareRasterizer::shadeTile(unsigned int tile)
+{
+	const int width = static_cast<int>(target->getWidth());
+	const int height = static_cast<int>(target->getHeight());
+	const int tileX0 = static_cast<int>(tile % tilesX * tileSize);
+	const int tileY0 = static_cast<int>(tile / tilesX * tileSize);
+	const int tileX1 = std::min(tileX0 + static_cast<int>(tileSize), width) - 1;
+	const int tileY1 = std::min(tileY0 + static_cast<int>(tileSize), height) - 1;
+	float* color = target->getColor();
+	float* depth = target->getDepth();
+	float varyings[softwareMaxVaryings][4];
+	float colors[4][4];
+	size_t shadedPixels = 0;
+
+	for (unsigned int index : bins[tile])
+	{
+		const SetupTriangle& triangle = triangles[index];
+		const DrawRecord& draw = draws[triangle.draw];
+		const bool depthEnable = draw.state.depth == SoftwareDepth::common;
+		const float* pool = &varyingPool[triangle.varyingOffset];
+		const size_t varyingCount = draw.varyingCount;
+		const int x0 = std::max(triangle.minX, tileX0) & ~1;
+		const int y0 = std::max(triangle.minY, tileY0) & ~1;
+		const int x1 = std::min(triangle.maxX, tileX1);
+		const int y1 = std::min(triangle.maxY, tileY1);
+		for (int y = y0; y <= y1; y += 2)
+		{
+			for (int x = x0; x <= x1; x += 2)
+			{
+				//2x2クアッドの画素: (x, y) (x + 1, y) (x, y + 1) (x + 1, y + 1)
+				unsigned int valid = 1u | (x + 1 < width ? 2u : 0u);
+				if (y + 1 < height) { valid |= valid << 2; }
+				const size_t pixel[4] = {
+					static_cast<size_t>(y) * width + x,static_cast<size_t>(y) * width + x + 1,
+					static_cast<size_t>(y + 1) * width + x,static_cast<size_t>(y + 1) * width + x + 1 };
+				float z[4];
+				unsigned int mask;
+#ifdef SOFTWARE_RASTERIZER_SSE2
+				const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(1.5f, 0.5f, 1.5f, 0.5f));
+				const __m128 py = _mm_add_ps(_mm_set1_ps(static_cast<float>(y)), _mm_set_ps(1.5f, 1.5f, 0.5f, 0.5f));
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				__m128 weight[3];
+				for (int e = 0; e < 3; e++)
+				{
+					const __m128 edge = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[e]), px),
+						_mm_mul_ps(_mm_set1_ps(triangle.edgeB[e]), py)), _mm_set1_ps(triangle.edgeC[e]));
+					inside = _mm_and_ps(inside, triangle.topLeft[e] ? _mm_cmpge_ps(edge, _mm_setzero_ps()) : _mm_cmpgt_ps(edge, _mm_setzero_ps()));
+					weight[e] = _mm_mul_ps(edge, _mm_set1_ps(triangle.inverseArea));
+				}
+				mask = static_cast<unsigned int>(_mm_movemask_ps(inside)) & valid;
+				if (!mask) { continue; }
+				const __m128 depthValue = _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight[0], _mm_set1_ps(triangle.z[0])),
+					_mm_mul_ps(weight[1], _mm_set1_ps(triangle.z[1]))), _mm_mul_ps(weight[2], _mm_set1_ps(triangle.z[2])));
+				__m128 pass = _mm_and_ps(_mm_cmpge_ps(depthValue, _mm_setzero_ps()), _mm_cmple_ps(depthValue, _mm_set1_ps(1.0f)));
+				if (depthEnable)
+				{
+					const __m128 stored = _mm_set_ps(mask & 8 ? depth[pixel[3]] : 0.0f, mask & 4 ? depth[pixel[2]] : 0.0f,
+						mask & 2 ? depth[pixel[1]] : 0.0f, depth[pixel[0]]);
+					pass = _mm_and_ps(pass, _mm_cmple_ps(depthValue, stored));
+				}
+				mask &= static_cast<unsigned int>(_mm_movemask_ps(pass));
+				if (!mask) { continue; }
+				const __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight[0], _mm_set1_ps(triangle.inverseW[0])),
+					_mm_mul_ps(weight[1], _mm_set1_ps(triangle.inverseW[1]))), _mm_mul_ps(weight[2], _mm_set1_ps(triangle.inverseW[2]))));
+				for (size_t v = 0; v < varyingCount; v++)
+				{
+					const __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight[0], _mm_set1_ps(pool[v])),
+						_mm_mul_ps(weight[1], _mm_set1_ps(pool[varyingCount + v]))), _mm_mul_ps(weight[2], _mm_set1_ps(pool[varyingCount * 2 + v])));
+					_mm_storeu_ps(varyings[v], _mm_mul_ps(value, w));
+				}
+				_mm_storeu_ps(z, depthValue);
+#else
+				float b[3][4];
+				mask = 0;
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (!(valid & (1u << lane))) { continue; }
+					const float px = x + (lane & 1) + 0.5f, py = y + (lane >> 1) + 0.5f;
+					bool covered = true;
+					for (int e = 0; e < 3; e++)
+					{
+						const float edge = triangle.edgeA[e] * px + triangle.edgeB[e] * py + triangle.edgeC[e];
+						covered &= triangle.topLeft[e] ? edge >= 0.0f : edge > 0.0f;
+						b[e][lane] = edge * triangle.inverseArea;
+					}
+					if (!covered) { continue; }
+					z[lane] = b[0][lane] * triangle.z[0] + b[1][lane] * triangle.z[1] + b[2][lane] * triangle.z[2];
+					if (z[lane] < 0.0f || z[lane] > 1.0f || (depthEnable && z[lane] > depth[pixel[lane]])) { continue; }
+					mask |= 1u << lane;
+					const float w = 1.0f / (b[0][lane] * triangle.inverseW[0] + b[1][lane] * triangle.inverseW[1] + b[2][lane] * triangle.inverseW[2]);
+					for (size_t v = 0; v < varyingCount; v++)
+					{
+						varyings[v][lane] = (b[0][lane] * pool[v] + b[1][lane] * pool[varyingCount + v] + b[2][lane] * pool[varyingCount * 2 + v]) * w;
+					}
+				}
+				if (!mask) { continue; }
+#endif
+				draw.function(draw.shader.get(), varyings, mask, colors);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (!(mask & (1u << lane))) { continue; }
+					detail::blendPixel(&color[pixel[lane] * 4], colors[lane], draw.state.blend);
+					if (depthEnable) { depth[pixel[lane]] = z[lane]; }
+					shadedPixels++;
+				}
+			}
+		}
+	}
+	return shadedPixels;
+}
+
+double SoftwareRasterizer::flush()
+{
+	const auto start = std::chrono::steady_clock::now();
+	//タイルごとの負荷が偏るので早い者勝ちで配る
+	std::atomic<size_t> nextTile{ 0 };
+	std::atomic<size_t> shadedPixels{ 0 };
+	const size_t tileCount = bins.size();
+	parallelForRanges(std::min(getWorkerCount(), tileCount), 1, [&](size_t, size_t, size_t)
+		{
+			size_t pixels = 0;
+			for (size_t tile = nextTile++; tile < tileCount; tile = nextTile++)
+			{
+				pixels += shadeTile(static_cast<unsigned int>(tile));
+			}
+			shadedPixels += pixels;
+		});
+	triangles.clear();
+	varyingPool.clear();
+	draws.clear();
+	for (std::vector<unsigned int>& bin : bins) { bin.clear(); }
+	const double milliseconds = detail::elapsedMilliseconds(start);
+	statistics.pixelCount += shadedPixels;
+	statistics.shadeMilliseconds += milliseconds;
+	return milliseconds;
+}
@@ -0,0 +1,176 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "ParallelFor.h"
+
+/****************************************************************
+	CPU backend for headless rendering of the painters.
+	Covers the pipeline subset they use: vertex and pixel shaders
+	as C++ functors, triangle list / strip, LESS_EQUAL depth and
+	the none / alpha / add blend states of PipelineState.
+	Triangles are binned into 64x64 tiles and tiles are shaded in
+	parallel, one 2x2 quad per step (SSE2 edge tests, interpolation
+	and blending). Rasterization follows D3D: pixel centers, top-left
+	rule, perspective correct varyings, depth clipped to [0, 1].
+****************************************************************/
+
+enum class SoftwareTopology { triangleList, triangleStrip };
+enum class SoftwareBlend { none, alpha, add };
+enum class SoftwareDepth { none, common };
+
+struct SoftwareDrawState
+{
+	SoftwareTopology topology = SoftwareTopology::triangleList;
+	SoftwareBlend blend = SoftwareBlend::none;
+	SoftwareDepth depth = SoftwareDepth::none;
+};
+
+constexpr size_t softwareMaxVaryings = 16;
+
+// Vertex shader output: clip-space SV_POSITION and the varyings.
+struct SoftwareVertex
+{
+	float position[4];
+	float varyings[softwareMaxVaryings];
+};
+
+/****************************************************************
+	RGBA32F color with a float depth buffer.
+****************************************************************/
+class SoftwareRenderTarget
+{
+private:
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::vector<float> color;
+	std::vector<float> depth;
+public:
+	SoftwareRenderTarget() = default;
+	SoftwareRenderTarget(unsigned int width, unsigned int height) { resize(width, height); }
+
+	void resize(unsigned int width, unsigned int height);
+	void clear(float r = 0, float g = 0, float b = 0, float a = 0);
+	void clearDepth(float value = 1.0f);
+
+	unsigned int getWidth()const { return width; }
+	unsigned int getHeight()const { return height; }
+	float* getColor() { return color.data(); }
+	const float* getColor()const { return color.data(); }
+	float* getDepth() { return depth.data(); }
+	const float* getDepth()const { return depth.data(); }
+
+	// 8-bit RGBA, clamped and rounded like a UNORM render target.
+	void getRgba8(std::vector<uint8_t>& outPixels)const;
+	// Binary PPM (alpha dropped) for regression images.
+	bool savePpm(const char* path)const;
+};
+
+/****************************************************************
+	RGBA32F texture, sampled like SamplerState::linear (wrap).
+****************************************************************/
+class SoftwareTexture
+{
+private:
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::vector<float> texels;
+public:
+	void create(unsigned int width, unsigned int height, const float* rgba = nullptr);
+	void createFromRgba8(unsigned int width, unsigned int height, const uint8_t* rgba);
+	void sample(float outColor[4], float u, float v)const;
+	unsigned int getWidth()const { return width; }
+	unsigned int getHeight()const { return height; }
+	float* getTexels() { return texels.data(); }
+};
+
+// Shades the covered lanes of a 2x2 quad. varyings are [component][lane].
+using SoftwarePixelFunction = void(*)(const void* shader, const float varyings[][4], unsigned int laneMask, float outColors[4][4]);
+
+class SoftwareRasterizer
+{
+public:
+	static constexpr unsigned int tileSize = 64;
+	struct Statistics
+	{
+		size_t drawCount = 0;
+		size_t triangleCount = 0;		// after clipping
+		size_t binnedCount = 0;			// triangle-tile pairs
+		size_t pixelCount = 0;			// pixels that passed coverage and depth
+		double binMilliseconds = 0;
+		double shadeMilliseconds = 0;
+	};
+private:
+	struct SetupTriangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3];
+		float inverseArea;
+		float z[3];
+		float inverseW[3];
+		int minX, minY, maxX, maxY;
+		unsigned char topLeft[3];
+		unsigned int draw;
+		size_t varyingOffset;			// 3 * varyingCount floats, divided by w
+	};
+	struct DrawRecord
+	{
+		SoftwareDrawState state;
+		size_t varyingCount;
+		std::shared_ptr<const void> shader;
+		SoftwarePixelFunction function;
+	};
+	SoftwareRenderTarget* target = nullptr;
+	unsigned int tilesX = 0;
+	unsigned int tilesY = 0;
+	std::vector<SetupTriangle> triangles;
+	std::vector<float> varyingPool;
+	std::vector<DrawRecord> draws;
+	std::vector<std::vector<unsigned int>> bins;
+	Statistics statistics;
+
+	void submit(const SoftwareDrawState& state, const SoftwareVertex* vertices, size_t vertexCount,
+		const unsigned int* indices, size_t indexCount, size_t varyingCount,
+		std::shared_ptr<const void> shader, SoftwarePixelFunction function);
+	void assembleTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2, unsigned int draw, size_t varyingCount);
+	void setupTriangle(const SoftwareVertex* const vertices[3], unsigned int draw, size_t varyingCount);
+	size_t shadeTile(unsigned int tile);
+
+	template<class PixelShader>
+	static void invokePixelShader(const void* shader, const float varyings[][4], unsigned int laneMask, float outColors[4][4])
+	{
+		const PixelShader& pixelShader = *static_cast<const PixelShader*>(shader);
+		float pixel[softwareMaxVaryings];
+		for (unsigned int lane = 0; lane < 4; lane++)
+		{
+			if (!(laneMask & (1u << lane))) { continue; }
+			for (size_t i = 0; i < PixelShader::varyingCount; i++) { pixel[i] = varyings[i][lane]; }
+			pixelShader(pixel, outColors[lane]);
+		}
+	}
+public:
+	void setTarget(SoftwareRenderTarget* target);
+
+	/****************************************************************
+		Queue one draw. vertexShader(const Vertex&, SoftwareVertex&)
+		runs on every core right away; pixelShader(const float*
+		varyings, float outColor[4]) is copied and runs in flush.
+		PixelShader::varyingCount tells how many varyings it reads.
+		indices may be null for non-indexed draws.
+	****************************************************************/
+	template<class Vertex, class VertexShader, class PixelShader>
+	void draw(const SoftwareDrawState& state, const Vertex* vertices, size_t vertexCount,
+		const unsigned int* indices, size_t indexCount, const VertexShader& vertexShader, const PixelShader& pixelShader)
+	{
+		static_assert(PixelShader::varyingCount <= softwareMaxVaryings, "Too many varyings");
+		std::vector<SoftwareVertex> shaded(vertexCount);
+		parallelFor(vertexCount, 4096, [&](size_t i) { vertexShader(vertices[i], shaded[i]); });
+		submit(state, shaded.data(), vertexCount, indices, indexCount, PixelShader::varyingCount,
+			std::make_shared<PixelShader>(pixelShader), &invokePixelShader<PixelShader>);
+	}
+
+	// Shade every queued draw in submission order. Returns milliseconds.
+	double flush();
+	const Statistics& getStatistics()const { return statistics; }
+	void resetStatistics() { statistics = Statistics(); }
+};
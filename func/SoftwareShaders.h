@@ -0,0 +1,244 @@
+﻿#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "SoftwareRasterizer.h"
+#include "WaveformPyramid.h"
+
+/****************************************************************
+	C++ ports of the painter shaders for SoftwareRasterizer.
+	Each pair mirrors its HLSL counterpart line by line, so a
+	headless render can be compared against the GPU output:
+		SpriteVs / SpritePs		Painter/shader/Sprite_vs, Sprite_ps
+		ToonVs / ToonPs			example/shader/Toon_vs, Toon_ps
+		WavePaintVs / WavePaintPs	example/shader/WavePaint_vs, WavePaint_ps
+	Matrices are row-major for row vectors, as in the cbuffers.
+****************************************************************/
+
+namespace detail
+{
+	inline float saturate(float x) { return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x); }
+	inline float step(float edge, float x) { return x >= edge ? 1.0f : 0.0f; }
+	inline float dot3(const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	inline void normalize3(float* v)
+	{
+		const float length = sqrtf(dot3(v, v));
+		const float inverse = length > 0.0f ? 1.0f / length : 0.0f;
+		v[0] *= inverse; v[1] *= inverse; v[2] *= inverse;
+	}
+	// out = float4(v, w) * m
+	inline void transformRow(float out[4], const float v[3], float w, const float m[16])
+	{
+		for (int c = 0; c < 4; c++) { out[c] = v[0] * m[c] + v[1] * m[4 + c] + v[2] * m[8 + c] + w * m[12 + c]; }
+	}
+}
+
+// SpritePainter::Vertex
+struct SoftwareSpriteVertex
+{
+	float pos[2];
+	float texcoord[2];
+	float color[4];
+};
+
+struct SpriteVs
+{
+	void operator()(const SoftwareSpriteVertex& vin, SoftwareVertex& vout)const
+	{
+		vout.position[0] = vin.pos[0];
+		vout.position[1] = vin.pos[1];
+		vout.position[2] = 0.0f;
+		vout.position[3] = 1.0f;
+		vout.varyings[0] = vin.texcoord[0];
+		vout.varyings[1] = vin.texcoord[1];
+		for (int i = 0; i < 4; i++) { vout.varyings[2 + i] = vin.color[i]; }
+	}
+};
+
+struct SpritePs
+{
+	static constexpr size_t varyingCount = 6;
+	const SoftwareTexture* colorMap = nullptr;
+
+	void operator()(const float* pin, float outColor[4])const
+	{
+		colorMap->sample(outColor, pin[0], pin[1]);
+		for (int i = 0; i < 4; i++) { outColor[i] *= pin[2 + i]; }
+	}
+};
+
+struct SoftwareToonVertex
+{
+	float position[3];
+	float normal[3];
+};
+
+// Toon constants with the frame, pass, material and object blocks flattened.
+struct SoftwareToonData
+{
+	float world[16];
+	float viewProjection[16];
+	float matColor[4] = { 1,1,1,1 };
+	float rimColor[4] = { 0,0,0,1 };
+	float lightDir[3] = { 0,-1,0 };
+	int toonLevels = 5;
+	float eyePos[3] = { 0,0,0 };
+	float outlineThreshold = 0;
+};
+
+struct ToonVs
+{
+	float worldViewProjection[16];
+	float world[16];
+
+	explicit ToonVs(const SoftwareToonData& data)
+	{
+		memcpy(world, data.world, sizeof(world));
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < 4; k++) { sum += data.world[r * 4 + k] * data.viewProjection[k * 4 + c]; }
+				worldViewProjection[r * 4 + c] = sum;
+			}
+		}
+	}
+	void operator()(const SoftwareToonVertex& vin, SoftwareVertex& vout)const
+	{
+		float position[4], normal[4];
+		detail::transformRow(vout.position, vin.position, 1.0f, worldViewProjection);
+		detail::transformRow(position, vin.position, 1.0f, world);
+		detail::transformRow(normal, vin.normal, 0.0f, world);
+		for (int i = 0; i < 3; i++)
+		{
+			vout.varyings[i] = position[i];
+			vout.varyings[3 + i] = normal[i];
+		}
+	}
+};
+
+struct ToonPs
+{
+	static constexpr size_t varyingCount = 6;
+	SoftwareToonData data;
+
+	void operator()(const float* pin, float outColor[4])const
+	{
+		float lightDirection[3] = { data.lightDir[0],data.lightDir[1],data.lightDir[2] };
+		float viewDirection[3] = { pin[0] - data.eyePos[0],pin[1] - data.eyePos[1],pin[2] - data.eyePos[2] };
+		float normal[3] = { pin[3],pin[4],pin[5] };
+		detail::normalize3(lightDirection);
+		detail::normalize3(viewDirection);
+		detail::normalize3(normal);
+
+		//toonShader (Toon.hlsli)
+		const float NdotL = detail::saturate(-detail::dot3(lightDirection, normal));
+		const float threshold = 1.0f / static_cast<float>(data.toonLevels);
+		const float intensity = floorf(NdotL / threshold) * threshold + threshold;
+		const float rim = detail::saturate(-detail::dot3(viewDirection, normal));
+		const float t = detail::step(data.outlineThreshold, rim);
+		for (int i = 0; i < 4; i++) { outColor[i] = data.rimColor[i] + (data.matColor[i] * intensity - data.rimColor[i]) * t; }
+	}
+};
+
+// Vertex id of the 4 vertex fullscreen strip (WavePainter::draw).
+struct WavePaintVs
+{
+	void operator()(const uint32_t& vertexId, SoftwareVertex& vout)const
+	{
+		const float u = static_cast<float>((vertexId << 1) & 2);
+		const float v = static_cast<float>(vertexId & 2);
+		vout.position[0] = u * 2.0f - 1.0f;
+		vout.position[1] = v * -2.0f + 1.0f;
+		vout.position[2] = 0.0f;
+		vout.position[3] = 1.0f;
+		vout.varyings[0] = u;
+		vout.varyings[1] = v;
+	}
+};
+
+// pixelWidth replaces ddx(texcoord.x): 1 / target width.
+struct WavePaintPs
+{
+	static constexpr size_t varyingCount = 2;
+	const float* amplitudes = nullptr;
+	const WaveformPyramid* pyramid = nullptr;
+	float lineColor[4] = { 1,1,1,1 };
+	uint32_t frameCount = 0;
+	uint32_t samplingRate = 0;
+	float tick = 0;
+	float thickness = 0.02f;
+	float pixelWidth = 0;
+
+	static float isRange(float x, float a, float b)
+	{
+		return detail::step(a < b ? a : b, x) * detail::step(x, a < b ? b : a);
+	}
+	float sampleAmplitude(float position)const
+	{
+		const uint32_t index = static_cast<uint32_t>(position);
+		const float a = amplitudes[index % frameCount];
+		const float b = amplitudes[(index + 1) % frameCount];
+		return a + (b - a) * (position - floorf(position));
+	}
+	void operator()(const float* pin, float outColor[4])const
+	{
+		const float fineness = 50;
+		const float samplesPerPixel = fmaxf(pixelWidth * samplingRate * fineness, 1e-3f);
+		const float samplingPosition = samplingRate * tick + samplingRate * pin[0] * fineness;
+		const float begin = fmaxf(samplingPosition - samplesPerPixel * 0.5f, 0.0f);
+		const float end = begin + samplesPerPixel;
+		const uint32_t levelCount = pyramid ? pyramid->getLevelCount() : 0;
+		const uint32_t envelopeBlock = pyramid ? pyramid->getBlock() : 0;
+
+		float minimum, maximum, rms;
+		if (levelCount == 0 || samplesPerPixel < envelopeBlock)
+		{
+			minimum = sampleAmplitude(begin);
+			maximum = minimum;
+			const float last = sampleAmplitude(end);
+			minimum = fminf(minimum, last);
+			maximum = fmaxf(maximum, last);
+			float sumSquares = 0;
+			const uint32_t first = static_cast<uint32_t>(ceilf(begin));
+			uint32_t count = static_cast<uint32_t>(fmaxf(floorf(end) - first + 1, 0.0f));
+			count = count < envelopeBlock + 1 ? count : envelopeBlock + 1;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const float amplitude = amplitudes[(first + i) % frameCount];
+				minimum = fminf(minimum, amplitude);
+				maximum = fmaxf(maximum, amplitude);
+				sumSquares += amplitude * amplitude;
+			}
+			rms = count > 0 ? sqrtf(sumSquares / count) : fmaxf(fabsf(minimum), fabsf(maximum));
+		}
+		else
+		{
+			const uint32_t selected = static_cast<uint32_t>(log2f(samplesPerPixel / envelopeBlock));
+			const uint32_t level = selected < levelCount - 1 ? selected : levelCount - 1;
+			const float span = static_cast<float>(envelopeBlock << level);
+			const uint32_t size = pyramid->getLevelSize(level);
+			const uint32_t first = static_cast<uint32_t>(begin / span);
+			uint32_t count = static_cast<uint32_t>(end / span) - first + 1;
+			count = count < 3 ? count : 3;
+			minimum = 1;
+			maximum = -1;
+			float sumSquares = 0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const WaveformEnvelope& envelope = pyramid->getEnvelope(level, (first + i) % size);
+				minimum = fminf(minimum, envelope.minimum);
+				maximum = fmaxf(maximum, envelope.maximum);
+				sumSquares += envelope.rms * envelope.rms;
+			}
+			rms = sqrtf(sumSquares / count);
+		}
+
+		const float width = thickness * 0.5f;
+		const float peak = isRange(pin[1], minimum * 0.5f + 0.5f - width, maximum * 0.5f + 0.5f + width);
+		const float body = isRange(pin[1], 0.5f - rms * 0.5f - width, 0.5f + rms * 0.5f + width);
+		const float intensity = peak * (0.5f + 0.5f * body);
+		for (int i = 0; i < 4; i++) { outColor[i] = lineColor[i] * intensity; }
+	}
+};
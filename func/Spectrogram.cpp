@@ -0,0 +1,123 @@
+﻿#include "Spectrogram.h"
+#include "ParallelFor.h"
+#include <assert.h>
+#include <math.h>
+#include <chrono>
+
+namespace detail
+{
+	inline double elapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void Spectrogram::init(const SpectrogramConfig& config, size_t sampleCount, size_t columnCount)
+{
+	assert(config.hop > 0 && config.minDecibels < 0.0f && "The spectrogram config is invalid.");
+	this->config = config;
+	this->sampleCount = sampleCount;
+	this->columnCount = columnCount;
+	fft.init(config.fftSize);
+	window.resize(config.fftSize);
+	//窓をかけた振幅1の正弦波が1になるように
+	binScale = static_cast<float>(2.0 / makeFftWindow(config.window, config.fftSize, window.data()));
+	windowBegin = 0;
+	windowEnd = 0;
+	scratch = Scratch();
+	columns.clear();
+}
+
+void Spectrogram::readSamples(const SampleSource& source, size_t first, float* out)const
+{
+	//終端をまたぐフレームは先頭から続ける
+	size_t remaining = config.fftSize;
+	while (remaining > 0)
+	{
+		const size_t begin = first % sampleCount;
+		const size_t count = sampleCount - begin < remaining ? sampleCount - begin : remaining;
+		source(begin, count, out);
+		out += count;
+		first += count;
+		remaining -= count;
+	}
+}
+
+void Spectrogram::computeFrame(const SampleSource& source, size_t frame, float* out, Scratch& scratch)const
+{
+	const size_t binCount = getBinCount();
+	if (sampleCount == 0)
+	{
+		for (size_t i = 0; i < binCount; i++) { out[i] = 0.0f; }
+		return;
+	}
+	scratch.samples.resize(config.fftSize);
+	scratch.re.resize(binCount);
+	scratch.im.resize(binCount);
+	readSamples(source, frame * config.hop, scratch.samples.data());
+	for (size_t i = 0; i < config.fftSize; i++) { scratch.samples[i] *= window[i]; }
+	fft.forward(scratch.samples.data(), scratch.re.data(), scratch.im.data());
+
+	//パワーをdBにして[minDecibels, 0]を[0, 1]へ
+	const float powerScale = binScale * binScale;
+	const float levelScale = -10.0f / config.minDecibels;
+	for (size_t i = 0; i < binCount; i++)
+	{
+		const float power = (scratch.re[i] * scratch.re[i] + scratch.im[i] * scratch.im[i]) * powerScale;
+		const float level = power > 0.0f ? 1.0f + log10f(power) * levelScale : 0.0f;
+		out[i] = level < 0.0f ? 0.0f : (level > 1.0f ? 1.0f : level);
+	}
+}
+
+size_t Spectrogram::update(const SampleSource& source, size_t position, const Upload& upload)
+{
+	if (columnCount == 0) { return 0; }
+	const size_t end = position / config.hop + 1;
+	const size_t begin = end > columnCount ? end - columnCount : 0;
+	//重ならなければ空のリングから. 表示範囲のうちリングにないフレームは前後の2区間まで
+	if (!(begin < windowEnd && windowBegin < end)) { windowBegin = windowEnd = begin; }
+	const size_t runs[2][2] = {
+		{ begin, end < windowBegin ? end : windowBegin },
+		{ begin > windowEnd ? begin : windowEnd, end } };
+	const size_t binCount = getBinCount();
+	size_t computed = 0;
+	for (int r = 0; r < 2; r++)
+	{
+		const size_t first = runs[r][0];
+		const size_t last = runs[r][1];
+		if (first >= last) { continue; }
+		const size_t count = last - first;
+		if (count > parallelFrames)
+		{
+			//シーク直後などまとまった量は全コアで求めてから送る
+			columns.resize(count * binCount);
+			bake(source, first, count, columns.data());
+			for (size_t i = 0; i < count; i++) { upload((first + i) % columnCount, columns.data() + i * binCount); }
+		}
+		else
+		{
+			columns.resize(binCount);
+			for (size_t f = first; f < last; f++)
+			{
+				computeFrame(source, f, columns.data(), scratch);
+				upload(f % columnCount, columns.data());
+			}
+		}
+		computed += count;
+	}
+	windowBegin = begin;
+	windowEnd = end;
+	return computed;
+}
+
+double Spectrogram::bake(const SampleSource& source, size_t firstFrame, size_t frameCount, float* out)const
+{
+	const auto start = std::chrono::steady_clock::now();
+	const size_t binCount = getBinCount();
+	parallelForRanges(frameCount, 4, [&](size_t begin, size_t end, size_t)
+		{
+			Scratch local;
+			for (size_t i = begin; i < end; i++) { computeFrame(source, firstFrame + i, out + i * binCount, local); }
+		});
+	return detail::elapsedMilliseconds(start);
+}
@@ -0,0 +1,71 @@
+﻿#pragma once
+#include <stddef.h>
+#include <functional>
+#include <vector>
+#include "RealFft.h"
+
+/****************************************************************
+	Short-time spectrum of a mono waveform.
+	Frame f is the FFT of samples [f * hop, f * hop + fftSize)
+	multiplied by the window; samples past the end wrap to the start
+	as in WavePainter. Each bin is stored as its level in decibels
+	mapped to [0, 1]: minDecibels and below -> 0, full scale -> 1.
+	update keeps the last columnCount frames up to a position in a
+	ring (frame f at column f % columnCount) and computes only the
+	frames that came into view since the last call:
+		spectrogram.update(source, position, [&](size_t column, const float* bins) { ... });
+	bake computes a run of frames on all cores for offline use.
+****************************************************************/
+struct SpectrogramConfig
+{
+	size_t fftSize = 2048;
+	size_t hop = 512;
+	FftWindow window = FftWindow::hann;
+	float minDecibels = -100.0f;
+};
+
+class Spectrogram
+{
+public:
+	// Writes samples [first, first + count) to out; called from worker threads.
+	using SampleSource = std::function<void(size_t first, size_t count, float* out)>;
+	using Upload = std::function<void(size_t column, const float* bins)>;
+	// Frames of one update past which the new ones are computed on all cores.
+	static constexpr size_t parallelFrames = 16;
+	// Buffers of one thread.
+	struct Scratch
+	{
+		std::vector<float> samples;
+		std::vector<float> re;
+		std::vector<float> im;
+	};
+private:
+	SpectrogramConfig config;
+	RealFft fft;
+	std::vector<float> window;
+	float binScale = 1.0f;		// amplitude of a full scale sine = 1
+	size_t sampleCount = 0;
+	size_t columnCount = 0;
+	// Frames [windowBegin, windowEnd) are in the ring.
+	size_t windowBegin = 0;
+	size_t windowEnd = 0;
+	Scratch scratch;
+	std::vector<float> columns;
+
+	void readSamples(const SampleSource& source, size_t first, float* out)const;
+public:
+	void init(const SpectrogramConfig& config, size_t sampleCount, size_t columnCount);
+
+	// Writes getBinCount() levels of frame to out.
+	void computeFrame(const SampleSource& source, size_t frame, float* out, Scratch& scratch)const;
+	// Brings the ring up to the frame holding position. Returns frames computed.
+	size_t update(const SampleSource& source, size_t position, const Upload& upload);
+	// Frames [firstFrame, firstFrame + frameCount) to out, getBinCount() each. Returns milliseconds.
+	double bake(const SampleSource& source, size_t firstFrame, size_t frameCount, float* out)const;
+
+	const SpectrogramConfig& getConfig()const { return config; }
+	size_t getBinCount()const { return fft.getBinCount(); }
+	size_t getColumnCount()const { return columnCount; }
+	// Newest frame in the ring.
+	size_t getLatestFrame()const { return windowEnd > 0 ? windowEnd - 1 : 0; }
+};
@@ -0,0 +1,134 @@
+﻿#include "StreamingWindow.h"
+
+void StreamingWindow::open(Source source, size_t sampleCount, size_t capacity, size_t chunkSize)
+{
+	close();
+	if (sampleCount == 0 || chunkSize == 0) { return; }
+	this->source = std::move(source);
+	this->sampleCount = sampleCount;
+	this->chunkSize = chunkSize;
+	const size_t slotCount = capacity > chunkSize ? (capacity + chunkSize - 1) / chunkSize : 1;
+	staging.assign(slotCount * chunkSize, 0.0f);
+	slots.assign(slotCount, Slot());
+	windowChunk = 0;
+	windowChanged = true;
+	quit = false;
+	statistics = Statistics();
+	worker = std::thread([this]() { run(); });
+}
+
+void StreamingWindow::close()
+{
+	if (worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_one();
+		worker.join();
+	}
+	source = nullptr;
+	staging.clear();
+	staging.shrink_to_fit();
+	slots.clear();
+	sampleCount = 0;
+}
+
+void StreamingWindow::convertChunk(size_t chunk, float* out)
+{
+	//ソースの終端をまたぐチャンクは先頭から続ける
+	size_t position = chunk * chunkSize;
+	size_t remaining = chunkSize;
+	while (remaining > 0)
+	{
+		const size_t first = position % sampleCount;
+		const size_t count = sampleCount - first < remaining ? sampleCount - first : remaining;
+		source(first, count, out);
+		out += count;
+		position += count;
+		remaining -= count;
+	}
+}
+
+bool StreamingWindow::findMissingChunk(size_t& outChunk)const
+{
+	//今いるチャンクから先へ, 手前の1チャンクは最後に読む
+	const size_t slotCount = slots.size();
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		const size_t chunk = (windowChunk > 0 && i == slotCount - 1) ? windowChunk - 1 : windowChunk + i;
+		const Slot& slot = slots[chunk % slotCount];
+		if (slot.state != SlotState::empty && slot.chunk == chunk) { continue; }
+		outChunk = chunk;
+		return true;
+	}
+	return false;
+}
+
+void StreamingWindow::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!quit)
+	{
+		size_t chunk;
+		if (!findMissingChunk(chunk))
+		{
+			converted.notify_all();
+			wake.wait(lock, [this]() { return quit || windowChanged; });
+			windowChanged = false;
+			continue;
+		}
+		//変換中のスロットは描画スレッドが触らないので, ロックを外して変換する
+		Slot& slot = slots[chunk % slots.size()];
+		slot.chunk = chunk;
+		slot.state = SlotState::converting;
+		float* out = staging.data() + (chunk % slots.size()) * chunkSize;
+		lock.unlock();
+		convertChunk(chunk, out);
+		lock.lock();
+		slot.state = SlotState::ready;
+		statistics.convertedChunks++;
+	}
+}
+
+void StreamingWindow::update(size_t position, const Upload& upload)
+{
+	if (!isOpen()) { return; }
+	std::unique_lock<std::mutex> lock(mutex);
+	const size_t chunk = position / chunkSize;
+	if (chunk != windowChunk)
+	{
+		windowChunk = chunk;
+		windowChanged = true;
+		wake.notify_one();
+	}
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		if (slots[i].state != SlotState::ready) { continue; }
+		upload(i * chunkSize, staging.data() + i * chunkSize, chunkSize);
+		slots[i].state = SlotState::resident;
+		statistics.uploadedChunks++;
+	}
+}
+
+void StreamingWindow::waitForWindow()
+{
+	if (!isOpen()) { return; }
+	std::unique_lock<std::mutex> lock(mutex);
+	converted.wait(lock, [this]()
+		{
+			size_t chunk;
+			for (const Slot& slot : slots)
+			{
+				if (slot.state == SlotState::converting) { return false; }
+			}
+			return quit || (!windowChanged && !findMissingChunk(chunk));
+		});
+}
+
+StreamingWindow::Statistics StreamingWindow::getStatistics()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
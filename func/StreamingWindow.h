@@ -0,0 +1,79 @@
+﻿#pragma once
+#include <stddef.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/****************************************************************
+	Sliding window of a long sample source held in a fixed ring.
+	Positions are unwrapped: position p holds sample
+	p % sampleCount and lives at ring index p % getCapacity(), so a
+	looping view never makes two chunks of the window share a slot,
+	and a shader finds a sample without knowing what is resident.
+	A worker thread converts the chunks of the current window into a
+	staging copy of the ring, nearest chunk first, and update hands
+	the finished ones to the caller for upload on the render thread:
+		window.open(source, frameCount, capacity);
+		window.update(position, [&](size_t ringOffset, const float* samples, size_t count) { ... });
+	The window keeps one chunk behind position. Memory is the staging
+	ring plus the GPU ring whatever the length of the source.
+****************************************************************/
+class StreamingWindow
+{
+public:
+	// Writes samples [first, first + count) to out; called from the worker thread.
+	using Source = std::function<void(size_t first, size_t count, float* out)>;
+	using Upload = std::function<void(size_t ringOffset, const float* samples, size_t count)>;
+	static constexpr size_t defaultChunkSize = 1 << 16;
+	struct Statistics
+	{
+		size_t convertedChunks = 0;
+		size_t uploadedChunks = 0;
+	};
+private:
+	enum class SlotState { empty, converting, ready, resident };
+	struct Slot
+	{
+		size_t chunk = 0;
+		SlotState state = SlotState::empty;
+	};
+	Source source;
+	size_t sampleCount = 0;
+	size_t chunkSize = defaultChunkSize;
+	std::vector<float> staging;
+	std::vector<Slot> slots;
+	size_t windowChunk = 0;
+	bool windowChanged = false;
+	bool quit = false;
+	Statistics statistics;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable converted;
+	std::thread worker;
+
+	void run();
+	void convertChunk(size_t chunk, float* out);
+	// Next chunk of the window that is not in its slot, or false.
+	bool findMissingChunk(size_t& outChunk)const;
+public:
+	StreamingWindow() = default;
+	~StreamingWindow() { close(); }
+	StreamingWindow(const StreamingWindow&) = delete;
+	StreamingWindow& operator=(const StreamingWindow&) = delete;
+
+	// capacity is rounded up to whole chunks.
+	void open(Source source, size_t sampleCount, size_t capacity, size_t chunkSize = defaultChunkSize);
+	void close();
+
+	// Moves the window and uploads every chunk finished since the last call.
+	void update(size_t position, const Upload& upload);
+	// Blocks until the whole window is converted (loading screens, tests).
+	void waitForWindow();
+
+	bool isOpen()const { return !slots.empty(); }
+	size_t getCapacity()const { return slots.size() * chunkSize; }
+	size_t getChunkSize()const { return chunkSize; }
+	Statistics getStatistics();
+};
@@ -0,0 +1,104 @@
+﻿#include "TrackPacking.h"
+#include "ParallelFor.h"
+#include <assert.h>
+#include <string.h>
+
+namespace detail
+{
+	//dstの[begin, end)に重なるトラックだけ写す
+	void packTrackRange(const TrackDesc* tracks, size_t count, const PackedTrack* layout, float* dst, size_t begin, size_t end)
+	{
+		//区間の先頭を含むトラックを二分探索
+		size_t low = 0;
+		size_t high = count;
+		while (low < high)
+		{
+			const size_t middle = (low + high) / 2;
+			if (layout[middle].sampleOffset <= begin) { low = middle + 1; }
+			else { high = middle; }
+		}
+		size_t position = begin;
+		for (size_t i = low > 0 ? low - 1 : 0; i < count && position < end; i++)
+		{
+			const size_t trackBegin = layout[i].sampleOffset;
+			const size_t trackEnd = trackBegin + layout[i].sampleCount;
+			const size_t nextBegin = i + 1 < count ? layout[i + 1].sampleOffset : end;
+			if (position < trackBegin)
+			{
+				const size_t gapEnd = trackBegin < end ? trackBegin : end;
+				memset(dst + position, 0, (gapEnd - position) * sizeof(float));
+				position = gapEnd;
+			}
+			const size_t copyEnd = trackEnd < end ? trackEnd : end;
+			if (position < copyEnd)
+			{
+				const TrackDesc& track = tracks[i];
+				const float* src = track.samples + (position - trackBegin) * track.stride;
+				if (track.stride == 1) { memcpy(dst + position, src, (copyEnd - position) * sizeof(float)); }
+				else
+				{
+					for (size_t p = position; p < copyEnd; p++, src += track.stride) { dst[p] = *src; }
+				}
+				position = copyEnd;
+			}
+			//次のトラックまでの詰め物
+			const size_t padEnd = nextBegin < end ? nextBegin : end;
+			if (position < padEnd)
+			{
+				memset(dst + position, 0, (padEnd - position) * sizeof(float));
+				position = padEnd;
+			}
+		}
+	}
+}
+
+size_t layoutTracks(const TrackDesc* tracks, size_t count, float laneGap, PackedTrack* out)
+{
+	const float laneHeight = count > 0 ? 1.0f / static_cast<float>(count) : 0.0f;
+	size_t offset = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		const TrackDesc& track = tracks[i];
+		PackedTrack& packed = out[i];
+		memcpy(packed.color, track.color, sizeof(packed.color));
+		packed.rect[0] = 0.0f;
+		packed.rect[1] = static_cast<float>(i) * laneHeight;
+		packed.rect[2] = 1.0f;
+		packed.rect[3] = laneHeight * (1.0f - laneGap);
+		packed.sampleOffset = static_cast<uint32_t>(offset);
+		packed.sampleCount = static_cast<uint32_t>(track.sampleCount);
+		packed.samplePerSec = track.samplePerSec;
+		packed.thickness = track.thickness;
+		offset += (track.sampleCount + trackAlignment - 1) / trackAlignment * trackAlignment;
+		assert(offset <= UINT32_MAX && "The tracks do not fit in 32-bit offsets.");
+	}
+	return offset;
+}
+
+void packTracks(const TrackDesc* tracks, size_t count, const PackedTrack* layout, float* dst)
+{
+	if (count == 0) { return; }
+	const PackedTrack& last = layout[count - 1];
+	const size_t total = last.sampleOffset + (size_t(last.sampleCount) + trackAlignment - 1) / trackAlignment * trackAlignment;
+	//範囲の境界もそろえて, 隣のスレッドと同じキャッシュラインに書かない
+	const size_t blocks = total / trackAlignment;
+	parallelForRanges(blocks, size_t(1) << 14, [&](size_t begin, size_t end, size_t)
+		{
+			detail::packTrackRange(tracks, count, layout, dst, begin * trackAlignment, end * trackAlignment);
+		});
+}
+
+void packTracksReference(const TrackDesc* tracks, size_t count, const PackedTrack* layout, float* dst)
+{
+	size_t position = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		for (; position < layout[i].sampleOffset; position++) { dst[position] = 0.0f; }
+		for (size_t s = 0; s < tracks[i].sampleCount; s++) { dst[position++] = tracks[i].samples[s * tracks[i].stride]; }
+	}
+	if (count > 0)
+	{
+		const size_t end = layout[count - 1].sampleOffset + (size_t(layout[count - 1].sampleCount) + trackAlignment - 1) / trackAlignment * trackAlignment;
+		for (; position < end; position++) { dst[position] = 0.0f; }
+	}
+}
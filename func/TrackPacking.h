@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************
+	Many waveforms in one StructuredBuffer<float>.
+	Track i owns samples [sampleOffset, sampleOffset + sampleCount)
+	of the shared buffer. Offsets are rounded up to trackAlignment
+	samples, so threads packing neighbouring tracks never write the
+	same cache line, and the gaps are zero.
+	PackedTrack is the per-instance record read by WaveTracks_vs /
+	WaveTracks_ps: the lane rectangle in [0, 1] target space plus
+	where its samples are.
+****************************************************************/
+struct PackedTrack
+{
+	float color[4];
+	float rect[4];			// left, top, width, height
+	uint32_t sampleOffset;
+	uint32_t sampleCount;
+	uint32_t samplePerSec;
+	float thickness;
+};
+static_assert(sizeof(PackedTrack) == 48, "PackedTrack must match the HLSL layout");
+
+// Input of one lane. stride > 1 picks one channel out of interleaved samples.
+struct TrackDesc
+{
+	const float* samples = nullptr;
+	size_t sampleCount = 0;
+	size_t stride = 1;
+	uint32_t samplePerSec = 0;
+	float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	float thickness = 0.02f;
+};
+
+constexpr uint32_t trackAlignment = 16;
+
+/****************************************************************
+	Fill out[count] with offsets and lanes stacked top to bottom,
+	laneGap being the fraction of a lane left empty below it.
+	Returns the length of the shared buffer.
+****************************************************************/
+size_t layoutTracks(const TrackDesc* tracks, size_t count, float laneGap, PackedTrack* out);
+
+/****************************************************************
+	Copy the samples of every track to dst (layoutTracks' length).
+	The buffer is cut into equal ranges on all cores whatever the
+	track sizes, so a few long tracks still use every core.
+****************************************************************/
+void packTracks(const TrackDesc* tracks, size_t count, const PackedTrack* layout, float* dst);
+void packTracksReference(const TrackDesc* tracks, size_t count, const PackedTrack* layout, float* dst);
@@ -0,0 +1,150 @@
+﻿#include "TriangleTessellator.h"
+#include <math.h>
+
+namespace detail
+{
+	constexpr float maxTessFactor = 63.0f;
+
+	//リングの点を追加し, 先頭の番号を返す (segments == 0は中心の1点)
+	uint32_t addRing(TessellatedPatch* out, uint32_t segments, uint32_t totalSegments)
+	{
+		const uint32_t first = static_cast<uint32_t>(out->domain.size() / 3);
+		const float third = 1.0f / 3.0f;
+		const float scale = static_cast<float>(segments) / static_cast<float>(totalSegments);
+		float corners[3][3];
+		for (int k = 0; k < 3; k++)
+		{
+			for (int c = 0; c < 3; c++) { corners[k][c] = third + ((k == c ? 1.0f : 0.0f) - third) * scale; }
+		}
+		if (segments == 0)
+		{
+			out->domain.insert(out->domain.end(), { third, third, third });
+			return first;
+		}
+		for (int k = 0; k < 3; k++)
+		{
+			const float* from = corners[k];
+			const float* to = corners[(k + 1) % 3];
+			for (uint32_t j = 0; j < segments; j++)
+			{
+				const float t = static_cast<float>(j) / static_cast<float>(segments);
+				for (int c = 0; c < 3; c++) { out->domain.push_back(from[c] + (to[c] - from[c]) * t); }
+			}
+		}
+		return first;
+	}
+}
+
+uint32_t getFractionalOddSegments(float factor)
+{
+	if (!(factor > 0.0f)) { return 0; }
+	const float clamped = factor < 1.0f ? 1.0f : (factor > detail::maxTessFactor ? detail::maxTessFactor : factor);
+	const uint32_t segments = static_cast<uint32_t>(ceilf(clamped));
+	return segments | 1;
+}
+
+namespace detail
+{
+	//内側の分割数. 内側が1でも辺が分割されていれば3に上げる
+	uint32_t getInsideSegments(const uint32_t edges[3], float insideFactor)
+	{
+		const uint32_t inside = getFractionalOddSegments(insideFactor > 1.0f ? insideFactor : 1.0f);
+		if (inside == 1 && (edges[0] > 1 || edges[1] > 1 || edges[2] > 1)) { return 3; }
+		return inside;
+	}
+}
+
+uint32_t getTessellatedTriangleCount(float factor)
+{
+	const uint32_t n = getFractionalOddSegments(factor);
+	return n == 0 ? 0 : (3 * n * n - 1) / 2;
+}
+
+uint32_t getTessellatedTriangleCount(const float edgeFactors[3], float insideFactor)
+{
+	const uint32_t edges[3] = { getFractionalOddSegments(edgeFactors[0]), getFractionalOddSegments(edgeFactors[1]), getFractionalOddSegments(edgeFactors[2]) };
+	if (edges[0] == 0 || edges[1] == 0 || edges[2] == 0) { return 0; }
+	const uint32_t n = detail::getInsideSegments(edges, insideFactor);
+	if (n == 1) { return 1; }
+	//内側は一様な分割, 外周は辺ごとにe + (n - 2)枚
+	return getTessellatedTriangleCount(static_cast<float>(n - 2)) + edges[0] + edges[1] + edges[2] + 3 * (n - 2);
+}
+
+void tessellateTriangle(float factor, TessellatedPatch* out)
+{
+	const float edgeFactors[3] = { factor, factor, factor };
+	tessellateTriangle(edgeFactors, factor, out);
+}
+
+void tessellateTriangle(const float edgeFactors[3], float insideFactor, TessellatedPatch* out)
+{
+	out->domain.clear();
+	out->indices.clear();
+	const uint32_t edges[3] = { getFractionalOddSegments(edgeFactors[0]), getFractionalOddSegments(edgeFactors[1]), getFractionalOddSegments(edgeFactors[2]) };
+	if (edges[0] == 0 || edges[1] == 0 || edges[2] == 0) { return; }
+	const uint32_t n = detail::getInsideSegments(edges, insideFactor);
+
+	//外周だけは辺ごとの分割数で点を置く
+	const uint32_t outerFirst = static_cast<uint32_t>(out->domain.size() / 3);
+	for (int k = 0; k < 3; k++)
+	{
+		for (uint32_t j = 0; j < edges[k]; j++)
+		{
+			const float t = static_cast<float>(j) / static_cast<float>(edges[k]);
+			for (int c = 0; c < 3; c++)
+			{
+				const float from = k == c ? 1.0f : 0.0f;
+				const float to = (k + 1) % 3 == c ? 1.0f : 0.0f;
+				out->domain.push_back(from + (to - from) * t);
+			}
+		}
+	}
+	if (n == 1)
+	{
+		out->indices.insert(out->indices.end(), { outerFirst, outerFirst + 1, outerFirst + 2 });
+		return;
+	}
+
+	//外側のリングから内側へ, 隣り合う2本のリングの間を三角形で埋める
+	uint32_t outer = outerFirst;
+	uint32_t outerSides[3] = { edges[0], edges[1], edges[2] };
+	for (uint32_t m = n; m > 1; m -= 2)
+	{
+		const uint32_t innerSegments = m - 2;
+		const uint32_t inner = detail::addRing(out, innerSegments, n);
+		const uint32_t outerCount = outerSides[0] + outerSides[1] + outerSides[2];
+		const uint32_t innerCount = innerSegments == 0 ? 1 : 3 * innerSegments;
+		uint32_t sideStart = 0;
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			//辺ごとに外側と内側の区間を, 辺上の位置が近い方から進めて縫う
+			const uint32_t sideSegments = outerSides[k];
+			uint32_t j = 0;
+			uint32_t l = 0;
+			while (j < sideSegments || l < innerSegments)
+			{
+				const uint32_t o0 = outer + (sideStart + j) % outerCount;
+				const uint32_t i0 = inner + (innerSegments == 0 ? 0 : (k * innerSegments + l) % innerCount);
+				//内側の点lは外側の辺で(l + 1) / mの位置にある
+				const bool advanceOuter = l == innerSegments || (j < sideSegments && (j + 1) * m <= (l + 2) * sideSegments);
+				if (advanceOuter)
+				{
+					const uint32_t o1 = outer + (sideStart + j + 1) % outerCount;
+					out->indices.insert(out->indices.end(), { o0, o1, i0 });
+					j++;
+				}
+				else
+				{
+					const uint32_t i1 = inner + (k * innerSegments + l + 1) % innerCount;
+					out->indices.insert(out->indices.end(), { o0, i1, i0 });
+					l++;
+				}
+			}
+			sideStart += sideSegments;
+		}
+		outer = inner;
+		outerSides[0] = outerSides[1] = outerSides[2] = innerSegments;
+	}
+	//奇数分割なので最後は中心の三角形
+	out->indices.insert(out->indices.end(), { outer, outer + 1, outer + 2 });
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/****************************************************************
+	CPU model of the fixed-function tessellator for a tri patch
+	whose three edge factors and inside factor are all the same,
+	as Destruction_hs sets them to divNum, with
+	partitioning("fractional_odd").
+	The factor is clamped to [1, 63] and each edge gets the next odd
+	segment count n >= factor; a factor <= 0 or NaN culls the patch.
+	The inside is built from concentric rings of n, n - 2, ... 3
+	segments per side around a center triangle, so a patch yields
+	(3 n^2 - 1) / 2 triangles.
+	With separate edge factors the outer ring has e0 + e1 + e2
+	points and is stitched to a uniform inside of n segments; an
+	inside of 1 is raised to 3 when any edge is split.
+	tessellateTriangle emits that topology with evenly spaced points;
+	the GPU moves the two short fractional segments but keeps the
+	topology, so the counts match what stream output captures.
+****************************************************************/
+struct TessellatedPatch
+{
+	std::vector<float> domain;			// 3 barycentric weights per point (SV_DomainLocation)
+	std::vector<uint32_t> indices;		// triangle list
+};
+
+uint32_t getFractionalOddSegments(float factor);
+uint32_t getTessellatedTriangleCount(float factor);
+// EdgeTessFactor[3] / InsideTessFactor; 0 when any edge factor culls the patch.
+uint32_t getTessellatedTriangleCount(const float edgeFactors[3], float insideFactor);
+void tessellateTriangle(float factor, TessellatedPatch* out);
+void tessellateTriangle(const float edgeFactors[3], float insideFactor, TessellatedPatch* out);
@@ -0,0 +1,220 @@
+﻿#include "VertexQuantization.h"
+#include <math.h>
+#include <string.h>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VERTEX_QUANTIZATION_SSE2
+#endif
+
+namespace detail
+{
+	inline const float* strided(const float* base, size_t index, size_t stride)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(base) + index * stride);
+	}
+
+	inline float positionScale(float extent)
+	{
+		return 65535.0f / extent;
+	}
+
+#ifdef VERTEX_QUANTIZATION_SSE2
+	inline void loadStrided3(const float* base, size_t first, size_t stride, __m128& x, __m128& y, __m128& z)
+	{
+		const float* p0 = strided(base, first + 0, stride);
+		const float* p1 = strided(base, first + 1, stride);
+		const float* p2 = strided(base, first + 2, stride);
+		const float* p3 = strided(base, first + 3, stride);
+		x = _mm_set_ps(p3[0], p2[0], p1[0], p0[0]);
+		y = _mm_set_ps(p3[1], p2[1], p1[1], p0[1]);
+		z = _mm_set_ps(p3[2], p2[2], p1[2], p0[2]);
+	}
+
+	// Pack two int32x4 holding 0..65535 into uint16x8 (SSE2 has no unsigned pack).
+	inline __m128i packUnsigned16(__m128i a, __m128i b)
+	{
+		const __m128i bias32 = _mm_set1_epi32(32768);
+		const __m128i bias16 = _mm_set1_epi16(-32768);
+		return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), bias16);
+	}
+#endif
+}
+
+QuantizationBounds computeQuantizationBounds(const float* positions, size_t count, size_t stride)
+{
+	QuantizationBounds bounds{};
+	if (count == 0) { return bounds; }
+	float mn[3] = { positions[0],positions[1],positions[2] };
+	float mx[3] = { positions[0],positions[1],positions[2] };
+	for (size_t i = 1; i < count; i++)
+	{
+		const float* p = detail::strided(positions, i, stride);
+		for (int k = 0; k < 3; k++)
+		{
+			if (p[k] < mn[k]) { mn[k] = p[k]; }
+			if (p[k] > mx[k]) { mx[k] = p[k]; }
+		}
+	}
+	for (int k = 0; k < 3; k++)
+	{
+		bounds.min[k] = mn[k];
+		bounds.extent[k] = mx[k] - mn[k];
+		if (!(bounds.extent[k] > 0.0f)) { bounds.extent[k] = 1.0f; }
+	}
+	return bounds;
+}
+
+void getDequantizationMatrix(float outMatrix[16], const QuantizationBounds& bounds)
+{
+	memset(outMatrix, 0, sizeof(float) * 16);
+	outMatrix[0] = bounds.extent[0];
+	outMatrix[5] = bounds.extent[1];
+	outMatrix[10] = bounds.extent[2];
+	outMatrix[12] = bounds.min[0];
+	outMatrix[13] = bounds.min[1];
+	outMatrix[14] = bounds.min[2];
+	outMatrix[15] = 1.0f;
+}
+
+void quantizePositionsReference(QuantizedVertex* dst, const float* positions, size_t count, size_t stride, const QuantizationBounds& bounds)
+{
+	const float scale[3] = { detail::positionScale(bounds.extent[0]),detail::positionScale(bounds.extent[1]),detail::positionScale(bounds.extent[2]) };
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* p = detail::strided(positions, i, stride);
+		for (int k = 0; k < 3; k++)
+		{
+			float q = (p[k] - bounds.min[k]) * scale[k];
+			q = q > 0.0f ? q : 0.0f;
+			q = q < 65535.0f ? q : 65535.0f;
+			dst[i].position[k] = static_cast<unsigned short>(lrintf(q));
+		}
+		dst[i].position[3] = 0;
+	}
+}
+
+void encodeOctahedralNormalsReference(QuantizedVertex* dst, const float* normals, size_t count, size_t stride)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* n = detail::strided(normals, i, stride);
+		const float sum = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+		const float inverse = sum > 0.0f ? 1.0f / sum : 0.0f;
+		float x = n[0] * inverse;
+		float y = n[1] * inverse;
+		if (n[2] < 0.0f)
+		{
+			const float fx = (1.0f - fabsf(y)) * copysignf(1.0f, x);
+			const float fy = (1.0f - fabsf(x)) * copysignf(1.0f, y);
+			x = fx;
+			y = fy;
+		}
+		x = x > -1.0f ? (x < 1.0f ? x : 1.0f) : -1.0f;
+		y = y > -1.0f ? (y < 1.0f ? y : 1.0f) : -1.0f;
+		dst[i].normal[0] = static_cast<short>(lrintf(x * 32767.0f));
+		dst[i].normal[1] = static_cast<short>(lrintf(y * 32767.0f));
+	}
+}
+
+void quantizePositions(QuantizedVertex* dst, const float* positions, size_t count, size_t stride, const QuantizationBounds& bounds)
+{
+	size_t i = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+	const __m128 minX = _mm_set1_ps(bounds.min[0]);
+	const __m128 minY = _mm_set1_ps(bounds.min[1]);
+	const __m128 minZ = _mm_set1_ps(bounds.min[2]);
+	const __m128 scaleX = _mm_set1_ps(detail::positionScale(bounds.extent[0]));
+	const __m128 scaleY = _mm_set1_ps(detail::positionScale(bounds.extent[1]));
+	const __m128 scaleZ = _mm_set1_ps(detail::positionScale(bounds.extent[2]));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 upper = _mm_set1_ps(65535.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		detail::loadStrided3(positions, i, stride, x, y, z);
+		x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(x, minX), scaleX), zero), upper);
+		y = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(y, minY), scaleY), zero), upper);
+		z = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(z, minZ), scaleZ), zero), upper);
+		const __m128i xy = detail::packUnsigned16(_mm_cvtps_epi32(x), _mm_cvtps_epi32(y));
+		const __m128i zw = detail::packUnsigned16(_mm_cvtps_epi32(z), _mm_setzero_si128());
+		// x0..x3 y0..y3 / z0..z3 w0..w3 -> x y z w per vertex
+		const __m128i xz = _mm_unpacklo_epi16(xy, zw);
+		const __m128i yw = _mm_unpackhi_epi16(xy, zw);
+		const __m128i v01 = _mm_unpacklo_epi16(xz, yw);
+		const __m128i v23 = _mm_unpackhi_epi16(xz, yw);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst[i + 0].position), v01);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst[i + 1].position), _mm_srli_si128(v01, 8));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst[i + 2].position), v23);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst[i + 3].position), _mm_srli_si128(v23, 8));
+	}
+#endif
+	quantizePositionsReference(dst + i, detail::strided(positions, i, stride), count - i, stride, bounds);
+}
+
+void encodeOctahedralNormals(QuantizedVertex* dst, const float* normals, size_t count, size_t stride)
+{
+	size_t i = 0;
+#ifdef VERTEX_QUANTIZATION_SSE2
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minusOne = _mm_set1_ps(-1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 snorm = _mm_set1_ps(32767.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		detail::loadStrided3(normals, i, stride, x, y, z);
+		const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)), _mm_andnot_ps(signMask, z));
+		const __m128 inverse = _mm_and_ps(_mm_div_ps(one, sum), _mm_cmpgt_ps(sum, zero));
+		x = _mm_mul_ps(x, inverse);
+		y = _mm_mul_ps(y, inverse);
+		// Fold the lower hemisphere over the diagonals.
+		const __m128 fx = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, y)), _mm_or_ps(_mm_and_ps(x, signMask), one));
+		const __m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), _mm_or_ps(_mm_and_ps(y, signMask), one));
+		const __m128 lower = _mm_cmplt_ps(z, zero);
+		x = _mm_or_ps(_mm_and_ps(lower, fx), _mm_andnot_ps(lower, x));
+		y = _mm_or_ps(_mm_and_ps(lower, fy), _mm_andnot_ps(lower, y));
+		x = _mm_min_ps(_mm_max_ps(x, minusOne), one);
+		y = _mm_min_ps(_mm_max_ps(y, minusOne), one);
+		const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(x, snorm)), _mm_cvtps_epi32(_mm_mul_ps(y, snorm)));
+		const __m128i interleaved = _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8));
+		int words[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(words), interleaved);
+		for (int k = 0; k < 4; k++)
+		{
+			memcpy(dst[i + k].normal, &words[k], sizeof(int));
+		}
+	}
+#endif
+	encodeOctahedralNormalsReference(dst + i, detail::strided(normals, i, stride), count - i, stride);
+}
+
+void quantizeVertices(QuantizedVertex* dst, const void* vertices, size_t count, size_t stride, size_t normalOffset, const QuantizationBounds& bounds)
+{
+	const float* positions = static_cast<const float*>(vertices);
+	const float* normals = reinterpret_cast<const float*>(static_cast<const unsigned char*>(vertices) + normalOffset);
+	quantizePositions(dst, positions, count, stride, bounds);
+	encodeOctahedralNormals(dst, normals, count, stride);
+}
+
+void dequantizePosition(float outPosition[3], const QuantizedVertex& vertex, const QuantizationBounds& bounds)
+{
+	for (int k = 0; k < 3; k++)
+	{
+		outPosition[k] = bounds.min[k] + (vertex.position[k] / 65535.0f) * bounds.extent[k];
+	}
+}
+
+void decodeOctahedralNormal(float outNormal[3], const QuantizedVertex& vertex)
+{
+	float x = fmaxf(vertex.normal[0] / 32767.0f, -1.0f);
+	float y = fmaxf(vertex.normal[1] / 32767.0f, -1.0f);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	const float t = fmaxf(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+	const float length = sqrtf(x * x + y * y + z * z);
+	outNormal[0] = x / length;
+	outNormal[1] = y / length;
+	outNormal[2] = z / length;
+}
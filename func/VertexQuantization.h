@@ -0,0 +1,50 @@
+﻿#pragma once
+#include <stddef.h>
+
+/****************************************************************
+	12-byte vertex.
+	position = R16G16B16A16_UNORM relative to the mesh bounds,
+	normal = octahedral R16G16_SNORM.
+****************************************************************/
+struct QuantizedVertex
+{
+	unsigned short position[4];
+	short normal[2];
+};
+static_assert(sizeof(QuantizedVertex) == 12, "QuantizedVertex must stay 12 bytes");
+
+struct QuantizationBounds
+{
+	float min[3] = { 0.0f,0.0f,0.0f };
+	float extent[3] = { 1.0f,1.0f,1.0f };
+};
+
+/****************************************************************
+	Axis-aligned bounds of a strided float3 array.
+	Zero extents are widened so dequantization stays invertible.
+****************************************************************/
+QuantizationBounds computeQuantizationBounds(const float* positions, size_t count, size_t stride);
+
+/****************************************************************
+	Row-major matrix that maps UNORM positions back to object
+	space. Multiply it in front of the world matrix.
+****************************************************************/
+void getDequantizationMatrix(float outMatrix[16], const QuantizationBounds& bounds);
+
+/****************************************************************
+	SIMD encoders. positions and normals are strided float3 arrays
+	(stride in bytes). Both match the scalar reference bit for bit.
+	Error: about extent / 131070 per axis for positions,
+	below 0.001 radians for normals.
+****************************************************************/
+void quantizePositions(QuantizedVertex* dst, const float* positions, size_t count, size_t stride, const QuantizationBounds& bounds);
+void encodeOctahedralNormals(QuantizedVertex* dst, const float* normals, size_t count, size_t stride);
+void quantizeVertices(QuantizedVertex* dst, const void* vertices, size_t count, size_t stride, size_t normalOffset, const QuantizationBounds& bounds);
+
+/****************************************************************
+	Scalar reference and decoders.
+****************************************************************/
+void quantizePositionsReference(QuantizedVertex* dst, const float* positions, size_t count, size_t stride, const QuantizationBounds& bounds);
+void encodeOctahedralNormalsReference(QuantizedVertex* dst, const float* normals, size_t count, size_t stride);
+void dequantizePosition(float outPosition[3], const QuantizedVertex& vertex, const QuantizationBounds& bounds);
+void decodeOctahedralNormal(float outNormal[3], const QuantizedVertex& vertex);
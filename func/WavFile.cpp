@@ -0,0 +1,115 @@
+﻿#include "WavFile.h"
+#include <string.h>
+
+namespace detail
+{
+	inline uint32_t readLe32(const unsigned char* p)
+	{
+		return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+	}
+
+	inline uint16_t readLe16(const unsigned char* p)
+	{
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+}
+
+WavParseResult parseWav(const void* fileData, size_t fileSize, WavFormat* outFormat)
+{
+	using detail::readLe16;
+	using detail::readLe32;
+	const unsigned char* data = static_cast<const unsigned char*>(fileData);
+	*outFormat = WavFormat();
+
+	//"RIFF", サイズ, "WAVE", チャンク...
+	if (!data || fileSize < 12 || memcmp(data, "RIFF", 4) != 0) { return WavParseResult::notRiff; }
+	if (memcmp(data + 8, "WAVE", 4) != 0) { return WavParseResult::notWave; }
+
+	bool foundFormat = false;
+	bool foundData = false;
+	uint32_t formatTag = 0;
+	size_t offset = 12;
+	while (offset + 8 <= fileSize && !(foundFormat && foundData))
+	{
+		const unsigned char* chunk = data + offset;
+		size_t chunkSize = readLe32(chunk + 4);
+		const size_t body = offset + 8;
+		if (chunkSize > fileSize - body)
+		{
+			//途中で切れたファイルはdataだけ読めるところまで使う
+			if (memcmp(chunk, "data", 4) != 0) { return WavParseResult::truncated; }
+			chunkSize = fileSize - body;
+		}
+		if (memcmp(chunk, "fmt ", 4) == 0)
+		{
+			if (chunkSize < 16) { return WavParseResult::unsupportedFormat; }
+			formatTag = readLe16(data + body);
+			outFormat->channels = readLe16(data + body + 2);
+			outFormat->samplesPerSec = readLe32(data + body + 4);
+			outFormat->blockAlign = readLe16(data + body + 12);
+			outFormat->bitsPerSample = readLe16(data + body + 14);
+			//WAVE_FORMAT_EXTENSIBLE: サブフォーマットGUIDの先頭2バイトが本来の形式
+			if (formatTag == 0xFFFE)
+			{
+				if (chunkSize < 40) { return WavParseResult::unsupportedFormat; }
+				formatTag = readLe16(data + body + 24);
+			}
+			foundFormat = true;
+		}
+		else if (memcmp(chunk, "data", 4) == 0)
+		{
+			outFormat->dataOffset = body;
+			outFormat->dataSize = chunkSize;
+			foundData = true;
+		}
+		//チャンクは2バイト境界に揃えられる
+		offset = body + chunkSize + (chunkSize & 1);
+	}
+	if (!foundFormat) { return WavParseResult::missingFormat; }
+	if (!foundData) { return WavParseResult::missingData; }
+
+	const uint32_t bits = outFormat->bitsPerSample;
+	if (formatTag == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) { outFormat->sampleType = WavSampleType::pcm; }
+	else if (formatTag == 3 && bits == 32) { outFormat->sampleType = WavSampleType::ieeeFloat; }
+	else { return WavParseResult::unsupportedFormat; }
+	if (outFormat->channels == 0 || outFormat->blockAlign != outFormat->channels * (bits / 8)) { return WavParseResult::unsupportedFormat; }
+
+	outFormat->frameCount = outFormat->dataSize / outFormat->blockAlign;
+	outFormat->dataSize = outFormat->frameCount * outFormat->blockAlign;
+	return WavParseResult::ok;
+}
+
+PcmFormat getPcmFormat(const WavFormat& format)
+{
+	if (format.sampleType == WavSampleType::ieeeFloat) { return PcmFormat::float32; }
+	switch (format.bitsPerSample)
+	{
+	case 8: return PcmFormat::unsigned8;
+	case 16: return PcmFormat::signed16;
+	case 24: return PcmFormat::signed24;
+	default: return PcmFormat::signed32;
+	}
+}
+
+WavParseResult WavFile::open(const char* path)
+{
+	close();
+	if (!file.open(path)) { return WavParseResult::notRiff; }
+	const WavParseResult result = parseWav(file.getData(), file.getSize(), &format);
+	if (result != WavParseResult::ok) { close(); }
+	return result;
+}
+
+void WavFile::close()
+{
+	file.close();
+	format = WavFormat();
+}
+
+size_t WavFile::readMono(size_t first, size_t count, float* out)const
+{
+	if (first >= format.frameCount) { return 0; }
+	if (count > format.frameCount - first) { count = format.frameCount - first; }
+	convertPcmMono(getData() + first * format.blockAlign, getPcmFormat(format), format.channels, count, out);
+	return count;
+}
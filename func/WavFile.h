@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "MappedFile.h"
+#include "PcmConversion.h"
+
+/****************************************************************
+	RIFF / WAVE reader without mmio.
+	parseWav walks the chunks of a file image: "fmt " and "data" may
+	appear in any order, unknown chunks (LIST, fact, ...) are skipped
+	with their pad byte. Supported payloads are integer PCM of 8, 16,
+	24 and 32 bits and 32-bit float, plain or WAVE_FORMAT_EXTENSIBLE.
+	A data chunk that claims more bytes than the file holds (a
+	recording that was cut off) is clamped to whole frames.
+****************************************************************/
+
+enum class WavSampleType { pcm, ieeeFloat };
+
+enum class WavParseResult { ok, notRiff, notWave, missingFormat, missingData, unsupportedFormat, truncated };
+
+struct WavFormat
+{
+	WavSampleType sampleType = WavSampleType::pcm;
+	uint32_t channels = 0;
+	uint32_t samplesPerSec = 0;
+	uint32_t bitsPerSample = 0;
+	uint32_t blockAlign = 0;		// bytes per frame
+	size_t dataOffset = 0;			// from the start of the file
+	size_t dataSize = 0;			// whole frames only
+	size_t frameCount = 0;
+};
+
+WavParseResult parseWav(const void* fileData, size_t fileSize, WavFormat* outFormat);
+// Sample layout of a parsed format, for convertPcm.
+PcmFormat getPcmFormat(const WavFormat& format);
+
+/****************************************************************
+	Memory mapped WAV. Only the pages that are read get loaded, so
+	a window of a long recording costs what the window needs.
+	readMono converts frames [first, first + count) to float in
+	[-1, 1], averaging the channels, with convertPcmMono.
+****************************************************************/
+class WavFile
+{
+private:
+	MappedFile file;
+	WavFormat format;
+public:
+	WavParseResult open(const char* path);
+	void close();
+
+	bool isOpen()const { return file.isOpen(); }
+	const WavFormat& getFormat()const { return format; }
+	size_t getFrameCount()const { return format.frameCount; }
+	const unsigned char* getData()const { return file.getData() + format.dataOffset; }
+
+	// count is clamped to the end of the data. Returns frames written.
+	size_t readMono(size_t first, size_t count, float* out)const;
+};
@@ -0,0 +1,222 @@
+﻿#include "WaveformPyramid.h"
+#include "ParallelFor.h"
+#include <assert.h>
+#include <math.h>
+#include <chrono>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define WAVEFORM_PYRAMID_SSE2
+#endif
+
+namespace detail
+{
+	inline double elapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void reduceScalar(const float* samples, size_t count, WaveformEnvelope& out)
+	{
+		float minimum = samples[0];
+		float maximum = samples[0];
+		float sumSquares = 0.0f;
+		for (size_t i = 0; i < count; i++)
+		{
+			minimum = samples[i] < minimum ? samples[i] : minimum;
+			maximum = samples[i] > maximum ? samples[i] : maximum;
+			sumSquares += samples[i] * samples[i];
+		}
+		out.minimum = minimum;
+		out.maximum = maximum;
+		out.rms = sqrtf(sumSquares / static_cast<float>(count));
+	}
+
+	//0段目: block個ずつのサンプルを1要素にまとめる (最後の要素は短くてもよい)
+	void reduceBlocks(const float* samples, size_t count, uint32_t block, WaveformEnvelope* out)
+	{
+		const size_t entryCount = (count + block - 1) / block;
+		for (size_t i = 0; i < entryCount; i++)
+		{
+			const float* s = samples + i * block;
+			const size_t n = count - i * block < block ? count - i * block : block;
+#ifdef WAVEFORM_PYRAMID_SSE2
+			if (n == block)
+			{
+				__m128 v = _mm_loadu_ps(s);
+				__m128 minimum = v;
+				__m128 maximum = v;
+				__m128 sumSquares = _mm_mul_ps(v, v);
+				for (uint32_t k = 4; k < block; k += 4)
+				{
+					v = _mm_loadu_ps(s + k);
+					minimum = _mm_min_ps(minimum, v);
+					maximum = _mm_max_ps(maximum, v);
+					sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(v, v));
+				}
+				minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+				maximum = _mm_max_ps(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+				sumSquares = _mm_add_ps(sumSquares, _mm_shuffle_ps(sumSquares, sumSquares, _MM_SHUFFLE(1, 0, 3, 2)));
+				minimum = _mm_min_ss(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+				maximum = _mm_max_ss(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+				sumSquares = _mm_add_ss(sumSquares, _mm_shuffle_ps(sumSquares, sumSquares, _MM_SHUFFLE(2, 3, 0, 1)));
+				out[i].minimum = _mm_cvtss_f32(minimum);
+				out[i].maximum = _mm_cvtss_f32(maximum);
+				out[i].rms = _mm_cvtss_f32(_mm_sqrt_ss(_mm_mul_ss(sumSquares, _mm_set_ss(1.0f / static_cast<float>(block)))));
+				continue;
+			}
+#endif
+			reduceScalar(s, n, out[i]);
+		}
+	}
+}
+
+void WaveformPyramid::allocate(size_t count, uint32_t block)
+{
+	assert(block >= 4 && block % 4 == 0 && "The block must be a multiple of 4.");
+	this->block = block;
+	sampleCount = count;
+	levelOffsets.clear();
+	envelopes.clear();
+	if (count == 0) { return; }
+
+	size_t size = (count + block - 1) / block;
+	size_t offset = 0;
+	levelOffsets.push_back(0);
+	while (true)
+	{
+		offset += size;
+		levelOffsets.push_back(static_cast<uint32_t>(offset));
+		if (size == 1 || levelOffsets.size() > maxLevels) { break; }
+		size = (size + 1) / 2;
+	}
+	envelopes.resize(offset);
+}
+
+uint32_t WaveformPyramid::getEntrySampleCount(uint32_t level, size_t index)const
+{
+	const size_t span = getLevelSpan(level);
+	const size_t first = index * span;
+	return static_cast<uint32_t>(sampleCount - first < span ? sampleCount - first : span);
+}
+
+void WaveformPyramid::mergeLevel(uint32_t level, size_t begin, size_t end)
+{
+	const WaveformEnvelope* lower = envelopes.data() + levelOffsets[level - 1];
+	const size_t lowerSize = getLevelSize(level - 1);
+	WaveformEnvelope* upper = envelopes.data() + levelOffsets[level];
+	for (size_t i = begin; i < end; i++)
+	{
+		const WaveformEnvelope& a = lower[i * 2];
+		if (i * 2 + 1 >= lowerSize)
+		{
+			upper[i] = a;
+			continue;
+		}
+		const WaveformEnvelope& b = lower[i * 2 + 1];
+		//RMSはサンプル数で重み付けして合成する (末尾の要素は短い)
+		const float countA = static_cast<float>(getEntrySampleCount(level - 1, i * 2));
+		const float countB = static_cast<float>(getEntrySampleCount(level - 1, i * 2 + 1));
+		upper[i].minimum = a.minimum < b.minimum ? a.minimum : b.minimum;
+		upper[i].maximum = a.maximum > b.maximum ? a.maximum : b.maximum;
+		upper[i].rms = sqrtf((a.rms * a.rms * countA + b.rms * b.rms * countB) / (countA + countB));
+	}
+}
+
+double WaveformPyramid::build(const float* samples, size_t count, uint32_t block)
+{
+	return buildChunks(count, block, [samples](size_t first, size_t, std::vector<float>&) { return samples + first; });
+}
+
+double WaveformPyramid::build(const SampleSource& source, size_t count, uint32_t block)
+{
+	return buildChunks(count, block, [&source](size_t first, size_t chunkSamples, std::vector<float>& scratch)
+		{
+			scratch.resize(chunkSamples);
+			source(first, chunkSamples, scratch.data());
+			return static_cast<const float*>(scratch.data());
+		});
+}
+
+template<class GetSamples>
+double WaveformPyramid::buildChunks(size_t count, uint32_t block, GetSamples getSamples)
+{
+	const auto start = std::chrono::steady_clock::now();
+	allocate(count, block);
+	const uint32_t levelCount = getLevelCount();
+	if (levelCount == 0) { return detail::elapsedMilliseconds(start); }
+
+	//チャンク単位で下の段から畳み込み, キャッシュに載っているうちに上の段を作る
+	const uint32_t localLevels = levelCount < chunkLevels + 1 ? levelCount : chunkLevels + 1;
+	const size_t baseSize = getLevelSize(0);
+	const size_t chunkCount = (baseSize + chunkEntries - 1) / chunkEntries;
+	parallelForRanges(chunkCount, 1, [&](size_t begin, size_t end, size_t)
+		{
+			std::vector<float> scratch;
+			for (size_t chunk = begin; chunk < end; chunk++)
+			{
+				const size_t first = chunk * chunkEntries;
+				const size_t last = first + chunkEntries < baseSize ? first + chunkEntries : baseSize;
+				const size_t firstSample = first * block;
+				const size_t lastSample = last * block < count ? last * block : count;
+				const float* samples = getSamples(firstSample, lastSample - firstSample, scratch);
+				detail::reduceBlocks(samples, lastSample - firstSample, block, envelopes.data() + first);
+				for (uint32_t level = 1; level < localLevels; level++)
+				{
+					const size_t levelFirst = first >> level;
+					const size_t levelLast = (chunk + 1) * (chunkEntries >> level);
+					const size_t levelSize = getLevelSize(level);
+					mergeLevel(level, levelFirst, levelLast < levelSize ? levelLast : levelSize);
+				}
+			}
+		});
+	//残りの段はチャンク数以下の要素しかない
+	for (uint32_t level = localLevels; level < levelCount; level++)
+	{
+		mergeLevel(level, 0, getLevelSize(level));
+	}
+	return detail::elapsedMilliseconds(start);
+}
+
+void WaveformPyramid::buildReference(const float* samples, size_t count, uint32_t block)
+{
+	allocate(count, block);
+	for (uint32_t level = 0; level < getLevelCount(); level++)
+	{
+		const size_t span = getLevelSpan(level);
+		for (size_t i = 0; i < getLevelSize(level); i++)
+		{
+			const size_t first = i * span;
+			const size_t n = getEntrySampleCount(level, i);
+			float minimum = samples[first];
+			float maximum = samples[first];
+			double sumSquares = 0.0;
+			for (size_t k = first; k < first + n; k++)
+			{
+				minimum = samples[k] < minimum ? samples[k] : minimum;
+				maximum = samples[k] > maximum ? samples[k] : maximum;
+				sumSquares += double(samples[k]) * samples[k];
+			}
+			WaveformEnvelope& out = envelopes[levelOffsets[level] + i];
+			out.minimum = minimum;
+			out.maximum = maximum;
+			out.rms = static_cast<float>(sqrt(sumSquares / static_cast<double>(n)));
+		}
+	}
+}
+
+void WaveformPyramid::clear()
+{
+	envelopes.clear();
+	envelopes.shrink_to_fit();
+	levelOffsets.clear();
+	sampleCount = 0;
+}
+
+int WaveformPyramid::selectLevel(float samplesPerPixel)const
+{
+	const uint32_t levelCount = getLevelCount();
+	if (levelCount == 0 || samplesPerPixel < static_cast<float>(block)) { return -1; }
+	int level = 0;
+	while (static_cast<uint32_t>(level + 1) < levelCount && static_cast<float>(getLevelSpan(level + 1)) <= samplesPerPixel) { level++; }
+	return level;
+}
@@ -0,0 +1,78 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+/****************************************************************
+	Min / max / RMS of a run of samples.
+	Same layout as Envelope in WavePaint_ps.
+****************************************************************/
+struct WaveformEnvelope
+{
+	float minimum;
+	float maximum;
+	float rms;
+};
+static_assert(sizeof(WaveformEnvelope) == 12, "WaveformEnvelope must match the HLSL layout");
+
+/****************************************************************
+	Multi-resolution envelope of a mono waveform.
+	Level 0 summarizes blocks of `block` samples, every further level
+	halves the entry count, up to a single entry for the whole wave.
+	All levels live in one array (getLevelOffset), so the pixel
+	shader reads them from a single StructuredBuffer.
+	A pixel covering n samples reads level floor(log2(n / block)),
+	where one entry spans at most one pixel, so at most 3 entries are
+	read whatever the zoom. Below `block` samples per pixel the raw
+	samples are cheaper.
+	build uses SSE2 for level 0 and builds 4096 entry chunks on all
+	cores; buildReference is the scalar version with double sums.
+	All levels together take 24 / block bytes per sample (1.5 for
+	the default block of 16).
+****************************************************************/
+class WaveformPyramid
+{
+public:
+	static constexpr uint32_t maxLevels = 31;
+	static constexpr uint32_t defaultBlock = 16;
+private:
+	std::vector<WaveformEnvelope> envelopes;
+	std::vector<uint32_t> levelOffsets;		// levelCount + 1
+	size_t sampleCount = 0;
+	uint32_t block = defaultBlock;
+
+	void allocate(size_t count, uint32_t block);
+	// Samples covered by entry index of level.
+	uint32_t getEntrySampleCount(uint32_t level, size_t index)const;
+	void mergeLevel(uint32_t level, size_t begin, size_t end);
+	template<class GetSamples>
+	double buildChunks(size_t count, uint32_t block, GetSamples getSamples);
+public:
+	// Level 0 entries reduced together; source calls cover chunkEntries * block samples.
+	static constexpr uint32_t chunkLevels = 12;
+	static constexpr size_t chunkEntries = size_t(1) << chunkLevels;
+	// Writes samples [first, first + count) to out; called from worker threads.
+	using SampleSource = std::function<void(size_t first, size_t count, float* out)>;
+
+	// block must be a multiple of 4. Returns milliseconds.
+	double build(const float* samples, size_t count, uint32_t block = defaultBlock);
+	// Streams the samples chunk by chunk, so only one chunk per core is held.
+	double build(const SampleSource& source, size_t count, uint32_t block = defaultBlock);
+	void buildReference(const float* samples, size_t count, uint32_t block = defaultBlock);
+	void clear();
+
+	// -1 = draw from the raw samples.
+	int selectLevel(float samplesPerPixel)const;
+
+	uint32_t getLevelCount()const { return levelOffsets.empty() ? 0 : static_cast<uint32_t>(levelOffsets.size() - 1); }
+	uint32_t getLevelOffset(uint32_t level)const { return levelOffsets[level]; }
+	uint32_t getLevelSize(uint32_t level)const { return levelOffsets[level + 1] - levelOffsets[level]; }
+	// Samples per entry of level.
+	size_t getLevelSpan(uint32_t level)const { return size_t(block) << level; }
+	uint32_t getBlock()const { return block; }
+	size_t getSampleCount()const { return sampleCount; }
+	const WaveformEnvelope* getEnvelopes()const { return envelopes.data(); }
+	const WaveformEnvelope& getEnvelope(uint32_t level, size_t index)const { return envelopes[levelOffsets[level] + index]; }
+	size_t getEntryCount()const { return envelopes.size(); }
+};
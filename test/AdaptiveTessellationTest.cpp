@@ -0,0 +1,232 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "AdaptiveTessellation.h"
+#include "Frustum.h"
+#include "TriangleTessellator.h"
+#include <math.h>
+#include <stdio.h>
+
+namespace
+{
+	// Eye at the origin looking down +z: 60 degree vertical field of view, 16:9, 1080 pixels high.
+	TessellationConstants makeConstants()
+	{
+		const float n = 0.1f, f = 1000.0f;
+		const float ys = 1.0f / tanf(0.5f * 3.14159265f / 3.0f), xs = ys * 9.0f / 16.0f;
+		const float viewProjection[16] =
+		{
+			xs, 0, 0, 0,
+			0, ys, 0, 0,
+			0, 0, f / (f - n), 1,
+			0, 0, -n * f / (f - n), 0,
+		};
+		TessellationConstants constants;
+		extractFrustumPlanes(constants.frustumPlanes, viewProjection);
+		constants.pixelsPerUnit = getPixelsPerUnit(viewProjection, 1080.0f);
+		constants.adaptive = 1;
+		return constants;
+	}
+
+	const float eye[3] = { 0, 0, 0 };
+	// Facing +z, away from the eye; the normals below say which side is the front.
+	const float triangle[9] = { 0, 0, 10, 1, 0, 10, 0, 2, 10 };
+	const float normalsAway[9] = { 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+	const float normalsToEye[9] = { 0, 0, -1, 0, 0, -1, 0, 0, -1 };
+
+	double expectedFactor(const float* a, const float* b, const TessellationConstants& constants, float scale = 1.0f)
+	{
+		const double length = hypot(hypot(double(b[0]) - a[0], double(b[1]) - a[1]), double(b[2]) - a[2]);
+		const double distance = hypot(hypot((double(a[0]) + b[0]) * 0.5, (double(a[1]) + b[1]) * 0.5), (double(a[2]) + b[2]) * 0.5);
+		return length * scale * constants.pixelsPerUnit / distance / constants.pixelsPerSegment * constants.budgetScale;
+	}
+
+	struct TriangleCounts
+	{
+		uint64_t fixed = 0;
+		uint64_t adaptive = 0;
+	};
+
+	// Moves the mesh by offset and counts what the tessellator emits for it, with divNum everywhere and with adaptive factors.
+	TriangleCounts countTriangles(const TestMesh& mesh, const float offset[3], bool swapYZ, const TessellationPass& pass, const TessellationConstants& constants)
+	{
+		TriangleCounts counts;
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			float positions[9], normals[9];
+			for (int k = 0; k < 3; k++)
+			{
+				const TestVertex& v = mesh.vertices[mesh.indices[i + k]];
+				const float position[3] = { v.position[0], swapYZ ? v.position[2] : v.position[1], swapYZ ? v.position[1] : v.position[2] };
+				const float normal[3] = { v.normal[0], swapYZ ? v.normal[2] : v.normal[1], swapYZ ? v.normal[1] : v.normal[2] };
+				for (int c = 0; c < 3; c++)
+				{
+					positions[k * 3 + c] = position[c] + offset[c];
+					normals[k * 3 + c] = normal[c];
+				}
+			}
+			float edges[3], inside;
+			counts.fixed += getTessellatedTriangleCount(pass.divNum);
+			getPatchTessFactors(positions, normals, eye, pass, constants, edges, &inside);
+			counts.adaptive += getTessellatedTriangleCount(edges, inside);
+		}
+		return counts;
+	}
+}
+
+TEST(fixedFactorsUseDivNum)
+{
+	TessellationConstants constants = makeConstants();
+	constants.adaptive = 0;
+	constants.backfaceCulling = 1;
+	const TessellationPass pass{ 7, 0, 1, 0 };
+	// Without adaptive, even a back face far away keeps divNum.
+	const float far[9] = { 0, 0, 900, 1, 0, 900, 0, 2, 900 };
+	float edges[3], inside;
+	getPatchTessFactors(far, normalsAway, eye, pass, constants, edges, &inside);
+	for (float edge : edges) { CHECK(edge == 7.0f); }
+	CHECK(inside == 7.0f);
+}
+
+TEST(edgeFactorsFollowProjectedLength)
+{
+	const TessellationConstants constants = makeConstants();
+	CHECK_NEAR(constants.pixelsPerUnit, 540.0 * sqrt(3.0), 1e-2);
+	const TessellationPass pass{ 64, 0, 1, 0 };
+	float edges[3], inside;
+	getPatchTessFactors(triangle, normalsToEye, eye, pass, constants, edges, &inside);
+	// Edge k is opposite corner k.
+	CHECK_NEAR(edges[0], expectedFactor(triangle + 3, triangle + 6, constants), 1e-3);
+	CHECK_NEAR(edges[1], expectedFactor(triangle + 6, triangle + 0, constants), 1e-3);
+	CHECK_NEAR(edges[2], expectedFactor(triangle + 0, triangle + 3, constants), 1e-3);
+	CHECK(edges[2] < edges[1] && edges[1] < edges[0]);
+	CHECK(inside == edges[0]);
+
+	// The destruction scale grows the edges, budgetScale shrinks every factor.
+	const TessellationPass scaled{ 64, 0, -2, 0 };
+	getPatchTessFactors(triangle, normalsToEye, eye, scaled, constants, edges, &inside);
+	CHECK_NEAR(edges[2], expectedFactor(triangle + 0, triangle + 3, constants, 2.0f), 1e-3);
+	TessellationConstants halved = constants;
+	halved.budgetScale = 0.5f;
+	getPatchTessFactors(triangle, normalsToEye, eye, pass, halved, edges, &inside);
+	CHECK_NEAR(edges[0], expectedFactor(triangle + 3, triangle + 6, constants) * 0.5, 1e-3);
+}
+
+TEST(factorsClampToOneAndDivNum)
+{
+	const TessellationConstants constants = makeConstants();
+	float edges[3], inside;
+	// Close up every edge wants more than divNum.
+	const float near[9] = { 0, 0, 1, 1, 0, 1, 0, 2, 1 };
+	getPatchTessFactors(near, normalsToEye, eye, TessellationPass{ 5, 0, 1, 0 }, constants, edges, &inside);
+	for (float edge : edges) { CHECK(edge == 5.0f); }
+	CHECK(inside == 5.0f);
+	// Far away, and with a divNum below 1, they stay at 1.
+	const float far[9] = { 0, 0, 900, 1, 0, 900, 0, 2, 900 };
+	getPatchTessFactors(far, normalsToEye, eye, TessellationPass{ 5, 0, 1, 0 }, constants, edges, &inside);
+	for (float edge : edges) { CHECK(edge == 1.0f); }
+	getPatchTessFactors(near, normalsToEye, eye, TessellationPass{ 0, 0, 1, 0 }, constants, edges, &inside);
+	for (float edge : edges) { CHECK(edge == 1.0f); }
+	// Factors fall off with distance.
+	float previous = 64.0f;
+	for (float z = 2.0f; z < 1000.0f; z *= 2.0f)
+	{
+		const float moved[9] = { 0, 0, z, 1, 0, z, 0, 2, z };
+		getPatchTessFactors(moved, normalsToEye, eye, TessellationPass{ 64, 0, 1, 0 }, constants, edges, &inside);
+		CHECK(inside <= previous);
+		previous = inside;
+	}
+	CHECK(previous == 1.0f);
+}
+
+TEST(patchesOutsideTheFrustumAreCulled)
+{
+	const TessellationConstants constants = makeConstants();
+	float edges[3], inside;
+	const float behind[9] = { 0, 0, -10, 1, 0, -10, 0, 2, -10 };
+	getPatchTessFactors(behind, normalsToEye, eye, TessellationPass{ 8, 0, 1, 0 }, constants, edges, &inside);
+	CHECK(edges[0] == 0.0f && edges[1] == 0.0f && edges[2] == 0.0f && inside == 0.0f);
+	const float left[9] = { -100, 0, 10, -99, 0, 10, -100, 2, 10 };
+	getPatchTessFactors(left, normalsToEye, eye, TessellationPass{ 8, 0, 1, 0 }, constants, edges, &inside);
+	CHECK(inside == 0.0f);
+	// Moving along the normal, or scaling and rotating about the center, may bring it back in.
+	CHECK(isPatchVisible(left, normalsToEye, eye, TessellationPass{ 8, 100, 1, 0 }, constants));
+	CHECK(!isPatchVisible(left, normalsToEye, eye, TessellationPass{ 8, 0, 2, 0 }, constants));
+	CHECK(isPatchVisible(left, normalsToEye, eye, TessellationPass{ 8, 0, 50, 0 }, constants));
+	// Straddling a plane is visible.
+	const float straddle[9] = { -20, 0, 10, 20, 0, 10, 0, 2, 10 };
+	CHECK(isPatchVisible(straddle, normalsToEye, eye, TessellationPass{ 8, 0, 1, 0 }, constants));
+}
+
+TEST(backFacesAreCulledUnlessMoveReachesTheEye)
+{
+	TessellationConstants constants = makeConstants();
+	const TessellationPass pass{ 8, 0, 1, 0 };
+	CHECK(isPatchVisible(triangle, normalsAway, eye, pass, constants));
+	constants.backfaceCulling = 1;
+	CHECK(!isPatchVisible(triangle, normalsAway, eye, pass, constants));
+	// The vertex normals choose the front side, whatever the winding.
+	CHECK(isPatchVisible(triangle, normalsToEye, eye, pass, constants));
+	// The plane is 10 from the eye; moving it past the eye may show its front.
+	CHECK(!isPatchVisible(triangle, normalsAway, eye, TessellationPass{ 8, 9.5f, 1, 0 }, constants));
+	CHECK(isPatchVisible(triangle, normalsAway, eye, TessellationPass{ 8, -10.5f, 1, 0 }, constants));
+	// A degenerate patch is never culled as a back face.
+	const float line[9] = { 0, 0, 10, 1, 0, 10, 2, 0, 10 };
+	CHECK(isPatchVisible(line, normalsAway, eye, pass, constants));
+}
+
+TEST(budgetScaleStepsTowardTheBudget)
+{
+	// Within budget it heads back to 1 and never above.
+	CHECK(updateBudgetScale(1.0f, 500, 1000) == 1.0f);
+	CHECK_NEAR(updateBudgetScale(0.25f, 500, 1000), 0.25 * sqrt(2.0), 1e-6);
+	// Triangles grow with the square of the factors.
+	CHECK_NEAR(updateBudgetScale(1.0f, 4000, 1000), 0.5, 1e-6);
+	CHECK_NEAR(updateBudgetScale(1.0f, 2000, 1000), sqrt(0.5), 1e-6);
+	// One step moves by 2x at most, and stops at 1 / 64.
+	CHECK_NEAR(updateBudgetScale(1.0f, 1000000, 1000), 0.5, 1e-6);
+	CHECK_NEAR(updateBudgetScale(0.125f, 10, 1000), 0.25, 1e-6);
+	CHECK(updateBudgetScale(1.0f / 64.0f, 1000000, 1000) == 1.0f / 64.0f);
+	CHECK(updateBudgetScale(1.0f / 128.0f, 1000000, 1000) == 1.0f / 64.0f);
+	// Nothing drawn doubles it.
+	CHECK(updateBudgetScale(0.25f, 0, 1000) == 0.5f);
+
+	// Feeding back a count that grows with the square of the scale settles on the budget.
+	float scale = 1.0f;
+	for (int frame = 0; frame < 20; frame++)
+	{
+		const uint64_t measured = static_cast<uint64_t>(100000.0 * scale * scale);
+		scale = updateBudgetScale(scale, measured, 10000);
+	}
+	CHECK_NEAR(scale, sqrt(0.1), 1e-3);
+}
+
+TEST(adaptiveReportAgainstFixed)
+{
+	const TessellationConstants constants = makeConstants();
+	// A grid facing the eye close up: every edge reaches divNum and nothing is saved.
+	const TestMesh grid = makeGridMesh(8, 2.0f);
+	const float gridOffset[3] = { 0, 0, 1.5f };
+	const TriangleCounts close = countTriangles(grid, gridOffset, true, TessellationPass{ 8, 0, 1, 0 }, constants);
+	CHECK_EQ(close.fixed, 128 * getTessellatedTriangleCount(8.0f));
+	CHECK_EQ(close.adaptive, close.fixed);
+
+	// A sphere moving away with back faces culled: the adaptive count drops to about one triangle per front patch.
+	TessellationConstants culling = constants;
+	culling.backfaceCulling = 1;
+	const TestMesh sphere = makeSphereMesh(32, 16);
+	const size_t patches = sphere.indices.size() / 3;
+	uint64_t previous = UINT64_MAX;
+	for (float distance = 1.0f; distance <= 1000.0f; distance *= 4.0f)
+	{
+		const float offset[3] = { 0, 0, distance };
+		const TriangleCounts counts = countTriangles(sphere, offset, false, TessellationPass{ 16, 0, 1, 0 }, culling);
+		printf("distance %6.0f: fixed %llu, adaptive %llu (%.1f%%)\n", distance, static_cast<unsigned long long>(counts.fixed),
+			static_cast<unsigned long long>(counts.adaptive), 100.0 * counts.adaptive / counts.fixed);
+		CHECK_EQ(counts.fixed, patches * getTessellatedTriangleCount(16.0f));
+		CHECK(counts.adaptive < counts.fixed);
+		CHECK(counts.adaptive <= previous);
+		previous = counts.adaptive;
+	}
+	CHECK(previous <= patches);
+	CHECK(previous >= patches / 3);
+}
@@ -0,0 +1,209 @@
+﻿#include "Test.h"
+#include "ComputeReference.h"
+#include "ShaderReflection.h"
+#include <stddef.h>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	void appendU32(std::vector<unsigned char>& out, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++) { out.push_back(static_cast<unsigned char>(value >> (i * 8))); }
+	}
+
+	// A DXBC container with a single SHEX chunk holding tokens.
+	std::vector<unsigned char> makeContainer(const std::vector<uint32_t>& tokens)
+	{
+		std::vector<unsigned char> out{ 'D', 'X', 'B', 'C' };
+		out.resize(20, 0);
+		appendU32(out, 1);
+		appendU32(out, static_cast<uint32_t>(36 + 8 + tokens.size() * 4));
+		appendU32(out, 1);
+		appendU32(out, 36);
+		out.insert(out.end(), { 'S', 'H', 'E', 'X' });
+		appendU32(out, static_cast<uint32_t>(tokens.size() * 4));
+		for (uint32_t token : tokens) { appendU32(out, token); }
+		return out;
+	}
+}
+
+TEST(groupCountsRoundUp)
+{
+	CHECK_EQ(getThreadGroupCount(0, 64), 0);
+	CHECK_EQ(getThreadGroupCount(1, 64), 1);
+	CHECK_EQ(getThreadGroupCount(64, 64), 1);
+	CHECK_EQ(getThreadGroupCount(65, 64), 2);
+	CHECK_EQ(getThreadGroupCount(7, 1), 7);
+	// No overflow at the top of the range.
+	CHECK_EQ(getThreadGroupCount(0xFFFFFFFFu, 64), 0x4000000u);
+	CHECK_EQ(getThreadGroupCount(0xFFFFFFFFu, 1), 0xFFFFFFFFu);
+
+	const uint32_t groupSize[3] = { 8, 4, 2 };
+	const DispatchIndirectArgs args = getDispatchArgs(37, 9, 3, groupSize);
+	CHECK_EQ(args.threadGroupCountX, 5);
+	CHECK_EQ(args.threadGroupCountY, 3);
+	CHECK_EQ(args.threadGroupCountZ, 2);
+}
+
+TEST(dispatchVisitsEveryThreadOnce)
+{
+	const uint32_t groupSize[3] = { 8, 4, 2 };
+	const DispatchIndirectArgs args = getDispatchArgs(37, 9, 3, groupSize);
+	std::set<std::tuple<uint32_t, uint32_t, uint32_t>> seen;
+	size_t calls = 0, mismatches = 0;
+	uint32_t previousGroup = 0;
+	dispatchReference(args, groupSize, [&](const ComputeThread& thread)
+	{
+		// SV_GroupIndex counts x fastest, and restarts with each group.
+		const uint32_t groupIndex = thread.groupThreadId[0] + thread.groupThreadId[1] * groupSize[0] + thread.groupThreadId[2] * groupSize[0] * groupSize[1];
+		mismatches += thread.groupIndex != groupIndex;
+		mismatches += thread.groupIndex != calls % 64;
+		for (int i = 0; i < 3; i++)
+		{
+			mismatches += thread.groupThreadId[i] >= groupSize[i];
+			mismatches += thread.dispatchThreadId[i] != thread.groupId[i] * groupSize[i] + thread.groupThreadId[i];
+		}
+		// Groups in x, y, z order.
+		const uint32_t group = thread.groupId[0] + thread.groupId[1] * args.threadGroupCountX + thread.groupId[2] * args.threadGroupCountX * args.threadGroupCountY;
+		mismatches += group < previousGroup;
+		previousGroup = group;
+		seen.insert({ thread.dispatchThreadId[0], thread.dispatchThreadId[1], thread.dispatchThreadId[2] });
+		calls++;
+	});
+	CHECK_EQ(mismatches, 0);
+	// Whole groups run, so the ids cover the rounded-up box exactly once.
+	CHECK_EQ(calls, 5 * 3 * 2 * 64);
+	CHECK_EQ(seen.size(), calls);
+	CHECK_EQ(previousGroup, 5 * 3 * 2 - 1);
+
+	// An empty dimension runs nothing.
+	calls = 0;
+	dispatchReference(DispatchIndirectArgs{ 4, 0, 1 }, groupSize, [&](const ComputeThread&) { calls++; });
+	CHECK_EQ(calls, 0);
+}
+
+TEST(indirectArgsMatchTheD3D11Layout)
+{
+	CHECK_EQ(offsetof(DispatchIndirectArgs, threadGroupCountZ), 8);
+	CHECK_EQ(offsetof(DrawInstancedIndirectArgs, instanceCount), 4);
+	CHECK_EQ(offsetof(DrawInstancedIndirectArgs, startInstanceLocation), 12);
+	CHECK_EQ(offsetof(DrawIndexedInstancedIndirectArgs, baseVertexLocation), 12);
+	CHECK_EQ(offsetof(DrawIndexedInstancedIndirectArgs, startInstanceLocation), 16);
+
+	// DispatchIndirect reads three counts at the offset it is given.
+	const uint32_t words[] = { 99, 99, 3, 2, 1, 99 };
+	const uint32_t groupSize[3] = { 4, 1, 1 };
+	size_t calls = 0;
+	uint32_t largest[3] = {};
+	dispatchIndirectReference(words, 8, groupSize, [&](const ComputeThread& thread)
+	{
+		for (int i = 0; i < 3; i++) { largest[i] = thread.groupId[i] > largest[i] ? thread.groupId[i] : largest[i]; }
+		calls++;
+	});
+	CHECK_EQ(calls, 3 * 2 * 1 * 4);
+	CHECK_EQ(largest[0], 2);
+	CHECK_EQ(largest[1], 1);
+	CHECK_EQ(largest[2], 0);
+}
+
+TEST(byteAddressBufferFollowsOutOfBoundsRules)
+{
+	// The width rounds down to whole words, which start at 0.
+	ReferenceByteAddressBuffer buffer(18);
+	CHECK_EQ(buffer.getByteWidth(), 16);
+	for (uint32_t offset = 0; offset < 16; offset += 4) { CHECK_EQ(buffer.load(offset), 0); }
+	buffer.store(4, 0xDEADBEEFu);
+	CHECK_EQ(buffer.data()[1], 0xDEADBEEFu);
+	// The low two address bits are ignored.
+	CHECK_EQ(buffer.load(7), 0xDEADBEEFu);
+	buffer.store(10, 5);
+	CHECK_EQ(buffer.load(8), 5);
+	CHECK_EQ(buffer.interlockedAdd(8, 3), 5);
+	CHECK_EQ(buffer.interlockedAdd(8, 0xFFFFFFFFu), 8);
+	CHECK_EQ(buffer.load(8), 7);
+	// Past the end reads return 0, writes and adds are dropped.
+	buffer.store(16, 1);
+	CHECK_EQ(buffer.load(16), 0);
+	CHECK_EQ(buffer.interlockedAdd(16, 1), 0);
+	CHECK_EQ(buffer.load(0xFFFFFFFCu), 0);
+	const uint32_t expected[4] = { 0, 0xDEADBEEFu, 7, 0 };
+	for (int i = 0; i < 4; i++) { CHECK_EQ(buffer.data()[i], expected[i]); }
+	CHECK_EQ(ReferenceByteAddressBuffer().getByteWidth(), 0);
+	CHECK_EQ(ReferenceByteAddressBuffer().load(0), 0);
+}
+
+TEST(cullingChainFillsIndirectArgs)
+{
+	// Pass 1 appends every third instance and counts it into DrawInstancedIndirectArgs.instanceCount,
+	// pass 2 turns the count into DispatchIndirect args, and pass 3 runs once per kept instance.
+	const uint32_t count = 1000;
+	const uint32_t groupSize[3] = { 64, 1, 1 };
+	const uint32_t single[3] = { 1, 1, 1 };
+	const uint32_t dispatchOffset = sizeof(DrawInstancedIndirectArgs);
+	ReferenceByteAddressBuffer args(sizeof(DrawInstancedIndirectArgs) + sizeof(DispatchIndirectArgs));
+	ReferenceByteAddressBuffer visible(count * 4);
+	args.store(offsetof(DrawInstancedIndirectArgs, vertexCountPerInstance), 4);
+	dispatchReference(getDispatchArgs(count, 1, 1, groupSize), groupSize, [&](const ComputeThread& thread)
+	{
+		const uint32_t i = thread.dispatchThreadId[0];
+		if (i >= count || i % 3 != 0) { return; }
+		const uint32_t slot = args.interlockedAdd(offsetof(DrawInstancedIndirectArgs, instanceCount), 1);
+		visible.store(slot * 4, i);
+	});
+	dispatchReference(DispatchIndirectArgs{ 1, 1, 1 }, single, [&](const ComputeThread&)
+	{
+		args.store(dispatchOffset, getThreadGroupCount(args.load(offsetof(DrawInstancedIndirectArgs, instanceCount)), groupSize[0]));
+		args.store(dispatchOffset + 4, 1);
+		args.store(dispatchOffset + 8, 1);
+	});
+
+	DrawInstancedIndirectArgs draw;
+	memcpy(&draw, args.data(), sizeof(draw));
+	CHECK_EQ(draw.vertexCountPerInstance, 4);
+	CHECK_EQ(draw.instanceCount, 334);
+	CHECK_EQ(draw.startVertexLocation, 0);
+	CHECK_EQ(draw.startInstanceLocation, 0);
+	for (uint32_t slot = 0; slot < draw.instanceCount; slot++) { CHECK_EQ(visible.load(slot * 4), slot * 3); }
+
+	uint64_t sum = 0;
+	size_t threads = 0;
+	dispatchIndirectReference(args.data(), dispatchOffset, groupSize, [&](const ComputeThread& thread)
+	{
+		threads++;
+		if (thread.dispatchThreadId[0] < args.load(offsetof(DrawInstancedIndirectArgs, instanceCount))) { sum += visible.load(thread.dispatchThreadId[0] * 4); }
+	});
+	CHECK_EQ(threads, 6 * 64);
+	CHECK_EQ(sum, 3 * (333 * 334 / 2));
+}
+
+TEST(threadGroupSizeFeedsTheDispatch)
+{
+	// cs_5_0: dcl_globalFlags, an immediate constant buffer, dcl_thread_group 64, 2, 1, ret.
+	const std::vector<uint32_t> tokens = { 0x00050050, 12, 0x0100086A, 0x00000035, 3, 0x12345678, 0x0400009B, 64, 2, 1, 0x0100003E, 0 };
+	std::vector<unsigned char> container = makeContainer(tokens);
+	uint32_t size[3] = {};
+	REQUIRE(reflectThreadGroupSize(container.data(), container.size(), size) == ShaderReflectResult::ok);
+	CHECK_EQ(size[0], 64);
+	CHECK_EQ(size[1], 2);
+	CHECK_EQ(size[2], 1);
+	// dispatchThreads(1920, 1080) with this shader.
+	const DispatchIndirectArgs args = getDispatchArgs(1920, 1080, 1, size);
+	CHECK_EQ(args.threadGroupCountX, 30);
+	CHECK_EQ(args.threadGroupCountY, 540);
+	CHECK_EQ(args.threadGroupCountZ, 1);
+
+	// Without the declaration the size stays 1, 1, 1.
+	const std::vector<uint32_t> noGroup = { 0x00050050, 3, 0x0100003E };
+	container = makeContainer(noGroup);
+	CHECK(reflectThreadGroupSize(container.data(), container.size(), size) == ShaderReflectResult::missingResourceDefinition);
+	CHECK(size[0] == 1 && size[1] == 1 && size[2] == 1);
+	// A token count past the chunk, or a zero-length instruction, is invalid.
+	const std::vector<uint32_t> truncated = { 0x00050050, 40, 0x0400009B, 64, 2, 1 };
+	container = makeContainer(truncated);
+	CHECK(reflectThreadGroupSize(container.data(), container.size(), size) == ShaderReflectResult::invalidData);
+	const std::vector<uint32_t> zeroLength = { 0x00050050, 6, 0x0000009B, 64, 2, 1 };
+	container = makeContainer(zeroLength);
+	CHECK(reflectThreadGroupSize(container.data(), container.size(), size) == ShaderReflectResult::invalidData);
+}
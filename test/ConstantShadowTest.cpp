@@ -0,0 +1,100 @@
+﻿#include "Test.h"
+#include "ConstantShadow.h"
+
+namespace
+{
+	struct Constants
+	{
+		float world[16];
+		float color[4];
+		unsigned int index;
+		unsigned int padding[3];
+	};
+	static_assert(IsConstantData<Constants>::value, "Constants must be valid cbuffer data");
+	HLSL_PACKING_CHECK(Constants, color);
+	HLSL_PACKING_CHECK(Constants, index);
+
+	struct Straddling
+	{
+		float a[3];
+		float b[2];		// 12..20 crosses the register at 16
+		float c[3];
+	};
+
+	struct Unpadded
+	{
+		float lightDir[3];
+	};
+}
+
+TEST(firstUpdateAlwaysUploads)
+{
+	ConstantShadow<Constants> shadow;
+	CHECK(!shadow.isValid());
+	// Even all-zero data must reach the GPU once.
+	const Constants zero{};
+	CHECK(shadow.update(zero));
+	CHECK(shadow.isValid());
+	CHECK_EQ(shadow.getGeneration(), 1);
+	CHECK(!shadow.update(zero));
+	CHECK_EQ(shadow.getUploadCount(), 1);
+	CHECK_EQ(shadow.getSkipCount(), 1);
+}
+
+TEST(onlyChangesUpload)
+{
+	ConstantShadow<Constants> shadow;
+	Constants data{};
+	data.color[3] = 1.0f;
+	CHECK(shadow.update(data));
+	CHECK(!shadow.update(data));
+	// Any byte counts, including padding and the last member.
+	data.index = 7;
+	CHECK(shadow.update(data));
+	CHECK_EQ(shadow.get().index, 7);
+	data.padding[2] = 1;
+	CHECK(shadow.update(data));
+	data.world[0] = -0.0f;
+	// -0 and +0 compare equal as floats but differ in memory; uploading is the safe answer.
+	CHECK(shadow.update(data));
+	CHECK(!shadow.update(data));
+	CHECK_EQ(shadow.getGeneration(), 4);
+	CHECK_EQ(shadow.getUploadCount(), 4);
+	CHECK_EQ(shadow.getSkipCount(), 2);
+	shadow.resetCounters();
+	CHECK_EQ(shadow.getUploadCount(), 0);
+	CHECK_EQ(shadow.getSkipCount(), 0);
+	CHECK_EQ(shadow.getGeneration(), 4);
+}
+
+TEST(resetAndInvalidate)
+{
+	ConstantShadow<Constants> shadow;
+	Constants data{};
+	data.index = 3;
+	// Buffers created with initial data: the shadow matches without an upload.
+	shadow.reset(data);
+	CHECK(shadow.isValid());
+	CHECK_EQ(shadow.getGeneration(), 1);
+	CHECK_EQ(shadow.getUploadCount(), 0);
+	CHECK(!shadow.update(data));
+
+	// After a device loss the contents are unknown: the same data uploads again.
+	shadow.invalidate();
+	CHECK(!shadow.isValid());
+	CHECK(shadow.update(data));
+	CHECK(!shadow.update(data));
+	CHECK_EQ(shadow.getGeneration(), 2);
+}
+
+TEST(packingRules)
+{
+	static_assert(isHlslPackedMember(0, 64), "Matrices start on a register");
+	static_assert(isHlslPackedMember(4, 12), "float3 after a float fits in one register");
+	static_assert(!isHlslPackedMember(8, 12), "float3 at 8 straddles");
+	static_assert(isHlslPackedMember(16, 1024), "Arrays starting on a register may span many");
+	CHECK(!isHlslPackedMember(offsetof(Straddling, b), sizeof(Straddling::b)));
+	CHECK(isHlslPackedMember(offsetof(Straddling, a), sizeof(Straddling::a)));
+	CHECK(!IsConstantData<Unpadded>::value);
+	CHECK(IsConstantData<Constants>::value);
+}
@@ -0,0 +1,140 @@
+﻿#include "Test.h"
+#include "DestructionMath.h"
+#include <math.h>
+#include <random>
+
+namespace
+{
+	// Row-major world: rotation about z by angle, then axis scales, then translation.
+	void makeWorld(float angle, const float scale[3], const float translation[3], float out[16])
+	{
+		const float c = cosf(angle), s = sinf(angle);
+		const float rows[16] =
+		{
+			c * scale[0], s * scale[0], 0, 0,
+			-s * scale[1], c * scale[1], 0, 0,
+			0, 0, scale[2], 0,
+			translation[0], translation[1], translation[2], 1,
+		};
+		for (int i = 0; i < 16; i++) { out[i] = rows[i]; }
+	}
+
+	// Largest difference between destructVertex on precomputed frames and the geometry shader model.
+	double compareWithReference(const float world[16], const DestructionParams& params, const float positions[9])
+	{
+		TriangleFrame frame;
+		computeTriangleFrames(positions, 3, 1, &frame);
+		float expected[9];
+		destructTriangleReference(world, params, positions, expected);
+		double difference = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			float actual[3];
+			destructVertex(world, params, positions + i * 3, frame, actual);
+			for (int c = 0; c < 3; c++) { difference = fmax(difference, fabs(double(actual[c]) - expected[i * 3 + c])); }
+		}
+		return difference;
+	}
+}
+
+TEST(framesHoldCenterAndUnitNormal)
+{
+	// Two triangles with a stride of 6 floats (position + normal).
+	const float vertices[] =
+	{
+		0, 0, 0, 9, 9, 9,
+		3, 0, 0, 9, 9, 9,
+		0, 3, 0, 9, 9, 9,
+		0, 0, 1, 9, 9, 9,
+		0, 0, 4, 9, 9, 9,
+		0, 2, 1, 9, 9, 9,
+	};
+	TriangleFrame frames[2];
+	computeTriangleFrames(vertices, 6, 2, frames);
+	CHECK_NEAR(frames[0].center[0], 1, 1e-6);
+	CHECK_NEAR(frames[0].center[1], 1, 1e-6);
+	CHECK_NEAR(frames[0].center[2], 0, 1e-6);
+	// e1 x e2 of (3,0,0) and (0,3,0) is +z.
+	CHECK_NEAR(frames[0].faceNormal[2], 1, 1e-6);
+	CHECK_NEAR(frames[1].center[2], 2, 1e-6);
+	CHECK_NEAR(frames[1].faceNormal[0], -1, 1e-6);
+
+	// A degenerate triangle has no normal.
+	const float line[] = { 0, 0, 0, 1, 1, 1, 2, 2, 2 };
+	TriangleFrame degenerate;
+	computeTriangleFrames(line, 3, 1, &degenerate);
+	CHECK(isnan(degenerate.faceNormal[0]));
+}
+
+TEST(neutralParamsOnlyApplyTheWorld)
+{
+	const float scale[3] = { 2, 2, 2 }, translation[3] = { 1, -2, 3 };
+	float world[16];
+	makeWorld(0.5f, scale, translation, world);
+	const float positions[9] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+	float out[9];
+	destructTriangleReference(world, DestructionParams(), positions, out);
+	for (int i = 0; i < 3; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			const float* p = positions + i * 3;
+			CHECK_NEAR(out[i * 3 + c], p[0] * world[c] + p[1] * world[4 + c] + p[2] * world[8 + c] + world[12 + c], 1e-5);
+		}
+	}
+	CHECK(compareWithReference(world, DestructionParams(), positions) < 1e-5);
+}
+
+TEST(moveScaleAndRotateAboutTheFace)
+{
+	const float identity[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+	const float positions[9] = { 0, 0, 0, 3, 0, 0, 0, 3, 0 };
+	DestructionParams params;
+	params.move = 2;
+	params.scale = 0.5f;
+	params.rotation = 1.0f;
+	float out[9];
+	destructTriangleReference(identity, params, positions, out);
+	// Centered on (1, 1) lifted by 2 along +z; each vertex keeps half its distance to the center.
+	for (int i = 0; i < 3; i++)
+	{
+		CHECK_NEAR(out[i * 3 + 2], 2, 1e-5);
+		const double before = hypot(positions[i * 3] - 1.0, positions[i * 3 + 1] - 1.0);
+		const double after = hypot(out[i * 3] - 1.0, out[i * 3 + 1] - 1.0);
+		CHECK_NEAR(after, before * 0.5, 1e-5);
+	}
+	// A row vector times axisRotationMatrix turns by -rotation around the normal.
+	CHECK_NEAR(atan2(out[4] - 1.0, out[3] - 1.0), atan2(-1.0, 2.0) - 1.0, 1e-5);
+	CHECK(compareWithReference(identity, params, positions) < 1e-5);
+}
+
+TEST(pulledVerticesMatchTheGeometryShader)
+{
+	// Random triangles, non-uniform and mirrored worlds, and random effect params.
+	std::mt19937 random(21);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	double worst = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		float positions[9];
+		for (float& p : positions) { p = unit(random) * 2.0f; }
+		const float scale[3] = { 0.5f + fabsf(unit(random)) * 3.0f, 0.5f + fabsf(unit(random)) * 3.0f, (i & 1 ? -1.0f : 1.0f) * (0.5f + fabsf(unit(random))) };
+		const float translation[3] = { unit(random) * 10.0f, unit(random) * 10.0f, unit(random) * 10.0f };
+		float world[16];
+		makeWorld(unit(random) * 3.0f, scale, translation, world);
+		DestructionParams params;
+		params.move = unit(random) * 3.0f;
+		params.scale = unit(random) * 2.0f;
+		params.rotation = unit(random) * 6.3f;
+		TriangleFrame frame;
+		computeTriangleFrames(positions, 3, 1, &frame);
+		// Skip slivers whose normal is ill-conditioned in float.
+		float edge1[3], edge2[3];
+		for (int c = 0; c < 3; c++) { edge1[c] = positions[3 + c] - positions[c]; edge2[c] = positions[6 + c] - positions[c]; }
+		const float area = hypotf(hypotf(edge1[1] * edge2[2] - edge1[2] * edge2[1], edge1[2] * edge2[0] - edge1[0] * edge2[2]), edge1[0] * edge2[1] - edge1[1] * edge2[0]);
+		if (area < 0.05f) { continue; }
+		worst = fmax(worst, compareWithReference(world, params, positions));
+	}
+	// Positions reach about 40 units, so this is a few float ulps.
+	CHECK(worst < 1e-3);
+}
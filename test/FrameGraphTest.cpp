@@ -0,0 +1,244 @@
+﻿#include "Test.h"
+#include "FrameGraph.h"
+#include <algorithm>
+
+namespace
+{
+	const FrameGraph::LayerDesc colorDesc{ 64, 64, 28 };
+	const FrameGraph::LayerDesc hdrDesc{ 64, 64, 10 };
+
+	unsigned int positionOf(const FrameGraph& graph, unsigned int pass)
+	{
+		const std::vector<unsigned int>& order = graph.getOrder();
+		return static_cast<unsigned int>(std::find(order.begin(), order.end(), pass) - order.begin());
+	}
+
+	bool contains(const std::vector<FrameGraph::Resource>& resources, FrameGraph::Resource resource)
+	{
+		return std::find(resources.begin(), resources.end(), resource) != resources.end();
+	}
+}
+
+TEST(cullsPassesWithoutConsumers)
+{
+	FrameGraph graph;
+	const FrameGraph::Resource backBuffer = graph.importLayer("backBuffer", colorDesc);
+	const unsigned int scene = graph.addPass("scene");
+	const unsigned int unusedBlur = graph.addPass("unusedBlur");
+	const unsigned int unusedSource = graph.addPass("unusedSource");
+	const unsigned int present = graph.addPass("present");
+
+	const FrameGraph::Resource color = graph.getBuilder(scene).create("color", colorDesc);
+	graph.getBuilder(scene).write(color);
+	const FrameGraph::Resource source = graph.getBuilder(unusedSource).create("source", colorDesc);
+	graph.getBuilder(unusedSource).write(source);
+	const FrameGraph::Resource blurred = graph.getBuilder(unusedBlur).create("blurred", colorDesc);
+	graph.getBuilder(unusedBlur).read(source);
+	graph.getBuilder(unusedBlur).write(blurred);
+	graph.getBuilder(present).read(color);
+	graph.getBuilder(present).write(backBuffer);
+
+	REQUIRE(graph.compile() == FrameGraph::Result::ok);
+	CHECK(!graph.getPass(scene).culled);
+	CHECK(!graph.getPass(present).culled);
+	// unusedSource only feeds unusedBlur, so it goes when unusedBlur does.
+	CHECK(graph.getPass(unusedBlur).culled);
+	CHECK(graph.getPass(unusedSource).culled);
+	CHECK_EQ(graph.getOrder().size(), 2);
+	CHECK_EQ(graph.getResource(source).physical, ~0u);
+}
+
+TEST(keepsSideEffectPasses)
+{
+	FrameGraph graph;
+	const unsigned int readback = graph.addPass("readback");
+	const FrameGraph::Resource color = graph.getBuilder(readback).create("color", colorDesc);
+	graph.getBuilder(readback).write(color);
+	graph.getBuilder(readback).sideEffect();
+	REQUIRE(graph.compile() == FrameGraph::Result::ok);
+	CHECK(!graph.getPass(readback).culled);
+	CHECK_EQ(graph.getOrder().size(), 1);
+}
+
+TEST(ordersProducersBeforeConsumers)
+{
+	FrameGraph graph;
+	const FrameGraph::Resource backBuffer = graph.importLayer("backBuffer", colorDesc);
+	const unsigned int shadow = graph.addPass("shadow");
+	const unsigned int gbuffer = graph.addPass("gbuffer");
+	const unsigned int lighting = graph.addPass("lighting");
+	const unsigned int present = graph.addPass("present");
+
+	const FrameGraph::Resource shadowMap = graph.getBuilder(shadow).create("shadowMap", colorDesc);
+	const FrameGraph::Resource albedo = graph.getBuilder(gbuffer).create("albedo", colorDesc);
+	const FrameGraph::Resource lit = graph.getBuilder(lighting).create("lit", hdrDesc);
+	// Declared out of pass order on purpose.
+	graph.getBuilder(present).write(backBuffer);
+	graph.getBuilder(present).read(lit);
+	graph.getBuilder(lighting).write(lit);
+	graph.getBuilder(lighting).read(albedo);
+	graph.getBuilder(lighting).read(shadowMap);
+	graph.getBuilder(gbuffer).write(albedo);
+	graph.getBuilder(shadow).write(shadowMap);
+
+	REQUIRE(graph.compile() == FrameGraph::Result::ok);
+	REQUIRE(graph.getOrder().size() == 4);
+	CHECK(positionOf(graph, shadow) < positionOf(graph, lighting));
+	CHECK(positionOf(graph, gbuffer) < positionOf(graph, lighting));
+	CHECK(positionOf(graph, lighting) < positionOf(graph, present));
+}
+
+TEST(writeAfterReadFollowsPassOrderNotDeclarationOrder)
+{
+	// A writes t, B reads t, C writes t again. The result must not depend
+	// on the order in which the builders were called.
+	for (int variant = 0; variant < 2; variant++)
+	{
+		FrameGraph graph;
+		const unsigned int a = graph.addPass("A");
+		const unsigned int b = graph.addPass("B");
+		const unsigned int c = graph.addPass("C");
+		const FrameGraph::Resource t = graph.getBuilder(a).create("t", colorDesc);
+		if (variant == 0)
+		{
+			graph.getBuilder(a).write(t);
+			graph.getBuilder(b).read(t);
+			graph.getBuilder(c).write(t);
+		}
+		else
+		{
+			graph.getBuilder(c).write(t);
+			graph.getBuilder(b).read(t);
+			graph.getBuilder(a).write(t);
+		}
+		graph.getBuilder(b).sideEffect();
+		graph.getBuilder(c).sideEffect();
+
+		REQUIRE(graph.compile() == FrameGraph::Result::ok);
+		REQUIRE(graph.getOrder().size() == 3);
+		CHECK_EQ(graph.getOrder()[0], a);
+		CHECK_EQ(graph.getOrder()[1], b);
+		CHECK_EQ(graph.getOrder()[2], c);
+	}
+}
+
+TEST(aliasesLayersWithDisjointLifetimes)
+{
+	FrameGraph graph;
+	const FrameGraph::Resource backBuffer = graph.importLayer("backBuffer", colorDesc);
+	const unsigned int p0 = graph.addPass("p0");
+	const unsigned int p1 = graph.addPass("p1");
+	const unsigned int p2 = graph.addPass("p2");
+	const unsigned int p3 = graph.addPass("p3");
+	const FrameGraph::Resource t0 = graph.getBuilder(p0).create("t0", colorDesc);
+	const FrameGraph::Resource t1 = graph.getBuilder(p1).create("t1", colorDesc);
+	const FrameGraph::Resource t2 = graph.getBuilder(p2).create("t2", colorDesc);
+	const FrameGraph::Resource other = graph.getBuilder(p2).create("other", hdrDesc);
+	graph.getBuilder(p0).write(t0);
+	graph.getBuilder(p1).read(t0);
+	graph.getBuilder(p1).write(t1);
+	graph.getBuilder(p2).read(t1);
+	graph.getBuilder(p2).write(t2);
+	graph.getBuilder(p2).write(other);
+	graph.getBuilder(p3).read(t2);
+	graph.getBuilder(p3).read(other);
+	graph.getBuilder(p3).write(backBuffer);
+
+	REQUIRE(graph.compile() == FrameGraph::Result::ok);
+	// t0 lives in [0, 1] and t2 in [2, 3], so they share a layer; t1 overlaps both.
+	CHECK_EQ(graph.getResource(t0).physical, graph.getResource(t2).physical);
+	CHECK(graph.getResource(t1).physical != graph.getResource(t0).physical);
+	CHECK(graph.getResource(other).physical != graph.getResource(t0).physical);
+	CHECK(graph.getResource(other).physical != graph.getResource(t1).physical);
+	CHECK_EQ(graph.getPhysicalLayers().size(), 3);
+	CHECK(graph.getPhysicalLayers()[graph.getResource(other).physical] == hdrDesc);
+	CHECK_EQ(graph.getResource(backBuffer).physical, ~0u);
+}
+
+TEST(recordsHazards)
+{
+	FrameGraph graph;
+	const FrameGraph::Resource backBuffer = graph.importLayer("backBuffer", colorDesc);
+	const unsigned int p0 = graph.addPass("p0");
+	const unsigned int p1 = graph.addPass("p1");
+	const unsigned int p2 = graph.addPass("p2");
+	const unsigned int p3 = graph.addPass("p3");
+	const FrameGraph::Resource t0 = graph.getBuilder(p0).create("t0", colorDesc);
+	const FrameGraph::Resource t1 = graph.getBuilder(p1).create("t1", colorDesc);
+	const FrameGraph::Resource t2 = graph.getBuilder(p2).create("t2", colorDesc);
+	graph.getBuilder(p0).write(t0);
+	graph.getBuilder(p1).read(t0);
+	graph.getBuilder(p1).write(t1);
+	graph.getBuilder(p2).read(t1);
+	graph.getBuilder(p2).write(t2);
+	graph.getBuilder(p3).read(t2);
+	graph.getBuilder(p3).write(backBuffer);
+
+	REQUIRE(graph.compile() == FrameGraph::Result::ok);
+	REQUIRE(graph.getResource(t0).physical == graph.getResource(t2).physical);
+	// p1 samples what p0 rendered.
+	CHECK(graph.getPass(p1).unbindRenderTargets);
+	// p2 renders into the layer p1 still has bound as t0.
+	CHECK(contains(graph.getPass(p2).unbindShaderResources, t2));
+	CHECK(graph.getPass(p1).unbindShaderResources.empty());
+	CHECK(!graph.getPass(p0).unbindRenderTargets);
+}
+
+TEST(rejectsInvalidGraphs)
+{
+	{
+		FrameGraph graph;
+		const unsigned int pass = graph.addPass("feedback");
+		const FrameGraph::Resource t = graph.getBuilder(pass).create("t", colorDesc);
+		graph.getBuilder(pass).read(t);
+		graph.getBuilder(pass).write(t);
+		CHECK(graph.compile() == FrameGraph::Result::selfDependency);
+		CHECK(!graph.isCompiled());
+	}
+	{
+		FrameGraph graph;
+		const unsigned int reader = graph.addPass("reader");
+		const unsigned int writer = graph.addPass("writer");
+		const FrameGraph::Resource t = graph.getBuilder(writer).create("t", colorDesc);
+		graph.getBuilder(writer).write(t);
+		graph.getBuilder(reader).read(t);
+		graph.getBuilder(reader).sideEffect();
+		CHECK(graph.compile() == FrameGraph::Result::uninitializedRead);
+		CHECK(graph.getOrder().empty());
+	}
+}
+
+TEST(choosesDepthTarget)
+{
+	FrameGraph graph;
+	const unsigned int single = graph.addPass("single");
+	const unsigned int multiple = graph.addPass("multiple");
+	const unsigned int explicitDepth = graph.addPass("explicitDepth");
+	const FrameGraph::Resource a = graph.getBuilder(single).create("a", colorDesc);
+	const FrameGraph::Resource b = graph.getBuilder(multiple).create("b", colorDesc);
+	const FrameGraph::Resource c = graph.getBuilder(multiple).create("c", colorDesc);
+	graph.getBuilder(single).write(a);
+	graph.getBuilder(multiple).write(b);
+	graph.getBuilder(multiple).write(c);
+	graph.getBuilder(explicitDepth).write(b);
+	graph.getBuilder(explicitDepth).writeDepth(c);
+	CHECK_EQ(graph.getDepthTarget(single), a);
+	CHECK_EQ(graph.getDepthTarget(multiple), FrameGraph::invalidResource);
+	CHECK_EQ(graph.getDepthTarget(explicitDepth), c);
+	CHECK_EQ(graph.getPass(explicitDepth).writes.size(), 2);
+}
+
+TEST(recompilesAfterClear)
+{
+	FrameGraph graph;
+	for (int frame = 0; frame < 3; frame++)
+	{
+		graph.clear();
+		const FrameGraph::Resource backBuffer = graph.importLayer("backBuffer", colorDesc);
+		const unsigned int pass = graph.addPass("present");
+		graph.getBuilder(pass).write(backBuffer);
+		REQUIRE(graph.compile() == FrameGraph::Result::ok);
+		CHECK_EQ(graph.getOrder().size(), 1);
+		CHECK(graph.getPhysicalLayers().empty());
+	}
+}
@@ -0,0 +1,144 @@
+﻿#include "Test.h"
+#include "InputLayoutKey.h"
+#include "ShaderFixtures.h"
+#include <unordered_map>
+
+namespace
+{
+	//DXGI_FORMAT and D3D11_APPEND_ALIGNED_ELEMENT
+	constexpr uint32_t formatFloat2 = 16, formatFloat3 = 6, formatFloat4 = 2;
+	constexpr uint32_t appendAligned = 0xFFFFFFFF;
+
+	std::vector<InputSignatureElement> loadSignature(const char* name)
+	{
+		const std::vector<char> bytecode = test::getShaderFixture(name);
+		std::vector<InputSignatureElement> elements;
+		if (bytecode.empty() || reflectInputSignature(bytecode.data(), bytecode.size(), &elements) != ShaderReflectResult::ok) { elements.clear(); }
+		return elements;
+	}
+
+	// The layout ToonPainter and DestructionPainter create: float3 position and normal.
+	InputLayoutKey makeMeshKey(const char* shader, const char* positionName = "POSITION")
+	{
+		InputLayoutKey key;
+		key.addElement(positionName, 0, formatFloat3, 0, appendAligned, 0, 0);
+		key.addElement("NORMAL", 0, formatFloat3, 0, appendAligned, 0, 0);
+		key.addSignature(loadSignature(shader));
+		return key;
+	}
+}
+
+TEST(hashIsFnv1a)
+{
+	CHECK(hashBytes("", 0) == fnvOffsetBasis);
+	CHECK(hashBytes("a", 1) == 0xAF63DC4C8601EC8Cull);
+	CHECK(hashBytes("foobar", 6) == 0x85944171F73967E8ull);
+	// Chaining equals hashing the concatenation.
+	CHECK(hashBytes("bar", 3, hashBytes("foo", 3)) == hashBytes("foobar", 6));
+
+	InputLayoutKey key;
+	CHECK(key.getHash() == fnvOffsetBasis);
+	key.addElement("POSITION", 0, formatFloat3, 0, 0, 0, 0);
+	CHECK(key.getHash() == hashBytes(key.getBytes().data(), key.getBytes().size()));
+	key.clear();
+	CHECK(key.getHash() == fnvOffsetBasis);
+	CHECK(key.getBytes().empty());
+}
+
+TEST(signaturesAreExtractedFromShippedShaders)
+{
+	const std::vector<InputSignatureElement> toon = loadSignature("Toon_vs");
+	REQUIRE(toon.size() == 2);
+	CHECK(toon[0].semanticName == "POSITION" && toon[0].registerIndex == 0);
+	CHECK(toon[1].semanticName == "NORMAL" && toon[1].registerIndex == 1);
+
+	const std::vector<InputSignatureElement> sprite = loadSignature("Sprite_vs");
+	REQUIRE(sprite.size() == 3);
+	CHECK(sprite[0].semanticName == "POSITION");
+	CHECK(sprite[1].semanticName == "TEXCOORD");
+	CHECK(sprite[2].semanticName == "COLOR");
+	CHECK_EQ(sprite[0].mask, 0x3);
+	CHECK_EQ(sprite[2].mask, 0xF);
+
+	const std::vector<InputSignatureElement> wave = loadSignature("WavePaint_vs");
+	REQUIRE(wave.size() == 1);
+	CHECK(wave[0].systemValue != 0);
+}
+
+TEST(shadersWithTheSameInputsShareALayout)
+{
+	// Toon_vs reads float3 inputs, Destruction_vs float4 ones; the masks are not part of the key.
+	const InputLayoutKey toon = makeMeshKey("Toon_vs");
+	const InputLayoutKey destruction = makeMeshKey("Destruction_vs");
+	CHECK(toon == destruction);
+	CHECK(toon.getHash() == destruction.getHash());
+
+	// Semantic names are case-insensitive.
+	CHECK(makeMeshKey("Toon_vs", "position") == toon);
+	CHECK(makeMeshKey("Toon_vs", "Position") == toon);
+
+	// Sprite_vs declares other inputs.
+	CHECK(makeMeshKey("Sprite_vs") != toon);
+}
+
+TEST(everyElementFieldChangesTheKey)
+{
+	const auto make = [](const char* name, uint32_t index, uint32_t format, uint32_t slot, uint32_t offset, uint32_t slotClass, uint32_t stepRate)
+	{
+		InputLayoutKey key;
+		key.addElement(name, index, format, slot, offset, slotClass, stepRate);
+		return key;
+	};
+	const InputLayoutKey base = make("TEXCOORD", 0, formatFloat2, 0, 12, 0, 0);
+	CHECK(make("TEXCOORD", 0, formatFloat2, 0, 12, 0, 0) == base);
+	CHECK(make("COLOR", 0, formatFloat2, 0, 12, 0, 0) != base);
+	CHECK(make("TEXCOORD", 1, formatFloat2, 0, 12, 0, 0) != base);
+	CHECK(make("TEXCOORD", 0, formatFloat4, 0, 12, 0, 0) != base);
+	CHECK(make("TEXCOORD", 0, formatFloat2, 1, 12, 0, 0) != base);
+	CHECK(make("TEXCOORD", 0, formatFloat2, 0, 16, 0, 0) != base);
+	CHECK(make("TEXCOORD", 0, formatFloat2, 0, 12, 1, 0) != base);
+	CHECK(make("TEXCOORD", 0, formatFloat2, 0, 12, 0, 1) != base);
+}
+
+TEST(keysAreUnambiguous)
+{
+	// Element order matters.
+	InputLayoutKey a, b;
+	a.addElement("POSITION", 0, formatFloat3, 0, appendAligned, 0, 0);
+	a.addElement("NORMAL", 0, formatFloat3, 0, appendAligned, 0, 0);
+	b.addElement("NORMAL", 0, formatFloat3, 0, appendAligned, 0, 0);
+	b.addElement("POSITION", 0, formatFloat3, 0, appendAligned, 0, 0);
+	CHECK(a != b);
+
+	// Names are terminated, so moving bytes across the boundary gives another key.
+	InputLayoutKey c, d;
+	c.addElement("AB", 0, 0, 0, 0, 0, 0);
+	d.addElement("A", 0, 0, 0, 0, 0, 0);
+	CHECK(c != d);
+
+	// An element list is never mistaken for a signature or raw bytecode.
+	InputLayoutKey element, signature, bytecode;
+	element.addElement("POSITION", 0, formatFloat3, 0, 0, 0, 0);
+	signature.addSignature(loadSignature("Toon_vs"));
+	bytecode.addBytecode(element.getBytes().data(), element.getBytes().size());
+	CHECK(element != signature);
+	CHECK(element != bytecode);
+
+	// System values are fed by the pipeline and add nothing.
+	InputLayoutKey wave;
+	wave.addSignature(loadSignature("WavePaint_vs"));
+	CHECK(wave.getBytes().empty());
+}
+
+TEST(keysIndexAnUnorderedMap)
+{
+	InputLayoutKey toon = makeMeshKey("Toon_vs"), sprite = makeMeshKey("Sprite_vs");
+	REQUIRE(toon != sprite);
+	std::unordered_map<InputLayoutKey, int, InputLayoutKey::Hasher> layouts;
+	layouts[toon] = 1;
+	layouts[sprite] = 2;
+	layouts[makeMeshKey("Destruction_vs")] = 3;
+	CHECK_EQ(layouts.size(), 2);
+	CHECK_EQ(layouts[toon], 3);
+	CHECK_EQ(layouts[sprite], 2);
+}
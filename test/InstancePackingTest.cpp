@@ -0,0 +1,79 @@
+﻿#include "Test.h"
+#include "InstancePacking.h"
+#include <string.h>
+#include <random>
+#include <vector>
+
+TEST(packMatchesReferenceExactly)
+{
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+	// Counts around the parallel split, the streaming store size and odd tails.
+	for (size_t count : { size_t(0), size_t(1), size_t(3), size_t(1023), size_t(4097), size_t(16384), size_t(70001) })
+	{
+		std::vector<float> worlds(count * 16 + 1), colors(count * 4 + 1);
+		for (float& v : worlds) { v = value(random); }
+		for (float& v : colors) { v = value(random); }
+		std::vector<PackedInstance> packed(count + 1), reference(count + 1);
+		for (const float* colorSource : { static_cast<const float*>(colors.data()), static_cast<const float*>(nullptr) })
+		{
+			memset(packed.data(), 0xCD, packed.size() * sizeof(PackedInstance));
+			memset(reference.data(), 0xCD, reference.size() * sizeof(PackedInstance));
+			packInstances(packed.data(), worlds.data(), colorSource, count);
+			packInstancesReference(reference.data(), worlds.data(), colorSource, count);
+			// Includes the untouched guard record after the last instance.
+			CHECK(memcmp(packed.data(), reference.data(), packed.size() * sizeof(PackedInstance)) == 0);
+		}
+	}
+}
+
+TEST(packTransposesColumns)
+{
+	// Row-major, row-vector translation (5, 6, 7).
+	const float world[16] = { 1,2,3,0, 4,5,6,0, 7,8,9,0, 5,6,7,1 };
+	const float color[4] = { 0.25f, 0.5f, 0.75f, 1.0f };
+	PackedInstance packed[2]{};
+	packInstances(packed, world, color, 1);
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 4; row++) { CHECK(packed[0].world[column][row] == world[row * 4 + column]); }
+	}
+	CHECK(memcmp(packed[0].color, color, sizeof(color)) == 0);
+	packInstances(packed + 1, world, nullptr, 1);
+	for (float c : packed[1].color) { CHECK(c == 1.0f); }
+}
+
+TEST(objectTransformIsFoldedIntoWorld)
+{
+	// Dequantization (scale 2, 4, 8 and offset 1, -2, 3) applied before each world.
+	const float dequantization[16] = { 2,0,0,0, 0,4,0,0, 0,0,8,0, 1,-2,3,1 };
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+	for (size_t count : { size_t(1), size_t(5), size_t(4097) })
+	{
+		std::vector<float> worlds(count * 16);
+		for (float& v : worlds) { v = value(random); }
+		std::vector<PackedInstance> packed(count), reference(count);
+		packInstances(packed.data(), worlds.data(), nullptr, count, dequantization);
+		packInstancesReference(reference.data(), worlds.data(), nullptr, count, dequantization);
+		CHECK(memcmp(packed.data(), reference.data(), count * sizeof(PackedInstance)) == 0);
+		// A quantized position q lands where q * dequantization * world does.
+		const float q[4] = { 0.25f, 0.5f, 0.75f, 1.0f };
+		for (size_t i = 0; i < count; i += 1 + count / 3)
+		{
+			const float* w = &worlds[i * 16];
+			float objectSpace[4] = {};
+			for (int c = 0; c < 4; c++) { for (int k = 0; k < 4; k++) { objectSpace[c] += q[k] * dequantization[k * 4 + c]; } }
+			for (int c = 0; c < 3; c++)
+			{
+				double expected = 0, actual = 0;
+				for (int k = 0; k < 4; k++)
+				{
+					expected += objectSpace[k] * w[k * 4 + c];
+					actual += q[k] * packed[i].world[c][k];
+				}
+				CHECK_NEAR(actual, expected, 1e-3);
+			}
+		}
+	}
+}
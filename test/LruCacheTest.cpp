@@ -0,0 +1,123 @@
+﻿#include "Test.h"
+#include "LruCache.h"
+#include <vector>
+
+namespace
+{
+	// Same fields as DestructionPainter::TessellationKey.
+	struct CaptureKey
+	{
+		uint64_t geometryId = 0;
+		uint32_t indexOffset = 0;
+		uint32_t indexCount = 0;
+		float divNum = 0;
+		bool operator==(const CaptureKey& other)const
+		{
+			return geometryId == other.geometryId && indexOffset == other.indexOffset && indexCount == other.indexCount && divNum == other.divNum;
+		}
+	};
+
+	struct Capture
+	{
+		int buffer = 0;			// stands in for the stream output buffer, kept across evictions
+		int capturedFor = -1;
+	};
+
+	// What DestructionPainter::updateTessellationCache does: fill the value on a miss.
+	int draw(LruCache<CaptureKey, Capture>& cache, const CaptureKey& key, int id, int* captureCount)
+	{
+		bool hit = false;
+		Capture& capture = cache.acquire(key, &hit);
+		if (!hit)
+		{
+			if (capture.buffer == 0) { capture.buffer = id + 100; }
+			capture.capturedFor = id;
+			(*captureCount)++;
+		}
+		return capture.capturedFor;
+	}
+}
+
+TEST(alternatingKeysCaptureOnce)
+{
+	LruCache<CaptureKey, Capture> cache(4);
+	// Two geometries, or one geometry at two lods or divNums, drawn in the same frame.
+	const CaptureKey keys[] = { { 1, 0, 300, 6 }, { 2, 0, 120, 6 }, { 1, 300, 90, 6 }, { 1, 0, 300, 8 } };
+	int captures = 0;
+	for (int frame = 0; frame < 100; frame++)
+	{
+		for (int k = 0; k < 4; k++) { CHECK_EQ(draw(cache, keys[k], k, &captures), k); }
+	}
+	CHECK_EQ(captures, 4);
+	CHECK_EQ(cache.getMissCount(), 4);
+	CHECK_EQ(cache.getHitCount(), 396);
+	CHECK_EQ(cache.getEvictionCount(), 0);
+	CHECK_EQ(cache.getSize(), 4);
+}
+
+TEST(leastRecentlyUsedIsEvicted)
+{
+	LruCache<int, Capture> cache(2);
+	bool hit = false;
+	cache.acquire(1, &hit).capturedFor = 1;
+	cache.acquire(2, &hit).capturedFor = 2;
+	CHECK(cache.find(1) != nullptr);
+	// 2 is the oldest now; its slot goes to 3 with the old contents to reuse.
+	Capture& reused = cache.acquire(3, &hit);
+	CHECK(!hit);
+	CHECK_EQ(reused.capturedFor, 2);
+	CHECK(cache.find(2) == nullptr);
+	CHECK(cache.find(1) != nullptr && cache.find(3) != nullptr);
+	CHECK_EQ(cache.getEvictionCount(), 1);
+
+	// More keys than the capacity in a cycle miss every time.
+	int captures = 0;
+	LruCache<CaptureKey, Capture> small(2);
+	const CaptureKey keys[] = { { 1, 0, 3, 6 }, { 2, 0, 3, 6 }, { 3, 0, 3, 6 } };
+	for (int i = 0; i < 30; i++) { draw(small, keys[i % 3], i % 3, &captures); }
+	CHECK_EQ(captures, 30);
+	// But the buffers are only made for the first two slots.
+	std::vector<int> buffers;
+	small.forEachValue([&](Capture& capture) { buffers.push_back(capture.buffer); });
+	REQUIRE(buffers.size() == 2);
+	CHECK((buffers[0] == 100 && buffers[1] == 101) || (buffers[0] == 101 && buffers[1] == 100));
+}
+
+TEST(clearAndEraseKeepValues)
+{
+	LruCache<int, Capture> cache(3);
+	bool hit = false;
+	for (int key = 0; key < 3; key++) { cache.acquire(key, &hit).buffer = key + 10; }
+	cache.erase(1);
+	CHECK(cache.find(1) == nullptr);
+	CHECK_EQ(cache.getSize(), 2);
+	// The freed slot is taken before anything is evicted.
+	CHECK_EQ(cache.acquire(7, &hit).buffer, 11);
+	CHECK_EQ(cache.getEvictionCount(), 0);
+
+	cache.clear();
+	CHECK_EQ(cache.getSize(), 0);
+	CHECK(cache.find(0) == nullptr);
+	int total = 0;
+	cache.forEachValue([&](Capture& capture) { total += capture.buffer; });
+	CHECK_EQ(total, 10 + 11 + 12);
+	cache.acquire(0, &hit);
+	CHECK(!hit);
+}
+
+TEST(shrinkingDropsTheOldest)
+{
+	LruCache<int, Capture> cache(4);
+	bool hit = false;
+	for (int key = 0; key < 4; key++) { cache.acquire(key, &hit); }
+	cache.find(0);
+	cache.setCapacity(2);
+	CHECK_EQ(cache.getCapacity(), 2);
+	CHECK(cache.find(0) != nullptr && cache.find(3) != nullptr);
+	CHECK(cache.find(1) == nullptr && cache.find(2) == nullptr);
+	CHECK_EQ(cache.getEvictionCount(), 2);
+	cache.setCapacity(3);
+	CHECK_EQ(cache.getSize(), 2);
+	cache.acquire(5, &hit);
+	CHECK_EQ(cache.getEvictionCount(), 2);
+}
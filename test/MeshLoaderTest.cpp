@@ -0,0 +1,154 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "MeshLoader.h"
+#include <stdio.h>
+#include <fstream>
+
+namespace
+{
+	// Canonical triangles of an imported mesh, converted back to the right-handed source space.
+	std::vector<std::array<float, 9>> getSourceTriangles(const MeshData& mesh)
+	{
+		std::vector<TestVertex> vertices(mesh.vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const float* p = mesh.vertices[i].position;
+			vertices[i] = TestVertex{ { p[0], p[1], -p[2] }, {}, {} };
+		}
+		return getCanonicalTriangles(vertices.data(), mesh.indices.data(), mesh.indices.size());
+	}
+
+	bool writeFile(const char* path, const void* data, size_t size)
+	{
+		std::ofstream ofs{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+		ofs.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		return static_cast<bool>(ofs);
+	}
+}
+
+TEST(importsObj)
+{
+	const TestMesh sphere = makeSphereMesh(16, 8);
+	const std::string text = makeObjText(sphere);
+	MeshData mesh{};
+	REQUIRE(importObj(text.data(), text.size(), &mesh) == MeshLoadResult::ok);
+	CHECK_EQ(mesh.indices.size(), sphere.indices.size());
+	CHECK_EQ(mesh.vertices.size(), sphere.vertices.size());
+	CHECK(getSourceTriangles(mesh) == getCanonicalTriangles(sphere));
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		// Normals follow positions on a unit-radius-0.5 sphere.
+		const MeshVertex& v = mesh.vertices[i];
+		for (int c = 0; c < 3; c++) { CHECK_NEAR(v.normal[c], v.position[c] * 2.0f, 1e-4); }
+	}
+}
+
+TEST(importsObjSyntaxVariants)
+{
+	// Negative indices, texcoords, comments, a quad and no normals.
+	const char text[] =
+		"# comment\n"
+		"v 0 0 0\r\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+		"vt 0 0\n"
+		"f -4/1 -3/1 -2/1 # trailing\n"
+		"f 1 3 4\n"
+		"f 1/1 2/1 3/1 4/1\n";
+	MeshData mesh{};
+	REQUIRE(importObj(text, sizeof(text) - 1, &mesh) == MeshLoadResult::ok);
+	CHECK_EQ(mesh.indices.size(), 12);
+	CHECK_EQ(mesh.vertices.size(), 4);
+	for (const MeshVertex& v : mesh.vertices)
+	{
+		// Generated normals of a plane in xy face along z.
+		CHECK_NEAR(fabs(v.normal[2]), 1.0, 1e-5);
+	}
+}
+
+TEST(rejectsBrokenObj)
+{
+	const char outOfRange[] = "v 0 0 0\nv 1 0 0\nf 1 2 3\n";
+	MeshData mesh{};
+	CHECK(importObj(outOfRange, sizeof(outOfRange) - 1, &mesh) == MeshLoadResult::invalidData);
+}
+
+TEST(importsGlbWithNodeTransform)
+{
+	const TestMesh sphere = makeSphereMesh(16, 8);
+	const float translation[3] = { 10.0f, -2.0f, 3.0f };
+	const std::vector<unsigned char> glb = makeGlb(sphere, translation);
+	MeshData mesh{};
+	REQUIRE(importGlb(glb.data(), glb.size(), &mesh) == MeshLoadResult::ok);
+	CHECK_EQ(mesh.indices.size(), sphere.indices.size());
+	REQUIRE(mesh.vertices.size() == sphere.vertices.size());
+	// Vertices keep their order; z is negated after the node transform.
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const float* p = sphere.vertices[i].position;
+		const float* n = sphere.vertices[i].normal;
+		CHECK_NEAR(mesh.vertices[i].position[0], p[0] + translation[0], 1e-5);
+		CHECK_NEAR(mesh.vertices[i].position[1], p[1] + translation[1], 1e-5);
+		CHECK_NEAR(mesh.vertices[i].position[2], -(p[2] + translation[2]), 1e-5);
+		CHECK_NEAR(mesh.vertices[i].normal[0], n[0], 1e-6);
+		CHECK_NEAR(mesh.vertices[i].normal[1], n[1], 1e-6);
+		CHECK_NEAR(mesh.vertices[i].normal[2], -n[2], 1e-6);
+	}
+	// Negating z mirrors the camera too, so the projected winding and the indices stay as they are.
+	CHECK(mesh.indices == sphere.indices);
+
+	// OBJ follows the same convention.
+	const std::string text = makeObjText(sphere);
+	MeshData fromObj{};
+	REQUIRE(importObj(text.data(), text.size(), &fromObj) == MeshLoadResult::ok);
+	CHECK(getSourceTriangles(fromObj) == getCanonicalTriangles(sphere));
+}
+
+TEST(rejectsBrokenGlb)
+{
+	const TestMesh sphere = makeSphereMesh(4, 4);
+	const float zero[3] = {};
+	std::vector<unsigned char> glb = makeGlb(sphere, zero);
+	MeshData mesh{};
+	CHECK(importGlb(glb.data(), 11, &mesh) == MeshLoadResult::invalidData);
+	CHECK(importGlb(glb.data(), glb.size() - 4, &mesh) == MeshLoadResult::invalidData);
+	glb[4] = 1;
+	CHECK(importGlb(glb.data(), glb.size(), &mesh) == MeshLoadResult::unsupportedFormat);
+}
+
+TEST(cacheRoundTripAndStaleness)
+{
+	const char* sourcePath = "MeshLoaderTest_source.obj";
+	const char* cachePath = "MeshLoaderTest_source.mesh";
+	const TestMesh sphere = makeSphereMesh(32, 16);
+	const std::string text = makeObjText(sphere);
+	REQUIRE(writeFile(sourcePath, text.data(), text.size()));
+	MeshData mesh{};
+	REQUIRE(importMesh(sourcePath, &mesh) == MeshLoadResult::ok);
+	const MeshLod lod{ 0, static_cast<unsigned int>(mesh.indices.size()), 0.0f };
+	REQUIRE(saveMeshCache(cachePath, sourcePath, mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), &lod, 1));
+
+	MeshCache cache{};
+	REQUIRE(cache.open(cachePath, sourcePath));
+	CHECK_EQ(cache.getVertexCount(), mesh.vertices.size());
+	CHECK_EQ(cache.getIndexCount(), mesh.indices.size());
+	CHECK_EQ(cache.getLodCount(), 1);
+	CHECK(memcmp(cache.getVertices(), mesh.vertices.data(), mesh.vertices.size() * sizeof(MeshVertex)) == 0);
+	CHECK(memcmp(cache.getIndices(), mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int)) == 0);
+	cache.close();
+	CHECK(!cache.isOpen());
+
+	// A source of a different size makes the cache stale; no source path skips the check.
+	const std::string edited = text + "# edited\n";
+	REQUIRE(writeFile(sourcePath, edited.data(), edited.size()));
+	CHECK(!cache.open(cachePath, sourcePath));
+	CHECK(cache.open(cachePath, nullptr));
+	cache.close();
+
+	// A truncated cache is rejected.
+	std::vector<char> bytes(128);
+	REQUIRE(writeFile(cachePath, bytes.data(), bytes.size()));
+	CHECK(!cache.open(cachePath, nullptr));
+	CHECK(importMesh("MeshLoaderTest_missing.obj", &mesh) == MeshLoadResult::fileNotFound);
+	CHECK(importMesh(cachePath, &mesh) == MeshLoadResult::unsupportedFormat);
+	remove(sourcePath);
+	remove(cachePath);
+}
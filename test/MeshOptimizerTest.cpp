@@ -0,0 +1,154 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "MeshOptimizer.h"
+
+TEST(weldsBitIdenticalVertices)
+{
+	const TestMesh cube = makeSoupCube();
+	std::vector<unsigned int> remap{};
+	// 8 corners x 3 face normals.
+	CHECK_EQ(weldVertices(remap, cube.vertices.data(), cube.vertices.size(), sizeof(TestVertex)), 24);
+	REQUIRE(remap.size() == cube.vertices.size());
+	for (size_t i = 0; i < remap.size(); i++)
+	{
+		for (size_t j = 0; j < remap.size(); j++)
+		{
+			const bool same = memcmp(&cube.vertices[i], &cube.vertices[j], sizeof(TestVertex)) == 0;
+			CHECK(same == (remap[i] == remap[j]));
+		}
+	}
+}
+
+TEST(remapKeepsTriangles)
+{
+	TestMesh cube = makeSoupCube();
+	const auto expected = getCanonicalTriangles(cube);
+	std::vector<unsigned int> remap{};
+	const size_t unique = weldVertices(remap, cube.vertices.data(), cube.vertices.size(), sizeof(TestVertex));
+	std::vector<TestVertex> welded(unique);
+	remapVertexBuffer(welded.data(), cube.vertices.data(), cube.vertices.size(), sizeof(TestVertex), remap);
+	remapIndexBuffer(cube.indices.data(), cube.indices.size(), remap);
+	for (unsigned int index : cube.indices) { CHECK(index < unique); }
+	CHECK(getCanonicalTriangles(welded.data(), cube.indices.data(), cube.indices.size()) == expected);
+}
+
+TEST(analyzesKnownCacheBehaviour)
+{
+	const unsigned int triangle[3] = { 0, 1, 2 };
+	MeshStatistics stats = analyzeMesh(triangle, 3, 3, 32);
+	CHECK_NEAR(stats.acmr, 3.0, 1e-6);
+	CHECK_NEAR(stats.atvr, 1.0, 1e-6);
+	CHECK_EQ(stats.indexBytes, 6);
+	CHECK_EQ(stats.vertexBytes, 96);
+
+	// A quad shares two vertices between its triangles.
+	const unsigned int quad[6] = { 0, 1, 2, 2, 1, 3 };
+	stats = analyzeMesh(quad, 6, 4, 32);
+	CHECK_NEAR(stats.acmr, 2.0, 1e-6);
+	CHECK_NEAR(stats.atvr, 1.0, 1e-6);
+
+	// Cache of 3 with a pattern that evicts every vertex before reuse.
+	const unsigned int thrash[12] = { 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5 };
+	stats = analyzeMesh(thrash, 12, 6, 32, 3);
+	CHECK_NEAR(stats.atvr, 2.0, 1e-6);
+}
+
+TEST(vertexCacheOrderImprovesAcmr)
+{
+	const TestMesh sphere = makeSphereMesh(64, 64);
+	const auto expected = getCanonicalTriangles(sphere);
+	std::vector<unsigned int> indices(sphere.indices.size());
+	optimizeVertexCache(indices.data(), sphere.indices.data(), indices.size(), sphere.vertices.size());
+	CHECK(getCanonicalTriangles(sphere.vertices.data(), indices.data(), indices.size()) == expected);
+	const MeshStatistics before = analyzeMesh(sphere.indices.data(), sphere.indices.size(), sphere.vertices.size(), sizeof(TestVertex));
+	const MeshStatistics after = analyzeMesh(indices.data(), indices.size(), sphere.vertices.size(), sizeof(TestVertex));
+	CHECK(after.acmr < before.acmr * 0.75f);
+	CHECK(after.acmr < 0.8f);
+
+	// In place gives the same order.
+	std::vector<unsigned int> inPlace = sphere.indices;
+	optimizeVertexCache(inPlace.data(), inPlace.data(), inPlace.size(), sphere.vertices.size());
+	CHECK(inPlace == indices);
+}
+
+TEST(overdrawOrderStaysWithinThreshold)
+{
+	const TestMesh sphere = makeSphereMesh(48, 48);
+	const auto expected = getCanonicalTriangles(sphere);
+	std::vector<unsigned int> indices(sphere.indices.size());
+	optimizeVertexCache(indices.data(), sphere.indices.data(), indices.size(), sphere.vertices.size());
+	const float cached = analyzeMesh(indices.data(), indices.size(), sphere.vertices.size(), sizeof(TestVertex)).acmr;
+	optimizeOverdraw(indices.data(), indices.data(), indices.size(), sphere.vertices[0].position, sphere.vertices.size(), sizeof(TestVertex), 1.05f);
+	CHECK(getCanonicalTriangles(sphere.vertices.data(), indices.data(), indices.size()) == expected);
+	const float overdraw = analyzeMesh(indices.data(), indices.size(), sphere.vertices.size(), sizeof(TestVertex)).acmr;
+	CHECK(overdraw <= cached * 1.05f + 1e-6f);
+}
+
+TEST(fetchRemapOrdersByFirstUse)
+{
+	const unsigned int indices[6] = { 4, 2, 0, 0, 2, 5 };
+	std::vector<unsigned int> remap{};
+	CHECK_EQ(optimizeVertexFetchRemap(remap, indices, 6, 7), 4);
+	REQUIRE(remap.size() == 7);
+	CHECK_EQ(remap[4], 0);
+	CHECK_EQ(remap[2], 1);
+	CHECK_EQ(remap[0], 2);
+	CHECK_EQ(remap[5], 3);
+	// Unreferenced vertices are dropped.
+	CHECK_EQ(remap[1], ~0u);
+	CHECK_EQ(remap[3], ~0u);
+	CHECK_EQ(remap[6], ~0u);
+}
+
+TEST(chooses16BitIndices)
+{
+	CHECK(fitsIn16BitIndices(0xFFFF));
+	CHECK(!fitsIn16BitIndices(0x10000));
+	const unsigned int wide[4] = { 0, 1, 0xFFFE, 0xFFFF };
+	unsigned short narrow[4] = {};
+	convertTo16BitIndices(narrow, wide, 4);
+	for (int i = 0; i < 4; i++) { CHECK_EQ(narrow[i], wide[i]); }
+}
+
+TEST(optimizeMeshPreservesSurface)
+{
+	TestMesh sphere = makeSphereMesh(64, 32);
+	const auto expected = getCanonicalTriangles(sphere);
+	const size_t vertexCount = sphere.vertices.size();
+	const MeshOptimizeReport report = optimizeMesh(sphere.vertices, sphere.indices);
+	CHECK(getCanonicalTriangles(sphere) == expected);
+	CHECK_EQ(report.before.vertexCount, vertexCount);
+	CHECK_EQ(report.after.vertexCount, sphere.vertices.size());
+	CHECK(report.after.acmr < report.before.acmr);
+	CHECK(report.use16BitIndices);
+	// 16-bit indices alone halve the index bytes.
+	CHECK(report.getBytesSaved() >= static_cast<long long>(sphere.indices.size() * 2));
+	// Vertices come in first-use order.
+	unsigned int next = 0;
+	for (unsigned int index : sphere.indices)
+	{
+		CHECK(index <= next);
+		if (index == next) { next++; }
+	}
+}
+
+TEST(optimizeMeshWeldsSoup)
+{
+	TestMesh cube = makeSoupCube();
+	const auto expected = getCanonicalTriangles(cube);
+	const MeshOptimizeReport report = optimizeMesh(cube.vertices, cube.indices);
+	CHECK_EQ(cube.vertices.size(), 24);
+	CHECK_EQ(report.after.vertexCount, 24);
+	CHECK(getCanonicalTriangles(cube) == expected);
+	CHECK(report.after.atvr <= 1.0f + 1e-6f);
+}
+
+TEST(optimizeMeshHandlesEmptyInput)
+{
+	std::vector<TestVertex> vertices{};
+	std::vector<unsigned int> indices{};
+	const MeshOptimizeReport report = optimizeMesh(vertices, indices);
+	CHECK(vertices.empty());
+	CHECK(indices.empty());
+	CHECK_EQ(report.getBytesSaved(), 0);
+}
@@ -0,0 +1,235 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	double dot(const double* a, const double* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+	// Distance from p to triangle abc (closest point by region, Ericson 5.1.5).
+	double getPointTriangleDistance(const float* point, const float* a, const float* b, const float* c)
+	{
+		double p[3], ab[3], ac[3], ap[3], bp[3], cp[3], q[3];
+		for (int k = 0; k < 3; k++)
+		{
+			p[k] = point[k];
+			ab[k] = b[k] - a[k];
+			ac[k] = c[k] - a[k];
+			ap[k] = p[k] - a[k];
+			bp[k] = p[k] - b[k];
+			cp[k] = p[k] - c[k];
+		}
+		auto distanceTo = [&](const double* x) { const double d[3] = { p[0] - x[0], p[1] - x[1], p[2] - x[2] }; return sqrt(dot(d, d)); };
+		const double pa[3] = { a[0], a[1], a[2] }, pb[3] = { b[0], b[1], b[2] }, pc[3] = { c[0], c[1], c[2] };
+		const double d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if (d1 <= 0 && d2 <= 0) { return distanceTo(pa); }
+		const double d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if (d3 >= 0 && d4 <= d3) { return distanceTo(pb); }
+		const double vc = d1 * d4 - d3 * d2;
+		if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		{
+			const double v = d1 / (d1 - d3);
+			for (int k = 0; k < 3; k++) { q[k] = pa[k] + v * ab[k]; }
+			return distanceTo(q);
+		}
+		const double d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if (d6 >= 0 && d5 <= d6) { return distanceTo(pc); }
+		const double vb = d5 * d2 - d1 * d6;
+		if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		{
+			const double w = d2 / (d2 - d6);
+			for (int k = 0; k < 3; k++) { q[k] = pa[k] + w * ac[k]; }
+			return distanceTo(q);
+		}
+		const double va = d3 * d6 - d5 * d4;
+		if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+		{
+			const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			for (int k = 0; k < 3; k++) { q[k] = pb[k] + w * (pc[k] - pb[k]); }
+			return distanceTo(q);
+		}
+		const double denominator = 1.0 / (va + vb + vc);
+		for (int k = 0; k < 3; k++) { q[k] = pa[k] + ab[k] * vb * denominator + ac[k] * vc * denominator; }
+		return distanceTo(q);
+	}
+
+	// Largest distance from a vertex of the full mesh to the simplified surface.
+	double getDeviation(const TestMesh& mesh, const unsigned int* lodIndices, size_t lodIndexCount)
+	{
+		std::vector<unsigned char> used(mesh.vertices.size(), 0);
+		for (unsigned int index : mesh.indices) { used[index] = 1; }
+		double worst = 0.0;
+		for (size_t v = 0; v < mesh.vertices.size(); v++)
+		{
+			if (!used[v]) { continue; }
+			double best = HUGE_VAL;
+			for (size_t t = 0; t + 2 < lodIndexCount; t += 3)
+			{
+				best = fmin(best, getPointTriangleDistance(mesh.vertices[v].position, mesh.vertices[lodIndices[t]].position,
+					mesh.vertices[lodIndices[t + 1]].position, mesh.vertices[lodIndices[t + 2]].position));
+			}
+			worst = fmax(worst, best);
+		}
+		return worst;
+	}
+
+	TestMesh makeOptimizedSphere(unsigned int slices, unsigned int stacks)
+	{
+		TestMesh sphere = makeSphereMesh(slices, stacks);
+		// Welding closes the seam so the simplifier sees a closed surface.
+		std::vector<TestVertex> positionsOnly(sphere.vertices.size());
+		for (size_t i = 0; i < sphere.vertices.size(); i++) { positionsOnly[i] = TestVertex{ { sphere.vertices[i].position[0], sphere.vertices[i].position[1], sphere.vertices[i].position[2] }, {}, {} }; }
+		sphere.vertices = positionsOnly;
+		optimizeMesh(sphere.vertices, sphere.indices);
+		return sphere;
+	}
+}
+
+TEST(lodChainIsDeterministic)
+{
+	const TestMesh sphere = makeOptimizedSphere(64, 64);
+	std::vector<unsigned int> reference = sphere.indices;
+	std::vector<MeshLod> referenceLods{};
+	buildLodChain(reference, referenceLods, sphere.vertices[0].position, sphere.vertices.size(), sizeof(TestVertex));
+	REQUIRE(referenceLods.size() > 2);
+
+	// Built concurrently on every worker, as loadGeometries does across meshes.
+	const size_t copies = getWorkerCount() * 2;
+	std::vector<std::vector<unsigned int>> chains(copies, sphere.indices);
+	std::vector<std::vector<MeshLod>> lods(copies);
+	parallelFor(copies, 1, [&](size_t i)
+		{
+			buildLodChain(chains[i], lods[i], sphere.vertices[0].position, sphere.vertices.size(), sizeof(TestVertex));
+		});
+	for (size_t i = 0; i < copies; i++)
+	{
+		CHECK(chains[i] == reference);
+		REQUIRE(lods[i].size() == referenceLods.size());
+		for (size_t l = 0; l < referenceLods.size(); l++)
+		{
+			CHECK_EQ(lods[i][l].indexOffset, referenceLods[l].indexOffset);
+			CHECK_EQ(lods[i][l].indexCount, referenceLods[l].indexCount);
+			CHECK(lods[i][l].error == referenceLods[l].error);
+		}
+	}
+}
+
+TEST(lodChainShrinksWithinErrorBound)
+{
+	const TestMesh sphere = makeOptimizedSphere(48, 48);
+	std::vector<unsigned int> chain = sphere.indices;
+	std::vector<MeshLod> lods{};
+	const LodChainDesc desc{};
+	buildLodChain(chain, lods, sphere.vertices[0].position, sphere.vertices.size(), sizeof(TestVertex), desc);
+	REQUIRE(lods.size() > 2);
+	CHECK_EQ(lods[0].indexOffset, 0);
+	CHECK_EQ(lods[0].indexCount, sphere.indices.size());
+	CHECK(lods[0].error == 0.0f);
+	// The sphere spans 1 unit, so the relative limit is also the absolute one.
+	const float extent = 1.0f;
+	for (size_t l = 1; l < lods.size(); l++)
+	{
+		const MeshLod& lod = lods[l];
+		CHECK_EQ(lod.indexOffset, lods[l - 1].indexOffset + lods[l - 1].indexCount);
+		CHECK(lod.indexCount % 3 == 0);
+		CHECK(lod.indexCount * 10 <= lods[l - 1].indexCount * 9);
+		CHECK(lod.indexCount >= desc.minIndexCount);
+		CHECK(lod.error >= lods[l - 1].error);
+		CHECK(lod.error <= desc.maxError * extent * 2.0f);
+		const double deviation = getDeviation(sphere, &chain[lod.indexOffset], lod.indexCount);
+		CHECK(deviation <= lod.error * 1.001 + 1e-6);
+	}
+	CHECK_EQ(lods.back().indexOffset + lods.back().indexCount, chain.size());
+	CHECK(lods.size() <= desc.maxLevels);
+}
+
+TEST(simplifyRespectsTargets)
+{
+	const TestMesh sphere = makeOptimizedSphere(32, 32);
+	std::vector<unsigned int> result(sphere.indices.size());
+	float error = -1.0f;
+	// Unlimited error: stops at the triangle target.
+	size_t count = simplifyMesh(result.data(), sphere.indices.data(), sphere.indices.size(), sphere.vertices[0].position,
+		sphere.vertices.size(), sizeof(TestVertex), sphere.indices.size() / 4, 1.0f, &error);
+	CHECK(count <= sphere.indices.size() / 4);
+	CHECK(count > 0);
+	CHECK(error >= 0.0f);
+
+	// Tight error: keeps more triangles and reports an error below the limit.
+	const float limit = 1e-3f;
+	count = simplifyMesh(result.data(), sphere.indices.data(), sphere.indices.size(), sphere.vertices[0].position,
+		sphere.vertices.size(), sizeof(TestVertex), 0, limit, &error);
+	CHECK(count > sphere.indices.size() / 4);
+	CHECK(error <= limit);
+	CHECK(getDeviation(sphere, result.data(), count) <= limit * 1.001);
+	for (size_t i = 0; i < count; i++) { CHECK(result[i] < sphere.vertices.size()); }
+}
+
+TEST(simplifyKeepsBordersAndFlatAreas)
+{
+	const unsigned int cells = 16;
+	const TestMesh grid = makeGridMesh(cells);
+	std::vector<unsigned int> result(grid.indices.size());
+	float error = -1.0f;
+	const size_t count = simplifyMesh(result.data(), grid.indices.data(), grid.indices.size(), grid.vertices[0].position,
+		grid.vertices.size(), sizeof(TestVertex), 0, 0.01f, &error);
+	CHECK(count < grid.indices.size() / 4);
+	// Collapses inside a plane cost nothing.
+	CHECK_NEAR(error, 0.0, 1e-6);
+	std::vector<unsigned char> used(grid.vertices.size(), 0);
+	for (size_t i = 0; i < count; i++) { used[result[i]] = 1; }
+	for (unsigned int z = 0; z <= cells; z++)
+	{
+		for (unsigned int x = 0; x <= cells; x++)
+		{
+			if (x == 0 || z == 0 || x == cells || z == cells) { CHECK(used[z * (cells + 1) + x]); }
+		}
+	}
+	// Area is preserved; triangles may not fold over.
+	double area = 0.0;
+	for (size_t t = 0; t < count; t += 3)
+	{
+		const float* a = grid.vertices[result[t]].position;
+		const float* b = grid.vertices[result[t + 1]].position;
+		const float* c = grid.vertices[result[t + 2]].position;
+		const double cross = (b[2] - a[2]) * (c[0] - a[0]) - (b[0] - a[0]) * (c[2] - a[2]);
+		CHECK(cross > 0.0);
+		area += cross * 0.5;
+	}
+	CHECK_NEAR(area, 1.0, 1e-5);
+}
+
+TEST(selectsLodWithHysteresis)
+{
+	const MeshLod lods[4] = { { 0, 300, 0.0f }, { 300, 150, 0.01f }, { 450, 75, 0.02f }, { 525, 36, 0.04f } };
+	// errorToPixels = 100: level errors project to 1, 2 and 4 pixels.
+	CHECK_EQ(selectLod(lods, 4, 100.0f, 0, 1.0f, 0.25f), 0);
+	CHECK_EQ(selectLod(lods, 4, 10.0f, 0, 1.0f, 0.25f), 3);
+	// Level 3 projects to 0.8 px, beyond the 0.75 px margin.
+	CHECK_EQ(selectLod(lods, 4, 20.0f, 0, 1.0f, 0.25f), 2);
+	// Level 1 projects to 0.9 px: under the threshold but inside the margin, so stay at 0...
+	CHECK_EQ(selectLod(lods, 4, 90.0f, 0, 1.0f, 0.25f), 0);
+	// ...but do not go back to 0 from 1 either.
+	CHECK_EQ(selectLod(lods, 4, 90.0f, 1, 1.0f, 0.25f), 1);
+	// Level 1 above the threshold forces the finer level at once.
+	CHECK_EQ(selectLod(lods, 4, 110.0f, 1, 1.0f, 0.25f), 0);
+	CHECK_EQ(selectLod(lods, 4, 1.0f, 9, 1.0f, 0.25f), 3);
+	CHECK_EQ(selectLod(lods, 0, 1.0f, 2, 1.0f, 0.25f), 0);
+}
+
+TEST(boundingSphereContainsVertices)
+{
+	TestMesh sphere = makeSphereMesh(24, 12, 2.0f);
+	for (TestVertex& v : sphere.vertices) { v.position[0] += 5.0f; }
+	float bounds[4];
+	computeBoundingSphere(bounds, sphere.vertices[0].position, sphere.vertices.size(), sizeof(TestVertex));
+	CHECK_NEAR(bounds[0], 5.0, 1e-4);
+	for (const TestVertex& v : sphere.vertices)
+	{
+		const float d[3] = { v.position[0] - bounds[0], v.position[1] - bounds[1], v.position[2] - bounds[2] };
+		CHECK(sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) <= bounds[3] * 1.0001f);
+	}
+	CHECK(bounds[3] <= 2.0f * sqrtf(3.0f) * 1.0001f);
+}
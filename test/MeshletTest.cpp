@@ -0,0 +1,215 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "Meshlet.h"
+#include <string.h>
+#include <random>
+
+namespace
+{
+	struct MeshletMesh
+	{
+		TestMesh mesh;
+		std::vector<Meshlet> meshlets;
+	};
+
+	// makeSphere winds its fronts clockwise; meshlet cones expect CCW fronts like PipelineState.
+	TestMesh makeCcwSphere(unsigned int slices, unsigned int stacks)
+	{
+		TestMesh sphere = makeSphereMesh(slices, stacks);
+		for (size_t i = 0; i < sphere.indices.size(); i += 3) { std::swap(sphere.indices[i + 1], sphere.indices[i + 2]); }
+		return sphere;
+	}
+
+	MeshletMesh makeMeshletSphere(unsigned int slices, unsigned int stacks)
+	{
+		MeshletMesh result{ makeCcwSphere(slices, stacks), {} };
+		buildMeshlets(result.meshlets, result.mesh.indices.data(), result.mesh.indices.size(),
+			result.mesh.vertices[0].position, result.mesh.vertices.size(), sizeof(TestVertex));
+		return result;
+	}
+
+	// Outward for CCW fronts in left-handed coordinates.
+	void getFaceNormal(float out[3], const float* a, const float* b, const float* c)
+	{
+		const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		out[0] = e2[1] * e1[2] - e2[2] * e1[1];
+		out[1] = e2[2] * e1[0] - e2[0] * e1[2];
+		out[2] = e2[0] * e1[1] - e2[1] * e1[0];
+	}
+
+	MeshletCullParams makeRandomParams(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+		MeshletCullParams params{};
+		// Camera outside the unit sphere, one plane through the mesh, the rest far away.
+		do
+		{
+			for (float& c : params.cameraPosition) { c = uniform(random) * 3.0f; }
+		} while (params.cameraPosition[0] * params.cameraPosition[0] + params.cameraPosition[1] * params.cameraPosition[1] + params.cameraPosition[2] * params.cameraPosition[2] < 1.0f);
+		for (int p = 1; p < 6; p++) { params.planes[p][3] = 100.0f; }
+		float length = 0.0f;
+		do
+		{
+			for (int k = 0; k < 3; k++) { params.planes[0][k] = uniform(random); }
+			length = sqrtf(params.planes[0][0] * params.planes[0][0] + params.planes[0][1] * params.planes[0][1] + params.planes[0][2] * params.planes[0][2]);
+		} while (length < 0.1f);
+		for (int k = 0; k < 3; k++) { params.planes[0][k] /= length; }
+		params.planes[0][3] = uniform(random) * 0.4f;
+		params.coneCulling = true;
+		return params;
+	}
+}
+
+TEST(meshletsPartitionTriangles)
+{
+	const TestMesh source = makeCcwSphere(64, 48);
+	const MeshletMesh sphere = makeMeshletSphere(64, 48);
+	// Reordered in place: the same triangles with the same winding.
+	CHECK(getCanonicalTriangles(sphere.mesh) == getCanonicalTriangles(source));
+	size_t offset = 0;
+	for (const Meshlet& meshlet : sphere.meshlets)
+	{
+		CHECK_EQ(meshlet.indexOffset, offset);
+		CHECK(meshlet.triangleCount >= 1 && meshlet.triangleCount <= 124);
+		CHECK(meshlet.vertexCount >= 3 && meshlet.vertexCount <= 64);
+		std::vector<unsigned int> vertices(sphere.mesh.indices.begin() + offset, sphere.mesh.indices.begin() + offset + meshlet.triangleCount * 3);
+		std::sort(vertices.begin(), vertices.end());
+		CHECK_EQ(std::unique(vertices.begin(), vertices.end()) - vertices.begin(), meshlet.vertexCount);
+		offset += meshlet.triangleCount * 3;
+	}
+	CHECK_EQ(offset, sphere.mesh.indices.size());
+
+	// baseIndexOffset only shifts the stored offsets.
+	TestMesh shifted = source;
+	std::vector<Meshlet> shiftedMeshlets{};
+	buildMeshlets(shiftedMeshlets, shifted.indices.data(), shifted.indices.size(), shifted.vertices[0].position,
+		shifted.vertices.size(), sizeof(TestVertex), 1000);
+	REQUIRE(shiftedMeshlets.size() == sphere.meshlets.size());
+	CHECK(shifted.indices == sphere.mesh.indices);
+	for (size_t i = 0; i < shiftedMeshlets.size(); i++) { CHECK_EQ(shiftedMeshlets[i].indexOffset, sphere.meshlets[i].indexOffset + 1000); }
+}
+
+TEST(meshletBoundsContainTrianglesAndNormals)
+{
+	const MeshletMesh sphere = makeMeshletSphere(64, 48);
+	for (const Meshlet& meshlet : sphere.meshlets)
+	{
+		for (unsigned int t = 0; t < meshlet.triangleCount; t++)
+		{
+			const unsigned int* triangle = &sphere.mesh.indices[meshlet.indexOffset + t * 3];
+			const float* p[3] = { sphere.mesh.vertices[triangle[0]].position, sphere.mesh.vertices[triangle[1]].position, sphere.mesh.vertices[triangle[2]].position };
+			for (const float* v : p)
+			{
+				const float d[3] = { v[0] - meshlet.center[0], v[1] - meshlet.center[1], v[2] - meshlet.center[2] };
+				CHECK(sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) <= meshlet.radius * 1.0001f + 1e-6f);
+			}
+			float n[3];
+			getFaceNormal(n, p[0], p[1], p[2]);
+			const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			// Pole triangles collapse to slivers with arbitrary normals.
+			if (length < 1e-6f) { continue; }
+			const float centroid[3] = { p[0][0] + p[1][0] + p[2][0], p[0][1] + p[1][1] + p[2][1], p[0][2] + p[1][2] + p[2][2] };
+			// Front faces of the sphere point outward.
+			CHECK(n[0] * centroid[0] + n[1] * centroid[1] + n[2] * centroid[2] > 0.0f);
+			if (meshlet.coneCutoff < 1.0f)
+			{
+				// Every normal lies inside the cone: dot >= sin(half angle complement).
+				const float dot = (n[0] * meshlet.coneAxis[0] + n[1] * meshlet.coneAxis[1] + n[2] * meshlet.coneAxis[2]) / length;
+				CHECK(dot >= sqrtf(1.0f - meshlet.coneCutoff * meshlet.coneCutoff) - 1e-4f);
+			}
+		}
+	}
+}
+
+TEST(meshletStatisticsOnSphere)
+{
+	const MeshletMesh sphere = makeMeshletSphere(128, 96);
+	size_t used = 0;
+	{
+		std::vector<unsigned char> seen(sphere.mesh.vertices.size(), 0);
+		for (unsigned int index : sphere.mesh.indices) { used += !seen[index]; seen[index] = 1; }
+	}
+	const MeshletStatistics statistics = analyzeMeshlets(sphere.meshlets.data(), sphere.meshlets.size(), used);
+	CHECK_EQ(statistics.meshletCount, sphere.meshlets.size());
+	// Quality floor for a regular grid: 64 vertices hold ~100 grid triangles, so the
+	// triangle limit is never reached; duplication stays low and most cones are usable.
+	CHECK(statistics.vertexFill >= 0.8f);
+	CHECK(statistics.triangleFill >= 0.55f);
+	CHECK(statistics.vertexRedundancy <= 1.5f);
+	CHECK(statistics.coneCullable >= 0.9f);
+	CHECK_NEAR(statistics.averageTriangles * statistics.meshletCount, sphere.mesh.indices.size() / 3, 0.5);
+
+	const Meshlet meshlets[2] = { { 0, 100, 60, 0.5f }, { 300, 20, 30, 1.0f } };
+	const MeshletStatistics fixed = analyzeMeshlets(meshlets, 2, 80, 64, 124);
+	CHECK_NEAR(fixed.averageVertices, 45.0, 1e-6);
+	CHECK_NEAR(fixed.averageTriangles, 60.0, 1e-6);
+	CHECK_NEAR(fixed.vertexFill, 45.0 / 64.0, 1e-6);
+	CHECK_NEAR(fixed.triangleFill, 60.0 / 124.0, 1e-6);
+	CHECK_NEAR(fixed.vertexRedundancy, 90.0 / 80.0, 1e-6);
+	CHECK_NEAR(fixed.coneCullable, 0.5, 1e-6);
+	CHECK_EQ(analyzeMeshlets(nullptr, 0, 0).meshletCount, 0);
+}
+
+TEST(cullMatchesReference)
+{
+	const MeshletMesh sphere = makeMeshletSphere(96, 64);
+	MeshletCullData data{};
+	// Odd counts exercise the padded tail.
+	for (size_t count : { sphere.meshlets.size(), sphere.meshlets.size() - 1, size_t(3), size_t(0) })
+	{
+		data.build(sphere.meshlets.data(), count);
+		CHECK(data.centerX.size() % 4 == 0);
+		std::mt19937 random(7);
+		std::vector<MeshletDrawRange> simd{}, reference{};
+		for (int i = 0; i < 64; i++)
+		{
+			MeshletCullParams params = makeRandomParams(random);
+			params.coneCulling = (i & 1) == 0;
+			params.radiusScale = (i & 2) ? 1.5f : 1.0f;
+			params.radiusBias = (i & 4) ? 0.01f : 0.0f;
+			CHECK_EQ(cullMeshlets(simd, data, params), cullMeshletsReference(reference, data, params));
+			REQUIRE(simd.size() == reference.size());
+			CHECK(simd.empty() || memcmp(simd.data(), reference.data(), simd.size() * sizeof(MeshletDrawRange)) == 0);
+		}
+	}
+}
+
+TEST(cullIsConservative)
+{
+	const MeshletMesh sphere = makeMeshletSphere(96, 64);
+	MeshletCullData data{};
+	data.build(sphere.meshlets.data(), sphere.meshlets.size());
+	std::mt19937 random(11);
+	std::vector<MeshletDrawRange> ranges{};
+	size_t culledTriangles = 0, culledByCone = 0;
+	for (int i = 0; i < 64; i++)
+	{
+		const MeshletCullParams params = makeRandomParams(random);
+		const size_t visible = cullMeshlets(ranges, data, params);
+		CHECK(visible <= sphere.meshlets.size());
+		// Ranges are sorted, disjoint and merged.
+		for (size_t r = 1; r < ranges.size(); r++) { CHECK(ranges[r].indexOffset > ranges[r - 1].indexOffset + ranges[r - 1].indexCount); }
+		std::vector<unsigned char> drawn(sphere.mesh.indices.size() / 3, 0);
+		for (const MeshletDrawRange& range : ranges) { memset(&drawn[range.indexOffset / 3], 1, range.indexCount / 3); }
+		for (size_t t = 0; t < drawn.size(); t++)
+		{
+			if (drawn[t]) { continue; }
+			culledTriangles++;
+			const float* p[3] = { sphere.mesh.vertices[sphere.mesh.indices[t * 3]].position,
+				sphere.mesh.vertices[sphere.mesh.indices[t * 3 + 1]].position, sphere.mesh.vertices[sphere.mesh.indices[t * 3 + 2]].position };
+			bool inside = false;
+			for (const float* v : p) { inside |= params.planes[0][0] * v[0] + params.planes[0][1] * v[1] + params.planes[0][2] * v[2] + params.planes[0][3] >= 0.0f; }
+			if (!inside) { continue; }
+			// Culled but inside the frustum: must be a back face.
+			float n[3];
+			getFaceNormal(n, p[0], p[1], p[2]);
+			const float facing = n[0] * (p[0][0] - params.cameraPosition[0]) + n[1] * (p[0][1] - params.cameraPosition[1]) + n[2] * (p[0][2] - params.cameraPosition[2]);
+			CHECK(facing >= 0.0f);
+			culledByCone++;
+		}
+	}
+	// Both paths actually ran.
+	CHECK(culledTriangles > culledByCone);
+	CHECK(culledByCone > 0);
+}
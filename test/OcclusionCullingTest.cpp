@@ -0,0 +1,206 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "OcclusionCulling.h"
+#include <random>
+
+namespace
+{
+	constexpr unsigned int screenWidth = 320;
+	constexpr unsigned int screenHeight = 192;
+
+	// Camera at the origin looking down +z (view = identity).
+	void makeViewProjection(float out[16])
+	{
+		const float nearZ = 0.5f, farZ = 200.0f;
+		const float yScale = 1.0f / tanf(0.5f), xScale = yScale * screenHeight / screenWidth;
+		const float projection[16] = { xScale,0,0,0, 0,yScale,0,0, 0,0,farZ / (farZ - nearZ),1, 0,0,-nearZ * farZ / (farZ - nearZ),0 };
+		memcpy(out, projection, sizeof(projection));
+	}
+
+	void transform(float out[4], const float* p, const float m[16])
+	{
+		for (int k = 0; k < 4; k++) { out[k] = p[0] * m[k] + p[1] * m[4 + k] + p[2] * m[8 + k] + m[12 + k]; }
+	}
+
+	// Per-pixel depth buffer of the front faces, sampled at pixel centers.
+	std::vector<float> rasterizeReference(const TestMesh& mesh, const float viewProjection[16])
+	{
+		std::vector<float> depth(screenWidth * screenHeight, 1.0f);
+		for (size_t t = 0; t < mesh.indices.size(); t += 3)
+		{
+			float x[3], y[3], z[3];
+			bool valid = true;
+			for (int v = 0; v < 3 && valid; v++)
+			{
+				float clip[4];
+				transform(clip, mesh.vertices[mesh.indices[t + v]].position, viewProjection);
+				valid = clip[3] > 1e-6f && clip[2] >= 0.0f;
+				x[v] = (clip[0] / clip[3] + 1.0f) * 0.5f * screenWidth;
+				y[v] = (1.0f - clip[1] / clip[3]) * 0.5f * screenHeight;
+				z[v] = clip[2] / clip[3];
+			}
+			const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+			// CCW on screen (y down) is negative area; back faces never occlude a closed box.
+			if (!valid || area >= 0.0f) { continue; }
+			for (unsigned int py = 0; py < screenHeight; py++)
+			{
+				for (unsigned int px = 0; px < screenWidth; px++)
+				{
+					const float sx = px + 0.5f, sy = py + 0.5f;
+					const float w0 = -((x[2] - x[1]) * (sy - y[1]) - (y[2] - y[1]) * (sx - x[1]));
+					const float w1 = -((x[0] - x[2]) * (sy - y[2]) - (y[0] - y[2]) * (sx - x[2]));
+					const float w2 = -((x[1] - x[0]) * (sy - y[0]) - (y[1] - y[0]) * (sx - x[0]));
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) { continue; }
+					float& d = depth[py * screenWidth + px];
+					d = std::min(d, (w0 * z[0] + w1 * z[1] + w2 * z[2]) / -area);
+				}
+			}
+		}
+		return depth;
+	}
+
+	TestMesh makeOccluderScene(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		TestMesh scene{};
+		for (int i = 0; i < 40; i++)
+		{
+			const float center[3] = { unit(random) * 30.0f, unit(random) * 15.0f, 20.0f + fabsf(unit(random)) * 30.0f };
+			const float half[3] = { 2.0f + fabsf(unit(random)) * 6.0f, 2.0f + fabsf(unit(random)) * 6.0f, 1.0f + fabsf(unit(random)) * 3.0f };
+			appendBoxMesh(scene, center, half);
+		}
+		return scene;
+	}
+}
+
+TEST(occluderBackfacesAreDropped)
+{
+	float viewProjection[16];
+	makeViewProjection(viewProjection);
+	TestMesh box{};
+	const float center[3] = { 0.0f, 0.0f, 10.0f }, half[3] = { 1.0f, 1.0f, 1.0f };
+	appendBoxMesh(box, center, half);
+	MaskedOcclusionBuffer buffer(screenWidth, screenHeight);
+	buffer.addOccluder(box.vertices[0].position, sizeof(TestVertex), box.indices.data(), 12, viewProjection);
+	// Straight ahead only the -z face is front facing.
+	CHECK_EQ(buffer.getQueuedTriangleCount(), 2);
+	buffer.clear();
+	buffer.addOccluder(box.vertices[0].position, sizeof(TestVertex), box.indices.data(), 12, viewProjection, false);
+	CHECK_EQ(buffer.getQueuedTriangleCount(), 12);
+
+	// Triangles crossing the near plane (0.5) are dropped; only the far face at z = 1.5 stays.
+	buffer.clear();
+	TestMesh nearBox{};
+	const float nearCenter[3] = { 0.0f, 0.0f, 0.5f };
+	appendBoxMesh(nearBox, nearCenter, half);
+	buffer.addOccluder(nearBox.vertices[0].position, sizeof(TestVertex), nearBox.indices.data(), 12, viewProjection, false);
+	CHECK_EQ(buffer.getQueuedTriangleCount(), 2);
+}
+
+TEST(wallOccludesBoxesBehindIt)
+{
+	float viewProjection[16];
+	makeViewProjection(viewProjection);
+	TestMesh wall{};
+	const float wallCenter[3] = { 0.0f, 0.0f, 20.0f }, wallHalf[3] = { 100.0f, 100.0f, 1.0f };
+	appendBoxMesh(wall, wallCenter, wallHalf);
+	MaskedOcclusionBuffer buffer(screenWidth, screenHeight);
+	buffer.addOccluder(wall.vertices[0].position, sizeof(TestVertex), wall.indices.data(), wall.indices.size() / 3, viewProjection);
+	buffer.rasterize();
+	const float behindMin[3] = { -1, -1, 30 }, behindMax[3] = { 1, 1, 32 };
+	const float frontMin[3] = { -1, -1, 10 }, frontMax[3] = { 1, 1, 12 };
+	// Straddles the wall: its nearest depth is in front.
+	const float throughMin[3] = { -1, -1, 15 }, throughMax[3] = { 1, 1, 25 };
+	const float asideMin[3] = { 200, -1, 30 }, asideMax[3] = { 202, 1, 32 };
+	const float nearMin[3] = { -1, -1, -1 }, nearMax[3] = { 1, 1, 1 };
+	CHECK(buffer.testAabb(behindMin, behindMax, viewProjection) == OcclusionResult::occluded);
+	CHECK(buffer.testAabb(frontMin, frontMax, viewProjection) == OcclusionResult::visible);
+	CHECK(buffer.testAabb(throughMin, throughMax, viewProjection) == OcclusionResult::visible);
+	CHECK(buffer.testAabb(asideMin, asideMax, viewProjection) == OcclusionResult::viewCulled);
+	CHECK(buffer.testAabb(nearMin, nearMax, viewProjection) == OcclusionResult::visible);
+
+	buffer.clear();
+	CHECK(buffer.testAabb(behindMin, behindMax, viewProjection) == OcclusionResult::visible);
+	CHECK(buffer.getPixelDepth(screenWidth / 2, screenHeight / 2) == 1.0f);
+}
+
+TEST(depthIsConservativeAgainstReference)
+{
+	float viewProjection[16];
+	makeViewProjection(viewProjection);
+	std::mt19937 random(5);
+	const TestMesh scene = makeOccluderScene(random);
+	MaskedOcclusionBuffer buffer(screenWidth, screenHeight);
+	buffer.addOccluder(scene.vertices[0].position, sizeof(TestVertex), scene.indices.data(), scene.indices.size() / 3, viewProjection);
+	buffer.rasterize();
+	const std::vector<float> reference = rasterizeReference(scene, viewProjection);
+
+	size_t tooNear = 0, known = 0, covered = 0;
+	for (unsigned int y = 0; y < screenHeight; y++)
+	{
+		for (unsigned int x = 0; x < screenWidth; x++)
+		{
+			const float depth = buffer.getPixelDepth(x, y);
+			const float exact = reference[y * screenWidth + x];
+			// Never nearer than the true surface, or objects would be culled wrongly.
+			tooNear += depth < exact - 1e-5f;
+			known += depth < 1.0f;
+			covered += exact < 1.0f;
+		}
+	}
+	CHECK_EQ(tooNear, 0);
+	CHECK(covered > screenWidth * screenHeight / 4);
+	// Coverage lost to the two-layer merge and tile edges stays small.
+	CHECK(known >= covered * 95 / 100);
+}
+
+TEST(objectTestsNeverOccludeVisibleBoxes)
+{
+	float viewProjection[16];
+	makeViewProjection(viewProjection);
+	std::mt19937 random(5);
+	const TestMesh scene = makeOccluderScene(random);
+	MaskedOcclusionBuffer buffer(screenWidth, screenHeight);
+	buffer.addOccluder(scene.vertices[0].position, sizeof(TestVertex), scene.indices.data(), scene.indices.size() / 3, viewProjection);
+	buffer.rasterize();
+	const std::vector<float> reference = rasterizeReference(scene, viewProjection);
+
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	size_t occluded = 0, referenceOccluded = 0, wrong = 0;
+	for (int i = 0; i < 20000; i++)
+	{
+		const float center[3] = { unit(random) * 40.0f, unit(random) * 20.0f, 25.0f + fabsf(unit(random)) * 70.0f };
+		const float size = 0.3f + fabsf(unit(random)) * 2.0f;
+		const float min[3] = { center[0] - size, center[1] - size, center[2] - size };
+		const float max[3] = { center[0] + size, center[1] + size, center[2] + size };
+		const OcclusionResult result = buffer.testAabb(min, max, viewProjection);
+		if (result == OcclusionResult::viewCulled) { continue; }
+		// Exact answer for the same screen rectangle and nearest depth.
+		float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			const float p[3] = { corner & 1 ? max[0] : min[0], corner & 2 ? max[1] : min[1], corner & 4 ? max[2] : min[2] };
+			float clip[4];
+			transform(clip, p, viewProjection);
+			minX = std::min(minX, (clip[0] / clip[3] + 1.0f) * 0.5f * screenWidth);
+			maxX = std::max(maxX, (clip[0] / clip[3] + 1.0f) * 0.5f * screenWidth);
+			minY = std::min(minY, (1.0f - clip[1] / clip[3]) * 0.5f * screenHeight);
+			maxY = std::max(maxY, (1.0f - clip[1] / clip[3]) * 0.5f * screenHeight);
+			minZ = std::min(minZ, clip[2] / clip[3]);
+		}
+		bool hidden = true;
+		const int firstY = std::max(0, static_cast<int>(floorf(minY))), lastY = std::min(static_cast<int>(screenHeight) - 1, static_cast<int>(floorf(maxY)));
+		const int firstX = std::max(0, static_cast<int>(floorf(minX))), lastX = std::min(static_cast<int>(screenWidth) - 1, static_cast<int>(floorf(maxX)));
+		for (int y = firstY; y <= lastY && hidden; y++)
+		{
+			for (int x = firstX; x <= lastX && hidden; x++) { hidden = reference[y * screenWidth + x] <= minZ; }
+		}
+		referenceOccluded += hidden;
+		occluded += result == OcclusionResult::occluded;
+		wrong += result == OcclusionResult::occluded && !hidden;
+	}
+	CHECK_EQ(wrong, 0);
+	CHECK(referenceOccluded > 1000);
+	// Conservative, but most truly hidden boxes are still found.
+	CHECK(occluded >= referenceOccluded * 4 / 5);
+}
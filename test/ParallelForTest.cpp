@@ -0,0 +1,111 @@
+﻿#include "Test.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// The sandbox may have a single core; force a pool so the threads are exercised.
+	constexpr size_t testWorkerCount = 4;
+
+	struct WorkerScope
+	{
+		size_t previous = getWorkerCount();
+		explicit WorkerScope(size_t count) { setWorkerCount(count); }
+		~WorkerScope() { setWorkerCount(previous); }
+	};
+}
+
+TEST(everyIndexRunsOnce)
+{
+	WorkerScope workers(testWorkerCount);
+	for (size_t count : { size_t(1), size_t(3), size_t(4), size_t(5), size_t(1000), size_t(100003) })
+	{
+		std::vector<std::atomic<int>> hits(count);
+		parallelFor(count, 1, [&](size_t i) { hits[i]++; });
+		CHECK(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int>& hit) { return hit == 1; }));
+	}
+}
+
+TEST(rangesAreContiguousAndIndexed)
+{
+	WorkerScope workers(testWorkerCount);
+	const size_t count = 10;
+	std::vector<size_t> begins(testWorkerCount, ~size_t(0)), ends(testWorkerCount, ~size_t(0));
+	const size_t rangeCount = parallelForRanges(count, 2, [&](size_t begin, size_t end, size_t range)
+		{
+			begins[range] = begin;
+			ends[range] = end;
+		});
+	REQUIRE(rangeCount == testWorkerCount);
+	CHECK_EQ(begins[0], size_t(0));
+	for (size_t r = 1; r < rangeCount; r++) { CHECK_EQ(begins[r], ends[r - 1]); }
+	CHECK_EQ(ends[rangeCount - 1], count);
+
+	// minRange limits the split, and tiny inputs stay on the caller.
+	CHECK_EQ(parallelForRanges(count, 4, [](size_t, size_t, size_t) {}), size_t(3));
+	CHECK_EQ(parallelForRanges(1, 1, [](size_t, size_t, size_t) {}), size_t(1));
+	CHECK_EQ(parallelForRanges(0, 1, [](size_t, size_t, size_t) {}), size_t(0));
+}
+
+TEST(threadsPersistAcrossCalls)
+{
+	WorkerScope workers(testWorkerCount);
+	std::mutex mutex;
+	std::vector<std::thread::id> ids;
+	for (int call = 0; call < 2000; call++)
+	{
+		parallelForRanges(testWorkerCount, 1, [&](size_t, size_t, size_t)
+			{
+				const std::thread::id id = std::this_thread::get_id();
+				std::lock_guard<std::mutex> lock(mutex);
+				if (std::find(ids.begin(), ids.end(), id) == ids.end()) { ids.push_back(id); }
+			});
+	}
+	// Spawning per call would show up to 2000 * 3 distinct ids.
+	CHECK(ids.size() <= testWorkerCount);
+	CHECK(std::find(ids.begin(), ids.end(), std::this_thread::get_id()) != ids.end());
+}
+
+TEST(nestedCallsRunOnTheCaller)
+{
+	WorkerScope workers(testWorkerCount);
+	const size_t outer = 16, inner = 64;
+	std::vector<std::atomic<int>> hits(outer * inner);
+	parallelFor(outer, 1, [&](size_t i)
+		{
+			parallelFor(inner, 1, [&](size_t j) { hits[i * inner + j]++; });
+		});
+	CHECK(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int>& hit) { return hit == 1; }));
+}
+
+TEST(concurrentCallersDoNotBlockEachOther)
+{
+	WorkerScope workers(testWorkerCount);
+	const size_t count = 4096;
+	std::vector<std::atomic<int>> hits(count * 2);
+	std::thread other([&]()
+		{
+			for (int call = 0; call < 200; call++) { parallelFor(count, 64, [&](size_t i) { hits[count + i]++; }); }
+		});
+	for (int call = 0; call < 200; call++) { parallelFor(count, 64, [&](size_t i) { hits[i]++; }); }
+	other.join();
+	CHECK(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int>& hit) { return hit == 200; }));
+}
+
+TEST(workerCountCanChange)
+{
+	WorkerScope workers(2);
+	CHECK_EQ(getWorkerCount(), size_t(2));
+	CHECK_EQ(parallelForRanges(100, 1, [](size_t, size_t, size_t) {}), size_t(2));
+	setWorkerCount(6);
+	CHECK_EQ(parallelForRanges(100, 1, [](size_t, size_t, size_t) {}), size_t(6));
+	setWorkerCount(0);
+	CHECK_EQ(getWorkerCount(), size_t(1));
+	std::atomic<size_t> sum{ 0 };
+	parallelFor(100, 1, [&](size_t i) { sum += i; });
+	CHECK_EQ(sum.load(), size_t(4950));
+}
@@ -0,0 +1,158 @@
+﻿#include "Test.h"
+#include "PcmConversion.h"
+#include <string.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const PcmFormat formats[] = { PcmFormat::unsigned8, PcmFormat::signed16, PcmFormat::signed24, PcmFormat::signed32, PcmFormat::float32 };
+	const PcmKernel kernels[] = { PcmKernel::scalar, PcmKernel::sse2, PcmKernel::avx2 };
+
+	// Random bytes; float inputs get values around [-1, 1] with NaN, infinities, -0 and rounding ties mixed in.
+	std::vector<unsigned char> makeSource(PcmFormat format, uint32_t channels, size_t frames, std::mt19937& random)
+	{
+		const size_t samples = static_cast<size_t>(channels) * frames;
+		std::vector<unsigned char> source(getPcmSampleSize(format) * samples);
+		for (unsigned char& byte : source) { byte = static_cast<unsigned char>(random()); }
+		if (format == PcmFormat::float32)
+		{
+			std::uniform_real_distribution<float> distribution(-1.5f, 1.5f);
+			for (size_t i = 0; i < samples; i++)
+			{
+				float value = distribution(random);
+				if (i % 97 == 0) { value = NAN; }
+				else if (i % 89 == 0) { value = -0.0f; }
+				else if (i % 83 == 0) { value = (i & 1) ? INFINITY : -INFINITY; }
+				else if (i % 79 == 0) { value = static_cast<float>((i % 7) * 2 + 1) * 0.5f / 32768.0f; }
+				memcpy(&source[i * 4], &value, 4);
+			}
+		}
+		return source;
+	}
+
+	template<class T>
+	std::vector<T*> getPointers(std::vector<std::vector<T>>& planes)
+	{
+		std::vector<T*> pointers;
+		for (std::vector<T>& plane : planes) { pointers.push_back(plane.data()); }
+		return pointers;
+	}
+
+	// Bitwise, so NaN and -0 count; empty vectors have a null data() that memcmp must not see.
+	bool sameBits(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+	}
+}
+
+TEST(kernelsMatchTheReferenceBitForBit)
+{
+	std::mt19937 random(7);
+	// 70001 frames are split across workers, the odd sizes exercise the vector tails.
+	const size_t lengths[] = { 0, 1, 5, 17, 33, 1001, 70001 };
+	for (PcmFormat format : formats)
+	{
+		for (uint32_t channels : { 1u, 2u, 3u, 6u })
+		{
+			for (size_t frames : lengths)
+			{
+				const std::vector<unsigned char> source = makeSource(format, channels, frames, random);
+				std::vector<std::vector<float>> referenceFloat(channels, std::vector<float>(frames)), actualFloat = referenceFloat;
+				std::vector<std::vector<int16_t>> referenceShort(channels, std::vector<int16_t>(frames)), actualShort = referenceShort;
+				std::vector<float> referenceMono(frames), actualMono(frames);
+				convertPcmReference(source.data(), format, channels, frames, getPointers(referenceFloat).data());
+				convertPcmReference(source.data(), format, channels, frames, getPointers(referenceShort).data());
+				convertPcmMonoReference(source.data(), format, channels, frames, referenceMono.data());
+				for (PcmKernel kernel : kernels)
+				{
+					convertPcm(source.data(), format, channels, frames, getPointers(actualFloat).data(), kernel);
+					convertPcm(source.data(), format, channels, frames, getPointers(actualShort).data(), kernel);
+					convertPcmMono(source.data(), format, channels, frames, actualMono.data(), kernel);
+					for (uint32_t c = 0; c < channels; c++)
+					{
+						CHECK(sameBits(referenceFloat[c], actualFloat[c]));
+						CHECK(referenceShort[c] == actualShort[c]);
+					}
+					CHECK(sameBits(referenceMono, actualMono));
+				}
+			}
+		}
+	}
+}
+
+TEST(integerSamplesConvertExactly)
+{
+	// Every 16-bit value times 2^15 gives back the integer.
+	std::vector<int16_t> shorts(65536);
+	for (size_t i = 0; i < shorts.size(); i++) { shorts[i] = static_cast<int16_t>(i - 32768); }
+	std::vector<float> floats(shorts.size());
+	float* out[] = { floats.data() };
+	int mismatches = 0;
+	for (PcmKernel kernel : kernels)
+	{
+		convertPcm(shorts.data(), PcmFormat::signed16, 1, shorts.size(), out, kernel);
+		for (size_t i = 0; i < shorts.size(); i++) { mismatches += floats[i] * 32768.0f != static_cast<float>(shorts[i]); }
+	}
+	CHECK_EQ(mismatches, 0);
+	CHECK(floats.front() == -1.0f);
+	CHECK(floats.back() == 32767.0f / 32768.0f);
+
+	// 24-bit samples are sign extended and fit the float mantissa.
+	const int32_t values[] = { 0, 1, -1, 0x7FFFFF, -0x800000, 0x123456, -0x123456 };
+	std::vector<unsigned char> packed;
+	for (int32_t value : values)
+	{
+		for (int b = 0; b < 3; b++) { packed.push_back(static_cast<unsigned char>(value >> (b * 8))); }
+	}
+	for (PcmKernel kernel : kernels)
+	{
+		float converted[7];
+		float* planes[] = { converted };
+		convertPcm(packed.data(), PcmFormat::signed24, 1, 7, planes, kernel);
+		for (int i = 0; i < 7; i++) { CHECK(converted[i] * 8388608.0f == static_cast<float>(values[i])); }
+		int16_t top[7];
+		int16_t* topPlanes[] = { top };
+		convertPcm(packed.data(), PcmFormat::signed24, 1, 7, topPlanes, kernel);
+		for (int i = 0; i < 7; i++) { CHECK_EQ(top[i], values[i] >> 8); }
+	}
+
+	// Unsigned 8-bit is centered on 0x80.
+	const unsigned char bytes[] = { 0x00, 0x80, 0xFF };
+	float eight[3];
+	float* eightPlanes[] = { eight };
+	convertPcm(bytes, PcmFormat::unsigned8, 1, 3, eightPlanes);
+	CHECK(eight[0] == -1.0f);
+	CHECK(eight[1] == 0.0f);
+	CHECK(eight[2] == 127.0f / 128.0f);
+}
+
+TEST(floatToShortRoundsAndClamps)
+{
+	const float inputs[] = { 0.0f, -0.0f, 0.5f / 32768, 1.5f / 32768, 2.5f / 32768, -0.5f / 32768, -1.5f / 32768, 1.0f, -1.0f, 2.0f, -2.0f, INFINITY, -INFINITY, NAN };
+	const int16_t expected[] = { 0, 0, 0, 2, 2, 0, -2, 32767, -32768, 32767, -32768, 32767, -32768, -32768 };
+	const size_t count = sizeof(inputs) / sizeof(inputs[0]);
+	for (PcmKernel kernel : kernels)
+	{
+		int16_t out[count];
+		int16_t* planes[] = { out };
+		convertPcm(inputs, PcmFormat::float32, 1, count, planes, kernel);
+		for (size_t i = 0; i < count; i++) { CHECK_EQ(out[i], expected[i]); }
+	}
+}
+
+TEST(monoAveragesInChannelOrder)
+{
+	const int16_t stereo[] = { 16384, 0, -32768, -32768, 1, 2 };
+	float mono[3];
+	convertPcmMono(stereo, PcmFormat::signed16, 2, 3, mono);
+	CHECK(mono[0] == 0.25f);
+	CHECK(mono[1] == -1.0f);
+	CHECK(mono[2] == 3.0f / 65536.0f);
+
+	// Three channels: (a + b + c) * (1 / 3), not divided by 3.
+	const float surround[] = { 0.1f, 0.2f, 0.3f };
+	float mixed;
+	convertPcmMono(surround, PcmFormat::float32, 3, 1, &mixed, PcmKernel::scalar);
+	CHECK(mixed == (0.1f + 0.2f + 0.3f) * (1.0f / 3.0f));
+}
@@ -0,0 +1,149 @@
+﻿#include "Test.h"
+#include "RealFft.h"
+#include <math.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const double pi = 3.14159265358979323846;
+
+	struct Spectrum
+	{
+		std::vector<float> re;
+		std::vector<float> im;
+	};
+
+	Spectrum transform(const RealFft& fft, const std::vector<float>& input)
+	{
+		Spectrum spectrum{ std::vector<float>(fft.getBinCount()), std::vector<float>(fft.getBinCount()) };
+		fft.forward(input.data(), spectrum.re.data(), spectrum.im.data());
+		return spectrum;
+	}
+}
+
+TEST(matchesTheNaiveDft)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	for (size_t size = 8; size <= 4096; size *= 2)
+	{
+		RealFft fft;
+		fft.init(size);
+		CHECK_EQ(fft.getSize(), size);
+		CHECK_EQ(fft.getBinCount(), size / 2 + 1);
+		std::vector<float> input(size);
+		for (float& x : input) { x = distribution(random); }
+		const Spectrum spectrum = transform(fft, input);
+		std::vector<double> re(size / 2 + 1), im(size / 2 + 1);
+		dftReference(input.data(), size, re.data(), im.data());
+		double error = 0.0, magnitude = 0.0;
+		for (size_t k = 0; k <= size / 2; k++)
+		{
+			error = fmax(error, hypot(spectrum.re[k] - re[k], spectrum.im[k] - im[k]));
+			magnitude = fmax(magnitude, hypot(re[k], im[k]));
+		}
+		// Float rounding grows with log2(n); measured below 2e-7 up to 16384.
+		CHECK(error <= magnitude * 1e-6);
+	}
+}
+
+TEST(tonesLandInTheirBins)
+{
+	const size_t size = 256;
+	RealFft fft;
+	fft.init(size);
+	std::vector<float> input(size);
+	for (size_t bin : { size_t(1), size_t(5), size_t(64), size_t(127) })
+	{
+		// cos gives a real n / 2 peak, sin an imaginary -n / 2 one.
+		for (size_t t = 0; t < size; t++) { input[t] = static_cast<float>(cos(2.0 * pi * bin * t / size)); }
+		Spectrum spectrum = transform(fft, input);
+		for (size_t k = 0; k <= size / 2; k++)
+		{
+			CHECK_NEAR(spectrum.re[k], k == bin ? size / 2.0 : 0.0, 1e-3);
+			CHECK_NEAR(spectrum.im[k], 0.0, 1e-3);
+		}
+		for (size_t t = 0; t < size; t++) { input[t] = static_cast<float>(sin(2.0 * pi * bin * t / size)); }
+		spectrum = transform(fft, input);
+		CHECK_NEAR(spectrum.re[bin], 0.0, 1e-3);
+		CHECK_NEAR(spectrum.im[bin], -(size / 2.0), 1e-3);
+	}
+
+	// DC and Nyquist are purely real.
+	for (size_t t = 0; t < size; t++) { input[t] = 0.25f + ((t & 1) ? -0.5f : 0.5f); }
+	const Spectrum spectrum = transform(fft, input);
+	CHECK_NEAR(spectrum.re[0], 0.25 * size, 1e-4);
+	CHECK_NEAR(spectrum.re[size / 2], 0.5 * size, 1e-4);
+	CHECK(spectrum.im[0] == 0.0f);
+	CHECK(spectrum.im[size / 2] == 0.0f);
+}
+
+TEST(energyIsPreserved)
+{
+	// Parseval: sum x^2 = (|X0|^2 + |Xn/2|^2 + 2 sum |Xk|^2) / n.
+	std::mt19937 random(3);
+	std::normal_distribution<float> distribution(0.0f, 0.3f);
+	const size_t size = 2048;
+	RealFft fft;
+	fft.init(size);
+	std::vector<float> input(size);
+	double energy = 0.0;
+	for (float& x : input) { x = distribution(random); energy += double(x) * x; }
+	const Spectrum spectrum = transform(fft, input);
+	double spectral = 0.0;
+	for (size_t k = 0; k <= size / 2; k++)
+	{
+		const double power = double(spectrum.re[k]) * spectrum.re[k] + double(spectrum.im[k]) * spectrum.im[k];
+		spectral += (k == 0 || k == size / 2) ? power : power * 2.0;
+	}
+	CHECK_NEAR(spectral / size, energy, energy * 1e-5);
+}
+
+TEST(oneInstanceServesSeveralThreads)
+{
+	const size_t size = 1024;
+	RealFft fft;
+	fft.init(size);
+	std::vector<std::vector<float>> inputs(4, std::vector<float>(size));
+	std::vector<Spectrum> expected;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		for (size_t t = 0; t < size; t++) { inputs[i][t] = static_cast<float>(sin(0.01 * t * (i + 1))); }
+		expected.push_back(transform(fft, inputs[i]));
+	}
+	std::vector<int> mismatches(inputs.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		threads.emplace_back([&, i]
+			{
+				for (int repeat = 0; repeat < 200; repeat++)
+				{
+					const Spectrum spectrum = transform(fft, inputs[i]);
+					mismatches[i] += spectrum.re != expected[i].re || spectrum.im != expected[i].im;
+				}
+			});
+	}
+	for (std::thread& thread : threads) { thread.join(); }
+	for (int count : mismatches) { CHECK_EQ(count, 0); }
+}
+
+TEST(windowsArePeriodic)
+{
+	const size_t size = 64;
+	std::vector<float> window(size);
+	CHECK_NEAR(makeFftWindow(FftWindow::rectangle, size, window.data()), size, 1e-9);
+	CHECK(window[0] == 1.0f && window[size - 1] == 1.0f);
+
+	// Periodic: the peak sits at n / 2 and the sums are the mean coefficients times n.
+	CHECK_NEAR(makeFftWindow(FftWindow::hann, size, window.data()), size * 0.5, 1e-5);
+	CHECK(window[0] == 0.0f);
+	CHECK_NEAR(window[size / 2], 1.0, 1e-7);
+	CHECK_NEAR(window[1], window[size - 1], 1e-7);
+
+	CHECK_NEAR(makeFftWindow(FftWindow::blackman, size, window.data()), size * 0.42, 1e-5);
+	CHECK_NEAR(window[0], 0.0, 1e-7);
+	CHECK_NEAR(window[size / 2], 1.0, 1e-7);
+}
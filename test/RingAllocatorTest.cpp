@@ -0,0 +1,132 @@
+﻿#include "Test.h"
+#include "RingAllocator.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+TEST(allocationsAreAligned)
+{
+	RingAllocator ring(4096, 256);
+	CHECK_EQ(ring.allocate(100), 0);
+	CHECK_EQ(ring.allocate(16), 256);
+	// The gap before the aligned offset counts as used.
+	CHECK_EQ(ring.getUsed(), 256 + 16);
+	CHECK_EQ(ring.allocate(256), 512);
+	CHECK_EQ(ring.allocate(0), RingAllocator::invalidOffset);
+	CHECK_EQ(ring.allocate(4097), RingAllocator::invalidOffset);
+}
+
+TEST(wrapPadsTheTail)
+{
+	RingAllocator ring(1024, 256);
+	CHECK_EQ(ring.allocate(512), 0);
+	ring.endFrame(1);
+	CHECK_EQ(ring.allocate(300), 512);
+	ring.endFrame(2);
+	ring.retire(1);
+	CHECK_EQ(ring.getUsed(), 300);
+	// 256 bytes remain at the end, too few for 400: wrap to 0 and hold the tail as padding.
+	CHECK_EQ(ring.allocate(400), 0);
+	CHECK_EQ(ring.getUsed(), 300 + (1024 - 812) + 400);
+	CHECK_EQ(ring.getHead(), 400);
+	ring.endFrame(3);
+	// Retiring frame 3 releases its padding too.
+	ring.retire(3);
+	CHECK_EQ(ring.getUsed(), 0);
+	CHECK_EQ(ring.getFramesInFlight(), 0);
+	// An empty ring starts over at 0.
+	CHECK_EQ(ring.allocate(1024), 0);
+}
+
+TEST(fullRingFailsUntilRetired)
+{
+	RingAllocator ring(1024, 256);
+	CHECK_EQ(ring.allocate(512), 0);
+	ring.endFrame(1);
+	CHECK_EQ(ring.allocate(512), 512);
+	ring.endFrame(2);
+	// The space ahead belongs to frame 1, which the GPU has not finished.
+	CHECK_EQ(ring.allocate(256), RingAllocator::invalidOffset);
+	ring.retire(0);
+	CHECK_EQ(ring.allocate(256), RingAllocator::invalidOffset);
+	CHECK_EQ(ring.getFramesInFlight(), 2);
+	ring.retire(1);
+	CHECK_EQ(ring.getFramesInFlight(), 1);
+	CHECK_EQ(ring.allocate(256), 0);
+	// A later completed fence retires every older frame at once.
+	ring.endFrame(5);
+	ring.retire(7);
+	CHECK_EQ(ring.getFramesInFlight(), 0);
+	CHECK_EQ(ring.getUsed(), 0);
+}
+
+TEST(overflowDiscardsLikeConstantArena)
+{
+	RingAllocator ring(1024, 256);
+	CHECK_EQ(ring.allocate(768), 0);
+	ring.endFrame(1);
+	// ConstantArena::write: allocation fails -> reset -> MAP_WRITE_DISCARD at offset 0.
+	size_t offset = ring.allocate(512);
+	CHECK_EQ(offset, RingAllocator::invalidOffset);
+	ring.reset();
+	offset = ring.allocate(512);
+	CHECK_EQ(offset, 0);
+	CHECK_EQ(ring.getFramesInFlight(), 0);
+	CHECK_EQ(ring.getUsed(), 512);
+}
+
+TEST(inFlightRangesNeverOverlap)
+{
+	struct Range
+	{
+		size_t begin;
+		size_t end;
+		uint64_t fence;
+	};
+	std::mt19937 random(9);
+	std::uniform_int_distribution<size_t> sizes(1, 3000);
+	std::uniform_int_distribution<int> draws(1, 20);
+	RingAllocator ring(64 * 1024, 256);
+	// Ranges the GPU may still read, in the buffer instance they were written to.
+	std::deque<Range> live;
+	std::vector<Range> frame;
+	const uint64_t latency = 3;
+	size_t discards = 0, wraps = 0;
+	for (uint64_t fence = 1; fence <= 2000; fence++)
+	{
+		// The GPU completes frames a few fences behind, sometimes stalling.
+		const uint64_t completed = fence > latency ? fence - latency - (random() % 2) : 0;
+		ring.retire(completed);
+		while (!live.empty() && live.front().fence <= completed) { live.pop_front(); }
+		const int count = draws(random);
+		for (int d = 0; d < count; d++)
+		{
+			const size_t size = sizes(random);
+			const size_t head = ring.getHead();
+			size_t offset = ring.allocate(size);
+			if (offset == RingAllocator::invalidOffset)
+			{
+				ring.reset();
+				live.clear();
+				frame.clear();
+				offset = ring.allocate(size);
+				discards++;
+			}
+			REQUIRE(offset != RingAllocator::invalidOffset);
+			CHECK(offset % 256 == 0);
+			CHECK(offset + size <= ring.getCapacity());
+			wraps += offset < head;
+			for (const Range& range : frame) { CHECK(offset + size <= range.begin || offset >= range.end); }
+			for (const Range& range : live) { CHECK(offset + size <= range.begin || offset >= range.end); }
+			frame.push_back(Range{ offset, offset + size, fence });
+		}
+		ring.endFrame(fence);
+		live.insert(live.end(), frame.begin(), frame.end());
+		frame.clear();
+		CHECK(ring.getUsed() <= ring.getCapacity());
+	}
+	// The sizes are picked so both paths are exercised.
+	CHECK(wraps > 100);
+	CHECK(discards > 0);
+	CHECK(discards < wraps);
+}
@@ -0,0 +1,133 @@
+﻿#include "Test.h"
+#include "SceneTree.h"
+#include "Frustum.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	bool isBoxInFrustum(const float planes[6][4], const SceneAabb& box)
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			const float* plane = planes[p];
+			// Corner furthest along the plane normal.
+			const float x = plane[0] >= 0.0f ? box.max[0] : box.min[0];
+			const float y = plane[1] >= 0.0f ? box.max[1] : box.min[1];
+			const float z = plane[2] >= 0.0f ? box.max[2] : box.min[2];
+			if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f) { return false; }
+		}
+		return true;
+	}
+
+	void makeBoxPlanes(float outPlanes[6][4], float extent)
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			for (int k = 0; k < 4; k++) { outPlanes[p][k] = 0.0f; }
+			outPlanes[p][p / 2] = (p & 1) ? -1.0f : 1.0f;
+			outPlanes[p][3] = extent;
+		}
+	}
+
+	struct Scene
+	{
+		SceneTree tree{ 0.5f };
+		std::vector<float> centers;
+		std::vector<int> proxies;
+		std::vector<unsigned char> alive;
+	};
+
+	SceneAabb makeBox(const float* center)
+	{
+		return SceneAabb{ { center[0] - 1.0f, center[1] - 1.0f, center[2] - 1.0f }, { center[0] + 1.0f, center[1] + 1.0f, center[2] + 1.0f } };
+	}
+
+	// Every live object whose fat box touches the frustum, and nothing else.
+	void checkQuery(const Scene& scene, const float planes[6][4])
+	{
+		std::vector<unsigned int> expected{};
+		for (size_t i = 0; i < scene.proxies.size(); i++)
+		{
+			if (scene.alive[i] && isBoxInFrustum(planes, scene.tree.getFatBox(scene.proxies[i]))) { expected.push_back(static_cast<unsigned int>(i)); }
+		}
+		std::vector<unsigned int> parallel{}, serial{};
+		CHECK_EQ(scene.tree.query(planes, parallel), expected.size());
+		CHECK_EQ(scene.tree.querySerial(planes, serial), expected.size());
+		std::sort(parallel.begin(), parallel.end());
+		std::sort(serial.begin(), serial.end());
+		CHECK(parallel == expected);
+		CHECK(serial == expected);
+	}
+}
+
+TEST(queryMatchesBruteForce)
+{
+	const size_t count = 50000;
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), step(-0.4f, 0.4f);
+	Scene scene{};
+	scene.centers.resize(count * 3);
+	for (float& c : scene.centers) { c = position(random); }
+	for (size_t i = 0; i < count; i++) { scene.proxies.push_back(scene.tree.insert(makeBox(&scene.centers[i * 3]), static_cast<unsigned int>(i))); }
+	scene.alive.assign(count, 1);
+	CHECK_EQ(scene.tree.getObjectCount(), count);
+	// A balanced tree stays within a small multiple of log2(count).
+	CHECK(scene.tree.getHeight() <= 40);
+
+	float planes[6][4];
+	makeBoxPlanes(planes, 30.0f);
+	checkQuery(scene, planes);
+
+	size_t reinserted = 0;
+	for (int frame = 0; frame < 4; frame++)
+	{
+		for (float& c : scene.centers) { c += step(random); }
+		for (size_t i = 0; i < count; i++)
+		{
+			const SceneAabb box = makeBox(&scene.centers[i * 3]);
+			reinserted += scene.tree.update(scene.proxies[i], box);
+			// The fat box always contains the object.
+			const SceneAabb& fat = scene.tree.getFatBox(scene.proxies[i]);
+			for (int k = 0; k < 3; k++) { CHECK(fat.min[k] <= box.min[k] && fat.max[k] >= box.max[k]); }
+		}
+		checkQuery(scene, planes);
+	}
+	// Small steps mostly stay inside the 0.5 margin.
+	CHECK(reinserted > 0);
+	CHECK(reinserted < count * 4 / 2);
+
+	for (size_t i = 0; i < count; i += 3)
+	{
+		scene.tree.remove(scene.proxies[i]);
+		scene.alive[i] = 0;
+	}
+	CHECK_EQ(scene.tree.getObjectCount(), count - (count + 2) / 3);
+	checkQuery(scene, planes);
+
+	// Freed nodes are reused and proxies keep their user data.
+	for (size_t i = 0; i < count; i += 3)
+	{
+		scene.proxies[i] = scene.tree.insert(makeBox(&scene.centers[i * 3]), static_cast<unsigned int>(i));
+		scene.alive[i] = 1;
+	}
+	for (size_t i = 0; i < count; i++) { CHECK_EQ(scene.tree.getUserData(scene.proxies[i]), i); }
+	checkQuery(scene, planes);
+	scene.tree.clear();
+	CHECK_EQ(scene.tree.getObjectCount(), 0);
+	CHECK_EQ(scene.tree.getHeight(), 0);
+	std::vector<unsigned int> visible{};
+	CHECK_EQ(scene.tree.query(planes, visible), 0);
+}
+
+TEST(boundingSphereToWorldBox)
+{
+	const float sphere[4] = { 1.0f, 2.0f, 3.0f, 0.5f };
+	// Scale 2, translate (10, 0, 0).
+	const float world[16] = { 2,0,0,0, 0,2,0,0, 0,0,2,0, 10,0,0,1 };
+	const SceneAabb box = transformBoundingSphere(sphere, world);
+	CHECK_NEAR(box.min[0], 11.0, 1e-5);
+	CHECK_NEAR(box.max[0], 13.0, 1e-5);
+	CHECK_NEAR(box.min[1], 3.0, 1e-5);
+	CHECK_NEAR(box.max[2], 7.0, 1e-5);
+}
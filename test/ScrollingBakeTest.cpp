@@ -0,0 +1,123 @@
+﻿#include "Test.h"
+#include "ScrollingBake.h"
+#include <stdlib.h>
+#include <random>
+#include <vector>
+
+TEST(floorDivideRoundsDown)
+{
+	CHECK_EQ(floorDivide(7, 4), 1);
+	CHECK_EQ(floorDivide(8, 4), 2);
+	CHECK_EQ(floorDivide(0, 4), 0);
+	CHECK_EQ(floorDivide(-1, 4), -1);
+	CHECK_EQ(floorDivide(-4, 4), -1);
+	CHECK_EQ(floorDivide(-5, 4), -2);
+}
+
+TEST(firstScrollRendersTheWholeLayer)
+{
+	ScrollingBake bake;
+	bake.reset(8);
+	ScrollColumns runs[ScrollingBake::maxRuns];
+	// Column 5 of wrap 0 to column 4 of wrap 1: cut where it wraps.
+	REQUIRE(bake.scroll(5, runs) == 2);
+	CHECK_EQ(runs[0].x, 5);
+	CHECK_EQ(runs[0].width, 3);
+	CHECK_EQ(runs[0].wrap, 0);
+	CHECK_EQ(runs[1].x, 0);
+	CHECK_EQ(runs[1].width, 5);
+	CHECK_EQ(runs[1].wrap, 1);
+	CHECK_EQ(bake.getWrapOffset(), 5);
+	CHECK(bake.getTexcoordOffset() == 5.0f / 8.0f);
+
+	// Aligned to the width it is a single run.
+	bake.invalidate();
+	REQUIRE(bake.scroll(16, runs) == 1);
+	CHECK_EQ(runs[0].x, 0);
+	CHECK_EQ(runs[0].width, 8);
+	CHECK_EQ(runs[0].wrap, 2);
+	CHECK_EQ(bake.getWrapOffset(), 0);
+}
+
+TEST(scrollingRendersOnlyExposedColumns)
+{
+	ScrollingBake bake;
+	bake.reset(8);
+	ScrollColumns runs[ScrollingBake::maxRuns];
+	bake.scroll(0, runs);
+	// Forward by 3: absolute columns 8-10 enter on the right, into physical 0-2 of wrap 1.
+	REQUIRE(bake.scroll(3, runs) == 1);
+	CHECK_EQ(runs[0].x, 0);
+	CHECK_EQ(runs[0].width, 3);
+	CHECK_EQ(runs[0].wrap, 1);
+	// Staying put renders nothing.
+	CHECK_EQ(bake.scroll(3, runs), 0);
+	// Back by 5: absolute columns -2 to 2 enter on the left, across the wrap.
+	REQUIRE(bake.scroll(-2, runs) == 2);
+	CHECK_EQ(runs[0].x, 6);
+	CHECK_EQ(runs[0].width, 2);
+	CHECK_EQ(runs[0].wrap, -1);
+	CHECK_EQ(runs[1].x, 0);
+	CHECK_EQ(runs[1].width, 3);
+	CHECK_EQ(runs[1].wrap, 0);
+	CHECK_EQ(bake.getWrapOffset(), 6);
+	// A jump of a full width or more redraws everything.
+	CHECK_EQ(bake.scroll(16, runs), 1);
+	CHECK_EQ(runs[0].width, 8);
+	CHECK_EQ(bake.scroll(-100, runs), 2);
+	CHECK_EQ(runs[0].width + runs[1].width, 8);
+}
+
+TEST(emptyLayerRendersNothing)
+{
+	ScrollingBake bake;
+	ScrollColumns runs[ScrollingBake::maxRuns];
+	CHECK_EQ(bake.scroll(10, runs), 0);
+	CHECK_EQ(bake.getWrapOffset(), 0);
+	CHECK(bake.getTexcoordOffset() == 0.0f);
+}
+
+TEST(randomScrollsKeepTheLayerConsistent)
+{
+	// Track which absolute column each physical column holds; after every scroll
+	// the layer read from getWrapOffset must show [column, column + width).
+	std::mt19937 random(5);
+	for (uint32_t width : { 1u, 7u, 64u, 1920u })
+	{
+		ScrollingBake bake;
+		bake.reset(width);
+		CHECK_EQ(bake.getWidth(), width);
+		std::vector<int64_t> physical(width, INT64_MIN);
+		int64_t column = random() % 3 == 0 ? -static_cast<int64_t>(random() % 5000) : static_cast<int64_t>(random() % 5000);
+		int mismatches = 0;
+		for (int step = 0; step < 5000; step++)
+		{
+			const int kind = random() % 10;
+			const int64_t delta = kind < 6 ? static_cast<int64_t>(random() % 4)
+				: kind < 8 ? -static_cast<int64_t>(random() % 4)
+				: static_cast<int64_t>(random() % (3 * width + 2)) - static_cast<int64_t>(width * 3 / 2);
+			if (step % 1000 == 0) { bake.invalidate(); }
+			const int64_t previous = bake.getFirstColumn();
+			column += delta;
+			ScrollColumns runs[ScrollingBake::maxRuns];
+			const uint32_t count = bake.scroll(column, runs);
+			CHECK(count <= ScrollingBake::maxRuns);
+			CHECK_EQ(bake.getFirstColumn(), column);
+			uint32_t rendered = 0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				CHECK(runs[i].width > 0 && runs[i].x + runs[i].width <= width);
+				rendered += runs[i].width;
+				for (uint32_t x = runs[i].x; x < runs[i].x + runs[i].width; x++) { physical[x] = runs[i].wrap * width + x; }
+			}
+			// Small scrolls render exactly the distance moved.
+			const int64_t distance = llabs(column - previous);
+			if (step % 1000 != 0 && distance < width) { CHECK_EQ(rendered, distance); }
+			const uint32_t offset = bake.getWrapOffset();
+			for (uint32_t j = 0; j < width; j++) { mismatches += physical[(offset + j) % width] != column + j; }
+			const float texcoord = bake.getTexcoordOffset();
+			CHECK(texcoord >= 0.0f && texcoord < 1.0f);
+		}
+		CHECK_EQ(mismatches, 0);
+	}
+}
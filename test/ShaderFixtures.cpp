@@ -0,0 +1,193 @@
+﻿#include "ShaderFixtures.h"
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+
+namespace
+{
+	//D3D_SHADER_INPUT_TYPE
+	enum : uint32_t { cbuffer = 0, texture = 2, sampler = 3, structured = 5 };
+
+	struct Binding
+	{
+		const char* name;
+		uint32_t type;
+		uint32_t bindPoint;
+		uint32_t size;					// cbuffers only
+	};
+
+	struct Element
+	{
+		const char* name;
+		uint32_t systemValue;
+		uint32_t componentType;
+		uint8_t mask;
+		uint8_t readMask;
+	};
+
+	struct Fixture
+	{
+		const char* name;
+		uint32_t programType;			// RDEF version >> 16
+		std::vector<Binding> bindings;	// fxc order: samplers, resources, cbuffers
+		std::vector<Element> inputs;	// register = position in the list
+	};
+
+	//cbufferのサイズは Painter.h / example.h の構造体と同じ
+	constexpr uint32_t frameSize = 96, toonPassSize = 32, destructionPassSize = 176, materialSize = 1024, objectSize = 80;
+	constexpr uint32_t vertex = 0xFFFE, pixel = 0xFFFF, hull = 0x4853, domain = 0x4453, geometry = 0x4753;
+	const Binding frame = { "FrameConstants", cbuffer, 0, frameSize };
+	const Binding toonPass = { "ToonPass", cbuffer, 1, toonPassSize };
+	const Binding destructionPass = { "DestructionPass", cbuffer, 1, destructionPassSize };
+	const Binding material = { "MaterialConstants", cbuffer, 2, materialSize };
+	const Binding object = { "ObjectConstants", cbuffer, 3, objectSize };
+
+	const Fixture fixtures[] = {
+		{ "Toon_vs", vertex, { frame, object }, { { "POSITION", 0, 3, 0x7, 0x7 }, { "NORMAL", 0, 3, 0x7, 0x7 } } },
+		{ "Toon_ps", pixel, { frame, toonPass, material, object }, {} },
+		// float4 inputs, only xyz of the normal is read
+		{ "Destruction_vs", vertex, { frame, object }, { { "POSITION", 0, 3, 0xF, 0xF }, { "NORMAL", 0, 3, 0xF, 0x7 } } },
+		{ "Destruction_hs", hull, { frame, destructionPass, object }, {} },
+		// only interpolates, so every block is stripped
+		{ "Destruction_ds", domain, {}, {} },
+		{ "Destruction_gs", geometry, { frame, destructionPass, object }, {} },
+		{ "Destruction_ps", pixel, { material, object }, {} },
+		{ "Sprite_vs", vertex, { { "SpriteData", cbuffer, 1, 16 } }, { { "POSITION", 0, 3, 0x3, 0x3 }, { "TEXCOORD", 0, 3, 0x3, 0x3 }, { "COLOR", 0, 3, 0xF, 0xF } } },
+		{ "Sprite_ps", pixel, { { "linearSamplerState", sampler, 0, 0 }, { "colorMap", texture, 0, 0 } }, {} },
+		// SV_VertexID (D3D_NAME 6) as uint
+		{ "WavePaint_vs", vertex, {}, { { "SV_VERTEXID", 6, 1, 0x1, 0x1 } } },
+		{ "WavePaint_ps", pixel, { { "amplitudes", structured, 0, 0 }, { "envelopes", structured, 1, 0 }, { "WaveData", cbuffer, 1, 176 } }, {} },
+	};
+
+	void appendU32(std::vector<char>& out, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++) { out.push_back(static_cast<char>(value >> (i * 8))); }
+	}
+
+	void setU32(std::vector<char>& out, size_t offset, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++) { out[offset + i] = static_cast<char>(value >> (i * 8)); }
+	}
+
+	uint32_t appendName(std::vector<char>& chunk, const char* name)
+	{
+		const uint32_t offset = static_cast<uint32_t>(chunk.size());
+		chunk.insert(chunk.end(), name, name + strlen(name) + 1);
+		return offset;
+	}
+
+	//ヘッダー, RD11, cbuffer (24バイト), バインド (32バイト), 名前
+	std::vector<char> makeResourceDefinition(const Fixture& fixture)
+	{
+		uint32_t cbufferCount = 0;
+		for (const Binding& binding : fixture.bindings) { cbufferCount += binding.type == cbuffer; }
+		const uint32_t bindingCount = static_cast<uint32_t>(fixture.bindings.size());
+		const uint32_t cbufferOffset = 60;
+		const uint32_t bindingOffset = cbufferOffset + cbufferCount * 24;
+		std::vector<char> chunk;
+		appendU32(chunk, cbufferCount);
+		appendU32(chunk, cbufferOffset);
+		appendU32(chunk, bindingCount);
+		appendU32(chunk, bindingOffset);
+		appendU32(chunk, (fixture.programType << 16) | 0x0500);
+		appendU32(chunk, 0);
+		appendU32(chunk, 0);			// creator, patched below
+		chunk.insert(chunk.end(), { 'R', 'D', '1', '1' });
+		for (uint32_t value : { 60u, 24u, 32u, 40u, 36u, 12u, 0u }) { appendU32(chunk, value); }
+		chunk.resize(bindingOffset + bindingCount * 32, 0);
+
+		size_t cbufferEntry = cbufferOffset;
+		for (uint32_t i = 0; i < bindingCount; i++)
+		{
+			//戻り値の型, 次元, サンプル数, フラグは読まないので0のまま
+			const Binding& binding = fixture.bindings[i];
+			const size_t entry = bindingOffset + size_t(i) * 32;
+			const uint32_t name = appendName(chunk, binding.name);
+			setU32(chunk, entry, name);
+			setU32(chunk, entry + 4, binding.type);
+			setU32(chunk, entry + 20, binding.bindPoint);
+			setU32(chunk, entry + 24, 1);
+			if (binding.type == cbuffer)
+			{
+				setU32(chunk, cbufferEntry, name);
+				setU32(chunk, cbufferEntry + 12, binding.size);
+				cbufferEntry += 24;
+			}
+		}
+		setU32(chunk, 24, appendName(chunk, "hand-written fixture"));
+		return chunk;
+	}
+
+	//要素数, 8, 要素 (24バイト), 名前
+	std::vector<char> makeInputSignature(const Fixture& fixture)
+	{
+		const uint32_t elementCount = static_cast<uint32_t>(fixture.inputs.size());
+		std::vector<char> chunk;
+		appendU32(chunk, elementCount);
+		appendU32(chunk, 8);
+		chunk.resize(8 + elementCount * 24, 0);
+		for (uint32_t i = 0; i < elementCount; i++)
+		{
+			const Element& element = fixture.inputs[i];
+			const size_t entry = 8 + size_t(i) * 24;
+			setU32(chunk, entry, appendName(chunk, element.name));
+			setU32(chunk, entry + 8, element.systemValue);
+			setU32(chunk, entry + 12, element.componentType);
+			setU32(chunk, entry + 16, i);
+			chunk[entry + 20] = static_cast<char>(element.mask);
+			chunk[entry + 21] = static_cast<char>(element.readMask);
+		}
+		return chunk;
+	}
+
+	//SHEX: プログラムの種類とバージョン, DWORD数, ret
+	std::vector<char> makeProgram(const Fixture& fixture)
+	{
+		uint32_t programIndex = 0;
+		switch (fixture.programType)
+		{
+		case vertex: programIndex = 1; break;
+		case geometry: programIndex = 2; break;
+		case hull: programIndex = 3; break;
+		case domain: programIndex = 4; break;
+		}
+		std::vector<char> chunk;
+		appendU32(chunk, (programIndex << 16) | 0x50);
+		appendU32(chunk, 3);
+		appendU32(chunk, 0x0100003E);
+		return chunk;
+	}
+}
+
+std::vector<char> test::getShaderFixture(const char* name)
+{
+	for (const Fixture& fixture : fixtures)
+	{
+		if (strcmp(fixture.name, name) != 0) { continue; }
+		std::vector<std::pair<const char*, std::vector<char>>> chunks;
+		chunks.emplace_back("RDEF", makeResourceDefinition(fixture));
+		if (!fixture.inputs.empty()) { chunks.emplace_back("ISGN", makeInputSignature(fixture)); }
+		chunks.emplace_back("SHEX", makeProgram(fixture));
+
+		//コンテナ: "DXBC", チェックサム (検証しないので0), 1, 全体サイズ, チャンク数, チャンクのオフセット
+		std::vector<char> out{ 'D', 'X', 'B', 'C' };
+		out.resize(20, 0);
+		appendU32(out, 1);
+		appendU32(out, 0);
+		appendU32(out, static_cast<uint32_t>(chunks.size()));
+		const size_t offsetTable = out.size();
+		out.resize(offsetTable + chunks.size() * 4, 0);
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			//チャンクは4バイト境界に置く
+			chunks[i].second.resize((chunks[i].second.size() + 3) & ~size_t(3), 0);
+			setU32(out, offsetTable + i * 4, static_cast<uint32_t>(out.size()));
+			out.insert(out.end(), chunks[i].first, chunks[i].first + 4);
+			appendU32(out, static_cast<uint32_t>(chunks[i].second.size()));
+			out.insert(out.end(), chunks[i].second.begin(), chunks[i].second.end());
+		}
+		setU32(out, 24, static_cast<uint32_t>(out.size()));
+		return out;
+	}
+	return {};
+}
@@ -0,0 +1,16 @@
+﻿#pragma once
+#include <vector>
+
+namespace test
+{
+	/****************************************************************
+		Hand-written DXBC containers for the shaders in example/shader
+		and Painter/shader, one per name ("Toon_vs", "Sprite_ps", ...).
+		Each holds the RDEF bindings the current source declares and
+		reads, the ISGN of the vertex shaders and a SHEX chunk with
+		just the version and ret, so the reflection tests follow the
+		constant blocks split by update frequency without fxc.
+		Empty for an unknown name.
+	****************************************************************/
+	std::vector<char> getShaderFixture(const char* name);
+}
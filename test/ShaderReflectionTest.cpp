@@ -0,0 +1,236 @@
+﻿#include "Test.h"
+#include "ShaderFixtures.h"
+#include "ShaderReflection.h"
+#include <initializer_list>
+#include <vector>
+
+namespace
+{
+	bool reflect(const char* name, ShaderReflection& outReflection)
+	{
+		const std::vector<char> bytecode = test::getShaderFixture(name);
+		return !bytecode.empty() && reflectShader(bytecode.data(), bytecode.size(), &outReflection) == ShaderReflectResult::ok;
+	}
+}
+
+TEST(stagesFollowTheProgramType)
+{
+	const struct { const char* name; ShaderStage stage; } shaders[] = {
+		{ "Destruction_vs", ShaderStage::vertex },
+		{ "Destruction_hs", ShaderStage::hull },
+		{ "Destruction_ds", ShaderStage::domain },
+		{ "Destruction_gs", ShaderStage::geometry },
+		{ "Destruction_ps", ShaderStage::pixel },
+		{ "Sprite_vs", ShaderStage::vertex },
+		{ "Sprite_ps", ShaderStage::pixel },
+		{ "Toon_vs", ShaderStage::vertex },
+		{ "Toon_ps", ShaderStage::pixel },
+		{ "WavePaint_vs", ShaderStage::vertex },
+		{ "WavePaint_ps", ShaderStage::pixel },
+	};
+	for (const auto& shader : shaders)
+	{
+		ShaderReflection reflection;
+		REQUIRE(reflect(shader.name, reflection));
+		CHECK(reflection.slots.stage == shader.stage);
+	}
+}
+
+TEST(constantBuffersKeepNameSlotAndSize)
+{
+	// Frame (b0) and object (b3) blocks; the vertex shader reads neither the pass nor the materials.
+	ShaderReflection toon;
+	REQUIRE(reflect("Toon_vs", toon));
+	REQUIRE(toon.bindings.size() == 2);
+	CHECK(toon.bindings[0].name == "FrameConstants");
+	CHECK(toon.bindings[0].type == ShaderInputType::constantBuffer);
+	CHECK_EQ(toon.bindings[0].bindPoint, 0);
+	CHECK_EQ(toon.bindings[0].bindCount, 1);
+	CHECK_EQ(toon.bindings[0].size, 96);
+	CHECK(toon.bindings[1].name == "ObjectConstants");
+	CHECK_EQ(toon.bindings[1].bindPoint, 3);
+	CHECK_EQ(toon.bindings[1].size, 80);
+	CHECK_EQ(toon.slots.constantBuffers, 0x9);
+	CHECK_EQ(toon.slots.shaderResources, 0);
+	CHECK(toon.findConstantBuffer(0) == &toon.bindings[0]);
+	CHECK(toon.findConstantBuffer(3) == &toon.bindings[1]);
+	CHECK(toon.findConstantBuffer(1) == nullptr);
+	CHECK(toon.findConstantBuffer(2) == nullptr);
+
+	// The pixel shader reads all four.
+	ShaderReflection toonPixel;
+	REQUIRE(reflect("Toon_ps", toonPixel));
+	CHECK_EQ(toonPixel.slots.constantBuffers, 0xF);
+	REQUIRE(toonPixel.findConstantBuffer(1) != nullptr && toonPixel.findConstantBuffer(2) != nullptr);
+	CHECK(toonPixel.findConstantBuffer(1)->name == "ToonPass");
+	CHECK_EQ(toonPixel.findConstantBuffer(1)->size, 32);
+	CHECK(toonPixel.findConstantBuffer(2)->name == "MaterialConstants");
+	CHECK_EQ(toonPixel.findConstantBuffer(2)->size, 1024);
+
+	ShaderReflection destruction;
+	REQUIRE(reflect("Destruction_gs", destruction));
+	REQUIRE(destruction.findConstantBuffer(1) != nullptr);
+	CHECK(destruction.findConstantBuffer(1)->name == "DestructionPass");
+	CHECK_EQ(destruction.findConstantBuffer(1)->size, 176);
+	CHECK(destruction.findConstantBuffer(2) == nullptr);
+}
+
+TEST(unreferencedResourcesAreStripped)
+{
+	// The domain shader only interpolates, so the compiler dropped every block.
+	ShaderReflection domain;
+	REQUIRE(reflect("Destruction_ds", domain));
+	CHECK(domain.bindings.empty());
+	CHECK_EQ(domain.slots.constantBuffers, 0);
+
+	// The pixel shader only takes the material color.
+	ShaderReflection pixel;
+	REQUIRE(reflect("Destruction_ps", pixel));
+	CHECK_EQ(pixel.slots.constantBuffers, 0xC);
+
+	ShaderReflection sprite;
+	REQUIRE(reflect("Sprite_vs", sprite));
+	REQUIRE(sprite.bindings.size() == 1);
+	CHECK(sprite.bindings[0].name == "SpriteData");
+	CHECK_EQ(sprite.slots.constantBuffers, 0x2);
+}
+
+TEST(texturesSamplersAndStructuredBuffers)
+{
+	ShaderReflection sprite;
+	REQUIRE(reflect("Sprite_ps", sprite));
+	CHECK_EQ(sprite.slots.constantBuffers, 0);
+	CHECK_EQ(sprite.slots.shaderResources, 1);
+	CHECK_EQ(sprite.slots.samplers, 1);
+	bool texture = false, sampler = false;
+	for (const ShaderBinding& binding : sprite.bindings)
+	{
+		texture |= binding.name == "colorMap" && binding.type == ShaderInputType::texture && binding.bindPoint == 0;
+		sampler |= binding.name == "linearSamplerState" && binding.type == ShaderInputType::sampler && binding.bindPoint == 0;
+		CHECK_EQ(binding.size, 0);
+	}
+	CHECK(texture && sampler);
+
+	// Waveform samples and the envelope pyramid; WaveData is a pass block at b1.
+	ShaderReflection wave;
+	REQUIRE(reflect("WavePaint_ps", wave));
+	CHECK_EQ(wave.slots.constantBuffers, 0x2);
+	CHECK_EQ(wave.slots.shaderResources, 0x3);
+	bool amplitudes = false, envelopes = false;
+	for (const ShaderBinding& binding : wave.bindings)
+	{
+		amplitudes |= binding.name == "amplitudes" && binding.type == ShaderInputType::structured && binding.bindPoint == 0;
+		envelopes |= binding.name == "envelopes" && binding.type == ShaderInputType::structured && binding.bindPoint == 1;
+	}
+	CHECK(amplitudes && envelopes);
+	CHECK(wave.findConstantBuffer(0) == nullptr);
+	REQUIRE(wave.findConstantBuffer(1) != nullptr);
+	CHECK(wave.findConstantBuffer(1)->name == "WaveData");
+	CHECK_EQ(wave.findConstantBuffer(1)->size, 176);
+}
+
+TEST(inputSignatureOfVertexShaders)
+{
+	std::vector<char> bytecode = test::getShaderFixture("Toon_vs");
+	REQUIRE(!bytecode.empty());
+	std::vector<InputSignatureElement> elements;
+	REQUIRE(reflectInputSignature(bytecode.data(), bytecode.size(), &elements) == ShaderReflectResult::ok);
+	REQUIRE(elements.size() == 2);
+	CHECK(elements[0].semanticName == "POSITION");
+	CHECK(elements[1].semanticName == "NORMAL");
+	for (const InputSignatureElement& element : elements)
+	{
+		CHECK_EQ(element.semanticIndex, 0);
+		CHECK_EQ(element.systemValue, 0);
+		CHECK_EQ(element.componentType, 3);
+		CHECK_EQ(element.mask, 0x7);
+		CHECK_EQ(element.readMask, 0x7);
+	}
+	CHECK_EQ(elements[1].registerIndex, 1);
+
+	// Destruction declares float4 and reads only xyz of the normal.
+	bytecode = test::getShaderFixture("Destruction_vs");
+	REQUIRE(reflectInputSignature(bytecode.data(), bytecode.size(), &elements) == ShaderReflectResult::ok);
+	REQUIRE(elements.size() == 2);
+	CHECK_EQ(elements[1].mask, 0xF);
+	CHECK_EQ(elements[1].readMask, 0x7);
+
+	// Only a system value, nothing for the input layout to feed.
+	bytecode = test::getShaderFixture("WavePaint_vs");
+	REQUIRE(reflectInputSignature(bytecode.data(), bytecode.size(), &elements) == ShaderReflectResult::ok);
+	REQUIRE(elements.size() == 1);
+	CHECK(elements[0].semanticName == "SV_VertexID" || elements[0].semanticName == "SV_VERTEXID");
+	CHECK_EQ(elements[0].systemValue, 6);
+	CHECK_EQ(elements[0].componentType, 1);
+}
+
+TEST(threadGroupSizeNeedsComputeShader)
+{
+	// The program has no dcl_thread_group.
+	const std::vector<char> bytecode = test::getShaderFixture("Toon_ps");
+	REQUIRE(!bytecode.empty());
+	uint32_t size[3] = {};
+	CHECK(reflectThreadGroupSize(bytecode.data(), bytecode.size(), size) == ShaderReflectResult::missingResourceDefinition);
+}
+
+TEST(stageBindingTableMergesStages)
+{
+	ShaderReflection vertex, pixel;
+	REQUIRE(reflect("WavePaint_vs", vertex));
+	REQUIRE(reflect("WavePaint_ps", pixel));
+	StageBindingTable table;
+	table.setStage(vertex.slots);
+	table.setStage(pixel.slots);
+	const unsigned int pixelMask = 1u << static_cast<int>(ShaderStage::pixel);
+	CHECK_EQ(table.getConstantBufferStages(0), 0);
+	CHECK_EQ(table.getConstantBufferStages(1), pixelMask);
+	CHECK_EQ(table.getShaderResourceStages(0), pixelMask);
+	CHECK_EQ(table.getShaderResourceStages(1), pixelMask);
+	CHECK_EQ(table.getSamplerStages(0), 0);
+	CHECK(StageBindingTable::hasStage(table.getConstantBufferStages(1), ShaderStage::pixel));
+	CHECK(!StageBindingTable::hasStage(table.getConstantBufferStages(1), ShaderStage::vertex));
+
+	// Each Destruction block goes only to the stages that read it.
+	table.clear();
+	for (const char* name : { "Destruction_vs", "Destruction_hs", "Destruction_ds", "Destruction_gs", "Destruction_ps" })
+	{
+		ShaderReflection reflection;
+		REQUIRE(reflect(name, reflection));
+		table.setStage(reflection.slots);
+	}
+	const auto mask = [](std::initializer_list<ShaderStage> stages)
+	{
+		unsigned int result = 0;
+		for (ShaderStage stage : stages) { result |= 1u << static_cast<int>(stage); }
+		return result;
+	};
+	CHECK_EQ(table.getConstantBufferStages(0), mask({ ShaderStage::vertex, ShaderStage::hull, ShaderStage::geometry }));
+	CHECK_EQ(table.getConstantBufferStages(1), mask({ ShaderStage::hull, ShaderStage::geometry }));
+	CHECK_EQ(table.getConstantBufferStages(2), mask({ ShaderStage::pixel }));
+	CHECK_EQ(table.getConstantBufferStages(3), mask({ ShaderStage::vertex, ShaderStage::hull, ShaderStage::geometry, ShaderStage::pixel }));
+	CHECK_EQ(table.getConstantBufferStages(4), 0);
+}
+
+TEST(damagedBytecodeIsRejected)
+{
+	const std::vector<char> bytecode = test::getShaderFixture("Sprite_ps");
+	REQUIRE(!bytecode.empty());
+	ShaderReflection reflection;
+	CHECK(reflectShader(bytecode.data(), 0, &reflection) != ShaderReflectResult::ok);
+	std::vector<char> renamed = bytecode;
+	renamed[0] = 'X';
+	CHECK(reflectShader(renamed.data(), renamed.size(), &reflection) == ShaderReflectResult::invalidContainer);
+
+	// Every truncation either fails or still reports the full bindings; none may read past the end.
+	for (size_t size = 0; size < bytecode.size(); size++)
+	{
+		std::vector<char> truncated(bytecode.begin(), bytecode.begin() + size);
+		ShaderReflection partial;
+		if (reflectShader(truncated.data(), truncated.size(), &partial) == ShaderReflectResult::ok)
+		{
+			CHECK_EQ(partial.bindings.size(), 2);
+		}
+		std::vector<InputSignatureElement> elements;
+		reflectInputSignature(truncated.data(), truncated.size(), &elements);
+	}
+}
@@ -0,0 +1,232 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "SoftwareShaders.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	struct PassVs
+	{
+		void operator()(const SoftwareVertex& vin, SoftwareVertex& vout)const { vout = vin; }
+	};
+
+	struct ColorPs
+	{
+		static constexpr size_t varyingCount = 4;
+		void operator()(const float* pin, float outColor[4])const
+		{
+			for (int i = 0; i < 4; i++) { outColor[i] = pin[i]; }
+		}
+	};
+
+	SoftwareVertex makeVertex(float x, float y, float z, float r, float g, float b, float a)
+	{
+		SoftwareVertex v{};
+		v.position[0] = x;
+		v.position[1] = y;
+		v.position[2] = z;
+		v.position[3] = 1.0f;
+		v.varyings[0] = r;
+		v.varyings[1] = g;
+		v.varyings[2] = b;
+		v.varyings[3] = a;
+		return v;
+	}
+
+	const float* getPixel(const SoftwareRenderTarget& target, unsigned int x, unsigned int y)
+	{
+		return target.getColor() + (static_cast<size_t>(y) * target.getWidth() + x) * 4;
+	}
+
+	// Binary PPM as written by SoftwareRenderTarget::savePpm.
+	bool loadPpm(const char* path, unsigned int& outWidth, unsigned int& outHeight, std::vector<uint8_t>& outRgb)
+	{
+		std::ifstream ifs{ path, std::ios::in | std::ios::binary };
+		std::string magic;
+		unsigned int maximum = 0;
+		if (!(ifs >> magic >> outWidth >> outHeight >> maximum) || magic != "P6" || maximum != 255) { return false; }
+		ifs.get();
+		outRgb.resize(static_cast<size_t>(outWidth) * outHeight * 3);
+		ifs.read(reinterpret_cast<char*>(outRgb.data()), static_cast<std::streamsize>(outRgb.size()));
+		return static_cast<bool>(ifs);
+	}
+
+	/****************************************************************
+		Compare against test/data/<name>.ppm. Small differences are
+		allowed for float contraction on other compilers; on failure
+		<name>.actual.ppm is written to the working directory.
+		UPDATE_REFERENCE_IMAGES=1 rewrites the reference instead.
+	****************************************************************/
+	void checkReferenceImage(const SoftwareRenderTarget& target, const char* name)
+	{
+		const std::string relative = std::string("test/data/") + name + ".ppm";
+		const std::string path = test::getRepoPath(relative.c_str());
+		if (getenv("UPDATE_REFERENCE_IMAGES"))
+		{
+			CHECK(target.savePpm(path.c_str()));
+			return;
+		}
+		unsigned int width = 0, height = 0;
+		std::vector<uint8_t> reference;
+		REQUIRE(loadPpm(path.c_str(), width, height, reference));
+		REQUIRE(width == target.getWidth() && height == target.getHeight());
+		std::vector<uint8_t> actual;
+		target.getRgba8(actual);
+		size_t differing = 0;
+		int largest = 0;
+		for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+		{
+			int difference = 0;
+			for (int c = 0; c < 3; c++) { difference = std::max(difference, abs(actual[i * 4 + c] - reference[i * 3 + c])); }
+			differing += difference > 2;
+			largest = std::max(largest, difference);
+		}
+		// Toon bands and silhouettes flip on a few edge pixels at most.
+		const bool matches = differing * 1000 <= static_cast<size_t>(width) * height;
+		CHECK(matches);
+		if (!matches)
+		{
+			printf("%s: %zu pixels differ (largest %d)\n", name, differing, largest);
+			target.savePpm((std::string(name) + ".actual.ppm").c_str());
+		}
+	}
+
+	void multiply(float out[16], const float a[16], const float b[16])
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < 4; k++) { sum += a[r * 4 + k] * b[k * 4 + c]; }
+				out[r * 4 + c] = sum;
+			}
+		}
+	}
+}
+
+TEST(sharedEdgesAreCoveredOnce)
+{
+	SoftwareRenderTarget target(200, 150);
+	SoftwareRasterizer rasterizer;
+	rasterizer.setTarget(&target);
+	const SoftwareVertex quad[4] =
+	{
+		makeVertex(-0.73f, -0.61f, 0, 1, 0, 0, 1), makeVertex(-0.73f, 0.61f, 0, 1, 0, 0, 1),
+		makeVertex(0.73f, 0.61f, 0, 1, 0, 0, 1), makeVertex(0.73f, -0.61f, 0, 1, 0, 0, 1),
+	};
+	const unsigned int indices[6] = { 0, 1, 2, 0, 2, 3 };
+	const SoftwareVertex strip[4] = { quad[1], quad[2], quad[0], quad[3] };
+	for (SoftwareTopology topology : { SoftwareTopology::triangleList, SoftwareTopology::triangleStrip })
+	{
+		target.clear();
+		SoftwareDrawState state{};
+		state.topology = topology;
+		state.blend = SoftwareBlend::add;
+		if (topology == SoftwareTopology::triangleList) { rasterizer.draw(state, quad, 4, indices, 6, PassVs(), ColorPs()); }
+		else { rasterizer.draw(state, strip, 4, nullptr, 0, PassVs(), ColorPs()); }
+		rasterizer.flush();
+		// Additive blending shows every pixel shaded twice along the diagonal.
+		size_t twice = 0, covered = 0;
+		for (unsigned int y = 0; y < 150; y++)
+		{
+			for (unsigned int x = 0; x < 200; x++)
+			{
+				const float red = getPixel(target, x, y)[0];
+				twice += red > 1.5f;
+				covered += red > 0.5f;
+			}
+		}
+		CHECK_EQ(twice, 0);
+		// Pixel centers inside x in [27, 173), y in [29.25, 120.75): 146 x 92.
+		CHECK_EQ(covered, 146 * 92);
+	}
+}
+
+TEST(depthAndBlendStates)
+{
+	SoftwareRenderTarget target(64, 64);
+	SoftwareRasterizer rasterizer;
+	rasterizer.setTarget(&target);
+	const SoftwareVertex nearTriangle[3] = { makeVertex(-1, -1, 0.3f, 1, 0, 0, 0.25f), makeVertex(0, 1, 0.3f, 1, 0, 0, 0.25f), makeVertex(1, -1, 0.3f, 1, 0, 0, 0.25f) };
+	const SoftwareVertex farTriangle[3] = { makeVertex(-1, -1, 0.6f, 0, 1, 0, 1), makeVertex(0, 1, 0.6f, 0, 1, 0, 1), makeVertex(1, -1, 0.6f, 0, 1, 0, 1) };
+
+	target.clear();
+	target.clearDepth();
+	SoftwareDrawState state{};
+	state.depth = SoftwareDepth::common;
+	rasterizer.draw(state, nearTriangle, 3, nullptr, 0, PassVs(), ColorPs());
+	rasterizer.draw(state, farTriangle, 3, nullptr, 0, PassVs(), ColorPs());
+	rasterizer.flush();
+	CHECK(getPixel(target, 32, 40)[0] == 1.0f);
+	CHECK(getPixel(target, 32, 40)[1] == 0.0f);
+	CHECK_NEAR(target.getDepth()[40 * 64 + 32], 0.3, 1e-6);
+	// Outside the triangle nothing is written.
+	CHECK(getPixel(target, 1, 1)[0] == 0.0f);
+	CHECK(target.getDepth()[64 + 1] == 1.0f);
+
+	// SrcAlpha / InvSrcAlpha over blue.
+	target.clear(0, 0, 1, 1);
+	state = SoftwareDrawState{};
+	state.blend = SoftwareBlend::alpha;
+	rasterizer.draw(state, nearTriangle, 3, nullptr, 0, PassVs(), ColorPs());
+	rasterizer.flush();
+	const float* blended = getPixel(target, 32, 40);
+	CHECK_NEAR(blended[0], 0.25, 1e-6);
+	CHECK_NEAR(blended[2], 0.75, 1e-6);
+}
+
+TEST(toonPainterMatchesReferenceImage)
+{
+	const unsigned int width = 256, height = 192;
+	SoftwareRenderTarget target(width, height);
+	SoftwareRasterizer rasterizer;
+	rasterizer.setTarget(&target);
+	target.clear(0.2f, 0.2f, 0.25f, 1.0f);
+	target.clearDepth();
+
+	// Camera at (0, 0, -2) looking down +z, 1 radian vertical fov.
+	const float nearZ = 0.1f, farZ = 10.0f;
+	const float yScale = 1.0f / tanf(0.5f), xScale = yScale * height / width;
+	const float view[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,2,1 };
+	const float projection[16] = { xScale,0,0,0, 0,yScale,0,0, 0,0,farZ / (farZ - nearZ),1, 0,0,-nearZ * farZ / (farZ - nearZ),0 };
+
+	const TestMesh sphere = makeSphereMesh(48, 32);
+	std::vector<SoftwareToonVertex> vertices(sphere.vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		memcpy(vertices[i].position, sphere.vertices[i].position, sizeof(vertices[i].position));
+		memcpy(vertices[i].normal, sphere.vertices[i].normal, sizeof(vertices[i].normal));
+	}
+
+	// Two overlapping spheres, as ToonPainter::draw issues them: one draw per object.
+	const float worlds[2][16] =
+	{
+		{ 1.6f,0,0,0, 0,1.6f,0,0, 0,0,1.6f,0, -0.3f,0,0,1 },
+		{ 0.8f,0,0,0, 0,0.8f,0,0, 0,0,0.8f,0, 0.6f,0.35f,-0.4f,1 },
+	};
+	const float colors[2][4] = { { 0.9f, 0.5f, 0.2f, 1.0f }, { 0.3f, 0.6f, 0.9f, 1.0f } };
+	SoftwareDrawState state{};
+	state.depth = SoftwareDepth::common;
+	for (int object = 0; object < 2; object++)
+	{
+		SoftwareToonData data{};
+		memcpy(data.world, worlds[object], sizeof(data.world));
+		multiply(data.viewProjection, view, projection);
+		memcpy(data.matColor, colors[object], sizeof(data.matColor));
+		const float lightDirection[3] = { 1.0f, -1.0f, 1.0f };
+		memcpy(data.lightDir, lightDirection, sizeof(data.lightDir));
+		data.toonLevels = 4;
+		data.eyePos[2] = -2.0f;
+		data.outlineThreshold = 0.3f;
+		ToonPs pixelShader{};
+		pixelShader.data = data;
+		rasterizer.draw(state, vertices.data(), vertices.size(), sphere.indices.data(), sphere.indices.size(), ToonVs(data), pixelShader);
+	}
+	rasterizer.flush();
+	CHECK_EQ(rasterizer.getStatistics().drawCount, 2);
+	checkReferenceImage(target, "ToonSpheres");
+}
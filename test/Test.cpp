@@ -0,0 +1,69 @@
+﻿#include "Test.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace detail
+{
+	struct TestCase
+	{
+		const char* name;
+		test::Function function;
+	};
+
+	inline std::vector<TestCase>& getCases()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+
+	int failures = 0;
+}
+
+test::Registrar::Registrar(const char* name, Function function)
+{
+	detail::getCases().push_back({ name, function });
+}
+
+void test::fail(const char* file, int line, const char* expression)
+{
+	detail::failures++;
+	printf("%s(%d): CHECK(%s) failed\n", file, line, expression);
+}
+
+void test::failEqual(const char* file, int line, const char* expression, long long actual, long long expected)
+{
+	detail::failures++;
+	printf("%s(%d): CHECK_EQ(%s) failed: %lld != %lld\n", file, line, expression, actual, expected);
+}
+
+void test::failNear(const char* file, int line, const char* expression, double actual, double expected)
+{
+	detail::failures++;
+	printf("%s(%d): CHECK_NEAR(%s) failed: %.9g != %.9g\n", file, line, expression, actual, expected);
+}
+
+const char* test::getRepoPath(const char* relative)
+{
+	//呼び出しごとに上書きされる
+	static std::string path;
+	path = std::string(REPO_DIR) + "/" + relative;
+	return path.c_str();
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	int run = 0;
+	for (const detail::TestCase& testCase : detail::getCases())
+	{
+		if (filter && !strstr(testCase.name, filter)) { continue; }
+		const int before = detail::failures;
+		testCase.function();
+		printf("[%s] %s\n", detail::failures == before ? "pass" : "FAIL", testCase.name);
+		run++;
+	}
+	printf("%d cases, %d failures\n", run, detail::failures);
+	return detail::failures == 0 ? 0 : 1;
+}
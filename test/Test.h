@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <math.h>
+#include <stdint.h>
+
+/****************************************************************
+	Minimal test harness for the portable modules.
+	TEST(name) registers a case. CHECK records a failure and lets
+	the case continue; REQUIRE also leaves the case. The executable
+	runs every case (or those whose name contains argv[1]) and exits
+	non-zero if anything failed.
+****************************************************************/
+namespace test
+{
+	using Function = void(*)();
+
+	struct Registrar
+	{
+		Registrar(const char* name, Function function);
+	};
+
+	void fail(const char* file, int line, const char* expression);
+	void failEqual(const char* file, int line, const char* expression, long long actual, long long expected);
+	void failNear(const char* file, int line, const char* expression, double actual, double expected);
+
+	// Absolute path of a file under the repository root.
+	const char* getRepoPath(const char* relative);
+}
+
+#define TEST(name) \
+	static void name(); \
+	static test::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	((expression) ? (void)0 : test::fail(__FILE__, __LINE__, #expression))
+
+#define REQUIRE(expression) \
+	do { if (!(expression)) { test::fail(__FILE__, __LINE__, #expression); return; } } while (0)
+
+#define CHECK_EQ(actual, expected) \
+	do { \
+		const long long actualValue = static_cast<long long>(actual); \
+		const long long expectedValue = static_cast<long long>(expected); \
+		if (actualValue != expectedValue) { test::failEqual(__FILE__, __LINE__, #actual " == " #expected, actualValue, expectedValue); } \
+	} while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	do { \
+		const double actualValue = static_cast<double>(actual); \
+		const double expectedValue = static_cast<double>(expected); \
+		if (!(fabs(actualValue - expectedValue) <= (tolerance))) { test::failNear(__FILE__, __LINE__, #actual " ~ " #expected, actualValue, expectedValue); } \
+	} while (0)
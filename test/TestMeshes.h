@@ -0,0 +1,218 @@
+﻿#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+/****************************************************************
+	Meshes shared by the tests and benchmarks.
+	TestVertex has the layout of Geometry::Vertex (position, normal,
+	texcoord), and makeSphereMesh emits the same vertices and
+	indices as makeSphere.
+****************************************************************/
+struct TestVertex
+{
+	float position[3];
+	float normal[3];
+	float texcoord[2];
+};
+
+struct TestMesh
+{
+	std::vector<TestVertex> vertices;
+	std::vector<unsigned int> indices;
+};
+
+inline TestMesh makeSphereMesh(unsigned int slices, unsigned int stacks, float radius = 0.5f)
+{
+	const float pi = 3.14159265358979f;
+	TestMesh mesh{};
+	mesh.vertices.resize(static_cast<size_t>(slices + 1) * (stacks + 1));
+	for (unsigned int y = 0; y <= stacks; y++)
+	{
+		const float h = radius * cosf(y * pi / stacks);
+		const float w = radius * sinf(y * pi / stacks);
+		for (unsigned int x = 0; x <= slices; x++)
+		{
+			TestVertex& v = mesh.vertices[static_cast<size_t>(y) * (slices + 1) + x];
+			const float angle = x * 2.0f * pi / slices;
+			v.position[0] = w * sinf(angle);
+			v.position[1] = h;
+			v.position[2] = w * cosf(angle);
+			for (int c = 0; c < 3; c++) { v.normal[c] = v.position[c] / radius; }
+			v.texcoord[0] = static_cast<float>(x) / slices;
+			v.texcoord[1] = static_cast<float>(y) / stacks;
+		}
+	}
+	for (unsigned int y = 0; y < stacks; y++)
+	{
+		for (unsigned int x = 0; x < slices; x++)
+		{
+			const unsigned int i = y * (slices + 1) + x;
+			const unsigned int quad[6] = { i + 1, i, i + slices + 1, i + 1, i + slices + 1, i + slices + 2 };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+// Flat grid on y = 0 spanning [-size/2, size/2], cells x cells quads.
+inline TestMesh makeGridMesh(unsigned int cells, float size = 1.0f)
+{
+	TestMesh mesh{};
+	mesh.vertices.resize(static_cast<size_t>(cells + 1) * (cells + 1));
+	for (unsigned int z = 0; z <= cells; z++)
+	{
+		for (unsigned int x = 0; x <= cells; x++)
+		{
+			TestVertex& v = mesh.vertices[static_cast<size_t>(z) * (cells + 1) + x];
+			v = TestVertex{ { (static_cast<float>(x) / cells - 0.5f) * size, 0.0f, (static_cast<float>(z) / cells - 0.5f) * size }, { 0, 1, 0 },
+				{ static_cast<float>(x) / cells, static_cast<float>(z) / cells } };
+		}
+	}
+	for (unsigned int z = 0; z < cells; z++)
+	{
+		for (unsigned int x = 0; x < cells; x++)
+		{
+			const unsigned int i = z * (cells + 1) + x;
+			const unsigned int quad[6] = { i, i + cells + 1, i + 1, i + 1, i + cells + 1, i + cells + 2 };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+// Unit cube as a triangle soup: 36 vertices, one per index.
+inline TestMesh makeSoupCube()
+{
+	static const float corners[8][3] =
+	{
+		{ -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+		{ -0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { -0.5f, 0.5f, 0.5f },
+	};
+	static const unsigned int faces[6][4] = { { 0, 3, 2, 1 }, { 4, 5, 6, 7 }, { 0, 1, 5, 4 }, { 3, 7, 6, 2 }, { 0, 4, 7, 3 }, { 1, 2, 6, 5 } };
+	static const float normals[6][3] = { { 0, 0, -1 }, { 0, 0, 1 }, { 0, -1, 0 }, { 0, 1, 0 }, { -1, 0, 0 }, { 1, 0, 0 } };
+	TestMesh mesh{};
+	for (int f = 0; f < 6; f++)
+	{
+		const unsigned int corner[6] = { 0, 1, 2, 0, 2, 3 };
+		for (unsigned int k : corner)
+		{
+			TestVertex v{};
+			memcpy(v.position, corners[faces[f][k]], sizeof(v.position));
+			memcpy(v.normal, normals[f], sizeof(v.normal));
+			mesh.indices.push_back(static_cast<unsigned int>(mesh.vertices.size()));
+			mesh.vertices.push_back(v);
+		}
+	}
+	return mesh;
+}
+
+// Box appended to mesh with CCW fronts (PipelineState, MeshLoader, occlusion and
+// meshlet culling). makeSphereMesh and makeSoupCube keep makeSphere's CW fronts.
+inline void appendBoxMesh(TestMesh& mesh, const float center[3], const float halfExtent[3])
+{
+	static const unsigned int faces[6][4] = { { 0, 1, 2, 3 }, { 4, 7, 6, 5 }, { 0, 4, 5, 1 }, { 3, 2, 6, 7 }, { 0, 3, 7, 4 }, { 1, 5, 6, 2 } };
+	const unsigned int base = static_cast<unsigned int>(mesh.vertices.size());
+	for (unsigned int corner = 0; corner < 8; corner++)
+	{
+		// Corners 0-3 go around the -z face, 4-7 around the +z face.
+		const float sx = (corner == 1 || corner == 2 || corner == 5 || corner == 6) ? 1.0f : -1.0f;
+		const float sy = (corner == 2 || corner == 3 || corner == 6 || corner == 7) ? 1.0f : -1.0f;
+		const float sz = corner >= 4 ? 1.0f : -1.0f;
+		mesh.vertices.push_back(TestVertex{ { center[0] + sx * halfExtent[0], center[1] + sy * halfExtent[1], center[2] + sz * halfExtent[2] }, { 0, 0, 0 }, { 0, 0 } });
+	}
+	for (const unsigned int* face : faces)
+	{
+		const unsigned int quad[6] = { face[0], face[1], face[2], face[0], face[2], face[3] };
+		for (unsigned int k : quad) { mesh.indices.push_back(base + k); }
+	}
+}
+
+// Triangles as sorted position triples, rotated to start at the smallest
+// corner so winding is kept. Two meshes draw the same surface when these match.
+inline std::vector<std::array<float, 9>> getCanonicalTriangles(const TestVertex* vertices, const unsigned int* indices, size_t indexCount)
+{
+	std::vector<std::array<float, 9>> triangles(indexCount / 3);
+	for (size_t t = 0; t < triangles.size(); t++)
+	{
+		std::array<std::array<float, 3>, 3> corner{};
+		for (int k = 0; k < 3; k++) { memcpy(corner[k].data(), vertices[indices[t * 3 + k]].position, sizeof(float) * 3); }
+		const int first = static_cast<int>(std::min_element(corner.begin(), corner.end()) - corner.begin());
+		for (int k = 0; k < 3; k++) { memcpy(&triangles[t][k * 3], corner[(first + k) % 3].data(), sizeof(float) * 3); }
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+inline std::vector<std::array<float, 9>> getCanonicalTriangles(const TestMesh& mesh)
+{
+	return getCanonicalTriangles(mesh.vertices.data(), mesh.indices.data(), mesh.indices.size());
+}
+
+// Wavefront OBJ with one normal per vertex ("f a//a b//b c//c").
+inline std::string makeObjText(const TestMesh& mesh)
+{
+	std::string text{};
+	text.reserve(mesh.vertices.size() * 80 + mesh.indices.size() * 12);
+	char line[160];
+	for (const TestVertex& v : mesh.vertices)
+	{
+		snprintf(line, sizeof(line), "v %.9g %.9g %.9g\nvn %.9g %.9g %.9g\n", v.position[0], v.position[1], v.position[2], v.normal[0], v.normal[1], v.normal[2]);
+		text += line;
+	}
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const unsigned int a = mesh.indices[i] + 1, b = mesh.indices[i + 1] + 1, c = mesh.indices[i + 2] + 1;
+		snprintf(line, sizeof(line), "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+		text += line;
+	}
+	return text;
+}
+
+// glTF 2.0 binary: one mesh under a node translated by translation, 32-bit indices.
+inline std::vector<unsigned char> makeGlb(const TestMesh& mesh, const float translation[3])
+{
+	const size_t vertexCount = mesh.vertices.size();
+	std::vector<unsigned char> bin(vertexCount * 24 + mesh.indices.size() * 4);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		memcpy(&bin[i * 12], mesh.vertices[i].position, 12);
+		memcpy(&bin[vertexCount * 12 + i * 12], mesh.vertices[i].normal, 12);
+	}
+	if (!mesh.indices.empty()) { memcpy(&bin[vertexCount * 24], mesh.indices.data(), mesh.indices.size() * 4); }
+
+	char json[2048];
+	snprintf(json, sizeof(json),
+		"{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+		"\"nodes\":[{\"mesh\":0,\"translation\":[%.9g,%.9g,%.9g]}],"
+		"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1},\"indices\":2}]}],"
+		"\"buffers\":[{\"byteLength\":%zu}],"
+		"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+		"{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+		"\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+		"{\"bufferView\":1,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+		"{\"bufferView\":2,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}]}",
+		translation[0], translation[1], translation[2], bin.size(),
+		vertexCount * 12, vertexCount * 12, vertexCount * 12, vertexCount * 24, mesh.indices.size() * 4,
+		vertexCount, vertexCount, mesh.indices.size());
+	std::string jsonChunk(json);
+	while (jsonChunk.size() % 4 != 0) { jsonChunk += ' '; }
+
+	std::vector<unsigned char> glb{};
+	auto append32 = [&](uint32_t value) { for (int b = 0; b < 4; b++) { glb.push_back(static_cast<unsigned char>(value >> (b * 8))); } };
+	append32(0x46546C67);	// "glTF"
+	append32(2);
+	append32(static_cast<uint32_t>(12 + 8 + jsonChunk.size() + 8 + bin.size()));
+	append32(static_cast<uint32_t>(jsonChunk.size()));
+	append32(0x4E4F534A);	// "JSON"
+	glb.insert(glb.end(), jsonChunk.begin(), jsonChunk.end());
+	append32(static_cast<uint32_t>(bin.size()));
+	append32(0x004E4942);	// "BIN"
+	glb.insert(glb.end(), bin.begin(), bin.end());
+	return glb;
+}
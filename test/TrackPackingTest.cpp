@@ -0,0 +1,94 @@
+﻿#include "Test.h"
+#include "TrackPacking.h"
+#include <string.h>
+#include <random>
+#include <vector>
+
+TEST(layoutAlignsOffsetsAndStacksLanes)
+{
+	std::vector<float> samples(100, 1.0f);
+	TrackDesc tracks[4];
+	const size_t counts[] = { 1, 16, 0, 33 };
+	for (int i = 0; i < 4; i++)
+	{
+		tracks[i].samples = samples.data();
+		tracks[i].sampleCount = counts[i];
+		tracks[i].samplePerSec = 44100 + i;
+		tracks[i].color[1] = 0.25f * i;
+		tracks[i].thickness = 0.01f * (i + 1);
+	}
+	PackedTrack layout[4];
+	CHECK_EQ(layoutTracks(tracks, 4, 0.25f, layout), 16 + 16 + 0 + 48);
+
+	// Each track starts on a 16 sample boundary; an empty track takes no room.
+	const uint32_t offsets[] = { 0, 16, 32, 32 };
+	for (int i = 0; i < 4; i++)
+	{
+		CHECK_EQ(layout[i].sampleOffset, offsets[i]);
+		CHECK_EQ(layout[i].sampleCount, counts[i]);
+		CHECK_EQ(layout[i].samplePerSec, 44100 + i);
+		CHECK(layout[i].color[1] == 0.25f * i);
+		CHECK(layout[i].thickness == 0.01f * (i + 1));
+		// Lanes of 1 / 4 from the top, the lowest quarter of each left as the gap.
+		CHECK(layout[i].rect[0] == 0.0f && layout[i].rect[2] == 1.0f);
+		CHECK_NEAR(layout[i].rect[1], 0.25 * i, 1e-7);
+		CHECK_NEAR(layout[i].rect[3], 0.25 * 0.75, 1e-7);
+	}
+	CHECK(layoutTracks(tracks, 0, 0.25f, layout) == 0);
+}
+
+TEST(packingCopiesChannelsAndZeroesGaps)
+{
+	// Stereo interleaved: lane 0 takes the left channel, lane 1 the right one.
+	std::vector<float> stereo(2 * 20);
+	for (size_t i = 0; i < 20; i++) { stereo[i * 2] = static_cast<float>(i); stereo[i * 2 + 1] = -static_cast<float>(i); }
+	TrackDesc tracks[2];
+	tracks[0].samples = stereo.data();
+	tracks[1].samples = stereo.data() + 1;
+	for (TrackDesc& track : tracks) { track.sampleCount = 20; track.stride = 2; }
+	PackedTrack layout[2];
+	const size_t total = layoutTracks(tracks, 2, 0.0f, layout);
+	REQUIRE(total == 64);
+	std::vector<float> buffer(total, 99.0f);
+	packTracks(tracks, 2, layout, buffer.data());
+	for (size_t i = 0; i < 20; i++)
+	{
+		CHECK(buffer[i] == static_cast<float>(i));
+		CHECK(buffer[32 + i] == -static_cast<float>(i));
+	}
+	for (size_t i = 20; i < 32; i++) { CHECK(buffer[i] == 0.0f && buffer[32 + i] == 0.0f); }
+}
+
+TEST(packingMatchesTheReference)
+{
+	// Random tracks, some empty and some long enough that packTracks splits them between cores (when there are several).
+	std::mt19937 random(3);
+	for (int trial = 0; trial < 60; trial++)
+	{
+		const size_t count = random() % 40;
+		std::vector<std::vector<float>> data(count);
+		std::vector<TrackDesc> tracks(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const size_t samples = random() % 5 == 0 ? 0 : random() % (trial < 50 ? 3000 : 200000);
+			const size_t stride = 1 + random() % 3;
+			data[i].resize(samples * stride + 1);
+			for (float& value : data[i]) { value = static_cast<float>(random() % 1000); }
+			tracks[i].samples = data[i].data();
+			tracks[i].sampleCount = samples;
+			tracks[i].stride = stride;
+		}
+		std::vector<PackedTrack> layout(count);
+		const size_t total = layoutTracks(tracks.data(), count, 0.1f, layout.data());
+		CHECK_EQ(total % trackAlignment, 0);
+		for (size_t i = 1; i < count; i++)
+		{
+			CHECK(layout[i].sampleOffset >= layout[i - 1].sampleOffset + layout[i - 1].sampleCount);
+			CHECK(layout[i].rect[1] + layout[i].rect[3] <= 1.0001f);
+		}
+		std::vector<float> packed(total, -1.0f), reference(total, -2.0f);
+		packTracks(tracks.data(), count, layout.data(), packed.data());
+		packTracksReference(tracks.data(), count, layout.data(), reference.data());
+		CHECK(packed == reference);
+	}
+}
@@ -0,0 +1,145 @@
+﻿#include "Test.h"
+#include "TriangleTessellator.h"
+#include <math.h>
+#include <random>
+
+namespace
+{
+	// Signed areas of the triangles in the (u, v) = (w1, w2) plane, where the whole patch has area 1 / 2.
+	struct PatchArea
+	{
+		double positive = 0;
+		double negative = 0;
+		double smallest = 1;
+	};
+
+	PatchArea measurePatch(const TessellatedPatch& patch)
+	{
+		PatchArea area;
+		for (size_t i = 0; i + 2 < patch.indices.size(); i += 3)
+		{
+			const float* a = &patch.domain[patch.indices[i] * 3];
+			const float* b = &patch.domain[patch.indices[i + 1] * 3];
+			const float* c = &patch.domain[patch.indices[i + 2] * 3];
+			const double signedArea = 0.5 * ((double(b[1]) - a[1]) * (double(c[2]) - a[2]) - (double(b[2]) - a[2]) * (double(c[1]) - a[1]));
+			(signedArea > 0 ? area.positive : area.negative) += fabs(signedArea);
+			area.smallest = fmin(area.smallest, fabs(signedArea));
+		}
+		return area;
+	}
+
+	// Every point is a barycentric coordinate on or inside the patch.
+	bool hasValidDomain(const TessellatedPatch& patch)
+	{
+		for (size_t i = 0; i < patch.domain.size(); i += 3)
+		{
+			const float* w = &patch.domain[i];
+			if (w[0] < -1e-6f || w[1] < -1e-6f || w[2] < -1e-6f || fabsf(w[0] + w[1] + w[2] - 1.0f) > 1e-5f) { return false; }
+		}
+		for (uint32_t index : patch.indices)
+		{
+			if (index >= patch.domain.size() / 3) { return false; }
+		}
+		return true;
+	}
+
+	// Points with weight c == 0 lie on the edge opposite corner c.
+	uint32_t countEdgePoints(const TessellatedPatch& patch, int c)
+	{
+		uint32_t count = 0;
+		for (size_t i = 0; i < patch.domain.size(); i += 3) { count += fabsf(patch.domain[i + c]) < 1e-6f; }
+		return count;
+	}
+}
+
+TEST(factorsRoundUpToOddSegments)
+{
+	CHECK_EQ(getFractionalOddSegments(1.0f), 1);
+	CHECK_EQ(getFractionalOddSegments(0.25f), 1);
+	CHECK_EQ(getFractionalOddSegments(1.01f), 3);
+	CHECK_EQ(getFractionalOddSegments(3.0f), 3);
+	CHECK_EQ(getFractionalOddSegments(4.0f), 5);
+	CHECK_EQ(getFractionalOddSegments(6.0f), 7);
+	CHECK_EQ(getFractionalOddSegments(63.0f), 63);
+	CHECK_EQ(getFractionalOddSegments(1000.0f), 63);
+	// Zero, negative and NaN factors cull the patch.
+	CHECK_EQ(getFractionalOddSegments(0.0f), 0);
+	CHECK_EQ(getFractionalOddSegments(-2.0f), 0);
+	CHECK_EQ(getFractionalOddSegments(NAN), 0);
+}
+
+TEST(uniformPatchesHaveTheClosedFormCount)
+{
+	CHECK_EQ(getTessellatedTriangleCount(1.0f), 1);
+	CHECK_EQ(getTessellatedTriangleCount(3.0f), 13);
+	CHECK_EQ(getTessellatedTriangleCount(6.0f), 73);
+	CHECK_EQ(getTessellatedTriangleCount(63.0f), 5953);
+	CHECK_EQ(getTessellatedTriangleCount(0.0f), 0);
+	TessellatedPatch patch;
+	for (float factor = 0.5f; factor <= 64.0f; factor += 0.75f)
+	{
+		const uint32_t n = getFractionalOddSegments(factor);
+		const uint32_t expected = (3 * n * n - 1) / 2;
+		CHECK_EQ(getTessellatedTriangleCount(factor), expected);
+		tessellateTriangle(factor, &patch);
+		CHECK_EQ(patch.indices.size(), expected * 3);
+		REQUIRE(hasValidDomain(patch));
+		// n + 1 points on each edge, so neighbouring patches share their vertices.
+		for (int c = 0; c < 3; c++) { CHECK_EQ(countEdgePoints(patch, c), n + 1); }
+	}
+}
+
+TEST(separateEdgesFollowTheStitchedCount)
+{
+	// Uniform inside of n segments minus its outer ring, plus e0 + e1 + e2 + 3 (n - 2) stitching triangles.
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> distribution(0.5f, 20.0f);
+	TessellatedPatch patch;
+	for (int i = 0; i < 300; i++)
+	{
+		const float edgeFactors[3] = { distribution(random), distribution(random), distribution(random) };
+		const float insideFactor = i % 10 == 0 ? 1.0f : distribution(random);
+		const uint32_t e[3] = { getFractionalOddSegments(edgeFactors[0]), getFractionalOddSegments(edgeFactors[1]), getFractionalOddSegments(edgeFactors[2]) };
+		uint32_t n = getFractionalOddSegments(insideFactor);
+		if (n == 1 && (e[0] > 1 || e[1] > 1 || e[2] > 1)) { n = 3; }
+		const uint32_t expected = n == 1 ? 1 : (3 * (n - 2) * (n - 2) - 1) / 2 + e[0] + e[1] + e[2] + 3 * (n - 2);
+		CHECK_EQ(getTessellatedTriangleCount(edgeFactors, insideFactor), expected);
+		tessellateTriangle(edgeFactors, insideFactor, &patch);
+		CHECK_EQ(patch.indices.size(), expected * 3);
+		REQUIRE(hasValidDomain(patch));
+		// Edge k runs from corner k to corner k + 1, opposite corner k + 2.
+		for (int k = 0; k < 3; k++) { CHECK_EQ(countEdgePoints(patch, (k + 2) % 3), e[k] + 1); }
+	}
+
+	// An inside factor of 1 is raised to 3 once an edge is split.
+	const float oneSplit[3] = { 3.0f, 1.0f, 1.0f };
+	CHECK_EQ(getTessellatedTriangleCount(oneSplit, 1.0f), 1 + 3 + 1 + 1 + 3);
+	const float culled[3] = { 3.0f, 0.0f, 3.0f };
+	CHECK_EQ(getTessellatedTriangleCount(culled, 3.0f), 0);
+	tessellateTriangle(culled, 3.0f, &patch);
+	CHECK(patch.indices.empty() && patch.domain.empty());
+}
+
+TEST(trianglesTileThePatch)
+{
+	// Same winding everywhere, no degenerate triangle, and the areas add up to the patch.
+	TessellatedPatch patch;
+	const float uniform[] = { 1.0f, 3.0f, 6.0f, 17.0f, 63.0f };
+	for (float factor : uniform)
+	{
+		tessellateTriangle(factor, &patch);
+		const PatchArea area = measurePatch(patch);
+		CHECK(area.positive == 0.0 || area.negative == 0.0);
+		CHECK_NEAR(area.positive + area.negative, 0.5, 1e-5);
+		CHECK(area.smallest > 0.0);
+	}
+	const float edgeFactors[][3] = { { 1, 9, 3 }, { 15, 1, 1 }, { 5, 7, 9 }, { 33, 3, 11 } };
+	for (const float* edges : edgeFactors)
+	{
+		tessellateTriangle(edges, 5.0f, &patch);
+		const PatchArea area = measurePatch(patch);
+		CHECK(area.positive == 0.0 || area.negative == 0.0);
+		CHECK_NEAR(area.positive + area.negative, 0.5, 1e-5);
+		CHECK(area.smallest > 0.0);
+	}
+}
@@ -0,0 +1,160 @@
+﻿#include "Test.h"
+#include "TestMeshes.h"
+#include "VertexQuantization.h"
+#include <float.h>
+#include <random>
+
+namespace
+{
+	std::vector<TestVertex> makeRandomVertices(size_t count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-5.0f, 5.0f);
+		std::normal_distribution<float> direction(0.0f, 1.0f);
+		std::vector<TestVertex> vertices(count);
+		for (TestVertex& v : vertices)
+		{
+			float length = 0.0f;
+			while (length < 1e-3f)
+			{
+				for (int c = 0; c < 3; c++) { v.normal[c] = direction(random); }
+				length = sqrtf(v.normal[0] * v.normal[0] + v.normal[1] * v.normal[1] + v.normal[2] * v.normal[2]);
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				v.position[c] = position(random);
+				v.normal[c] /= length;
+			}
+		}
+		// Axes, signed zeros and octant borders are the edge cases of the octahedral fold.
+		const float special[][3] =
+		{
+			{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+			{ -0.0f, 0, -1 }, { 0, -0.0f, -1 }, { 0.70710678f, 0.70710678f, 0 }, { -0.70710678f, 0, -0.70710678f },
+		};
+		for (size_t i = 0; i < sizeof(special) / sizeof(special[0]) && i < count; i++)
+		{
+			memcpy(vertices[i].normal, special[i], sizeof(float) * 3);
+		}
+		return vertices;
+	}
+
+	double getAngle(const float* a, const float* b)
+	{
+		const double lengthA = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+		const double lengthB = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+		const double cosine = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / (lengthA * lengthB);
+		return acos(cosine > 1.0 ? 1.0 : (cosine < -1.0 ? -1.0 : cosine));
+	}
+}
+
+TEST(simdMatchesReferenceBitForBit)
+{
+	// Every tail length around the SIMD width, plus a large batch.
+	for (size_t count : { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100003 })
+	{
+		const std::vector<TestVertex> vertices = makeRandomVertices(count, static_cast<unsigned int>(count) + 1);
+		const QuantizationBounds bounds = computeQuantizationBounds(vertices.empty() ? nullptr : vertices[0].position, count, sizeof(TestVertex));
+		std::vector<QuantizedVertex> simd(count + 1), reference(count + 1);
+		memset(simd.data(), 0xCD, simd.size() * sizeof(QuantizedVertex));
+		memset(reference.data(), 0xCD, reference.size() * sizeof(QuantizedVertex));
+		if (count > 0)
+		{
+			quantizePositions(simd.data(), vertices[0].position, count, sizeof(TestVertex), bounds);
+			encodeOctahedralNormals(simd.data(), vertices[0].normal, count, sizeof(TestVertex));
+			quantizePositionsReference(reference.data(), vertices[0].position, count, sizeof(TestVertex), bounds);
+			encodeOctahedralNormalsReference(reference.data(), vertices[0].normal, count, sizeof(TestVertex));
+		}
+		// The guard element past the end must stay untouched.
+		CHECK(memcmp(simd.data(), reference.data(), simd.size() * sizeof(QuantizedVertex)) == 0);
+
+		std::vector<QuantizedVertex> combined(count + 1);
+		memset(combined.data(), 0xCD, combined.size() * sizeof(QuantizedVertex));
+		if (count > 0) { quantizeVertices(combined.data(), vertices.data(), count, sizeof(TestVertex), offsetof(TestVertex, normal), bounds); }
+		CHECK(memcmp(combined.data(), reference.data(), combined.size() * sizeof(QuantizedVertex)) == 0);
+	}
+}
+
+TEST(positionErrorWithinHalfStep)
+{
+	const size_t count = 200000;
+	const std::vector<TestVertex> vertices = makeRandomVertices(count, 7);
+	const QuantizationBounds bounds = computeQuantizationBounds(vertices[0].position, count, sizeof(TestVertex));
+	std::vector<QuantizedVertex> quantized(count);
+	quantizePositions(quantized.data(), vertices[0].position, count, sizeof(TestVertex), bounds);
+	// Half a UNORM16 step, plus float rounding of coordinates up to 5 in magnitude.
+	double worst = 0.0;
+	for (size_t i = 0; i < count; i++)
+	{
+		float decoded[3];
+		dequantizePosition(decoded, quantized[i], bounds);
+		for (int c = 0; c < 3; c++)
+		{
+			const double bound = bounds.extent[c] / 131070.0 + 8.0 * 5.0 * FLT_EPSILON;
+			worst = fmax(worst, fabs(decoded[c] - vertices[i].position[c]) / bound);
+		}
+	}
+	CHECK(worst <= 1.0);
+}
+
+TEST(normalErrorBelowOneMilliradian)
+{
+	const size_t count = 200000;
+	const std::vector<TestVertex> vertices = makeRandomVertices(count, 11);
+	std::vector<QuantizedVertex> quantized(count);
+	encodeOctahedralNormals(quantized.data(), vertices[0].normal, count, sizeof(TestVertex));
+	double worst = 0.0;
+	for (size_t i = 0; i < count; i++)
+	{
+		float decoded[3];
+		decodeOctahedralNormal(decoded, quantized[i]);
+		worst = fmax(worst, getAngle(decoded, vertices[i].normal));
+		CHECK_NEAR(sqrt(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2]), 1.0, 1e-5);
+	}
+	CHECK(worst < 0.001);
+}
+
+TEST(boundsCoverMeshAndStayInvertible)
+{
+	const TestMesh grid = makeGridMesh(8, 2.0f);
+	const QuantizationBounds bounds = computeQuantizationBounds(grid.vertices[0].position, grid.vertices.size(), sizeof(TestVertex));
+	CHECK_NEAR(bounds.min[0], -1.0, 1e-6);
+	CHECK_NEAR(bounds.min[2], -1.0, 1e-6);
+	CHECK_NEAR(bounds.extent[0], 2.0, 1e-6);
+	CHECK_NEAR(bounds.extent[2], 2.0, 1e-6);
+	// The grid is flat in y; a zero extent would divide by zero.
+	CHECK(bounds.extent[1] > 0.0f);
+
+	std::vector<QuantizedVertex> quantized(grid.vertices.size());
+	quantizePositions(quantized.data(), grid.vertices[0].position, grid.vertices.size(), sizeof(TestVertex), bounds);
+	for (size_t i = 0; i < grid.vertices.size(); i++)
+	{
+		float decoded[3];
+		dequantizePosition(decoded, quantized[i], bounds);
+		CHECK_NEAR(decoded[1], 0.0, 1e-6);
+	}
+}
+
+TEST(dequantizationMatrixMatchesDecoder)
+{
+	const std::vector<TestVertex> vertices = makeRandomVertices(1000, 3);
+	const QuantizationBounds bounds = computeQuantizationBounds(vertices[0].position, vertices.size(), sizeof(TestVertex));
+	std::vector<QuantizedVertex> quantized(vertices.size());
+	quantizePositions(quantized.data(), vertices[0].position, vertices.size(), sizeof(TestVertex), bounds);
+	float matrix[16];
+	getDequantizationMatrix(matrix, bounds);
+	for (const QuantizedVertex& q : quantized)
+	{
+		// The vertex shader sees UNORM values in [0, 1] with w = 1.
+		const float unorm[4] = { q.position[0] / 65535.0f, q.position[1] / 65535.0f, q.position[2] / 65535.0f, 1.0f };
+		float transformed[4] = {};
+		for (int c = 0; c < 4; c++)
+		{
+			for (int r = 0; r < 4; r++) { transformed[c] += unorm[r] * matrix[r * 4 + c]; }
+		}
+		float decoded[3];
+		dequantizePosition(decoded, q, bounds);
+		for (int c = 0; c < 3; c++) { CHECK_NEAR(transformed[c], decoded[c], 1e-5); }
+		CHECK_NEAR(transformed[3], 1.0, 0.0);
+	}
+}
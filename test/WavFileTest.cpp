@@ -0,0 +1,251 @@
+﻿#include "Test.h"
+#include "WavFile.h"
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr uint16_t formatPcm = 1, formatFloat = 3, formatExtensible = 0xFFFE;
+
+	void appendU16(std::string& out, uint16_t value) { out.append(reinterpret_cast<const char*>(&value), 2); }
+	void appendU32(std::string& out, uint32_t value) { out.append(reinterpret_cast<const char*>(&value), 4); }
+
+	// RIFF image built chunk by chunk; the RIFF size is patched by getBytes.
+	class WavBuilder
+	{
+	private:
+		std::string bytes = std::string("RIFF\0\0\0\0WAVE", 12);
+	public:
+		// declaredSize = 0 uses the real size. Odd bodies get their pad byte unless pad is false.
+		void addChunk(const char* id, const std::string& body, uint32_t declaredSize = 0, bool pad = true)
+		{
+			bytes.append(id, 4);
+			appendU32(bytes, declaredSize ? declaredSize : static_cast<uint32_t>(body.size()));
+			bytes += body;
+			if (pad && (body.size() & 1)) { bytes.push_back('\xEE'); }
+		}
+		std::string getBytes()const
+		{
+			std::string out = bytes;
+			const uint32_t riffSize = static_cast<uint32_t>(out.size() - 8);
+			memcpy(&out[4], &riffSize, 4);
+			return out;
+		}
+	};
+
+	// Body of a "fmt " chunk. subFormat is the tag in the SubFormat GUID of WAVE_FORMAT_EXTENSIBLE.
+	std::string makeFormat(uint16_t tag, uint16_t channels, uint32_t rate, uint16_t bits, uint16_t subFormat = 0)
+	{
+		std::string body;
+		const uint16_t blockAlign = static_cast<uint16_t>(channels * (bits / 8));
+		appendU16(body, tag);
+		appendU16(body, channels);
+		appendU32(body, rate);
+		appendU32(body, rate * blockAlign);
+		appendU16(body, blockAlign);
+		appendU16(body, bits);
+		if (tag == formatExtensible)
+		{
+			//cbSize, wValidBitsPerSample, dwChannelMask, SubFormat
+			appendU16(body, 22);
+			appendU16(body, bits);
+			appendU32(body, channels == 2 ? 3 : 0x3F);
+			appendU16(body, subFormat);
+			body.append("\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71", 14);
+		}
+		return body;
+	}
+
+	std::string makeSamples16(std::initializer_list<int16_t> samples)
+	{
+		std::string out;
+		for (int16_t sample : samples) { out.append(reinterpret_cast<const char*>(&sample), 2); }
+		return out;
+	}
+
+	WavParseResult parse(const std::string& file, WavFormat& outFormat)
+	{
+		return parseWav(file.data(), file.size(), &outFormat);
+	}
+}
+
+TEST(chunksInAnyOrder)
+{
+	const std::string samples = makeSamples16({ 1, 2, 3, 4, 5, 6 });
+	WavBuilder formatFirst;
+	formatFirst.addChunk("fmt ", makeFormat(formatPcm, 2, 44100, 16));
+	formatFirst.addChunk("data", samples);
+	WavBuilder dataFirst;
+	dataFirst.addChunk("LIST", std::string(10, 'x'));
+	dataFirst.addChunk("data", samples);
+	dataFirst.addChunk("fmt ", makeFormat(formatPcm, 2, 44100, 16));
+
+	for (const WavBuilder* builder : { &formatFirst, &dataFirst })
+	{
+		const std::string file = builder->getBytes();
+		WavFormat format;
+		REQUIRE(parse(file, format) == WavParseResult::ok);
+		CHECK(format.sampleType == WavSampleType::pcm);
+		CHECK_EQ(format.channels, 2);
+		CHECK_EQ(format.samplesPerSec, 44100);
+		CHECK_EQ(format.bitsPerSample, 16);
+		CHECK_EQ(format.blockAlign, 4);
+		CHECK_EQ(format.frameCount, 3);
+		CHECK_EQ(format.dataSize, samples.size());
+		CHECK(file.compare(format.dataOffset, samples.size(), samples) == 0);
+		CHECK(getPcmFormat(format) == PcmFormat::signed16);
+	}
+}
+
+TEST(oddChunksArePadded)
+{
+	// An odd LIST chunk is followed by a pad byte that is not counted in its size.
+	WavBuilder builder;
+	builder.addChunk("LIST", std::string(7, 'x'));
+	builder.addChunk("fmt ", makeFormat(formatPcm, 1, 8000, 8));
+	builder.addChunk("fact", std::string(3, 'y'));
+	builder.addChunk("data", std::string("\x80\xFF\x00", 3));
+	const std::string file = builder.getBytes();
+	WavFormat format;
+	REQUIRE(parse(file, format) == WavParseResult::ok);
+	CHECK_EQ(format.dataOffset, 12 + (8 + 8) + (8 + 16) + (8 + 4) + 8);
+	CHECK_EQ(format.frameCount, 3);
+	CHECK(getPcmFormat(format) == PcmFormat::unsigned8);
+
+	// Without the pad byte the next chunk header is read one byte early.
+	WavBuilder unpadded;
+	unpadded.addChunk("LIST", std::string(7, 'x'), 0, false);
+	unpadded.addChunk("fmt ", makeFormat(formatPcm, 1, 8000, 8));
+	unpadded.addChunk("data", std::string("\x80\x80", 2));
+	CHECK(parse(unpadded.getBytes(), format) != WavParseResult::ok);
+}
+
+TEST(extensibleUsesTheSubFormat)
+{
+	WavBuilder floatFile;
+	floatFile.addChunk("fmt ", makeFormat(formatExtensible, 2, 48000, 32, formatFloat));
+	floatFile.addChunk("data", std::string(8 * 5, '\0'));
+	WavFormat format;
+	REQUIRE(parse(floatFile.getBytes(), format) == WavParseResult::ok);
+	CHECK(format.sampleType == WavSampleType::ieeeFloat);
+	CHECK(getPcmFormat(format) == PcmFormat::float32);
+	CHECK_EQ(format.frameCount, 5);
+
+	WavBuilder pcm24;
+	pcm24.addChunk("fmt ", makeFormat(formatExtensible, 6, 48000, 24, formatPcm));
+	pcm24.addChunk("data", std::string(18 * 2, '\0'));
+	REQUIRE(parse(pcm24.getBytes(), format) == WavParseResult::ok);
+	CHECK(format.sampleType == WavSampleType::pcm);
+	CHECK(getPcmFormat(format) == PcmFormat::signed24);
+	CHECK_EQ(format.blockAlign, 18);
+	CHECK_EQ(format.frameCount, 2);
+
+	// The extension must be complete, and its sub format supported.
+	WavBuilder shortExtension;
+	shortExtension.addChunk("fmt ", makeFormat(formatExtensible, 2, 48000, 16, formatPcm).substr(0, 24));
+	shortExtension.addChunk("data", std::string(4, '\0'));
+	CHECK(parse(shortExtension.getBytes(), format) == WavParseResult::unsupportedFormat);
+	WavBuilder adpcm;
+	adpcm.addChunk("fmt ", makeFormat(formatExtensible, 2, 48000, 16, 2));
+	adpcm.addChunk("data", std::string(4, '\0'));
+	CHECK(parse(adpcm.getBytes(), format) == WavParseResult::unsupportedFormat);
+}
+
+TEST(truncatedDataIsClampedToWholeFrames)
+{
+	// The recording claims 1000 bytes but stopped after 2.5 stereo 16-bit frames.
+	WavBuilder builder;
+	builder.addChunk("fmt ", makeFormat(formatPcm, 2, 44100, 16));
+	builder.addChunk("data", std::string(10, '\x11'), 1000, false);
+	WavFormat format;
+	REQUIRE(parse(builder.getBytes(), format) == WavParseResult::ok);
+	CHECK_EQ(format.frameCount, 2);
+	CHECK_EQ(format.dataSize, 8);
+
+	// Any other chunk running past the end is an error.
+	WavBuilder cutFormat;
+	cutFormat.addChunk("data", std::string(4, '\0'));
+	cutFormat.addChunk("fmt ", makeFormat(formatPcm, 2, 44100, 16).substr(0, 10), 16, false);
+	CHECK(parse(cutFormat.getBytes(), format) == WavParseResult::truncated);
+
+	// Less than one frame leaves an empty but valid file.
+	WavBuilder empty;
+	empty.addChunk("fmt ", makeFormat(formatPcm, 2, 44100, 16));
+	empty.addChunk("data", std::string(3, '\0'), 4000, false);
+	REQUIRE(parse(empty.getBytes(), format) == WavParseResult::ok);
+	CHECK_EQ(format.frameCount, 0);
+}
+
+TEST(malformedFilesAreRejected)
+{
+	WavFormat format;
+	CHECK(parseWav(nullptr, 0, &format) == WavParseResult::notRiff);
+	CHECK(parse(std::string("RIFX\4\0\0\0WAVE", 12), format) == WavParseResult::notRiff);
+	CHECK(parse(std::string("RIFF\4\0\0\0AVI ", 12), format) == WavParseResult::notWave);
+
+	WavBuilder noFormat;
+	noFormat.addChunk("data", std::string(4, '\0'));
+	CHECK(parse(noFormat.getBytes(), format) == WavParseResult::missingFormat);
+	WavBuilder noData;
+	noData.addChunk("fmt ", makeFormat(formatPcm, 2, 44100, 16));
+	CHECK(parse(noData.getBytes(), format) == WavParseResult::missingData);
+
+	const struct { uint16_t tag; uint16_t channels; uint16_t bits; } unsupported[] = {
+		{ formatPcm, 2, 12 },
+		{ formatFloat, 2, 64 },
+		{ 2, 2, 16 },
+		{ formatPcm, 0, 16 },
+	};
+	for (const auto& f : unsupported)
+	{
+		WavBuilder builder;
+		builder.addChunk("fmt ", makeFormat(f.tag, f.channels, 44100, f.bits));
+		builder.addChunk("data", std::string(16, '\0'));
+		CHECK(parse(builder.getBytes(), format) == WavParseResult::unsupportedFormat);
+	}
+
+	// blockAlign has to match channels * bytes per sample.
+	std::string badAlign = makeFormat(formatPcm, 2, 44100, 16);
+	badAlign[12] = 6;
+	WavBuilder builder;
+	builder.addChunk("fmt ", badAlign);
+	builder.addChunk("data", std::string(12, '\0'));
+	CHECK(parse(builder.getBytes(), format) == WavParseResult::unsupportedFormat);
+}
+
+TEST(openMapsAndMixesToMono)
+{
+	const char* path = "WavFileTest.wav";
+	WavBuilder builder;
+	builder.addChunk("LIST", std::string(5, 'x'));
+	builder.addChunk("fmt ", makeFormat(formatPcm, 2, 44100, 16));
+	builder.addChunk("data", makeSamples16({ 16384, 0, -32768, -32768, 8192, 8192 }));
+	const std::string file = builder.getBytes();
+	{
+		std::ofstream ofs{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+		ofs.write(file.data(), static_cast<std::streamsize>(file.size()));
+	}
+
+	WavFile wav;
+	REQUIRE(wav.open(path) == WavParseResult::ok);
+	CHECK(wav.isOpen());
+	CHECK_EQ(wav.getFrameCount(), 3);
+	float mono[4] = { 9, 9, 9, 9 };
+	CHECK_EQ(wav.readMono(0, 4, mono), 3);
+	CHECK(mono[0] == 0.25f);
+	CHECK(mono[1] == -1.0f);
+	CHECK(mono[2] == 0.25f);
+	CHECK(mono[3] == 9);
+	CHECK_EQ(wav.readMono(2, 1, mono), 1);
+	CHECK(mono[0] == 0.25f);
+	CHECK_EQ(wav.readMono(3, 1, mono), 0);
+	wav.close();
+	CHECK(!wav.isOpen());
+	CHECK_EQ(wav.getFrameCount(), 0);
+
+	CHECK(wav.open("WavFileTest_missing.wav") == WavParseResult::notRiff);
+	remove(path);
+}